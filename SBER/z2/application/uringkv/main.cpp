@@ -1,14 +1,25 @@
 #include "kv.hpp"
+#include "perf_context.hpp"
+#include "sst/compression.hpp"
+#include "sst/footer.hpp"
+#include "sst/index.hpp"
+#include "sst/reader.hpp"
+#include "sst/table.hpp"
+#include "sst/writer.hpp"
 
 #include <spdlog/spdlog.h>
+#include <spdlog/sinks/stdout_color_sinks.h>
 #include <fmt/core.h>
 
 #include <algorithm>
 #include <atomic>
 #include <chrono>
 #include <cstdint>
+#include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <filesystem>
+#include <functional>
 #include <new>
 #include <optional>
 #include <random>
@@ -17,11 +28,16 @@
 #include <thread>
 #include <vector>
 
+#include <fcntl.h>
+#include <unistd.h>
+
 // --------- грубый трекер аллокаций для демонстрации ---------
 static std::atomic<uint64_t> g_allocs{0}, g_frees{0};
+static thread_local uint64_t t_allocs = 0; // аллокации потока: bench считает их на операцию
 
 void* operator new(std::size_t sz) {
   g_allocs.fetch_add(1, std::memory_order_relaxed);
+  ++t_allocs;
   if (void* p = std::malloc(sz)) return p;
   throw std::bad_alloc();
 }
@@ -38,13 +54,14 @@ void operator delete(void* p, std::size_t) noexcept {
 // Парсер аргументов / режимы
 // ----------------------------
 struct Args {
-  std::string mode = "run";          // run | bench | put | get | del | scan | metrics
+  std::string mode = "run";          // run | bench | sstbench | indexbench | walbench | put | get | del | scan | metrics
   std::string path = "/tmp/uringkv_demo";
 
   // опции io/durability/compaction
   bool        use_uring = false;
   unsigned    uring_qd  = 256;
   std::string flush_mode = "fdatasync";          // fdatasync|fsync|sfr
+  std::string wal_format = "padded";             // padded|packed
   std::string compaction_policy = "size-tiered"; // size-tiered|leveled
   bool        uring_sqpoll = false;
 
@@ -58,17 +75,46 @@ struct Args {
   uint64_t    sst_flush_threshold = 4ull * 1024 * 1024;
   bool        bg_compaction       = true;
   size_t      l0_compact_threshold= 6;
+  uint64_t    level_base_bytes    = 256ull * 1024 * 1024;
+  uint32_t    level_multiplier    = 10;
+  uint32_t    max_levels          = 7;
+  unsigned    compaction_threads  = 1;
+  unsigned    subcompactions      = 1;
+  uint64_t    manifest_max_bytes  = 4ull * 1024 * 1024;
   size_t      table_cache_capacity= 64;
+  uint64_t    block_cache_bytes   = 32ull * 1024 * 1024;
+  uint32_t    sst_format          = 3;
+  uint64_t    sst_block_size      = 4096;
+  uint64_t    sst_target_file     = 64ull * 1024 * 1024;
+  uint32_t    bloom_bits          = 10;
+  uint64_t    blob_threshold      = 0;
+  uint64_t    blob_file_bytes     = 256ull * 1024 * 1024;
+  double      blob_gc_ratio       = 0.5;
+  std::string compression         = "none";
+  int         compression_level   = 0;
+  uint32_t    zstd_dict_bytes     = 0;
+  uint64_t    bg_rate             = 0;  // байт/с, 0 = без ограничения
+  bool        bg_rate_auto        = false;
+  bool        bg_ioprio           = true;
+  size_t      l0_slowdown         = 20;
+  size_t      l0_stop             = 36;
+  bool        latency_hist        = false;
 
   // bench
   uint64_t ops = 100'000;
   std::string ratio = "90:5:5";
   size_t key_len = 16;
   size_t val_len = 100;
+  std::string val_kind = "random"; // random | json
   unsigned threads = 1;
+  uint64_t batch = 1; // walbench: PUT'ов в одном WriteBatch
+  unsigned replay_threads = 0; // 0 = по числу ядер
+  bool perf = false; // bench: perf-контекст потоков и гистограммы KV
+  bool pinned = true; // bench: GET в PinnableSlice (без копии значения)
 
   // kv ops
   std::string key;
+  std::string keys; // mget: K1,K2,...
   std::string value;
   std::string start;
   std::string end;
@@ -76,6 +122,7 @@ struct Args {
   // metrics
   bool watch = false;
   double watch_interval_sec = 1.0;
+  std::string format = "text"; // text | prometheus | json
 
   bool help = false;
 };
@@ -83,28 +130,57 @@ struct Args {
 static void print_usage(const char* prog) {
   fmt::print(
 R"(Usage:
-  {0} [options] <run|bench|put|get|del|scan|metrics> [args...]
+  {0} [options] <run|bench|sstbench|indexbench|walbench|recoverybench|put|get|mget|del|delrange|delprefix|scan|metrics> [args...]
 
 Common options:
   --path DIR                       : data path (default: /tmp/uringkv_demo)
   --use-uring on|off               : enable io_uring (default: off)
   --queue-depth N                  : io_uring QD (default: 256)
   --uring-sqpoll on|off            : io_uring SQPOLL (default: off)
-  --uring-fixed-buf BYTES          : size of io_uring fixed buffer (default: 0 = off)
-  --uring-submit-batch N           : SQE batch size before submit (default: 16)
+  --uring-fixed-buf BYTES          : io_uring fixed buffer: WAL staging ring for async appends
+                                     (WRITE_FIXED) and READ_FIXED in mget (default: 0 = off)
+  --uring-submit-batch N           : SQEs queued before an automatic submit (default: 16)
   --flush fdatasync|fsync|sfr      : durability mode (default: fdatasync)
   --compaction-policy size-tiered|leveled (default: size-tiered)
+  --level-base BYTES               : leveled: L1 size limit (default: 256MiB)
+  --level-multiplier N             : leveled: size ratio of adjacent levels (default: 10)
+  --max-levels N                   : leveled: number of levels incl. L0 (default: 7)
+  --compaction-threads N           : background compaction threads (default: 1)
+  --subcompactions N               : split a large compaction into N key-range parts (default: 1)
+  --manifest-max BYTES             : rewrite the MANIFEST log as one snapshot past this size (default: 4MiB)
+  --wal-format padded|packed       : WAL records padded to 4KiB or packed into shared blocks (default: padded)
   --segment BYTES                  : WAL max segment size (default: 64MiB)
+  --replay-threads N               : threads reading/validating WAL segments on open, 0 = all cores (default: 0)
   --group-commit BYTES             : WAL group-commit threshold (default: 1MiB)
   --flush-threshold BYTES          : SST flush threshold (default: 4MiB)
   --bg-compact on|off              : background compaction (default: on)
   --l0-threshold N                 : L0 compaction start threshold (default: 6)
   --table-cache N                  : table cache capacity (default: 64)
+  --block-cache BYTES              : SST block cache size, 0 = off (default: 32MiB)
+  --sst-format 2|3                 : SST format for new tables (default: 3 = packed blocks)
+  --block-size BYTES               : SST v3 data block size (default: 4096)
+  --sst-target-size BYTES          : compaction output SST size (default: 64MiB)
+  --bloom-bits N                   : bloom filter bits per key in new SSTs, 0 = off (default: 10)
+  --blob-threshold BYTES           : values >= BYTES go to blob files on flush, 0 = off (default: 0)
+  --blob-file-size BYTES           : blob file size limit (default: 256MiB)
+  --blob-gc-ratio R                : background GC of blob files with garbage share >= R, >1 = off (default: 0.5)
+  --compression none|lz4|zstd      : SST v3 data block codec (default: none)
+  --compression-level N            : codec level, 0 = codec default (default: 0)
+  --zstd-dict BYTES                : zstd dictionary trained per compaction output SST, 0 = off (default: 0)
+  --bg-rate BYTES                  : flush+compaction write limit per second, flush first, 0 = off (default: 0)
+  --bg-rate-auto on|off            : scale the limit from 1/8 to full with pending compaction bytes (default: off)
+  --bg-ioprio on|off               : run compaction at the lowest best-effort I/O priority (default: on)
+  --l0-slowdown N                  : delay writes by 1ms per group when L0 has >= N files, 0 = off (default: 20)
+  --l0-stop N                      : stop writes until compaction when L0 has >= N files, 0 = off (default: 36)
+  --latency-hist on|off            : per-operation latency histograms in metrics (default: off)
 
 KV commands:
   put  --key K --value V
   get  --key K
+  mget --keys K1,K2,...            : batched get (SST reads submitted together)
   del  --key K
+  delrange --start A --end B       : delete all keys in [A, B) with one range tombstone
+  delprefix --key P                : delete all keys starting with P
   scan --start A --end B
 
 Bench options:
@@ -113,11 +189,28 @@ Bench options:
   --ratio PUT:GET:DEL              : mix in percent (default: 90:5:5)
   --key-len N                      : key length bytes (default: 16)
   --val-len N                      : value length bytes (default: 100)
+  --val-kind random|json           : value content: random bytes or compressible JSON (default: random)
   --threads N                      : worker threads (default: 1)
+  --perf on|off                    : bench: per-stage GET/PUT breakdown from thread perf contexts and
+                                     engine latency histograms (default: off)
+  --pinned on|off                  : bench: GET into a PinnableSlice pinned to the block cache/MemTable
+                                     instead of a copied std::string (default: on)
+  sstbench                         : SST v2 vs v3 (and v3 + --compression) size/throughput, decode cost
+                                     (uses --ops/--key-len/--val-len/--val-kind)
+  indexbench                       : SST v3 hash index v1 (16 B slots) vs v2 (64 B buckets, scalar and SIMD
+                                     tag compare): index bytes, probe ns for hits/misses, GET ops/s
+                                     (uses --ops/--key-len/--val-len)
+  walbench                         : multi-threaded PUT with fdatasync per commit, padded vs packed WAL
+                                     (uses --ops/--threads/--key-len/--val-len)
+  --batch N                        : walbench: PUTs per WriteBatch (one WAL record), 1 = plain put (default: 1)
+  recoverybench                    : write --ops PUTs into the WAL only (padded and packed), then reopen
+                                     with 1 and --replay-threads replay threads and report startup time
 
 Metrics:
   metrics                          : print one-time snapshot
   metrics --watch [seconds]        : print periodically (default 1s)
+  --format text|prometheus|json    : metrics output format; with --watch prometheus/json print
+                                     a full snapshot each interval (default: text)
 
 Examples:
   {0} --path /tmp/kv run
@@ -156,7 +249,7 @@ static Args parse_args(int argc, char** argv) {
 
     auto need_value = [&](int i)->bool { return (i+1)<argc; };
 
-    if (t=="run"||t=="bench"||t=="put"||t=="get"||t=="del"||t=="scan"||t=="metrics") { a.mode = std::string(t); continue; }
+    if (t=="run"||t=="bench"||t=="sstbench"||t=="indexbench"||t=="walbench"||t=="recoverybench"||t=="put"||t=="get"||t=="mget"||t=="del"||t=="delrange"||t=="delprefix"||t=="scan"||t=="metrics") { a.mode = std::string(t); continue; }
     if (t=="--path" && need_value(i)) { a.path = argv[++i]; continue; }
     if (t=="--use-uring" && need_value(i)) { if(!parse_bool(argv[++i], a.use_uring)) a.help=true; continue; }
     if (t=="--queue-depth" && need_value(i)) { a.uring_qd = std::strtoul(argv[++i],nullptr,10); continue; }
@@ -164,21 +257,52 @@ static Args parse_args(int argc, char** argv) {
     if (t=="--uring-fixed-buf" && need_value(i)) { a.uring_fixed_buf = parse_bytes(argv[++i]); continue; }
     if (t=="--uring-submit-batch" && need_value(i)) { a.uring_submit_batch = std::strtoul(argv[++i], nullptr, 10); continue; }
     if (t=="--flush" && need_value(i)) { a.flush_mode = argv[++i]; continue; }
+    if (t=="--wal-format" && need_value(i)) { a.wal_format = argv[++i]; continue; }
     if (t=="--compaction-policy" && need_value(i)) { a.compaction_policy = argv[++i]; continue; }
     if (t=="--segment" && need_value(i)) { a.wal_segment_bytes = parse_bytes(argv[++i]); continue; }
+    if (t=="--replay-threads" && need_value(i)) { a.replay_threads = std::strtoul(argv[++i],nullptr,10); continue; }
     if (t=="--group-commit" && need_value(i)) { a.wal_group_commit = parse_bytes(argv[++i]); continue; }
     if (t=="--flush-threshold" && need_value(i)) { a.sst_flush_threshold = parse_bytes(argv[++i]); continue; }
     if (t=="--bg-compact" && need_value(i)) { if(!parse_bool(argv[++i], a.bg_compaction)) a.help=true; continue; }
     if (t=="--l0-threshold" && need_value(i)) { a.l0_compact_threshold = std::strtoul(argv[++i],nullptr,10); continue; }
+    if (t=="--level-base" && need_value(i)) { a.level_base_bytes = parse_bytes(argv[++i]); continue; }
+    if (t=="--level-multiplier" && need_value(i)) { a.level_multiplier = std::strtoul(argv[++i],nullptr,10); continue; }
+    if (t=="--max-levels" && need_value(i)) { a.max_levels = std::strtoul(argv[++i],nullptr,10); continue; }
+    if (t=="--compaction-threads" && need_value(i)) { a.compaction_threads = std::strtoul(argv[++i],nullptr,10); continue; }
+    if (t=="--subcompactions" && need_value(i)) { a.subcompactions = std::strtoul(argv[++i],nullptr,10); continue; }
+    if (t=="--manifest-max" && need_value(i)) { a.manifest_max_bytes = parse_bytes(argv[++i]); continue; }
     if (t=="--table-cache" && need_value(i)) { a.table_cache_capacity = std::strtoul(argv[++i],nullptr,10); continue; }
+    if (t=="--block-cache" && need_value(i)) { a.block_cache_bytes = parse_bytes(argv[++i]); continue; }
+    if (t=="--sst-format" && need_value(i)) { a.sst_format = std::strtoul(argv[++i],nullptr,10); continue; }
+    if (t=="--block-size" && need_value(i)) { a.sst_block_size = parse_bytes(argv[++i]); continue; }
+    if (t=="--sst-target-size" && need_value(i)) { a.sst_target_file = parse_bytes(argv[++i]); continue; }
+    if (t=="--bloom-bits" && need_value(i)) { a.bloom_bits = std::strtoul(argv[++i],nullptr,10); continue; }
+    if (t=="--blob-threshold" && need_value(i)) { a.blob_threshold = parse_bytes(argv[++i]); continue; }
+    if (t=="--blob-file-size" && need_value(i)) { a.blob_file_bytes = parse_bytes(argv[++i]); continue; }
+    if (t=="--blob-gc-ratio" && need_value(i)) { a.blob_gc_ratio = std::strtod(argv[++i], nullptr); continue; }
+    if (t=="--compression" && need_value(i)) { a.compression = argv[++i]; continue; }
+    if (t=="--compression-level" && need_value(i)) { a.compression_level = std::atoi(argv[++i]); continue; }
+    if (t=="--zstd-dict" && need_value(i)) { a.zstd_dict_bytes = static_cast<uint32_t>(parse_bytes(argv[++i])); continue; }
+    if (t=="--bg-rate" && need_value(i)) { a.bg_rate = parse_bytes(argv[++i]); continue; }
+    if (t=="--bg-rate-auto" && need_value(i)) { if(!parse_bool(argv[++i], a.bg_rate_auto)) a.help=true; continue; }
+    if (t=="--bg-ioprio" && need_value(i)) { if(!parse_bool(argv[++i], a.bg_ioprio)) a.help=true; continue; }
+    if (t=="--l0-slowdown" && need_value(i)) { a.l0_slowdown = std::strtoul(argv[++i],nullptr,10); continue; }
+    if (t=="--l0-stop" && need_value(i)) { a.l0_stop = std::strtoul(argv[++i],nullptr,10); continue; }
+    if (t=="--latency-hist" && need_value(i)) { if(!parse_bool(argv[++i], a.latency_hist)) a.help=true; continue; }
+    if (t=="--perf" && need_value(i)) { if(!parse_bool(argv[++i], a.perf)) a.help=true; continue; }
+    if (t=="--pinned" && need_value(i)) { if(!parse_bool(argv[++i], a.pinned)) a.help=true; continue; }
+    if (t=="--format" && need_value(i)) { a.format = argv[++i]; continue; }
 
     if (t=="--ops" && need_value(i)) { a.ops = std::strtoull(argv[++i],nullptr,10); continue; }
     if (t=="--ratio" && need_value(i)) { a.ratio = argv[++i]; continue; }
     if (t=="--key-len" && need_value(i)) { a.key_len = std::strtoul(argv[++i],nullptr,10); continue; }
     if (t=="--val-len" && need_value(i)) { a.val_len = std::strtoul(argv[++i],nullptr,10); continue; }
+    if (t=="--val-kind" && need_value(i)) { a.val_kind = argv[++i]; continue; }
     if (t=="--threads" && need_value(i)) { a.threads = std::strtoul(argv[++i],nullptr,10); continue; }
+    if (t=="--batch" && need_value(i)) { a.batch = std::max<uint64_t>(1, std::strtoull(argv[++i],nullptr,10)); continue; }
 
     if (t=="--key" && need_value(i)) { a.key = argv[++i]; continue; }
+    if (t=="--keys" && need_value(i)) { a.keys = argv[++i]; continue; }
     if (t=="--value" && need_value(i)) { a.value = argv[++i]; continue; }
     if (t=="--start" && need_value(i)) { a.start = argv[++i]; continue; }
     if (t=="--end" && need_value(i)) { a.end = argv[++i]; continue; }
@@ -223,6 +347,26 @@ static std::string rand_value(std::mt19937_64& rng, size_t len) {
   for (size_t i=0;i<len;++i) s[i]=static_cast<char>(dist(rng));
   return s;
 }
+// JSON-подобное значение: повторяющиеся имена полей, случайные числа/слова (сжимается)
+static std::string json_value(std::mt19937_64& rng, size_t len) {
+  static const char* words[] = {"alpha", "bravo", "charlie", "delta", "echo", "foxtrot", "golf", "hotel"};
+  std::string s = "{";
+  for (unsigned f = 0; s.size() < len; ++f) {
+    s += fmt::format("\"field{}\":", f % 16);
+    switch (rng() % 3) {
+      case 0:  s += std::to_string(rng() % 100000); break;
+      case 1:  s += fmt::format("\"{}\"", words[rng() % 8]); break;
+      default: s += (rng() & 1) ? "true" : "false"; break;
+    }
+    s += ',';
+  }
+  s.resize(len);
+  if (len) s.back() = '}';
+  return s;
+}
+static std::string gen_value(std::mt19937_64& rng, const Args& a) {
+  return a.val_kind == "json" ? json_value(rng, a.val_len) : rand_value(rng, a.val_len);
+}
 
 // ----------------------------
 // bench worker
@@ -230,14 +374,15 @@ static std::string rand_value(std::mt19937_64& rng, size_t len) {
 struct BenchStats {
   uint64_t put_cnt=0, get_cnt=0, del_cnt=0;
   std::vector<double> put_lat, get_lat, del_lat; // мкс
+  uint64_t put_allocs=0, get_allocs=0, del_allocs=0; // operator new внутри операций
+  uringkv::PerfContext get_perf, write_perf; // --perf: GET и PUT/DEL отдельно
 };
 
-static void bench_worker(unsigned tid, const Args& a, uringkv::KVOptions base_opts,
+// все потоки работают с одним KV (как реальные клиенты одной БД)
+static void bench_worker(unsigned tid, const Args& a, uringkv::KV& kv,
                          uint64_t ops, uint32_t pct_put, uint32_t pct_get, [[maybe_unused]]uint32_t pct_del,
                          BenchStats& out)
 {
-  uringkv::KV kv(base_opts);
-
   std::mt19937_64 rng(0xBADC0FFEEULL + tid);
   std::uniform_int_distribution<uint32_t> dice(1,100);
 
@@ -250,51 +395,555 @@ static void bench_worker(unsigned tid, const Args& a, uringkv::KVOptions base_op
 
   auto now = []{ return std::chrono::steady_clock::now(); };
 
+  // контекст потока копится через все операции; разбивка GET и записи —
+  // разности до/после операции
+  auto& pc = uringkv::get_perf_context();
+  if (a.perf) {
+    uringkv::set_perf_level(uringkv::PerfLevel::ENABLE_TIME);
+    pc.reset();
+  }
+  auto take_perf = [&](uringkv::PerfContext& dst) {
+    if (!a.perf) return;
+    dst += pc;
+    pc.reset();
+  };
+
+  uringkv::PinnableSlice pv; // держит значение до следующего GET
   for (uint64_t i=0;i<ops;++i) {
     uint32_t r = dice(rng);
     if (r <= pct_put) {
       std::string k = rand_key(rng, a.key_len);
-      std::string v = rand_value(rng, a.val_len);
+      std::string v = gen_value(rng, a);
+      const uint64_t a0 = t_allocs;
       auto t0 = now();
       kv.put(k, v);
       auto t1 = now();
+      out.put_allocs += t_allocs - a0;
+      take_perf(out.write_perf);
       out.put_lat.push_back(std::chrono::duration<double,std::micro>(t1-t0).count());
       ++out.put_cnt;
       if (keys.size()<100000) keys.push_back(std::move(k));
     } else if (r <= pct_put + pct_get) {
       if (keys.empty()) continue;
       const std::string& k = keys[rng()%keys.size()];
+      const uint64_t a0 = t_allocs;
       auto t0 = now();
-      (void)kv.get(k);
+      if (a.pinned) (void)kv.get(k, pv);
+      else (void)kv.get(k);
       auto t1 = now();
+      out.get_allocs += t_allocs - a0;
+      take_perf(out.get_perf);
       out.get_lat.push_back(std::chrono::duration<double,std::micro>(t1-t0).count());
       ++out.get_cnt;
     } else {
       if (keys.empty()) continue;
       const std::string& k = keys[rng()%keys.size()];
+      const uint64_t a0 = t_allocs;
       auto t0 = now();
       kv.del(k);
       auto t1 = now();
+      out.del_allocs += t_allocs - a0;
+      take_perf(out.write_perf);
       out.del_lat.push_back(std::chrono::duration<double,std::micro>(t1-t0).count());
       ++out.del_cnt;
     }
   }
+  if (a.perf) uringkv::set_perf_level(uringkv::PerfLevel::DISABLE);
+}
+
+// ----------------------------
+// sstbench: размер и скорость SST v2 vs v3 (и v3 со сжатием блоков)
+// ----------------------------
+static int run_sst_bench(const Args& a, const uringkv::KVOptions& opts) {
+  namespace fs = std::filesystem;
+  std::error_code ec;
+  fs::create_directories(a.path, ec);
+
+  const uint64_t n = std::max<uint64_t>(1, a.ops);
+  std::mt19937_64 rng(0x5571BE7CULL);
+
+  // отсортированные уникальные ключи фиксированной длины
+  std::vector<std::pair<std::string, std::optional<std::string>>> entries;
+  entries.reserve(n);
+  for (uint64_t i = 0; i < n; ++i) {
+    std::string k = fmt::format("{:0{}}", i, std::max<size_t>(a.key_len, 1));
+    entries.emplace_back(std::move(k), gen_value(rng, a));
+  }
+  const uint64_t logical = n * (a.key_len + a.val_len);
+
+  fmt::print("=== uringkv sstbench @ {} (records={}, key_len={}, val_len={}, val_kind={}, block={}B) ===\n",
+             a.path, n, a.key_len, a.val_len, a.val_kind, a.sst_block_size);
+
+  std::vector<uringkv::SstWriterOptions> configs = {
+      {.format_version = 2, .block_size = static_cast<uint32_t>(a.sst_block_size)},
+      {.format_version = 3, .block_size = static_cast<uint32_t>(a.sst_block_size)}};
+  if (opts.sst_compression != uringkv::SstCompression::NONE) {
+    if (!uringkv::sst_compression_supported(opts.sst_compression))
+      spdlog::warn("sstbench: {} is not built in", uringkv::sst_compression_name(opts.sst_compression));
+    configs.push_back({.format_version = 3, .block_size = static_cast<uint32_t>(a.sst_block_size),
+                       .compression = opts.sst_compression, .compression_level = opts.sst_compression_level,
+                       .zstd_dict_bytes = opts.sst_zstd_dict_bytes});
+  }
+
+  for (const auto& cfg : configs) {
+    const uint32_t ver = cfg.format_version;
+    const std::string name = cfg.compression == uringkv::SstCompression::NONE
+                                 ? fmt::format("v{}", ver)
+                                 : fmt::format("v3+{}{}", uringkv::sst_compression_name(cfg.compression),
+                                               cfg.zstd_dict_bytes ? "+dict" : "");
+    const auto path = (fs::path(a.path) / fmt::format("sstbench_{}.sst", name)).string();
+
+    auto t0 = std::chrono::steady_clock::now();
+    uint64_t raw_blocks = 0, stored_blocks = 0;
+    {
+      uringkv::SstWriter w(path, cfg);
+      if (!w.write_sorted(entries)) { spdlog::error("sstbench: write failed {}", path); return 1; }
+      raw_blocks = w.raw_block_bytes();
+      stored_blocks = w.stored_block_bytes();
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    const double wsec = std::chrono::duration<double>(t1 - t0).count();
+    const uint64_t fsize = fs::file_size(path, ec);
+
+    auto& cs = uringkv::sst_codec_stats();
+    cs.reset();
+    uringkv::SstTable tbl(path);
+    std::uniform_int_distribution<uint64_t> pick(0, n - 1);
+    uint64_t found = 0;
+    t0 = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < n; ++i) {
+      if (tbl.get(entries[pick(rng)].first)) ++found;
+    }
+    t1 = std::chrono::steady_clock::now();
+    const double gsec = std::chrono::duration<double>(t1 - t0).count();
+
+    t0 = std::chrono::steady_clock::now();
+    uringkv::SstReader rd(path);
+    const auto all = rd.scan(std::string_view{}, std::string_view{});
+    t1 = std::chrono::steady_clock::now();
+    const double ssec = std::chrono::duration<double>(t1 - t0).count();
+
+    fmt::print("{}: file={} B ({:.2f}x of raw kv)  write={:.1f} MB/s  get={} ops/s (found {}/{})  scan={} rec/s\n",
+               name, fsize, logical ? double(fsize) / double(logical) : 0.0,
+               double(logical) / 1e6 / std::max(wsec, 1e-9),
+               static_cast<uint64_t>(double(n) / std::max(gsec, 1e-9)), found, n,
+               static_cast<uint64_t>(double(all.size()) / std::max(ssec, 1e-9)));
+    const uint64_t dblocks = cs.blocks_decompressed.load(), dns = cs.decompress_ns.load();
+    if (cfg.compression != uringkv::SstCompression::NONE)
+      fmt::print("    blocks: raw={} B stored={} B ratio={:.2f}x  decode: blocks={} {:.0f} ns/block {:.0f} MB/s\n",
+                 raw_blocks, stored_blocks, stored_blocks ? double(raw_blocks) / double(stored_blocks) : 1.0,
+                 dblocks, dblocks ? double(dns) / double(dblocks) : 0.0,
+                 dns ? double(cs.bytes_decompressed.load()) * 1e3 / double(dns) : 0.0);
+  }
+  return 0;
+}
+
+// ----------------------------
+// indexbench: хеш-индекс v1 (слоты по 16 байт) против v2 (бакеты по 64 байта)
+// ----------------------------
+static int run_index_bench(const Args& a) {
+  namespace fs = std::filesystem;
+  std::error_code ec;
+  fs::create_directories(a.path, ec);
+
+  const uint64_t n = std::max<uint64_t>(1, a.ops);
+  std::mt19937_64 rng(0x1D8BE7CULL);
+  std::vector<std::pair<std::string, std::optional<std::string>>> entries;
+  entries.reserve(n);
+  for (uint64_t i = 0; i < n; ++i)
+    entries.emplace_back(fmt::format("{:0{}}", i, std::max<size_t>(a.key_len, 1)), rand_value(rng, a.val_len));
+
+  // хеши запросов считаются заранее: меряется только пробирование индекса
+  std::vector<uint64_t> hits(n), misses(n);
+  std::uniform_int_distribution<uint64_t> pick(0, n - 1);
+  for (uint64_t i = 0; i < n; ++i) {
+    const auto& k = entries[pick(rng)].first;
+    hits[i] = uringkv::sst_key_hash(k.data(), k.size());
+    const auto m = fmt::format("miss{}", rng());
+    misses[i] = uringkv::sst_key_hash(m.data(), m.size());
+  }
+
+  fmt::print("=== uringkv indexbench @ {} (records={}, key_len={}, val_len={}, simd={}) ===\n",
+             a.path, n, a.key_len, a.val_len, uringkv::hidx_simd_name());
+
+  for (uint32_t ver : {uringkv::kHidxVersionV1, uringkv::kHidxVersionV2}) {
+    const auto path = (fs::path(a.path) / fmt::format("indexbench_v{}.sst", ver)).string();
+    {
+      uringkv::SstWriter w(path, {.hash_index_version = ver});
+      if (!w.write_sorted(entries)) { spdlog::error("indexbench: write failed {}", path); return 1; }
+    }
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    uringkv::SstFooter f{};
+    uringkv::SstFooterExt ext{};
+    uringkv::MmapHashIndex idx;
+    if (fd < 0 || !uringkv::sst_read_footer(fd, f, ext) || !idx.open(fd, f.hash_index_offset, f.hash_table_size)) {
+      spdlog::error("indexbench: cannot open hash index of {}", path);
+      if (fd >= 0) ::close(fd);
+      return 1;
+    }
+
+    auto probe_ns = [&](const std::vector<uint64_t>& hs, auto&& probe_one) {
+      uint64_t cand = 0;
+      auto t0 = std::chrono::steady_clock::now();
+      for (uint64_t h : hs) cand += probe_one(h);
+      auto t1 = std::chrono::steady_clock::now();
+      return std::make_pair(std::chrono::duration<double, std::nano>(t1 - t0).count() / double(hs.size()), cand);
+    };
+    // кандидатов до первого (hit) / всех (miss): блоки не читаются
+    auto print_mode = [&](std::string_view mode, auto&& probe_one) {
+      const auto [hit_ns, hit_cand] = probe_ns(hits, probe_one);
+      const auto [miss_ns, miss_cand] = probe_ns(misses, probe_one);
+      fmt::print("  {:<7} probe: hit={:.1f} ns  miss={:.1f} ns  candidates/miss={:.4f}  (hits found {}/{})\n",
+                 mode, hit_ns, miss_ns, double(miss_cand) / double(n), hit_cand, n);
+    };
+
+    fmt::print("v{}: index={} B ({:.1f} B/key)\n", ver, idx.memory_usage(),
+               double(idx.memory_usage()) / double(n));
+    if (ver == uringkv::kHidxVersionV1) {
+      print_mode("slots", [&](uint64_t h) {
+        uint64_t c = 0;
+        idx.probe(h, [&](uint64_t) { ++c; return true; });
+        return c;
+      });
+    } else {
+      print_mode("scalar", [&](uint64_t h) {
+        uint64_t c = 0;
+        idx.probe<false>(h, [&](uint64_t) { ++c; return true; });
+        return c;
+      });
+      print_mode(uringkv::hidx_simd_name(), [&](uint64_t h) {
+        uint64_t c = 0;
+        idx.probe<true>(h, [&](uint64_t) { ++c; return true; });
+        return c;
+      });
+    }
+    idx.close();
+    ::close(fd);
+
+    uringkv::SstTable tbl(path);
+    uint64_t found = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < n; ++i)
+      if (tbl.get(entries[pick(rng)].first)) ++found;
+    auto t1 = std::chrono::steady_clock::now();
+    fmt::print("  get={} ops/s (found {}/{})\n",
+               static_cast<uint64_t>(double(n) / std::max(std::chrono::duration<double>(t1 - t0).count(), 1e-9)),
+               found, n);
+  }
+  return 0;
+}
+
+// ----------------------------
+// walbench: group commit на WAL-bound нагрузке
+// ----------------------------
+static int run_wal_bench(const Args& a, const uringkv::KVOptions& base) {
+  namespace fs = std::filesystem;
+  const unsigned th = std::max(1u, a.threads);
+
+  fmt::print("=== uringkv walbench @ {} (threads={}, ops={}, key_len={}, val_len={}, batch={}, fdatasync per commit) ===\n",
+             a.path, th, a.ops, a.key_len, a.val_len, a.batch);
+
+  for (auto fmt_kind : {uringkv::WalFormat::PADDED, uringkv::WalFormat::PACKED}) {
+    const bool packed = (fmt_kind == uringkv::WalFormat::PACKED);
+    const auto dir = (fs::path(a.path) / (packed ? "walbench_packed" : "walbench_padded")).string();
+    std::error_code ec;
+    fs::remove_all(dir, ec);
+    fs::create_directories(dir, ec);
+
+    uringkv::KVOptions o = base;
+    o.path = dir;
+    o.wal_format = fmt_kind;
+    o.wal_group_commit_bytes = 1;               // каждый commit — fdatasync
+    o.sst_flush_threshold_bytes = (1ull << 40); // измеряем только WAL
+    o.final_flush_on_close = false;
+    o.background_compaction = false;
+
+    double sec = 0.0;
+    uringkv::KVMetrics m;
+    {
+      uringkv::KV kv(o);
+      const uint64_t per = a.ops / th, rem = a.ops % th;
+      std::vector<std::thread> workers;
+      auto t0 = std::chrono::steady_clock::now();
+      for (unsigned i = 0; i < th; ++i) {
+        const uint64_t my_ops = per + (i < rem ? 1 : 0);
+        workers.emplace_back([&, i, my_ops] {
+          std::mt19937_64 rng(0x57A1BE7CULL + i);
+          if (a.batch <= 1) {
+            for (uint64_t j = 0; j < my_ops; ++j)
+              kv.put(rand_key(rng, a.key_len), gen_value(rng, a));
+            return;
+          }
+          uringkv::WriteBatch b;
+          for (uint64_t j = 0; j < my_ops; ++j) {
+            b.put(rand_key(rng, a.key_len), gen_value(rng, a));
+            if (b.count() == a.batch || j + 1 == my_ops) {
+              kv.write(b);
+              b.clear();
+            }
+          }
+        });
+      }
+      for (auto& t : workers) t.join();
+      sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+      m = kv.get_metrics();
+    }
+
+    fmt::print("{:6}: {} ops/s  wal_bytes={} ({:.1f} B/rec)  syncs={}  batches={} (avg {:.1f} rec/batch)\n",
+               packed ? "packed" : "padded",
+               static_cast<uint64_t>(double(m.puts) / std::max(sec, 1e-9)),
+               m.wal_bytes, m.puts ? double(m.wal_bytes) / double(m.puts) : 0.0,
+               m.wal_syncs, m.wal_batches,
+               m.wal_batches ? double(m.puts) / double(m.wal_batches) : 0.0);
+  }
+  return 0;
+}
+
+// Восстановление: WAL без SST (flush выключен), затем открытие с 1 потоком
+// воспроизведения и с --replay-threads. Файлы обычно в page cache — меряется
+// разбор/проверка и построение MemTable, а не холодное чтение с диска.
+static int run_recovery_bench(const Args& a, const uringkv::KVOptions& base) {
+  namespace fs = std::filesystem;
+  const unsigned th = std::max(1u, a.threads);
+  fmt::print("=== uringkv recoverybench @ {} (ops={}, key_len={}, val_len={}, segment={}B) ===\n",
+             a.path, a.ops, a.key_len, a.val_len, a.wal_segment_bytes);
+
+  for (auto fmt_kind : {uringkv::WalFormat::PADDED, uringkv::WalFormat::PACKED}) {
+    const bool packed = (fmt_kind == uringkv::WalFormat::PACKED);
+    const auto dir = (fs::path(a.path) / (packed ? "recoverybench_packed" : "recoverybench_padded")).string();
+    std::error_code ec;
+    fs::remove_all(dir, ec);
+    fs::create_directories(dir, ec);
+
+    uringkv::KVOptions o = base;
+    o.path = dir;
+    o.wal_format = fmt_kind;
+    o.wal_group_commit_bytes = (1ull << 40);    // fsync не нужен для замера
+    o.sst_flush_threshold_bytes = (1ull << 40); // всё остаётся в WAL
+    o.final_flush_on_close = false;
+    o.background_compaction = false;
+    {
+      uringkv::KV kv(o);
+      const uint64_t per = a.ops / th, rem = a.ops % th;
+      std::vector<std::thread> workers;
+      for (unsigned i = 0; i < th; ++i) {
+        const uint64_t my_ops = per + (i < rem ? 1 : 0);
+        workers.emplace_back([&, i, my_ops] {
+          std::mt19937_64 rng(0x5EC0FE5ULL + i);
+          for (uint64_t j = 0; j < my_ops; ++j)
+            kv.put(rand_key(rng, a.key_len), gen_value(rng, a));
+        });
+      }
+      for (auto& t : workers) t.join();
+    }
+
+    for (unsigned rt : {1u, a.replay_threads}) {
+      o.wal_replay_threads = rt;
+      uringkv::KV kv(o);
+      const auto m = kv.get_metrics();
+      const double sec = std::max(1e-9, double(m.wal_replay_us) / 1e6);
+      fmt::print("{:6} replay_threads={:<4}: startup={:.1f} ms  replay={:.1f} ms  records={}  wal={:.1f} MiB  "
+                 "{:.0f} MiB/s  {:.0f} rec/s\n",
+                 packed ? "packed" : "padded", rt ? std::to_string(rt) : std::string("auto"),
+                 double(m.startup_us) / 1e3, double(m.wal_replay_us) / 1e3, m.wal_replay_records,
+                 double(m.wal_replay_bytes) / (1024.0 * 1024.0),
+                 double(m.wal_replay_bytes) / (1024.0 * 1024.0) / sec, double(m.wal_replay_records) / sec);
+    }
+  }
+  return 0;
 }
 
 // ----------------------------
 // helpers for metrics printing
 // ----------------------------
+// сжатие блоков SST: коэффициент по записанным блокам, цена распаковки чтений с диска
+static void print_codec_line(const uringkv::KVMetrics& m) {
+  fmt::print("codec: raw={} stored={} ratio={:.2f}x decompressed_blocks={} decode={:.0f} ns/block ({:.0f} MB/s)\n",
+             m.sst_block_raw_bytes, m.sst_block_stored_bytes,
+             m.sst_block_stored_bytes ? double(m.sst_block_raw_bytes) / double(m.sst_block_stored_bytes) : 1.0,
+             m.sst_blocks_decompressed,
+             m.sst_blocks_decompressed ? double(m.sst_decompress_ns) / double(m.sst_blocks_decompressed) : 0.0,
+             m.sst_decompress_ns ? double(m.sst_decompressed_bytes) * 1e3 / double(m.sst_decompress_ns) : 0.0);
+}
+
+// фоновая запись и торможение записей (долг компактации, лимит, ожидания)
+static void print_stall_line(const uringkv::KVMetrics& m) {
+  fmt::print("bgio:  pending_compaction={} rate_limit={} flush_bytes={} compaction_bytes={} "
+             "flush_wait_us={} compaction_wait_us={} slowdowns={} stalls={} stall_us={}\n",
+             m.pending_compaction_bytes, m.bg_rate_limit, m.bg_flush_bytes, m.bg_compaction_bytes,
+             m.bg_flush_wait_us, m.bg_compaction_wait_us, m.write_slowdowns, m.write_stalls, m.write_stall_us);
+}
+
+// ---- metrics --format prometheus|json ----
+// Счётчики KVMetrics одной таблицей: имя (без префикса), тип Prometheus, справка
+struct MetricField {
+  const char* name;
+  uint64_t uringkv::KVMetrics::*field;
+  bool gauge;
+  const char* help;
+};
+
+static const MetricField kMetricFields[] = {
+  {"puts_total", &uringkv::KVMetrics::puts, false, "PUT operations"},
+  {"gets_total", &uringkv::KVMetrics::gets, false, "GET operations"},
+  {"dels_total", &uringkv::KVMetrics::dels, false, "DEL operations"},
+  {"range_deletes_total", &uringkv::KVMetrics::range_deletes, false, "Range tombstones written"},
+  {"range_del_dropped_keys_total", &uringkv::KVMetrics::range_del_dropped_keys, false, "Versions dropped under range tombstones"},
+  {"range_del_dropped_files_total", &uringkv::KVMetrics::range_del_dropped_files, false, "SSTs dropped whole under range tombstones"},
+  {"get_hits_total", &uringkv::KVMetrics::get_hits, false, "GETs that found a value"},
+  {"get_misses_total", &uringkv::KVMetrics::get_misses, false, "GETs that found nothing"},
+  {"wal_bytes_total", &uringkv::KVMetrics::wal_bytes, false, "WAL bytes appended"},
+  {"wal_syncs_total", &uringkv::KVMetrics::wal_syncs, false, "WAL fsync/fdatasync calls"},
+  {"wal_batches_total", &uringkv::KVMetrics::wal_batches, false, "WAL group-commit batches"},
+  {"sst_flushes_total", &uringkv::KVMetrics::sst_flushes, false, "MemTable flushes"},
+  {"compactions_total", &uringkv::KVMetrics::compactions, false, "Compactions"},
+  {"subcompactions_total", &uringkv::KVMetrics::subcompactions, false, "Compaction key-range parts"},
+  {"compactions_running", &uringkv::KVMetrics::compactions_running, true, "Compactions running now"},
+  {"compaction_parallel_peak", &uringkv::KVMetrics::compaction_parallel_peak, true, "Peak concurrent compactions"},
+  {"table_cache_hits_total", &uringkv::KVMetrics::table_cache_hits, false, "Table cache hits"},
+  {"table_cache_misses_total", &uringkv::KVMetrics::table_cache_misses, false, "Table cache misses"},
+  {"table_cache_opens_total", &uringkv::KVMetrics::table_cache_opens, false, "Tables opened"},
+  {"table_cache_evictions_total", &uringkv::KVMetrics::table_cache_evictions, false, "Tables evicted"},
+  {"table_cache_open_us_total", &uringkv::KVMetrics::table_cache_open_us, false, "Time spent opening tables, us"},
+  {"table_cache_open_max_us", &uringkv::KVMetrics::table_cache_open_max_us, true, "Slowest table open, us"},
+  {"table_cache_files", &uringkv::KVMetrics::table_cache_files, true, "Tables open now"},
+  {"table_cache_pinned_bytes", &uringkv::KVMetrics::table_cache_pinned_bytes, true, "Index and filter bytes of open tables"},
+  {"block_cache_hits_total", &uringkv::KVMetrics::block_cache_hits, false, "Block cache hits"},
+  {"block_cache_misses_total", &uringkv::KVMetrics::block_cache_misses, false, "Block cache misses"},
+  {"block_cache_evictions_total", &uringkv::KVMetrics::block_cache_evictions, false, "Block cache evictions"},
+  {"block_cache_usage_bytes", &uringkv::KVMetrics::block_cache_usage, true, "Block cache usage"},
+  {"bloom_checks_total", &uringkv::KVMetrics::bloom_checks, false, "Bloom filter checks"},
+  {"bloom_useful_total", &uringkv::KVMetrics::bloom_useful, false, "Tables skipped by bloom"},
+  {"bloom_hits_total", &uringkv::KVMetrics::bloom_hits, false, "Bloom positives with the key found"},
+  {"bloom_false_positives_total", &uringkv::KVMetrics::bloom_false_positives, false, "Bloom false positives"},
+  {"blob_files", &uringkv::KVMetrics::blob_files, true, "Blob files"},
+  {"blob_bytes", &uringkv::KVMetrics::blob_bytes, true, "Bytes in blob files"},
+  {"blob_garbage_bytes", &uringkv::KVMetrics::blob_garbage_bytes, true, "Dead bytes in blob files"},
+  {"blob_bytes_written_total", &uringkv::KVMetrics::blob_bytes_written, false, "Blob bytes written"},
+  {"blob_gc_runs_total", &uringkv::KVMetrics::blob_gc_runs, false, "Blob GC runs"},
+  {"blob_gc_relocated_bytes_total", &uringkv::KVMetrics::blob_gc_relocated_bytes, false, "Live bytes moved by blob GC"},
+  {"blob_files_deleted_total", &uringkv::KVMetrics::blob_files_deleted, false, "Blob files deleted"},
+  {"sst_block_raw_bytes_total", &uringkv::KVMetrics::sst_block_raw_bytes, false, "SST block bytes before compression"},
+  {"sst_block_stored_bytes_total", &uringkv::KVMetrics::sst_block_stored_bytes, false, "SST block bytes after compression"},
+  {"sst_blocks_decompressed_total", &uringkv::KVMetrics::sst_blocks_decompressed, false, "SST blocks decompressed (process)"},
+  {"sst_decompressed_bytes_total", &uringkv::KVMetrics::sst_decompressed_bytes, false, "SST bytes decompressed (process)"},
+  {"sst_decompress_ns_total", &uringkv::KVMetrics::sst_decompress_ns, false, "Time spent decompressing, ns (process)"},
+  {"pending_compaction_bytes", &uringkv::KVMetrics::pending_compaction_bytes, true, "Estimated compaction debt"},
+  {"bg_rate_limit_bytes", &uringkv::KVMetrics::bg_rate_limit, true, "Background write limit, bytes/s (0 = off)"},
+  {"bg_flush_bytes_total", &uringkv::KVMetrics::bg_flush_bytes, false, "Bytes written by flush"},
+  {"bg_compaction_bytes_total", &uringkv::KVMetrics::bg_compaction_bytes, false, "Bytes written by compaction"},
+  {"bg_flush_wait_us_total", &uringkv::KVMetrics::bg_flush_wait_us, false, "Flush wait for rate limiter, us"},
+  {"bg_compaction_wait_us_total", &uringkv::KVMetrics::bg_compaction_wait_us, false, "Compaction wait for rate limiter, us"},
+  {"write_slowdowns_total", &uringkv::KVMetrics::write_slowdowns, false, "Write groups delayed"},
+  {"write_stalls_total", &uringkv::KVMetrics::write_stalls, false, "Write stops"},
+  {"write_stall_us_total", &uringkv::KVMetrics::write_stall_us, false, "Time in write delays and stops, us"},
+  {"mem_bytes", &uringkv::KVMetrics::mem_bytes, true, "MemTable bytes"},
+  {"sst_count", &uringkv::KVMetrics::sst_count, true, "Live SST files"},
+  {"live_versions", &uringkv::KVMetrics::live_versions, true, "Live tree versions"},
+  {"sst_files_deleted_total", &uringkv::KVMetrics::sst_files_deleted, false, "SST files deleted"},
+  {"manifest_bytes", &uringkv::KVMetrics::manifest_bytes, true, "MANIFEST log size"},
+  {"manifest_edits", &uringkv::KVMetrics::manifest_edits, true, "MANIFEST edits since last snapshot"},
+  {"manifest_rewrites_total", &uringkv::KVMetrics::manifest_rewrites, false, "MANIFEST rewrites"},
+  {"startup_us", &uringkv::KVMetrics::startup_us, true, "Open time, us"},
+  {"wal_replay_us", &uringkv::KVMetrics::wal_replay_us, true, "WAL replay time, us"},
+  {"wal_replay_records", &uringkv::KVMetrics::wal_replay_records, true, "WAL records replayed"},
+  {"wal_replay_bytes", &uringkv::KVMetrics::wal_replay_bytes, true, "WAL bytes read on replay"},
+};
+
+struct LatencyField {
+  const char* op;
+  uringkv::LatencyStats uringkv::KVMetrics::*field;
+};
+
+static const LatencyField kLatencyFields[] = {
+  {"put", &uringkv::KVMetrics::put_latency},
+  {"get", &uringkv::KVMetrics::get_latency},
+  {"del", &uringkv::KVMetrics::del_latency},
+  {"scan", &uringkv::KVMetrics::scan_latency},
+  {"flush", &uringkv::KVMetrics::flush_latency},
+  {"compaction", &uringkv::KVMetrics::compaction_latency},
+  {"wal_sync", &uringkv::KVMetrics::wal_sync_latency},
+};
+
+// Prometheus text exposition: счётчики/gauge и summary задержек в секундах
+static void print_metrics_prometheus(const uringkv::KVMetrics& m) {
+  for (const auto& f : kMetricFields) {
+    fmt::print("# HELP uringkv_{} {}\n# TYPE uringkv_{} {}\nuringkv_{} {}\n",
+               f.name, f.help, f.name, f.gauge ? "gauge" : "counter", f.name, m.*f.field);
+  }
+  fmt::print("# HELP uringkv_op_latency_seconds Operation latency (enable with --latency-hist on)\n"
+             "# TYPE uringkv_op_latency_seconds summary\n");
+  for (const auto& l : kLatencyFields) {
+    const auto& s = m.*l.field;
+    const std::pair<const char*, uint64_t> qs[] = {
+      {"0.5", s.p50_ns}, {"0.9", s.p90_ns}, {"0.99", s.p99_ns}, {"0.999", s.p999_ns}, {"1", s.max_ns}};
+    for (const auto& [q, ns] : qs)
+      fmt::print("uringkv_op_latency_seconds{{op=\"{}\",quantile=\"{}\"}} {:.9f}\n", l.op, q, double(ns) / 1e9);
+    fmt::print("uringkv_op_latency_seconds_sum{{op=\"{}\"}} {:.9f}\n", l.op, double(s.sum_ns) / 1e9);
+    fmt::print("uringkv_op_latency_seconds_count{{op=\"{}\"}} {}\n", l.op, s.count);
+  }
+}
+
+// одна строка JSON: {"name": value, ..., "latency": {"get": {...}, ...}}
+static void print_metrics_json(const uringkv::KVMetrics& m) {
+  fmt::print("{{");
+  for (const auto& f : kMetricFields) fmt::print("\"{}\":{},", f.name, m.*f.field);
+  fmt::print("\"latency\":{{");
+  for (const auto& l : kLatencyFields) {
+    const auto& s = m.*l.field;
+    fmt::print("{}\"{}\":{{\"count\":{},\"sum_ns\":{},\"p50_ns\":{},\"p90_ns\":{},\"p99_ns\":{},"
+               "\"p999_ns\":{},\"max_ns\":{}}}",
+               &l == kLatencyFields ? "" : ",", l.op, s.count, s.sum_ns, s.p50_ns, s.p90_ns, s.p99_ns,
+               s.p999_ns, s.max_ns);
+  }
+  fmt::print("}}}}\n");
+}
+
+// задержки из гистограмм KV (только с --latency-hist / --perf)
+static void print_latency_lines(const uringkv::KVMetrics& m) {
+  for (const auto& l : kLatencyFields) {
+    const auto& s = m.*l.field;
+    if (!s.count) continue;
+    fmt::print("lat:   {:<10} n={} avg={:.2f}us p50={:.2f}us p90={:.2f}us p99={:.2f}us p99.9={:.2f}us max={:.2f}us\n",
+               l.op, s.count, double(s.sum_ns) / double(s.count) / 1e3, s.p50_ns / 1e3, s.p90_ns / 1e3,
+               s.p99_ns / 1e3, s.p999_ns / 1e3, s.max_ns / 1e3);
+  }
+}
+
 static void print_metrics_once(const uringkv::KVMetrics& m) {
   auto hit_total = m.get_hits + m.get_misses;
   double hit_rate = hit_total ? (100.0 * double(m.get_hits) / double(hit_total)) : 0.0;
 
   fmt::print("=== uringkv metrics ===\n");
-  fmt::print("ops:   puts={} gets={} dels={}\n", m.puts, m.gets, m.dels);
+  fmt::print("ops:   puts={} gets={} dels={} range_dels={}\n", m.puts, m.gets, m.dels, m.range_deletes);
   fmt::print("gets:  hits={} misses={} hit_rate={:.2f}%\n", m.get_hits, m.get_misses, hit_rate);
-  fmt::print("wal:   bytes_written={}\n", m.wal_bytes);
-  fmt::print("sst:   flushes={} compactions={} sst_count={}\n", m.sst_flushes, m.compactions, m.sst_count);
+  fmt::print("wal:   bytes_written={} syncs={} batches={}\n", m.wal_bytes, m.wal_syncs, m.wal_batches);
+  fmt::print("sst:   flushes={} compactions={} subcompactions={} running={} parallel_peak={} sst_count={}\n",
+             m.sst_flushes, m.compactions, m.subcompactions, m.compactions_running, m.compaction_parallel_peak,
+             m.sst_count);
   fmt::print("mem:   mem_bytes={}\n", m.mem_bytes);
-  fmt::print("tcache:hits={} misses={} opens={}\n", m.table_cache_hits, m.table_cache_misses, m.table_cache_opens);
+  const double open_avg_us = m.table_cache_opens ? double(m.table_cache_open_us) / double(m.table_cache_opens) : 0.0;
+  fmt::print("tcache:hits={} misses={} opens={} evictions={} files={} pinned={} open_avg={:.1f}us open_max={}us\n",
+             m.table_cache_hits, m.table_cache_misses, m.table_cache_opens, m.table_cache_evictions,
+             m.table_cache_files, m.table_cache_pinned_bytes, open_avg_us, m.table_cache_open_max_us);
+  fmt::print("rdel:  dropped_keys={} dropped_files={}\n", m.range_del_dropped_keys, m.range_del_dropped_files);
+  fmt::print("vers:  live={} sst_deleted={} manifest_bytes={} manifest_edits={} manifest_rewrites={}\n",
+             m.live_versions, m.sst_files_deleted, m.manifest_bytes, m.manifest_edits, m.manifest_rewrites);
+  fmt::print("bcache:hits={} misses={} evictions={} usage={}\n", m.block_cache_hits,
+             m.block_cache_misses, m.block_cache_evictions, m.block_cache_usage);
+  fmt::print("bloom: checks={} useful={} hits={} false_positives={}\n", m.bloom_checks, m.bloom_useful,
+             m.bloom_hits, m.bloom_false_positives);
+  const uint64_t blob_live = m.blob_bytes - std::min(m.blob_bytes, m.blob_garbage_bytes);
+  fmt::print("blob:  files={} bytes={} garbage={} space_amp={:.2f} written={} gc_runs={} gc_relocated={} "
+             "files_deleted={}\n",
+             m.blob_files, m.blob_bytes, m.blob_garbage_bytes,
+             blob_live ? double(m.blob_bytes) / double(blob_live) : 1.0, m.blob_bytes_written, m.blob_gc_runs,
+             m.blob_gc_relocated_bytes, m.blob_files_deleted);
+  print_codec_line(m);
+  print_stall_line(m);
+  fmt::print("open:  startup_us={} wal_replay_us={} replayed_records={} replayed_bytes={}\n", m.startup_us,
+             m.wal_replay_us, m.wal_replay_records, m.wal_replay_bytes);
+  print_latency_lines(m);
 }
 
 static void print_metrics_diff(const uringkv::KVMetrics& prev, const uringkv::KVMetrics& cur, double dt_sec) {
@@ -352,10 +1001,41 @@ int main(int argc, char** argv) {
   opts.uring_submit_batch          = a.uring_submit_batch;  // NEW
   opts.wal_max_segment_bytes       = a.wal_segment_bytes;
   opts.wal_group_commit_bytes      = a.wal_group_commit;
+  opts.wal_replay_threads          = a.replay_threads;
   opts.sst_flush_threshold_bytes   = a.sst_flush_threshold;
   opts.background_compaction       = a.bg_compaction;
   opts.l0_compact_threshold        = a.l0_compact_threshold;
+  opts.level_base_bytes            = a.level_base_bytes;
+  opts.level_size_multiplier       = a.level_multiplier;
+  opts.max_levels                  = a.max_levels;
+  opts.compaction_threads          = a.compaction_threads;
+  opts.max_subcompactions          = a.subcompactions;
+  opts.manifest_max_bytes          = a.manifest_max_bytes;
   opts.table_cache_capacity        = a.table_cache_capacity;
+  opts.block_cache_bytes           = a.block_cache_bytes;
+  opts.sst_format_version          = a.sst_format;
+  opts.sst_block_size              = a.sst_block_size;
+  opts.sst_target_file_bytes       = a.sst_target_file;
+  opts.bloom_bits_per_key          = a.bloom_bits;
+  opts.blob_value_threshold        = a.blob_threshold;
+  opts.blob_file_bytes             = a.blob_file_bytes;
+  opts.blob_gc_garbage_ratio       = a.blob_gc_ratio;
+  opts.sst_compression_level       = a.compression_level;
+  opts.sst_zstd_dict_bytes         = a.zstd_dict_bytes;
+  opts.bg_rate_bytes_per_sec       = a.bg_rate;
+  opts.bg_rate_auto_tune           = a.bg_rate_auto;
+  opts.bg_io_low_priority          = a.bg_ioprio;
+  opts.l0_slowdown_trigger         = a.l0_slowdown;
+  opts.l0_stop_trigger             = a.l0_stop;
+  opts.latency_histograms          = a.latency_hist || (a.mode == "bench" && a.perf);
+  if (!uringkv::parse_sst_compression(a.compression, opts.sst_compression)) {
+    spdlog::error("Unknown --compression '{}'", a.compression);
+    return 2;
+  }
+  if (a.val_kind != "random" && a.val_kind != "json") {
+    spdlog::error("Unknown --val-kind '{}'", a.val_kind);
+    return 2;
+  }
 
   // flush mode
   if (a.flush_mode == "fdatasync") opts.flush_mode = uringkv::FlushMode::FDATASYNC;
@@ -363,6 +1043,10 @@ int main(int argc, char** argv) {
   else if (a.flush_mode == "sfr")   opts.flush_mode = uringkv::FlushMode::SYNC_FILE_RANGE;
   else { spdlog::error("Unknown --flush '{}'", a.flush_mode); return 2; }
 
+  if (a.wal_format == "padded") opts.wal_format = uringkv::WalFormat::PADDED;
+  else if (a.wal_format == "packed") opts.wal_format = uringkv::WalFormat::PACKED;
+  else { spdlog::error("Unknown --wal-format '{}'", a.wal_format); return 2; }
+
   // compaction policy (leveled заглушка)
   if (a.compaction_policy == "size-tiered") opts.compaction_policy = uringkv::CompactionPolicy::SIZE_TIERED;
   else if (a.compaction_policy == "leveled") opts.compaction_policy = uringkv::CompactionPolicy::LEVELED;
@@ -397,6 +1081,22 @@ int main(int argc, char** argv) {
     return 0;
   }
 
+  if (a.mode == "mget") {
+    if (a.keys.empty()) { spdlog::error("mget: --keys required"); return 2; }
+    std::vector<std::string_view> keys;
+    for (std::string_view rest = a.keys; !rest.empty();) {
+      const auto comma = rest.find(',');
+      keys.push_back(rest.substr(0, comma));
+      rest = comma == std::string_view::npos ? std::string_view{} : rest.substr(comma + 1);
+    }
+    uringkv::KV kv(opts);
+    if (!kv.init_storage_layout()) { spdlog::error("init failed"); return 1; }
+    auto vals = kv.multi_get(keys);
+    for (std::size_t i = 0; i < keys.size(); ++i)
+      fmt::print("{} {}\n", keys[i], vals[i] ? *vals[i] : std::string("(nil)"));
+    return 0;
+  }
+
   if (a.mode == "del") {
     if (a.key.empty()) { spdlog::error("del: --key required"); return 2; }
     uringkv::KV kv(opts);
@@ -406,6 +1106,19 @@ int main(int argc, char** argv) {
     return ok ? 0 : 1;
   }
 
+  if (a.mode == "delrange" || a.mode == "delprefix") {
+    const bool prefix = a.mode == "delprefix";
+    if (prefix ? a.key.empty() : a.start.empty() || a.end.empty()) {
+      spdlog::error("{}: {} required", a.mode, prefix ? "--key" : "--start and --end");
+      return 2;
+    }
+    uringkv::KV kv(opts);
+    if (!kv.init_storage_layout()) { spdlog::error("init failed"); return 1; }
+    bool ok = prefix ? kv.delete_prefix(a.key) : kv.delete_range(a.start, a.end);
+    fmt::print("{}\n", ok ? "OK" : "ERR");
+    return ok ? 0 : 1;
+  }
+
   if (a.mode == "scan") {
     uringkv::KV kv(opts);
     if (!kv.init_storage_layout()) { spdlog::error("init failed"); return 1; }
@@ -416,14 +1129,27 @@ int main(int argc, char** argv) {
     return 0;
   }
 
+  if (a.mode == "sstbench") {
+    return run_sst_bench(a, opts);
+  }
+
+  if (a.mode == "indexbench") {
+    return run_index_bench(a);
+  }
+
+  if (a.mode == "walbench") {
+    return run_wal_bench(a, opts);
+  }
+
+  if (a.mode == "recoverybench") {
+    return run_recovery_bench(a, opts);
+  }
+
   if (a.mode == "bench") {
-    // init layout once
-    {
-      uringkv::KV kv(opts);
-      if (!kv.init_storage_layout()) {
-        spdlog::error("Failed to init storage layout at {}", a.path);
-        return 1;
-      }
+    uringkv::KV kv(opts);
+    if (!kv.init_storage_layout()) {
+      spdlog::error("Failed to init storage layout at {}", a.path);
+      return 1;
     }
 
     unsigned th = std::max(1u, a.threads);
@@ -436,7 +1162,7 @@ int main(int argc, char** argv) {
 
     for (unsigned i=0;i<th;++i) {
       uint64_t my_ops = per + (i < rem ? 1 : 0);
-      workers.emplace_back(bench_worker, i, a, opts, my_ops, putP, getP, delP, std::ref(stats[i]));
+      workers.emplace_back(bench_worker, i, std::cref(a), std::ref(kv), my_ops, putP, getP, delP, std::ref(stats[i]));
     }
     for (auto& t : workers) t.join();
 
@@ -446,46 +1172,87 @@ int main(int argc, char** argv) {
     BenchStats tot;
     for (auto& s : stats) {
       tot.put_cnt += s.put_cnt; tot.get_cnt += s.get_cnt; tot.del_cnt += s.del_cnt;
+      tot.get_perf += s.get_perf; tot.write_perf += s.write_perf;
+      tot.put_allocs += s.put_allocs; tot.get_allocs += s.get_allocs; tot.del_allocs += s.del_allocs;
       tot.put_lat.insert(tot.put_lat.end(), s.put_lat.begin(), s.put_lat.end());
       tot.get_lat.insert(tot.get_lat.end(), s.get_lat.begin(), s.get_lat.end());
       tot.del_lat.insert(tot.del_lat.end(), s.del_lat.begin(), s.del_lat.end());
     }
 
-    auto print_class = [&](std::string_view name, uint64_t cnt, std::vector<double>& lat){
+    auto print_class = [&](std::string_view name, uint64_t cnt, std::vector<double>& lat, uint64_t allocs){
       double tps = cnt / sec;
       double p50 = percentile(lat, 50.0);
       double p95 = percentile(lat, 95.0);
       double p99 = percentile(lat, 99.0);
-      fmt::print("{}: ops={} ({} ops/s)  latency_us: p50={:.2f} p95={:.2f} p99={:.2f}\n",
-                 name, cnt, static_cast<uint64_t>(tps), p50, p95, p99);
+      fmt::print("{}: ops={} ({} ops/s)  latency_us: p50={:.2f} p95={:.2f} p99={:.2f}  allocs/op={:.2f}\n",
+                 name, cnt, static_cast<uint64_t>(tps), p50, p95, p99, cnt ? double(allocs) / cnt : 0.0);
     };
 
     fmt::print("=== uringkv bench @ {} (threads={}, ratio={} PUT:GET:DEL) ===\n",
                a.path, th, a.ratio);
     fmt::print("opts: uring={} qd={} sqpoll={} fixed_buf={}B submit_batch={} "
-               "segment={}B group-commit={}B flush={} bg_compact={} l0_thr={} table_cache={} policy={}\n",
+               "wal={} segment={}B group-commit={}B flush={} bg_compact={} l0_thr={} table_cache={} policy={} "
+               "compression={} val_kind={} bg_rate={}{} pinned_get={}\n",
                (a.use_uring?"on":"off"), a.uring_qd, (a.uring_sqpoll?"on":"off"),
                a.uring_fixed_buf, a.uring_submit_batch,
-               a.wal_segment_bytes, a.wal_group_commit, a.flush_mode,
-               (a.bg_compaction?"on":"off"), a.l0_compact_threshold, a.table_cache_capacity, a.compaction_policy);
+               a.wal_format, a.wal_segment_bytes, a.wal_group_commit, a.flush_mode,
+               (a.bg_compaction?"on":"off"), a.l0_compact_threshold, a.table_cache_capacity, a.compaction_policy,
+               a.compression, a.val_kind, a.bg_rate, a.bg_rate_auto ? "(auto)" : "",
+               (a.pinned?"on":"off"));
     fmt::print("total ops: {}  elapsed: {:.3f} s  overall: {} ops/s\n\n",
                a.ops, sec, static_cast<uint64_t>(a.ops/sec));
 
-    print_class("PUT", tot.put_cnt, tot.put_lat);
-    print_class("GET", tot.get_cnt, tot.get_lat);
-    print_class("DEL", tot.del_cnt, tot.del_lat);
+    print_class("PUT", tot.put_cnt, tot.put_lat, tot.put_allocs);
+    print_class("GET", tot.get_cnt, tot.get_lat, tot.get_allocs);
+    print_class("DEL", tot.del_cnt, tot.del_lat, tot.del_allocs);
+    const auto bm = kv.get_metrics();
+    print_codec_line(bm);
+    print_stall_line(bm);
+    if (a.perf) {
+      // средние на операцию по стадиям
+      const auto& g = tot.get_perf;
+      const double n = tot.get_cnt ? double(tot.get_cnt) : 1.0;
+      fmt::print("\nGET stages (avg ns/op): memtable={:.0f} table_cache={:.0f} (open={:.0f}) filter={:.0f} "
+                 "index={:.0f} block={:.0f} (checksum={:.0f} decompress={:.0f}) record={:.0f} blob={:.0f}\n",
+                 g.get_memtable_ns / n, g.get_table_cache_ns / n, g.table_open_ns / n, g.get_filter_ns / n,
+                 g.index_probe_ns / n, g.block_read_ns / n, g.block_checksum_ns / n, g.block_decompress_ns / n,
+                 g.record_read_ns / n, g.blob_read_ns / n);
+      fmt::print("GET perf: {}\n", g.to_string());
+      const auto& w = tot.write_perf;
+      const double nw = (tot.put_cnt + tot.del_cnt) ? double(tot.put_cnt + tot.del_cnt) : 1.0;
+      fmt::print("write stages (avg ns/op): delay={:.0f} wal={:.0f} memtable={:.0f}\n",
+                 w.write_delay_ns / nw, w.write_wal_ns / nw, w.write_memtable_ns / nw);
+      print_latency_lines(bm);
+    }
 
     fmt::print("\nallocations: alloc={} free={}\n", g_allocs.load(), g_frees.load());
     return 0;
   }
 
   if (a.mode == "metrics") {
+    if (a.format != "text" && a.format != "prometheus" && a.format != "json") {
+      spdlog::error("Unknown --format '{}'", a.format);
+      return 2;
+    }
+    // журнал KV — в stderr: stdout остаётся под выгрузку метрик
+    if (a.format != "text") spdlog::set_default_logger(spdlog::stderr_color_mt("uringkv"));
     uringkv::KV kv(opts);
     if (!kv.init_storage_layout()) {
       spdlog::error("Failed to init storage layout at {}", a.path);
       return 1;
     }
 
+    if (a.format != "text") {
+      const auto print = a.format == "json" ? print_metrics_json : print_metrics_prometheus;
+      print(kv.get_metrics());
+      while (a.watch) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(static_cast<int>(a.watch_interval_sec * 1000)));
+        print(kv.get_metrics());
+        std::fflush(stdout);
+      }
+      return 0;
+    }
+
     auto snap = kv.get_metrics();
     print_metrics_once(snap);
     fmt::print("alloc: alloc={} free={}\n", g_allocs.load(), g_frees.load());
@@ -0,0 +1,531 @@
+// uringkv_bench: фазы в духе db_bench (fillseq, fillrandom, overwrite, readrandom,
+// seekrandom) и YCSB A–F поверх одного KV. Задержки — в гистограммах
+// (LatencyHistogram, нс), отдельно для прогрева и установившегося режима.
+#include "histogram.hpp"
+#include "kv.hpp"
+#include "sst/compression.hpp"
+#include "workload.hpp"
+
+#include <spdlog/spdlog.h>
+#include <spdlog/sinks/stdout_color_sinks.h>
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <memory>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#ifndef URINGKV_BUILD_COMMIT
+#define URINGKV_BUILD_COMMIT ""
+#endif
+
+using namespace uringkv;
+using namespace uringkv::bench;
+
+namespace {
+
+// ----------------------------
+// Аргументы
+// ----------------------------
+struct Args {
+  std::string path = "/tmp/uringkv_bench";
+  bool fresh = true;                 // удалить path перед запуском
+  std::string benchmarks = "fillrandom,readrandom";
+  uint64_t num = 100000;             // ключей в fill/preload
+  uint64_t ops = 0;                  // операций в остальных фазах, 0 = num
+  uint64_t warmup_ops = UINT64_MAX;  // первые операции фазы — прогрев; по умолчанию ops/10
+  unsigned threads = 1;
+  std::size_t key_len = 16;
+  std::size_t val_len = 100;
+  std::string distribution = "default"; // default = своё у каждой фазы
+  double zipf_theta = 0.99;
+  double hot_set = 0.2;
+  double hot_ops = 0.8;
+  unsigned seek_nexts = 10;          // seekrandom: next() после seek
+  unsigned scan_len = 100;           // YCSB E: длина scan равномерно в [1, scan_len]
+  bool preload = false;              // загрузить num ключей (по порядку) перед фазами
+  std::string json;                  // файл отчёта, "-" = stdout
+  uint64_t seed = 0xB3AC4ULL;
+
+  // KV
+  bool use_uring = false;
+  unsigned uring_qd = 256;
+  std::string flush_mode = "fdatasync";
+  std::string wal_format = "padded";
+  uint64_t wal_group_commit = 1ull << 20;
+  uint64_t flush_threshold = 4ull * 1024 * 1024;
+  bool bg_compaction = true;
+  std::string compaction_policy = "size-tiered";
+  unsigned compaction_threads = 1;
+  uint64_t block_cache = 32ull * 1024 * 1024;
+  uint32_t bloom_bits = 10;
+  uint32_t sst_format = 3;
+  std::string compression = "none";
+
+  bool help = false;
+};
+
+void print_usage(const char* prog) {
+  fmt::print(
+R"(Usage:
+  {0} [options]
+
+Workload:
+  --benchmarks LIST      : comma-separated phases, run in order (default: fillrandom,readrandom)
+                           fillseq, fillrandom    write --num keys in order / in random order
+                           overwrite              --ops updates of existing keys
+                           readrandom             --ops gets
+                           seekrandom             --ops iterator seeks + --seek-nexts next()
+                           ycsba .. ycsbf         YCSB core workloads A-F over the loaded keys
+  --num N                : keys written by fill phases and --preload (default: 100000)
+  --ops N                : operations per non-fill phase (default: --num)
+  --preload on|off       : load --num keys in order before the phases (YCSB load) (default: off)
+  --threads N            : client threads sharing one KV (default: 1)
+  --key-len N            : key length bytes (default: 16)
+  --val-len N            : value length bytes (default: 100)
+  --distribution D       : default|uniform|zipfian|latest|hotspot; default = per phase
+                           (YCSB: zipfian, D: latest; db_bench phases: uniform)
+  --zipf-theta X         : zipfian skew (default: 0.99)
+  --hot-set F            : hotspot: share of keys that are hot (default: 0.2)
+  --hot-ops F            : hotspot: share of operations going to hot keys (default: 0.8)
+  --seek-nexts N         : seekrandom: next() calls after each seek (default: 10)
+  --scan-len N           : YCSB E: scan length uniform in [1, N] (default: 100)
+  --warmup-ops N         : first N operations of each phase are reported as warmup (default: ops/10)
+  --json FILE            : write the report as JSON, '-' = stdout instead of the text report
+  --seed N               : RNG seed (default: fixed)
+
+KV options:
+  --path DIR             : data path (default: /tmp/uringkv_bench)
+  --fresh on|off         : remove DIR before the run (default: on)
+  --use-uring on|off     : io_uring for WAL and batched reads (default: off)
+  --queue-depth N        : io_uring QD (default: 256)
+  --flush fdatasync|fsync|sfr (default: fdatasync)
+  --wal-format padded|packed (default: padded)
+  --group-commit BYTES   : WAL group-commit threshold (default: 1MiB)
+  --flush-threshold BYTES: MemTable size that triggers a flush (default: 4MiB)
+  --bg-compact on|off    : background compaction (default: on)
+  --compaction-policy size-tiered|leveled (default: size-tiered)
+  --compaction-threads N : (default: 1)
+  --block-cache BYTES    : (default: 32MiB)
+  --bloom-bits N         : (default: 10)
+  --sst-format 2|3       : (default: 3)
+  --compression none|lz4|zstd (default: none)
+
+Example:
+  {0} --benchmarks fillseq,ycsba,ycsbc --num 1000000 --threads 8 --json result.json
+)",
+    prog);
+}
+
+bool parse_bool(std::string_view s, bool& out) {
+  if (s == "on" || s == "true" || s == "1") { out = true; return true; }
+  if (s == "off"|| s == "false"|| s == "0") { out = false; return true; }
+  return false;
+}
+
+uint64_t parse_bytes(std::string_view s) {
+  if (s.empty()) return 0;
+  char unit = s.back();
+  uint64_t mul = 1;
+  std::string_view num = s;
+  if (unit=='K'||unit=='k'||unit=='M'||unit=='m'||unit=='G'||unit=='g') {
+    num.remove_suffix(1);
+    if (unit=='K'||unit=='k') mul = 1024ull;
+    if (unit=='M'||unit=='m') mul = 1024ull*1024ull;
+    if (unit=='G'||unit=='g') mul = 1024ull*1024ull*1024ull;
+  }
+  return std::strtoull(std::string(num).c_str(), nullptr, 10) * mul;
+}
+
+Args parse_args(int argc, char** argv) {
+  Args a;
+  for (int i = 1; i < argc; ++i) {
+    std::string_view t = argv[i];
+    auto need_value = [&](int idx){ return idx + 1 < argc; };
+    auto num = [&]{ return std::strtoull(argv[++i], nullptr, 10); };
+    auto real = [&]{ return std::strtod(argv[++i], nullptr); };
+    if (t=="-h"||t=="--help") { a.help = true; continue; }
+    if (t=="--benchmarks" && need_value(i)) { a.benchmarks = argv[++i]; continue; }
+    if (t=="--num" && need_value(i)) { a.num = num(); continue; }
+    if (t=="--ops" && need_value(i)) { a.ops = num(); continue; }
+    if (t=="--preload" && need_value(i)) { if(!parse_bool(argv[++i], a.preload)) a.help=true; continue; }
+    if (t=="--threads" && need_value(i)) { a.threads = static_cast<unsigned>(num()); continue; }
+    if (t=="--key-len" && need_value(i)) { a.key_len = num(); continue; }
+    if (t=="--val-len" && need_value(i)) { a.val_len = num(); continue; }
+    if (t=="--distribution" && need_value(i)) { a.distribution = argv[++i]; continue; }
+    if (t=="--zipf-theta" && need_value(i)) { a.zipf_theta = real(); continue; }
+    if (t=="--hot-set" && need_value(i)) { a.hot_set = real(); continue; }
+    if (t=="--hot-ops" && need_value(i)) { a.hot_ops = real(); continue; }
+    if (t=="--seek-nexts" && need_value(i)) { a.seek_nexts = static_cast<unsigned>(num()); continue; }
+    if (t=="--scan-len" && need_value(i)) { a.scan_len = static_cast<unsigned>(num()); continue; }
+    if (t=="--warmup-ops" && need_value(i)) { a.warmup_ops = num(); continue; }
+    if (t=="--json" && need_value(i)) { a.json = argv[++i]; continue; }
+    if (t=="--seed" && need_value(i)) { a.seed = num(); continue; }
+    if (t=="--path" && need_value(i)) { a.path = argv[++i]; continue; }
+    if (t=="--fresh" && need_value(i)) { if(!parse_bool(argv[++i], a.fresh)) a.help=true; continue; }
+    if (t=="--use-uring" && need_value(i)) { if(!parse_bool(argv[++i], a.use_uring)) a.help=true; continue; }
+    if (t=="--queue-depth" && need_value(i)) { a.uring_qd = static_cast<unsigned>(num()); continue; }
+    if (t=="--flush" && need_value(i)) { a.flush_mode = argv[++i]; continue; }
+    if (t=="--wal-format" && need_value(i)) { a.wal_format = argv[++i]; continue; }
+    if (t=="--group-commit" && need_value(i)) { a.wal_group_commit = parse_bytes(argv[++i]); continue; }
+    if (t=="--flush-threshold" && need_value(i)) { a.flush_threshold = parse_bytes(argv[++i]); continue; }
+    if (t=="--bg-compact" && need_value(i)) { if(!parse_bool(argv[++i], a.bg_compaction)) a.help=true; continue; }
+    if (t=="--compaction-policy" && need_value(i)) { a.compaction_policy = argv[++i]; continue; }
+    if (t=="--compaction-threads" && need_value(i)) { a.compaction_threads = static_cast<unsigned>(num()); continue; }
+    if (t=="--block-cache" && need_value(i)) { a.block_cache = parse_bytes(argv[++i]); continue; }
+    if (t=="--bloom-bits" && need_value(i)) { a.bloom_bits = static_cast<uint32_t>(num()); continue; }
+    if (t=="--sst-format" && need_value(i)) { a.sst_format = static_cast<uint32_t>(num()); continue; }
+    if (t=="--compression" && need_value(i)) { a.compression = argv[++i]; continue; }
+    spdlog::error("Unknown or incomplete option '{}'", t);
+    a.help = true;
+  }
+  return a;
+}
+
+// ----------------------------
+// Результаты фазы
+// ----------------------------
+constexpr int kOpTypes = static_cast<int>(OpType::kCount);
+
+struct OpHistograms {
+  std::array<std::unique_ptr<LatencyHistogram>, kOpTypes> warmup, steady;
+  OpHistograms() {
+    for (auto& h : warmup) h = std::make_unique<LatencyHistogram>();
+    for (auto& h : steady) h = std::make_unique<LatencyHistogram>();
+  }
+};
+
+struct ThreadResult {
+  OpHistograms hist;
+  uint64_t ops = 0;
+  uint64_t found = 0, not_found = 0; // чтения
+  std::chrono::steady_clock::time_point steady_start{};
+};
+
+struct PhaseResult {
+  std::string name;
+  std::string distribution;
+  uint64_t ops = 0, warmup_ops = 0;
+  uint64_t found = 0, not_found = 0;
+  double seconds = 0, steady_seconds = 0;
+  OpHistograms hist;
+};
+
+using Clock = std::chrono::steady_clock;
+
+// ----------------------------
+// Исполнение фазы
+// ----------------------------
+class Runner {
+public:
+  Runner(const Args& a, KV& kv) : a_(a), kv_(kv) {
+    // значения — срезы одного случайного буфера: генерация не попадает в замеры
+    std::mt19937_64 rng(a.seed ^ 0x5A5A);
+    values_.resize(a.val_len * 2 + 64);
+    for (auto& c : values_) c = static_cast<char>('a' + rng() % 26);
+  }
+
+  uint64_t loaded() const { return loaded_; }
+
+  PhaseResult run(const Workload& w, Distribution dist, uint64_t ops) {
+    PhaseResult r;
+    r.name = w.name;
+    const bool fill = w.fill != Workload::Fill::NONE;
+    r.distribution = fill ? (w.fill == Workload::Fill::SEQ ? "sequential" : "uniform") : distribution_name(dist);
+    if (!fill && loaded_ == 0) spdlog::warn("{}: no keys loaded (use a fill phase or --preload on)", w.name);
+
+    KeyChooser keys(dist, loaded_, a_.zipf_theta, a_.hot_set, a_.hot_ops);
+    const unsigned th = std::max(1u, a_.threads);
+    const uint64_t total = fill ? a_.num : ops;
+    const uint64_t warm_total = a_.warmup_ops == UINT64_MAX ? total / 10 : std::min(a_.warmup_ops, total);
+
+    std::vector<ThreadResult> res(th);
+    std::vector<std::thread> workers;
+    const auto t0 = Clock::now();
+    for (unsigned i = 0; i < th; ++i) {
+      const uint64_t begin = total * i / th, end = total * (i + 1) / th;
+      const uint64_t warm = warm_total * (i + 1) / th - warm_total * i / th;
+      workers.emplace_back([&, i, begin, end, warm] { worker(w, keys, i, begin, end, warm, res[i]); });
+    }
+    for (auto& t : workers) t.join();
+    const auto t1 = Clock::now();
+
+    auto steady_start = t0;
+    for (auto& tr : res) {
+      steady_start = std::max(steady_start, tr.steady_start);
+      r.ops += tr.ops;
+      r.found += tr.found;
+      r.not_found += tr.not_found;
+      for (int k = 0; k < kOpTypes; ++k) {
+        r.hist.warmup[k]->merge(*tr.hist.warmup[k]);
+        r.hist.steady[k]->merge(*tr.hist.steady[k]);
+      }
+    }
+    r.warmup_ops = warm_total;
+    r.seconds = std::chrono::duration<double>(t1 - t0).count();
+    r.steady_seconds = std::chrono::duration<double>(t1 - steady_start).count();
+    if (fill) loaded_ = std::max(loaded_, a_.num);
+    else loaded_ = std::max(loaded_, keys.key_count());
+    return r;
+  }
+
+private:
+  std::string_view value(std::mt19937_64& rng) const {
+    return std::string_view(values_).substr(rng() % (values_.size() - a_.val_len), a_.val_len);
+  }
+
+  OpType pick_op(const Workload& w, std::mt19937_64& rng) const {
+    uint32_t dice = static_cast<uint32_t>(rng() % 100), acc = 0;
+    for (int k = 0; k < kOpTypes; ++k) {
+      acc += w.pct[k];
+      if (dice < acc) return static_cast<OpType>(k);
+    }
+    return OpType::READ;
+  }
+
+  void worker(const Workload& w, KeyChooser& keys, unsigned tid, uint64_t begin, uint64_t end,
+              uint64_t warm, ThreadResult& out) {
+    std::mt19937_64 rng(a_.seed + 0x9E3779B97F4A7C15ULL * (tid + 1));
+    out.steady_start = Clock::now();
+    for (uint64_t i = begin, done = 0; i < end; ++i, ++done) {
+      if (done == warm) out.steady_start = Clock::now();
+      auto& hist = done < warm ? out.hist.warmup : out.hist.steady;
+      OpType op = OpType::INSERT;
+      uint64_t n = 0;
+      if (w.fill == Workload::Fill::SEQ) {
+        n = i;
+      } else if (w.fill == Workload::Fill::RANDOM) {
+        n = std::uniform_int_distribution<uint64_t>(0, a_.num - 1)(rng);
+      } else {
+        op = pick_op(w, rng);
+        n = op == OpType::INSERT ? keys.next_insert() : keys.next(rng);
+      }
+      const std::string key = make_key(n, a_.key_len);
+
+      const auto s = Clock::now();
+      switch (op) {
+        case OpType::READ: {
+          if (kv_.get(key)) ++out.found; else ++out.not_found;
+          break;
+        }
+        case OpType::UPDATE:
+        case OpType::INSERT:
+          (void)kv_.put(key, value(rng));
+          break;
+        case OpType::RMW: {
+          auto v = kv_.get(key);
+          if (v) ++out.found; else ++out.not_found;
+          (void)kv_.put(key, value(rng));
+          break;
+        }
+        case OpType::SCAN:
+        case OpType::SEEK: {
+          const unsigned len = op == OpType::SCAN
+              ? 1 + static_cast<unsigned>(rng() % std::max(1u, a_.scan_len)) : a_.seek_nexts + 1;
+          KV::Iterator it(&kv_);
+          it.seek(key);
+          for (unsigned k = 1; k < len && it.valid(); ++k) it.next();
+          break;
+        }
+        case OpType::kCount:
+          break;
+      }
+      const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - s).count();
+      hist[static_cast<int>(op)]->record(static_cast<uint64_t>(ns));
+      ++out.ops;
+    }
+  }
+
+  const Args& a_;
+  KV& kv_;
+  std::string values_;
+  uint64_t loaded_ = 0;
+};
+
+// ----------------------------
+// Отчёт
+// ----------------------------
+void print_phase(const PhaseResult& r) {
+  fmt::print("{:<11} : {:>10.0f} ops/s  (steady {:>10.0f} ops/s)  ops={} warmup={} {:.3f}s  dist={}",
+             r.name, double(r.ops) / std::max(r.seconds, 1e-9),
+             double(r.ops - std::min(r.ops, r.warmup_ops)) / std::max(r.steady_seconds, 1e-9),
+             r.ops, r.warmup_ops, r.seconds, r.distribution);
+  if (r.found + r.not_found) fmt::print("  found {}/{}", r.found, r.found + r.not_found);
+  fmt::print("\n");
+  auto line = [](std::string_view stage, std::string_view op, const LatencyHistogram& h) {
+    if (!h.count()) return;
+    fmt::print("    {:<6} {:<7} count={:<9} us: mean={:.2f} p50={:.2f} p95={:.2f} p99={:.2f} p99.9={:.2f} max={:.2f}\n",
+               op, stage, h.count(), h.mean() / 1e3, h.percentile(50) / 1e3, h.percentile(95) / 1e3,
+               h.percentile(99) / 1e3, h.percentile(99.9) / 1e3, h.max() / 1e3);
+  };
+  for (int k = 0; k < kOpTypes; ++k) {
+    line("warmup", op_name(static_cast<OpType>(k)), *r.hist.warmup[k]);
+    line("steady", op_name(static_cast<OpType>(k)), *r.hist.steady[k]);
+  }
+}
+
+std::string json_escape(std::string_view s) {
+  std::string out;
+  for (char c : s) {
+    if (c == '"' || c == '\\') out += '\\';
+    if (static_cast<unsigned char>(c) < 0x20) { out += fmt::format("\\u{:04x}", c); continue; }
+    out += c;
+  }
+  return out;
+}
+
+std::string json_hist(const LatencyHistogram& h) {
+  return fmt::format(R"({{"count":{},"mean_ns":{:.1f},"min_ns":{},"p50_ns":{},"p90_ns":{},"p95_ns":{},"p99_ns":{},"p999_ns":{},"max_ns":{}}})",
+                     h.count(), h.mean(), h.min(), h.percentile(50), h.percentile(90), h.percentile(95),
+                     h.percentile(99), h.percentile(99.9), h.max());
+}
+
+std::string json_report(const Args& a, const std::vector<PhaseResult>& phases, const KVMetrics& m) {
+  std::string j = "{\n";
+  j += fmt::format(R"(  "tool": "uringkv_bench", "commit": "{}",)" "\n", json_escape(URINGKV_BUILD_COMMIT));
+  j += fmt::format(R"(  "config": {{"path":"{}","threads":{},"num":{},"key_len":{},"val_len":{},)"
+                   R"("distribution":"{}","zipf_theta":{},"preload":{},"use_uring":{},"flush":"{}",)"
+                   R"("wal_format":"{}","compaction_policy":"{}","compaction_threads":{},)"
+                   R"("block_cache":{},"bloom_bits":{},"sst_format":{},"compression":"{}"}},)" "\n",
+                   json_escape(a.path), a.threads, a.num, a.key_len, a.val_len, json_escape(a.distribution),
+                   a.zipf_theta, a.preload, a.use_uring, json_escape(a.flush_mode), json_escape(a.wal_format),
+                   json_escape(a.compaction_policy), a.compaction_threads, a.block_cache, a.bloom_bits,
+                   a.sst_format, json_escape(a.compression));
+  j += "  \"phases\": [\n";
+  for (std::size_t p = 0; p < phases.size(); ++p) {
+    const auto& r = phases[p];
+    const uint64_t steady_ops = r.ops - std::min(r.ops, r.warmup_ops);
+    j += fmt::format(R"(    {{"name":"{}","distribution":"{}","ops":{},"warmup_ops":{},"seconds":{:.6f},)"
+                     R"("ops_per_sec":{:.1f},"steady_seconds":{:.6f},"steady_ops_per_sec":{:.1f},)"
+                     R"("found":{},"not_found":{},"latency":{{)",
+                     json_escape(r.name), r.distribution, r.ops, r.warmup_ops, r.seconds,
+                     double(r.ops) / std::max(r.seconds, 1e-9), r.steady_seconds,
+                     double(steady_ops) / std::max(r.steady_seconds, 1e-9), r.found, r.not_found);
+    bool first = true;
+    for (int k = 0; k < kOpTypes; ++k) {
+      const auto& w = *r.hist.warmup[k];
+      const auto& s = *r.hist.steady[k];
+      if (!w.count() && !s.count()) continue;
+      j += fmt::format(R"({}"{}":{{"warmup":{},"steady":{}}})", first ? "" : ",",
+                       op_name(static_cast<OpType>(k)), json_hist(w), json_hist(s));
+      first = false;
+    }
+    j += fmt::format("}}}}{}\n", p + 1 < phases.size() ? "," : "");
+  }
+  j += "  ],\n";
+  j += fmt::format(R"(  "metrics": {{"wal_bytes":{},"wal_syncs":{},"sst_flushes":{},"compactions":{},)"
+                   R"("block_cache_hits":{},"block_cache_misses":{},"bloom_useful":{},"write_stalls":{},)"
+                   R"("write_stall_us":{},"sst_count":{}}})" "\n",
+                   m.wal_bytes, m.wal_syncs, m.sst_flushes, m.compactions, m.block_cache_hits,
+                   m.block_cache_misses, m.bloom_useful, m.write_stalls, m.write_stall_us, m.sst_count);
+  j += "}\n";
+  return j;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  // журнал KV — в stderr: stdout остаётся под отчёт (--json -)
+  spdlog::set_default_logger(spdlog::stderr_color_mt("uringkv_bench"));
+  auto a = parse_args(argc, argv);
+  if (a.help) { print_usage(argv[0]); return 0; }
+  if (a.num == 0 || a.key_len == 0) { spdlog::error("--num and --key-len must be > 0"); return 2; }
+  if (a.ops == 0) a.ops = a.num;
+
+  std::vector<Workload> phases;
+  for (std::string_view rest = a.benchmarks; !rest.empty();) {
+    const auto comma = rest.find(',');
+    const auto name = rest.substr(0, comma);
+    rest = comma == std::string_view::npos ? std::string_view{} : rest.substr(comma + 1);
+    if (name.empty()) continue;
+    Workload w;
+    if (!workload_by_name(name, w)) { spdlog::error("Unknown benchmark '{}'", name); return 2; }
+    phases.push_back(std::move(w));
+  }
+  Distribution forced{};
+  const bool force_dist = a.distribution != "default";
+  if (force_dist && !parse_distribution(a.distribution, forced)) {
+    spdlog::error("Unknown --distribution '{}'", a.distribution);
+    return 2;
+  }
+
+  KVOptions opts;
+  opts.path                      = a.path;
+  opts.use_uring                 = a.use_uring;
+  opts.uring_queue_depth         = a.uring_qd;
+  opts.wal_group_commit_bytes    = a.wal_group_commit;
+  opts.sst_flush_threshold_bytes = a.flush_threshold;
+  opts.background_compaction     = a.bg_compaction;
+  opts.compaction_threads        = a.compaction_threads;
+  opts.block_cache_bytes         = a.block_cache;
+  opts.bloom_bits_per_key        = a.bloom_bits;
+  opts.sst_format_version        = a.sst_format;
+  if (!parse_sst_compression(a.compression, opts.sst_compression)) {
+    spdlog::error("Unknown --compression '{}'", a.compression);
+    return 2;
+  }
+  if (a.flush_mode == "fdatasync") opts.flush_mode = FlushMode::FDATASYNC;
+  else if (a.flush_mode == "fsync") opts.flush_mode = FlushMode::FSYNC;
+  else if (a.flush_mode == "sfr")   opts.flush_mode = FlushMode::SYNC_FILE_RANGE;
+  else { spdlog::error("Unknown --flush '{}'", a.flush_mode); return 2; }
+  if (a.wal_format == "padded") opts.wal_format = WalFormat::PADDED;
+  else if (a.wal_format == "packed") opts.wal_format = WalFormat::PACKED;
+  else { spdlog::error("Unknown --wal-format '{}'", a.wal_format); return 2; }
+  if (a.compaction_policy == "size-tiered") opts.compaction_policy = CompactionPolicy::SIZE_TIERED;
+  else if (a.compaction_policy == "leveled") opts.compaction_policy = CompactionPolicy::LEVELED;
+  else { spdlog::error("Unknown --compaction-policy '{}'", a.compaction_policy); return 2; }
+
+  if (a.fresh) {
+    std::error_code ec;
+    std::filesystem::remove_all(a.path, ec);
+  }
+  KV kv(opts);
+  if (!kv.init_storage_layout()) { spdlog::error("Failed to init storage layout at {}", a.path); return 1; }
+
+  const bool text = a.json != "-";
+  if (text)
+    fmt::print("=== uringkv_bench @ {} (commit {}, threads={}, num={}, ops={}, key_len={}, val_len={}, "
+               "uring={}, flush={}, wal={}) ===\n",
+               a.path, URINGKV_BUILD_COMMIT, a.threads, a.num, a.ops, a.key_len, a.val_len,
+               a.use_uring ? "on" : "off", a.flush_mode, a.wal_format);
+
+  Runner runner(a, kv);
+  std::vector<PhaseResult> results;
+  if (a.preload) {
+    Workload load;
+    (void)workload_by_name("fillseq", load);
+    load.name = "preload";
+    results.push_back(runner.run(load, Distribution::UNIFORM, a.num));
+    if (text) print_phase(results.back());
+  }
+  for (const auto& w : phases) {
+    results.push_back(runner.run(w, force_dist ? forced : w.dist, a.ops));
+    if (text) print_phase(results.back());
+  }
+
+  const auto m = kv.get_metrics();
+  if (!a.json.empty()) {
+    const std::string report = json_report(a, results, m);
+    if (a.json == "-") {
+      fmt::print("{}", report);
+    } else if (FILE* f = std::fopen(a.json.c_str(), "w")) {
+      std::fwrite(report.data(), 1, report.size(), f);
+      std::fclose(f);
+      fmt::print("report: {}\n", a.json);
+    } else {
+      spdlog::error("cannot write {}", a.json);
+      return 1;
+    }
+  }
+  return 0;
+}
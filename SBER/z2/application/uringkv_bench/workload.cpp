@@ -0,0 +1,138 @@
+#include "workload.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace uringkv::bench {
+
+bool parse_distribution(std::string_view s, Distribution& out) {
+  if (s == "uniform") out = Distribution::UNIFORM;
+  else if (s == "zipfian") out = Distribution::ZIPFIAN;
+  else if (s == "latest") out = Distribution::LATEST;
+  else if (s == "hotspot") out = Distribution::HOTSPOT;
+  else return false;
+  return true;
+}
+
+const char* distribution_name(Distribution d) {
+  switch (d) {
+    case Distribution::UNIFORM: return "uniform";
+    case Distribution::ZIPFIAN: return "zipfian";
+    case Distribution::LATEST:  return "latest";
+    case Distribution::HOTSPOT: return "hotspot";
+  }
+  return "?";
+}
+
+static double zeta(uint64_t n, double theta) {
+  double s = 0;
+  for (uint64_t i = 1; i <= n; ++i) s += 1.0 / std::pow(double(i), theta);
+  return s;
+}
+
+ZipfianGenerator::ZipfianGenerator(uint64_t n, double theta)
+    : n_(std::max<uint64_t>(1, n)), theta_(theta) {
+  alpha_ = 1.0 / (1.0 - theta_);
+  zetan_ = zeta(n_, theta_);
+  const double zeta2 = zeta(2, theta_);
+  eta_ = (1.0 - std::pow(2.0 / double(n_), 1.0 - theta_)) / (1.0 - zeta2 / zetan_);
+  half_pow_theta_ = 1.0 + std::pow(0.5, theta_);
+}
+
+uint64_t ZipfianGenerator::next(std::mt19937_64& rng) const {
+  const double u = std::uniform_real_distribution<double>(0.0, 1.0)(rng);
+  const double uz = u * zetan_;
+  if (uz < 1.0) return 0;
+  if (uz < half_pow_theta_) return std::min<uint64_t>(1, n_ - 1);
+  const auto r = static_cast<uint64_t>(double(n_) * std::pow(eta_ * u - eta_ + 1.0, alpha_));
+  return std::min(r, n_ - 1);
+}
+
+// FNV-1a над номером: горячие ранги zipf разбрасываются по всему диапазону
+// ключей (ScrambledZipfian в YCSB), а не собираются в его начале
+static uint64_t fnv64(uint64_t v) {
+  uint64_t h = 0xcbf29ce484222325ULL;
+  for (int i = 0; i < 8; ++i) {
+    h ^= v & 0xff;
+    h *= 0x100000001b3ULL;
+    v >>= 8;
+  }
+  return h;
+}
+
+KeyChooser::KeyChooser(Distribution d, uint64_t keys, double zipf_theta, double hot_set, double hot_ops)
+    : dist_(d), count_(std::max<uint64_t>(1, keys)), hot_set_(hot_set), hot_ops_(hot_ops) {
+  if (d == Distribution::ZIPFIAN || d == Distribution::LATEST)
+    zipf_ = std::make_unique<ZipfianGenerator>(count_.load(), zipf_theta);
+}
+
+uint64_t KeyChooser::next(std::mt19937_64& rng) const {
+  const uint64_t n = key_count();
+  switch (dist_) {
+    case Distribution::ZIPFIAN:
+      return fnv64(zipf_->next(rng)) % n;
+    case Distribution::LATEST: {
+      const uint64_t back = zipf_->next(rng);
+      return back < n ? n - 1 - back : 0;
+    }
+    case Distribution::HOTSPOT: {
+      // hot_set_ доли ключей (начало диапазона) получают hot_ops_ доли запросов
+      const auto hot = std::clamp<uint64_t>(static_cast<uint64_t>(double(n) * hot_set_), 1, n);
+      const bool to_hot = std::uniform_real_distribution<double>(0.0, 1.0)(rng) < hot_ops_;
+      if (to_hot || hot == n) return std::uniform_int_distribution<uint64_t>(0, hot - 1)(rng);
+      return std::uniform_int_distribution<uint64_t>(hot, n - 1)(rng);
+    }
+    case Distribution::UNIFORM:
+      break;
+  }
+  return std::uniform_int_distribution<uint64_t>(0, n - 1)(rng);
+}
+
+std::string make_key(uint64_t i, std::size_t len) {
+  char buf[24];
+  const int w = std::snprintf(buf, sizeof(buf), "%020llu", static_cast<unsigned long long>(i));
+  std::string_view digits(buf, static_cast<std::size_t>(w));
+  // 20 цифр вмещают любой номер; короче — младшие цифры, длиннее — нули слева
+  if (len <= digits.size()) return std::string(digits.substr(digits.size() - len));
+  return std::string(len - digits.size(), '0') + std::string(digits);
+}
+
+const char* op_name(OpType t) {
+  switch (t) {
+    case OpType::READ:   return "read";
+    case OpType::UPDATE: return "update";
+    case OpType::INSERT: return "insert";
+    case OpType::SCAN:   return "scan";
+    case OpType::RMW:    return "rmw";
+    case OpType::SEEK:   return "seek";
+    case OpType::kCount: break;
+  }
+  return "?";
+}
+
+bool workload_by_name(std::string_view name, Workload& out) {
+  out = Workload{};
+  out.name = std::string(name);
+  auto set = [&](std::initializer_list<std::pair<OpType, uint32_t>> mix, Distribution d) {
+    for (auto [t, p] : mix) out.pct[static_cast<int>(t)] = p;
+    out.dist = d;
+  };
+  using enum OpType;
+  if (name == "fillseq") out.fill = Workload::Fill::SEQ;
+  else if (name == "fillrandom") out.fill = Workload::Fill::RANDOM;
+  else if (name == "overwrite") set({{UPDATE, 100}}, Distribution::UNIFORM);
+  else if (name == "readrandom") set({{READ, 100}}, Distribution::UNIFORM);
+  else if (name == "seekrandom") set({{SEEK, 100}}, Distribution::UNIFORM);
+  // YCSB core workloads
+  else if (name == "ycsba") set({{READ, 50}, {UPDATE, 50}}, Distribution::ZIPFIAN);
+  else if (name == "ycsbb") set({{READ, 95}, {UPDATE, 5}}, Distribution::ZIPFIAN);
+  else if (name == "ycsbc") set({{READ, 100}}, Distribution::ZIPFIAN);
+  else if (name == "ycsbd") set({{READ, 95}, {INSERT, 5}}, Distribution::LATEST);
+  else if (name == "ycsbe") set({{SCAN, 95}, {INSERT, 5}}, Distribution::ZIPFIAN);
+  else if (name == "ycsbf") set({{READ, 50}, {RMW, 50}}, Distribution::ZIPFIAN);
+  else return false;
+  return true;
+}
+
+} // namespace uringkv::bench
@@ -0,0 +1,70 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace uringkv::bench {
+
+// Распределения номеров ключей (как в YCSB)
+enum class Distribution { UNIFORM, ZIPFIAN, LATEST, HOTSPOT };
+
+bool parse_distribution(std::string_view s, Distribution& out);
+const char* distribution_name(Distribution d);
+
+// Zipf по рангам [0, n) (Gray et al., как ZipfianGenerator в YCSB): ранг 0 самый
+// частый. zeta(n) считается один раз в конструкторе — O(n).
+class ZipfianGenerator {
+public:
+  ZipfianGenerator(uint64_t n, double theta);
+  uint64_t next(std::mt19937_64& rng) const;
+  uint64_t items() const { return n_; }
+
+private:
+  uint64_t n_;
+  double theta_, alpha_, zetan_, eta_, half_pow_theta_;
+};
+
+// Номер следующего ключа для запросов. Общий для потоков (только чтение),
+// кроме счётчика ключей, который растёт на вставках YCSB D/E.
+class KeyChooser {
+public:
+  // keys — сколько ключей загружено; zipf строится по нему (новые ключи latest
+  // достаёт от конца, остальные распределения — по текущему числу ключей)
+  KeyChooser(Distribution d, uint64_t keys, double zipf_theta, double hot_set, double hot_ops);
+
+  uint64_t next(std::mt19937_64& rng) const;
+  // номер для вставки (новый ключ)
+  uint64_t next_insert() { return count_.fetch_add(1, std::memory_order_relaxed); }
+  uint64_t key_count() const { return count_.load(std::memory_order_relaxed); }
+
+private:
+  Distribution dist_;
+  std::atomic<uint64_t> count_;
+  std::unique_ptr<ZipfianGenerator> zipf_;
+  double hot_set_, hot_ops_;
+};
+
+// Ключ номера i: десятичный, дополненный нулями до len (порядок ключей = порядок номеров)
+std::string make_key(uint64_t i, std::size_t len);
+
+// Операции фазы и их доли (в процентах)
+enum class OpType { READ, UPDATE, INSERT, SCAN, RMW, SEEK, kCount };
+const char* op_name(OpType t);
+
+struct Workload {
+  std::string name;
+  // fill: num записей номеров 0..num-1 (по порядку или случайно), без выбора ключа
+  enum class Fill { NONE, SEQ, RANDOM } fill = Fill::NONE;
+  // проценты READ/UPDATE/INSERT/SCAN/RMW/SEEK, сумма 100
+  uint32_t pct[static_cast<int>(OpType::kCount)] = {};
+  Distribution dist = Distribution::UNIFORM; // если не задано --distribution
+};
+
+// fillseq, fillrandom, overwrite, readrandom, seekrandom, ycsba..ycsbf; false — неизвестное имя
+bool workload_by_name(std::string_view name, Workload& out);
+
+} // namespace uringkv::bench
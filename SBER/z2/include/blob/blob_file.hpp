@@ -0,0 +1,105 @@
+#pragma once
+#include <cstdint>
+#include "rate_limiter.hpp"
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace uringkv {
+
+// ---- blob-файлы: разделение значений (WiscKey) ----
+// Значения не короче KVOptions::blob_value_threshold при flush уходят в
+// append-only файлы blob/NNNNNN.blob, а SST хранит только ссылку (SST_FLAG_BLOB),
+// поэтому компактация переписывает ссылки, а не сами значения.
+// Формат файла: BlobFileHeader, затем записи подряд:
+//   BlobRecordHeader | key[klen] | value[vlen]
+// Ключ хранится рядом со значением: чтение проверяет, что запись принадлежит ключу.
+struct BlobFileHeader {
+  uint32_t magic;   // 'BLOB' = 0x424F4C42
+  uint32_t version; // 1
+};
+
+struct BlobRecordHeader {
+  uint32_t klen;
+  uint32_t vlen;
+  uint64_t checksum; // XXH64(key||value)
+};
+
+static constexpr uint32_t BLOB_MAGIC   = 0x424F4C42u; // 'BLOB'
+static constexpr uint32_t BLOB_VERSION = 1u;
+
+inline uint64_t blob_record_bytes(std::size_t klen, std::size_t vlen) {
+  return sizeof(BlobRecordHeader) + uint64_t(klen) + uint64_t(vlen);
+}
+
+// Ссылка на значение: номер файла, смещение записи (её заголовка), длина значения.
+// В SST кодируется как varint64 file | varint64 offset | varint32 size.
+struct BlobRef {
+  uint64_t file   = 0;
+  uint64_t offset = 0;
+  uint32_t size   = 0;
+};
+
+void encode_blob_ref(std::string& dst, const BlobRef& ref);
+bool decode_blob_ref(std::string_view src, BlobRef& ref);
+
+std::string blob_name(uint64_t index); // "000001.blob"
+// имена NNNNNN.blob каталога по возрастанию
+std::vector<std::string> list_blob_files(const std::string& blob_dir);
+
+// Последовательная запись одного blob-файла (буфер + write, fsync в finish).
+// Незавершённый файл остаётся на диске — его удаляет владелец.
+// limiter (если есть) выдаёт токены на каждую запись буфера.
+class BlobWriter {
+public:
+  BlobWriter(const std::string& path, uint64_t index, RateLimiter* limiter = nullptr,
+             RateLimiter::Priority pri = RateLimiter::Priority::LOW);
+  ~BlobWriter();
+
+  BlobWriter(const BlobWriter&) = delete;
+  BlobWriter& operator=(const BlobWriter&) = delete;
+
+  bool good() const { return fd_ >= 0 && !failed_; }
+  uint64_t index() const { return index_; }
+  const std::string& path() const { return path_; }
+  // байт записей (без заголовка файла)
+  uint64_t record_bytes() const { return file_size() - sizeof(BlobFileHeader); }
+  uint64_t file_size() const { return file_off_ + wbuf_.size(); }
+
+  bool add(std::string_view key, std::string_view value, BlobRef& ref);
+  // дописать буфер и fsync
+  bool finish();
+
+private:
+  bool flush_out();
+
+  std::string path_;
+  uint64_t index_ = 0;
+  int fd_ = -1;
+  std::string wbuf_;
+  uint64_t file_off_ = 0;
+  RateLimiter* limiter_ = nullptr;
+  RateLimiter::Priority pri_;
+  bool failed_ = false;
+};
+
+// Открытый на чтение blob-файл. Читатели держат его через shared_ptr, поэтому
+// файл, удалённый GC, дочитывается по уже открытому fd.
+class BlobFile {
+public:
+  explicit BlobFile(const std::string& path);
+  ~BlobFile();
+
+  BlobFile(const BlobFile&) = delete;
+  BlobFile& operator=(const BlobFile&) = delete;
+
+  bool good() const { return fd_ >= 0; }
+  // pread записи по ссылке + проверка ключа и checksum
+  bool read(const BlobRef& ref, std::string_view key, std::string& value) const;
+
+private:
+  std::string path_;
+  int fd_ = -1;
+};
+
+} // namespace uringkv
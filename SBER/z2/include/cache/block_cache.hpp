@@ -0,0 +1,78 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace uringkv {
+
+// Шардированный LRU-кэш содержимого SST: ключ (file_id, offset), ёмкость в байтах.
+// v3 — проверенные блоки данных, v2 — записи. file_id — номер SST (не
+// переиспользуется), поэтому закрытие/переоткрытие таблицы кэш не обнуляет.
+// Handle держит данные живыми и после вытеснения.
+class BlockCache {
+public:
+  using Handle = std::shared_ptr<const std::string>;
+
+  explicit BlockCache(std::size_t capacity_bytes, unsigned num_shard_bits = 4);
+
+  BlockCache(const BlockCache&) = delete;
+  BlockCache& operator=(const BlockCache&) = delete;
+
+  Handle lookup(uint64_t file_id, uint64_t offset);
+  // Если блок уже есть (вставил параллельный читатель) — вернёт имеющийся.
+  Handle insert(uint64_t file_id, uint64_t offset, std::string data);
+  // освободить блоки удалённого файла
+  void erase_file(uint64_t file_id);
+
+  std::size_t capacity() const { return capacity_; }
+  std::size_t usage() const;
+
+  uint64_t hits() const { return hits_.load(std::memory_order_relaxed); }
+  uint64_t misses() const { return misses_.load(std::memory_order_relaxed); }
+  uint64_t evictions() const { return evictions_.load(std::memory_order_relaxed); }
+  void reset_stats();
+
+private:
+  struct Key {
+    uint64_t file_id;
+    uint64_t offset;
+    bool operator==(const Key& o) const { return file_id == o.file_id && offset == o.offset; }
+  };
+  struct KeyHash {
+    std::size_t operator()(const Key& k) const {
+      uint64_t h = k.file_id * 0x9E3779B97F4A7C15ull ^ k.offset;
+      h ^= h >> 29;
+      h *= 0xBF58476D1CE4E5B9ull;
+      return static_cast<std::size_t>(h ^ (h >> 32));
+    }
+  };
+  struct Entry {
+    Key key;
+    Handle data;
+    std::size_t charge;
+  };
+  struct Shard {
+    std::mutex mu;
+    std::list<Entry> lru; // front — самый свежий
+    std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> map;
+    std::size_t usage = 0;
+  };
+
+  Shard& shard_for(const Key& k);
+  void evict_locked(Shard& s);
+
+  std::size_t capacity_;
+  std::size_t shard_capacity_;
+  unsigned shard_bits_;
+  std::vector<std::unique_ptr<Shard>> shards_;
+
+  std::atomic<uint64_t> hits_{0}, misses_{0}, evictions_{0};
+};
+
+} // namespace uringkv
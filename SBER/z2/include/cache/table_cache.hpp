@@ -1,59 +1,75 @@
 #pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include <list>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "sst/table.hpp"
 
 namespace uringkv {
 
+class BlockCache;
+
+// Шардированный LRU-кэш открытых SST: ключ — номер файла (не переиспользуется),
+// ёмкость — в файлах. Безопасен из любых потоков, свои локи по шардам.
+// Открытая таблица держит в памяти футер, блочный индекс, фильтр, словарь и
+// range tombstone'ы, пока она в кэше или у читателя (shared_ptr). Файлы,
+// выбывшие после компактации, закрываются по одному через erase_file.
 class TableCache {
 public:
-  explicit TableCache(size_t capacity_files = 64)
-      : cap_(capacity_files ? capacity_files : 1) {}
-
-  std::shared_ptr<SstTable> get_table(const std::string &path) {
-    auto it = map_.find(path);
-    if (it != map_.end()) {
-      hits_++;
-      lru_.splice(lru_.begin(), lru_, it->second);
-      return it->second->table;
-    }
-    misses_++;
-    auto tbl = std::make_shared<SstTable>(path);
-    if (!tbl->good())
-      return nullptr;
-    opens_++;
-
-    lru_.push_front({path, tbl});
-    map_[path] = lru_.begin();
-
-    // вытеснить, если нужно
-    if (lru_.size() > cap_) {
-      auto &back = lru_.back();
-      map_.erase(back.path);
-      lru_.pop_back();
-    }
-    return tbl;
-  }
-
-  uint64_t hits() const { return hits_; }
-  uint64_t misses() const { return misses_; }
-  uint64_t opens() const { return opens_; }
-  void reset_stats() { hits_ = misses_ = opens_ = 0; }
+  // block_cache (опционально) передаётся открываемым таблицам
+  explicit TableCache(std::size_t capacity_files = 64, BlockCache* block_cache = nullptr,
+                      unsigned num_shard_bits = 4);
+
+  TableCache(const TableCache&) = delete;
+  TableCache& operator=(const TableCache&) = delete;
+
+  // Таблица файла file_number; промах — открыть path без лока шарда
+  // (параллельные читатели других файлов шарда не ждут I/O). nullptr — не открылась.
+  std::shared_ptr<SstTable> get_table(uint64_t file_number, const std::string& path);
+  // закрыть таблицу удалённого файла (читатели дочитывают свою копию)
+  void erase_file(uint64_t file_number);
+
+  std::size_t capacity() const { return capacity_; }
+  std::size_t size() const;          // открытых таблиц
+  std::size_t pinned_bytes() const;  // их метаданные в памяти
+
+  uint64_t hits() const { return hits_.load(std::memory_order_relaxed); }
+  uint64_t misses() const { return misses_.load(std::memory_order_relaxed); }
+  uint64_t opens() const { return opens_.load(std::memory_order_relaxed); }
+  uint64_t evictions() const { return evictions_.load(std::memory_order_relaxed); }
+  uint64_t open_us() const { return open_us_.load(std::memory_order_relaxed); } // суммарно
+  uint64_t open_max_us() const { return open_max_us_.load(std::memory_order_relaxed); }
+  void reset_stats();
 
 private:
-  struct Node {
-    std::string path;
+  struct Entry {
+    uint64_t file;
     std::shared_ptr<SstTable> table;
+    std::size_t charge; // metadata_bytes() таблицы
+  };
+  struct Shard {
+    std::mutex mu;
+    std::list<Entry> lru; // front — самый свежий
+    std::unordered_map<uint64_t, std::list<Entry>::iterator> map;
+    std::size_t pinned = 0;
   };
 
-  size_t cap_;
-  std::list<Node> lru_;
-  std::unordered_map<std::string, std::list<Node>::iterator> map_;
+  Shard& shard_for(uint64_t file);
+
+  std::size_t capacity_;
+  std::size_t shard_capacity_;
+  unsigned shard_bits_;
+  BlockCache* block_cache_;
+  std::vector<std::unique_ptr<Shard>> shards_;
 
-  uint64_t hits_ = 0, misses_ = 0, opens_ = 0;
+  std::atomic<uint64_t> hits_{0}, misses_{0}, opens_{0}, evictions_{0};
+  std::atomic<uint64_t> open_us_{0}, open_max_us_{0};
 };
 
 } // namespace uringkv
@@ -0,0 +1,88 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace uringkv {
+
+// Гистограмма задержек в стиле HdrHistogram: log-linear корзины, 64 корзины на
+// каждую степень двойки (до 127 — точно), т.е. относительная ошибка <= 1/64.
+// Значения больше max_value() попадают в последнюю корзину. Единица — любая
+// (бенчмарк пишет наносекунды). record потокобезопасен (relaxed atomics);
+// чтения во время записи видят согласованный лишь приблизительно срез.
+class LatencyHistogram {
+public:
+  LatencyHistogram();
+
+  LatencyHistogram(const LatencyHistogram&) = delete;
+  LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+  void record(uint64_t v) {
+    counts_[bucket_of(v)].fetch_add(1, std::memory_order_relaxed);
+    total_.fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(v, std::memory_order_relaxed);
+    uint64_t m = max_.load(std::memory_order_relaxed);
+    while (v > m && !max_.compare_exchange_weak(m, v, std::memory_order_relaxed)) {}
+    m = min_.load(std::memory_order_relaxed);
+    while (v < m && !min_.compare_exchange_weak(m, v, std::memory_order_relaxed)) {}
+  }
+
+  // прибавить другую гистограмму (сведение потоков бенчмарка)
+  void merge(const LatencyHistogram& o);
+  void reset();
+
+  uint64_t count() const { return total_.load(std::memory_order_relaxed); }
+  uint64_t sum() const { return sum_.load(std::memory_order_relaxed); }
+  uint64_t min() const { return count() ? min_.load(std::memory_order_relaxed) : 0; }
+  uint64_t max() const { return max_.load(std::memory_order_relaxed); }
+  double mean() const { return count() ? double(sum()) / double(count()) : 0.0; }
+  // наибольшее значение корзины, в которой лежит p-й перцентиль (p в [0, 100])
+  uint64_t percentile(double p) const;
+
+  static constexpr uint64_t max_value() { return (uint64_t(1) << kMaxExp) - 1; }
+
+private:
+  static constexpr unsigned kSubBits = 6;                      // 64 корзины на октаву
+  static constexpr unsigned kMaxExp  = 44;                     // ~4.9 часа в нс
+  static constexpr std::size_t kLinear = std::size_t(2) << kSubBits; // 0..127 точно
+  static constexpr std::size_t kBuckets = kLinear + (kMaxExp - kSubBits - 1) * (std::size_t(1) << kSubBits);
+
+  static std::size_t bucket_of(uint64_t v) {
+    if (v < kLinear) return static_cast<std::size_t>(v);
+    if (v > max_value()) v = max_value();
+    const unsigned shift = 63u - static_cast<unsigned>(__builtin_clzll(v)) - kSubBits; // >= 1
+    return kLinear + (shift - 1) * (std::size_t(1) << kSubBits) +
+           static_cast<std::size_t>((v >> shift) - (uint64_t(1) << kSubBits));
+  }
+  static uint64_t bucket_high(std::size_t i);
+
+  std::unique_ptr<std::atomic<uint64_t>[]> counts_;
+  std::atomic<uint64_t> total_{0};
+  std::atomic<uint64_t> sum_{0};
+  std::atomic<uint64_t> min_{UINT64_MAX};
+  std::atomic<uint64_t> max_{0};
+};
+
+// Время области в гистограмму, нс; h == nullptr — часы не читаются
+class ScopedLatency {
+public:
+  explicit ScopedLatency(LatencyHistogram* h) : h_(h) {
+    if (h_) t0_ = std::chrono::steady_clock::now();
+  }
+  ~ScopedLatency() {
+    if (h_)
+      h_->record(static_cast<uint64_t>(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0_).count()));
+  }
+
+  ScopedLatency(const ScopedLatency&) = delete;
+  ScopedLatency& operator=(const ScopedLatency&) = delete;
+
+private:
+  LatencyHistogram* h_;
+  std::chrono::steady_clock::time_point t0_{};
+};
+
+} // namespace uringkv
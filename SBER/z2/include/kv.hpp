@@ -1,7 +1,10 @@
 #pragma once
 #include <cstdint>
 #include <cstddef>
+#include <functional>
+#include <memory>
 #include <optional>
+#include <span>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -15,31 +18,146 @@ enum class FlushMode {
   SYNC_FILE_RANGE
 };
 
+// формат WAL: PADDED — каждая запись выровнена на 4 KiB (v1),
+// PACKED — записи подряд во фрагментах внутри 4 KiB блоков (v2, group commit)
+enum class WalFormat {
+  PADDED,
+  PACKED
+};
+
+// SIZE_TIERED — все SST в L0, компактация сливает весь L0;
+// LEVELED — многоуровневое дерево (MANIFEST), сливаются только пересекающиеся файлы
 enum class CompactionPolicy {
   SIZE_TIERED,
   LEVELED
 };
 
+// кодек блоков SST v3; значение — байт кодека в трейлере блока (sst/compression.hpp)
+enum class SstCompression : uint8_t {
+  NONE = 0,
+  LZ4  = 1,
+  ZSTD = 2
+};
+
 // ----- внешние метрики -----
+// Задержки одной операции по гистограмме (KVOptions::latency_histograms), нс;
+// перцентиль — верхняя граница его корзины (ошибка <= 1/64)
+struct LatencyStats {
+  uint64_t count   = 0;
+  uint64_t sum_ns  = 0;
+  uint64_t p50_ns  = 0;
+  uint64_t p90_ns  = 0;
+  uint64_t p99_ns  = 0;
+  uint64_t p999_ns = 0;
+  uint64_t max_ns  = 0;
+};
+
 struct KVMetrics {
   uint64_t puts        = 0;
   uint64_t gets        = 0;
   uint64_t dels        = 0;
+  // range delete: записано range tombstone'ов; версий, выброшенных компактацией
+  // под ними, и SST, удалённых целиком (накрыты более новым tombstone'ом)
+  uint64_t range_deletes          = 0;
+  uint64_t range_del_dropped_keys  = 0;
+  uint64_t range_del_dropped_files = 0;
 
   uint64_t get_hits    = 0;
   uint64_t get_misses  = 0;
 
   uint64_t wal_bytes   = 0;
+  uint64_t wal_syncs   = 0; // fsync/fdatasync WAL
+  uint64_t wal_batches = 0; // group-commit батчей (лидер записал очередь)
 
   uint64_t sst_flushes = 0;
   uint64_t compactions = 0;
+  // планировщик компактаций: частей слияния у заданий, поделённых по ключам,
+  // идущих сейчас заданий и максимум одновременно идущих
+  uint64_t subcompactions           = 0;
+  uint64_t compactions_running      = 0;
+  uint64_t compaction_parallel_peak = 0;
 
   uint64_t table_cache_hits   = 0;
   uint64_t table_cache_misses = 0;
   uint64_t table_cache_opens  = 0;
+  uint64_t table_cache_evictions    = 0;
+  uint64_t table_cache_open_us      = 0; // суммарное время открытия таблиц
+  uint64_t table_cache_open_max_us  = 0;
+  uint64_t table_cache_files        = 0; // открыто сейчас
+  uint64_t table_cache_pinned_bytes = 0; // их индексы/фильтры в памяти
+
+  uint64_t block_cache_hits      = 0;
+  uint64_t block_cache_misses    = 0;
+  uint64_t block_cache_evictions = 0;
+  uint64_t block_cache_usage     = 0; // байт
+
+  // bloom-фильтры SST на GET: проверок, отсечённых таблиц (useful),
+  // положительных с найденным ключом (hits) и ложноположительных
+  uint64_t bloom_checks          = 0;
+  uint64_t bloom_useful          = 0;
+  uint64_t bloom_hits            = 0;
+  uint64_t bloom_false_positives = 0;
+
+  // разделение значений: blob-файлы и их GC. Пространственное усиление blob-части —
+  // blob_bytes / (blob_bytes - blob_garbage_bytes)
+  uint64_t blob_files              = 0;
+  uint64_t blob_bytes              = 0; // записей во всех blob-файлах
+  uint64_t blob_garbage_bytes      = 0; // из них версии, уже выброшенные из SST
+  uint64_t blob_bytes_written      = 0; // flush + перенос GC
+  uint64_t blob_gc_runs            = 0;
+  uint64_t blob_gc_relocated_bytes = 0; // живые значения, переписанные GC
+  uint64_t blob_files_deleted      = 0;
+
+  // сжатие блоков SST: байт блоков до/после сжатия (flush + компактация).
+  // Распаковка считается на весь процесс (общая для всех KV): блоков, байт, время
+  uint64_t sst_block_raw_bytes     = 0;
+  uint64_t sst_block_stored_bytes  = 0;
+  uint64_t sst_blocks_decompressed = 0;
+  uint64_t sst_decompressed_bytes  = 0;
+  uint64_t sst_decompress_ns       = 0;
+
+  // фоновая запись и торможение записей. Долг компактации — оценка байт, которые
+  // компактации ещё предстоит переписать. bg_*_bytes — записано flush'ем и
+  // компактацией (вместе с blob GC), *_wait_us — ожидание токенов ограничителя.
+  // slowdowns — групп записи, задержанных на 1 мс; stalls — остановок записи
+  // (L0/долг компактации или ожидание flush); stall_us — время задержек и остановок
+  uint64_t pending_compaction_bytes  = 0;
+  uint64_t bg_rate_limit             = 0; // текущий лимит, байт/с; 0 = без ограничения
+  uint64_t bg_flush_bytes            = 0;
+  uint64_t bg_compaction_bytes       = 0;
+  uint64_t bg_flush_wait_us          = 0;
+  uint64_t bg_compaction_wait_us     = 0;
+  uint64_t write_slowdowns           = 0;
+  uint64_t write_stalls              = 0;
+  uint64_t write_stall_us            = 0;
 
   uint64_t mem_bytes = 0;
   uint64_t sst_count = 0;
+
+  // версии дерева: живых (текущая + удерживаемые читателями), SST, удалённых
+  // после того как их отпустила последняя версия; журнал MANIFEST — размер,
+  // правок с последнего снимка и переписываний снимком
+  uint64_t live_versions     = 0;
+  uint64_t sst_files_deleted = 0;
+  uint64_t manifest_bytes    = 0;
+  uint64_t manifest_edits    = 0;
+  uint64_t manifest_rewrites = 0;
+
+  // открытие KV: время конструктора целиком и воспроизведение WAL
+  uint64_t startup_us         = 0;
+  uint64_t wal_replay_us      = 0;
+  uint64_t wal_replay_records = 0;
+  uint64_t wal_replay_bytes   = 0; // прочитано байт сегментов
+
+  // задержки операций (пусто без latency_histograms). put/del — вызовы KV::put/del,
+  // scan — KV::scan целиком; wal_sync — commit группы записи, закончившийся fsync
+  LatencyStats put_latency;
+  LatencyStats get_latency;
+  LatencyStats del_latency;
+  LatencyStats scan_latency;
+  LatencyStats flush_latency;
+  LatencyStats compaction_latency;
+  LatencyStats wal_sync_latency;
 };
 
 // ----- опции -----
@@ -53,19 +171,81 @@ struct KVOptions {
 
   // NEW: включение fixed buffers и размер батча submit
   std::size_t uring_fixed_buffer_bytes = 0; // 0 = не использовать fixed buffers
+  // SQE до автоматического submit в WalWriter::commit_async. На запись KV не
+  // влияет: лидер group commit ждёт свою запись, и каждый commit — отдельный submit
   unsigned    uring_submit_batch       = 16;
 
   // WAL/SST/flush
   uint64_t   wal_max_segment_bytes     = 64ull * 1024 * 1024;
   uint64_t   wal_group_commit_bytes    = (1ull<<20); // полезные байты до fsync
   uint64_t   sst_flush_threshold_bytes = 4ull * 1024 * 1024;
+  // через io_uring (use_uring) fsync всегда IORING_FSYNC_DATASYNC, режим не учитывается
   FlushMode  flush_mode                = FlushMode::FDATASYNC;
+  WalFormat  wal_format                = WalFormat::PADDED;
+  // потоков чтения/проверки сегментов при восстановлении, 0 = по числу ядер
+  unsigned   wal_replay_threads        = 0;
+
+  // формат SST: 3 = упакованные блоки (по умолчанию), 2 = запись на 4 KiB
+  uint32_t    sst_format_version = 3;
+  std::size_t sst_block_size     = 4096;
+  // компактация режет выход на SST примерно такого размера
+  uint64_t    sst_target_file_bytes = 64ull * 1024 * 1024;
+  // bloom-фильтр в каждой новой SST v3 (бит на ключ), 0 = без фильтра
+  uint32_t    bloom_bits_per_key    = 10;
+  // сжатие блоков данных (v3); блок, сжавшийся меньше чем на 1/8, пишется как есть.
+  // Кодек, не собранный в этой сборке (нет liblz4/libzstd), заменяется на NONE
+  SstCompression sst_compression       = SstCompression::NONE;
+  int            sst_compression_level = 0; // 0 = уровень кодека по умолчанию
+  // ZSTD: словарь такого размера обучается на блоках каждой SST компактации
+  // и хранится в ней; 0 = без словаря
+  uint32_t       sst_zstd_dict_bytes   = 0;
 
   // компактация/кэш
   bool               background_compaction = true;
   std::size_t        l0_compact_threshold  = 6;
   std::size_t        table_cache_capacity  = 64;
+  std::size_t        block_cache_bytes     = 32ull * 1024 * 1024; // 0 = без кэша блоков
   CompactionPolicy   compaction_policy     = CompactionPolicy::SIZE_TIERED;
+  // LEVELED: лимит L1; каждый следующий уровень в multiplier раз больше
+  uint64_t           level_base_bytes      = 256ull * 1024 * 1024;
+  uint32_t           level_size_multiplier = 10;
+  uint32_t           max_levels            = 7;
+  // потоков компактации: задания с непересекающимися входами идут параллельно
+  unsigned           compaction_threads    = 1;
+  // большое задание делится по диапазонам ключей на столько частей, каждая в
+  // своём потоке (не меньше 1 MiB входа на часть); 1 — без деления
+  unsigned           max_subcompactions    = 1;
+  // журнал MANIFEST длиннее этого переписывается одним снимком
+  uint64_t           manifest_max_bytes    = 4ull * 1024 * 1024;
+
+  // фоновая запись (flush, компактация, blob GC): общий лимит, байт/с; 0 = без
+  // ограничения. Flush получает токены раньше компактации; WAL не ограничивается.
+  uint64_t           bg_rate_bytes_per_sec = 0;
+  // автоподстройка лимита по долгу компактации: без долга — 1/8 лимита, к
+  // soft_pending_compaction_bytes растёт до полного
+  bool               bg_rate_auto_tune     = false;
+  // компактация идёт с пониженным приоритетом I/O (ioprio), WAL — с обычным
+  bool               bg_io_low_priority    = true;
+  // торможение записей (только с background_compaction): при L0 >= slowdown или
+  // долге >= soft лидер группы ждёт 1 мс, при L0 >= stop или долге >= hard
+  // записи стоят, пока компактация не разгрузит дерево. 0 — условие выключено;
+  // пороги L0 не ниже l0_compact_threshold
+  std::size_t        l0_slowdown_trigger   = 20;
+  std::size_t        l0_stop_trigger       = 36;
+  uint64_t           soft_pending_compaction_bytes = 1ull << 30;
+  uint64_t           hard_pending_compaction_bytes = 4ull << 30;
+
+  // разделение значений (WiscKey): значения не короче порога flush пишет в
+  // blob-файлы, в SST остаётся ссылка; 0 = выключено. Только для SST v3.
+  uint64_t           blob_value_threshold  = 0;
+  uint64_t           blob_file_bytes       = 256ull * 1024 * 1024; // файл режется по размеру
+  // фоновый GC переносит живые значения из файла, где мусора не меньше этой доли
+  double             blob_gc_garbage_ratio = 0.5;
+
+  // гистограммы задержек put/get/del/scan/flush/компактации/fsync WAL в
+  // KVMetrics; выключены — часы на этих путях не читаются. Разбивка GET по
+  // стадиям — perf-контекст потока (perf_context.hpp)
+  bool latency_histograms = false;
 
   // завершение
   bool final_flush_on_close = true;
@@ -77,6 +257,114 @@ struct RangeItem {
   std::string value;
 };
 
+// ----- пакет записей -----
+// put/del копируются в один буфер; KV::write пишет его одной записью WAL,
+// применяет к MemTable целиком (чтения видят либо весь пакет, либо ничего)
+// и при восстановлении пакет воспроизводится тоже целиком или не воспроизводится.
+// Формат: [u32 count] затем записи [u8 flags][varint klen][key]([varint vlen][value] — PUT
+// и RANGE_DEL, у которого value — конец диапазона).
+class WriteBatch {
+public:
+  WriteBatch();
+
+  void put(std::string_view key, std::string_view value);
+  void del(std::string_view key);
+  // range tombstone [start, end) (см. KV::delete_range)
+  void delete_range(std::string_view start, std::string_view end);
+  void clear();
+
+  std::size_t count() const { return count_; }
+  bool empty() const { return count_ == 0; }
+  // сколько из них range tombstone'ов (KV::write проверяет только такие пакеты)
+  std::size_t range_deletes() const { return range_dels_; }
+  // размер закодированного пакета (столько же полезных байт уйдёт в WAL)
+  std::size_t byte_size() const { return rep_.size(); }
+  std::string_view data() const { return rep_; }
+
+  // Разбор закодированного пакета по порядку: fn(flags, key, value), flags — WAL_FLAG_*.
+  // false — данные битые или число записей не совпало с заголовком.
+  static bool for_each(std::string_view rep,
+                       const std::function<void(uint32_t, std::string_view, std::string_view)>& fn);
+
+private:
+  std::string rep_;
+  std::size_t count_ = 0;
+  std::size_t range_dels_ = 0;
+};
+
+class KV;
+
+// ----- снимок -----
+// Фиксирует seqno последней применённой записи. Пока handle жив, чтения с ним
+// видят состояние на момент создания, а flush и компактация сохраняют нужные
+// ему версии ключей. Не должен переживать KV.
+class Snapshot {
+public:
+  ~Snapshot();
+  Snapshot(const Snapshot&) = delete;
+  Snapshot& operator=(const Snapshot&) = delete;
+
+  uint64_t seqno() const { return seqno_; }
+
+private:
+  friend class KV;
+  Snapshot(KV* kv, uint64_t seqno) : kv_(kv), seqno_(seqno) {}
+
+  KV* kv_;
+  uint64_t seqno_;
+};
+
+// ----- опции чтения -----
+struct ReadOptions {
+  const Snapshot* snapshot = nullptr; // nullptr — последнее состояние
+};
+
+// ----- значение GET без копии -----
+// Вид на значение, закреплённый за его источником: блоком BlockCache или
+// MemTable (арена живёт, пока слайс держит ссылку). Вытеснение блока, flush и
+// компактация вид не портят. Источника без закрепления (чтение без кэша блоков,
+// blob-файл, SST v2) — значение во внутреннем буфере. Только перемещается;
+// освобождается в деструкторе или reset(). Может пережить KV.
+class PinnableSlice {
+public:
+  PinnableSlice() = default;
+  ~PinnableSlice() = default;
+  PinnableSlice(PinnableSlice&& o) noexcept { *this = std::move(o); }
+  PinnableSlice& operator=(PinnableSlice&& o) noexcept;
+  PinnableSlice(const PinnableSlice&) = delete;
+  PinnableSlice& operator=(const PinnableSlice&) = delete;
+
+  std::string_view view() const { return data_; }
+  const char* data() const { return data_.data(); }
+  std::size_t size() const { return data_.size(); }
+  bool empty() const { return data_.empty(); }
+  std::string to_string() const { return std::string(data_); }
+  // true — вид в чужую память (блок кэша, MemTable), false — свой буфер
+  bool pinned() const { return pin_ != nullptr; }
+  void reset();
+
+  // v ссылается в память, которую держит pin
+  void pin(std::string_view v, std::shared_ptr<const void> pin);
+  // значение — буфер buf целиком или его часть [off, off + len)
+  void own(std::string&& buf, std::size_t off = 0, std::size_t len = std::string::npos);
+  // значение строкой: свой буфер целиком отдаётся без копии
+  std::string release();
+
+private:
+  std::string_view data_;
+  std::string buf_;
+  std::shared_ptr<const void> pin_;
+  std::size_t off_ = 0; // начало значения в buf_ (вид перестраивается при перемещении)
+};
+
+// ----- опции итератора -----
+struct IteratorOptions {
+  std::string prefix{};  // только ключи с этим префиксом
+  std::string end{};     // включительная верхняя граница; пусто — без границы
+  std::size_t limit = 0; // максимум элементов от seek; 0 — без ограничения
+  const Snapshot* snapshot = nullptr; // nullptr — снимок на момент создания итератора
+};
+
 // ----- основной класс -----
 class KV {
 public:
@@ -89,16 +377,74 @@ public:
   // CRUD
   bool put(std::string_view key, std::string_view value);
   std::optional<std::string> get(std::string_view key);
+  std::optional<std::string> get(std::string_view key, const ReadOptions& ro);
+  // GET без копирования значения: false — ключа нет (value сброшен)
+  bool get(std::string_view key, PinnableSlice& value, const ReadOptions& ro = {});
   bool del(std::string_view key);
+  // Удалить все ключи [start, end) одной записью — range tombstone (WAL, MemTable,
+  // отдельный блок SST). Чтения его учитывают, компактация выбрасывает накрытые
+  // версии и SST, накрытые целиком. Нужен start < end и SST v3.
+  bool delete_range(std::string_view start, std::string_view end);
+  // Все ключи с префиксом: delete_range до ближайшего ключа за префиксом
+  bool delete_prefix(std::string_view prefix);
+  // атомарно записать пакет (одна запись WAL, подряд идущие seqno); пакет с
+  // range tombstone'ом, не проходящим проверки delete_range, отклоняется целиком
+  bool write(const WriteBatch& batch);
+
+  // Пакетный GET (ответы в порядке keys): сначала MemTable, затем все чтения SST
+  // пакета отправляются разом (io_uring при use_uring, иначе pread).
+  // ro.snapshot — как у get: весь пакет читается на этом снимке.
+  std::vector<std::optional<std::string>> multi_get(std::span<const std::string_view> keys,
+                                                    const ReadOptions& ro = {});
+
+  // диапазон [start, end] (пустые границы — без ограничения); обёртка над Iterator
+  std::vector<RangeItem> scan(std::string_view start, std::string_view end,
+                              const ReadOptions& ro = {});
+
+  // Снимок для get/scan/Iterator; освобождается вместе с последним handle.
+  std::shared_ptr<const Snapshot> snapshot();
 
-  // диапазон
-  std::vector<RangeItem> scan(std::string_view start, std::string_view end);
+  // Потоковый итератор: слияние MemTable, immutable и SST (новее побеждает,
+  // tombstone и более новый range tombstone скрывают ключ). Видит состояние на момент создания: версии
+  // MemTable новее снимка пропускаются, SST и blob-файлы закреплены версией
+  // дерева: компактация удалит их с диска только после итератора.
+  // KV должен жить дольше итератора; один итератор — один поток.
+  class Iterator {
+  public:
+    explicit Iterator(KV* kv, IteratorOptions opts = {});
+    ~Iterator();
+
+    Iterator(const Iterator&) = delete;
+    Iterator& operator=(const Iterator&) = delete;
+
+    void seek_to_first();
+    // первый ключ >= target
+    void seek(std::string_view target);
+    void next();
+
+    bool valid() const;
+    std::string_view key() const;
+    std::string_view value() const;
+
+  private:
+    struct Impl;
+    Impl* p_ = nullptr;
+  };
+
+  // Blob GC вручную: для файлов с долей мусора >= min_garbage_ratio (< 0 —
+  // blob_gc_garbage_ratio из опций) переписывает ссылающиеся на них SST, перенося
+  // живые значения в новый blob-файл. true — хотя бы один файл освобождён.
+  // Фоновый GC делает то же самое с порогом из опций.
+  bool gc_blobs(double min_garbage_ratio = -1.0);
 
   // метрики
   KVMetrics get_metrics() const;
   void reset_metrics(bool reset_cache_stats);
 
 private:
+  friend class Snapshot;
+  void release_snapshot(uint64_t seqno);
+
   struct Impl;
   Impl* p_ = nullptr;
 };
@@ -0,0 +1,48 @@
+// include/memtable/arena.hpp
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace uringkv {
+
+// Арена для MemTable: память выдаётся кусками из блоков и освобождается
+// только целиком вместе с ареной. Аллокации — с одного писателя,
+// memory_usage() можно читать из любых потоков.
+class Arena {
+public:
+  Arena() = default;
+  ~Arena();
+
+  Arena(const Arena&) = delete;
+  Arena& operator=(const Arena&) = delete;
+
+  char* allocate(std::size_t bytes);
+  // выравнивание по alignof(void*) — для узлов с атомиками
+  char* allocate_aligned(std::size_t bytes);
+
+  std::size_t memory_usage() const { return usage_.load(std::memory_order_relaxed); }
+
+private:
+  static constexpr std::size_t BLOCK_SIZE = 4096;
+
+  char* allocate_fallback(std::size_t bytes);
+  char* allocate_new_block(std::size_t bytes);
+
+  char* ptr_ = nullptr;
+  std::size_t remaining_ = 0;
+  std::vector<char*> blocks_;
+  std::atomic<std::size_t> usage_{0};
+};
+
+inline char* Arena::allocate(std::size_t bytes) {
+  if (bytes <= remaining_) {
+    char* r = ptr_;
+    ptr_ += bytes;
+    remaining_ -= bytes;
+    return r;
+  }
+  return allocate_fallback(bytes);
+}
+
+} // namespace uringkv
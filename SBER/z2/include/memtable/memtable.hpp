@@ -0,0 +1,104 @@
+// include/memtable/memtable.hpp
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "memtable/arena.hpp"
+#include "memtable/skiplist.hpp"
+#include "sst/range_del.hpp"
+
+namespace uringkv {
+
+// MemTable: упорядоченный по ключу skiplist поверх арены.
+// Каждая запись — отдельная версия (key, seqno), новые версии идут раньше старых.
+// Формат записи в арене:
+//   varint32 klen | key | u64 tag (seqno << 8 | flags) | varint32 vlen | value
+// Range tombstone'ы (WAL_FLAG_RANGE_DEL: key = start, value = end) лежат в
+// отдельном skiplist того же формата, по возрастанию start.
+// Писатель один (KV вставляет под mu), читатели — без локов.
+class MemTable {
+public:
+  MemTable();
+
+  MemTable(const MemTable&) = delete;
+  MemTable& operator=(const MemTable&) = delete;
+
+  // flags: WAL_FLAG_PUT | WAL_FLAG_DEL | WAL_FLAG_RANGE_DEL
+  void add(uint64_t seqno, uint32_t flags, std::string_view key, std::string_view value);
+
+  // true — ключ есть в MemTable (value == nullopt для tombstone);
+  // видны только версии с seqno <= snapshot, seqno (опционально) — найденной.
+  // Range tombstone'ы get не применяет — см. range_del_seq.
+  bool get(std::string_view key, std::optional<std::string>& value,
+           uint64_t snapshot = UINT64_MAX, uint64_t* seqno = nullptr) const;
+  // то же без копии: value — вид в арену, жив вместе с MemTable
+  bool get(std::string_view key, std::optional<std::string_view>& value,
+           uint64_t snapshot = UINT64_MAX, uint64_t* seqno = nullptr) const;
+
+  // seqno самого нового range tombstone'а, накрывающего key и видимого снимку; 0 — нет
+  uint64_t range_del_seq(std::string_view key, uint64_t snapshot = UINT64_MAX) const;
+  // все range tombstone'ы с seqno <= snapshot, по возрастанию start
+  void range_tombstones(std::vector<RangeTombstone>& out, uint64_t snapshot = UINT64_MAX) const;
+  uint64_t range_dels() const { return range_dels_count_.load(std::memory_order_acquire); }
+
+  // записи всех видов, включая range tombstone'ы
+  bool empty() const { return entries() == 0; }
+  uint64_t entries() const { return entries_.load(std::memory_order_acquire); }
+  // сумма key+value всех версий — порог flush
+  uint64_t data_bytes() const { return data_bytes_.load(std::memory_order_relaxed); }
+  std::size_t memory_usage() const { return arena_.memory_usage(); }
+
+  // Искомое для поиска по skiplist: ключ и seqno снимка (первая версия с
+  // seqno <= seq) — сравнивается с записями арены без кодирования в буфер
+  struct LookupKey {
+    std::string_view key;
+    uint64_t seq;
+  };
+
+  struct KeyCmp {
+    int operator()(const char* a, const char* b) const;
+    int operator()(const char* a, const LookupKey& b) const;
+  };
+  using Table = SkipList<const char*, KeyCmp>;
+
+  // Итератор по всем версиям: key по возрастанию, seqno по убыванию.
+  class Iterator {
+  public:
+    explicit Iterator(const MemTable* mt) : it_(&mt->table_) {}
+
+    bool valid() const { return it_.valid(); }
+    void seek_to_first() { it_.seek_to_first(); decode(); }
+    // первая версия с key >= target (для key == target — с seqno <= snapshot)
+    void seek(std::string_view target, uint64_t snapshot = UINT64_MAX);
+    void next() { it_.next(); decode(); }
+    // пропустить остальные (более старые) версии текущего ключа
+    void next_key();
+
+    std::string_view key() const { return key_; }
+    std::string_view value() const { return value_; }
+    uint64_t seqno() const { return tag_ >> 8; }
+    uint32_t flags() const { return static_cast<uint32_t>(tag_ & 0xFFu); }
+
+  private:
+    void decode();
+
+    Table::Iterator it_;
+    std::string_view key_, value_;
+    uint64_t tag_ = 0;
+  };
+
+private:
+  Arena arena_;
+  Table table_;
+  Table range_dels_;
+  std::atomic<uint64_t> entries_{0};
+  std::atomic<uint64_t> range_dels_count_{0};
+  std::atomic<uint64_t> data_bytes_{0};
+};
+
+} // namespace uringkv
@@ -0,0 +1,166 @@
+// include/memtable/skiplist.hpp
+#pragma once
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <new>
+
+#include "memtable/arena.hpp"
+
+namespace uringkv {
+
+// Конкурентный skiplist (схема LevelDB).
+//  * Вставка — только с одного писателя одновременно (внешняя синхронизация).
+//  * Чтение/итерация — без локов из любых потоков: узлы не удаляются, пока
+//    жив список, а связи публикуются release-store'ами после инициализации узла.
+// Key — тривиально копируемый дескриптор (например, указатель в арену),
+// Cmp — int operator()(const Key&, const Key&). Поиск гетерогенный: seek
+// принимает и другой тип T, если есть int Cmp::operator()(const Key&, const T&)
+// (искомое не нужно собирать в Key).
+template <typename Key, class Cmp>
+class SkipList {
+  struct Node;
+
+public:
+  SkipList(Cmp cmp, Arena* arena);
+
+  SkipList(const SkipList&) = delete;
+  SkipList& operator=(const SkipList&) = delete;
+
+  // key не должен совпадать ни с одним уже вставленным
+  void insert(const Key& key);
+  bool contains(const Key& key) const;
+
+  class Iterator {
+  public:
+    explicit Iterator(const SkipList* list) : list_(list) {}
+
+    bool valid() const { return node_ != nullptr; }
+    const Key& key() const { assert(valid()); return node_->key; }
+    void next() { assert(valid()); node_ = node_->next(0); }
+    // первый элемент >= target
+    template <class T>
+    void seek(const T& target) { node_ = list_->find_greater_or_equal(target, nullptr); }
+    void seek_to_first() { node_ = list_->head_->next(0); }
+
+  private:
+    const SkipList* list_;
+    Node* node_ = nullptr;
+  };
+
+private:
+  static constexpr int MAX_HEIGHT = 12;
+  static constexpr unsigned BRANCHING = 4;
+
+  int max_height() const { return max_height_.load(std::memory_order_relaxed); }
+  Node* new_node(const Key& key, int height);
+  int random_height();
+  template <class T>
+  bool key_is_after_node(const T& key, Node* n) const { return n && cmp_(n->key, key) < 0; }
+  // prev[] (если задан) заполняется предшественниками на каждом уровне
+  template <class T>
+  Node* find_greater_or_equal(const T& key, Node** prev) const;
+
+  Cmp const cmp_;
+  Arena* const arena_;
+  Node* const head_;
+  std::atomic<int> max_height_{1};
+  uint64_t rnd_ = 0x9E3779B97F4A7C15ull; // трогает только писатель
+};
+
+template <typename Key, class Cmp>
+struct SkipList<Key, Cmp>::Node {
+  explicit Node(const Key& k) : key(k) {}
+
+  Key const key;
+
+  Node* next(int n) {
+    // acquire: видим полностью инициализированный узел
+    return next_[n].load(std::memory_order_acquire);
+  }
+  void set_next(int n, Node* x) { next_[n].store(x, std::memory_order_release); }
+  Node* nobarrier_next(int n) { return next_[n].load(std::memory_order_relaxed); }
+  void nobarrier_set_next(int n, Node* x) { next_[n].store(x, std::memory_order_relaxed); }
+
+private:
+  // фактический размер массива = высота узла (хвост выделяется в арене)
+  std::atomic<Node*> next_[1];
+};
+
+template <typename Key, class Cmp>
+typename SkipList<Key, Cmp>::Node* SkipList<Key, Cmp>::new_node(const Key& key, int height) {
+  char* mem = arena_->allocate_aligned(sizeof(Node) +
+                                       sizeof(std::atomic<Node*>) * (height - 1));
+  Node* n = new (mem) Node(key);
+  // хвост next_[1..height) лежит сразу за узлом
+  for (int i = 1; i < height; ++i)
+    new (mem + sizeof(Node) + sizeof(std::atomic<Node*>) * (i - 1)) std::atomic<Node*>(nullptr);
+  return n;
+}
+
+template <typename Key, class Cmp>
+SkipList<Key, Cmp>::SkipList(Cmp cmp, Arena* arena)
+    : cmp_(cmp), arena_(arena), head_(new_node(Key{}, MAX_HEIGHT)) {
+  for (int i = 0; i < MAX_HEIGHT; ++i) head_->set_next(i, nullptr);
+}
+
+template <typename Key, class Cmp>
+int SkipList<Key, Cmp>::random_height() {
+  int h = 1;
+  while (h < MAX_HEIGHT) {
+    // xorshift64
+    rnd_ ^= rnd_ << 13;
+    rnd_ ^= rnd_ >> 7;
+    rnd_ ^= rnd_ << 17;
+    if ((rnd_ % BRANCHING) != 0) break;
+    ++h;
+  }
+  return h;
+}
+
+template <typename Key, class Cmp>
+template <class T>
+typename SkipList<Key, Cmp>::Node*
+SkipList<Key, Cmp>::find_greater_or_equal(const T& key, Node** prev) const {
+  Node* x = head_;
+  int level = max_height() - 1;
+  while (true) {
+    Node* nx = x->next(level);
+    if (key_is_after_node(key, nx)) {
+      x = nx;
+    } else {
+      if (prev) prev[level] = x;
+      if (level == 0) return nx;
+      --level;
+    }
+  }
+}
+
+template <typename Key, class Cmp>
+void SkipList<Key, Cmp>::insert(const Key& key) {
+  Node* prev[MAX_HEIGHT];
+  Node* x = find_greater_or_equal(key, prev);
+  assert(x == nullptr || cmp_(key, x->key) != 0);
+  (void)x;
+
+  const int height = random_height();
+  if (height > max_height()) {
+    for (int i = max_height(); i < height; ++i) prev[i] = head_;
+    // читатель со старой высотой просто не увидит новые уровни head_ (там nullptr)
+    max_height_.store(height, std::memory_order_relaxed);
+  }
+
+  x = new_node(key, height);
+  for (int i = 0; i < height; ++i) {
+    x->nobarrier_set_next(i, prev[i]->nobarrier_next(i));
+    prev[i]->set_next(i, x); // публикация
+  }
+}
+
+template <typename Key, class Cmp>
+bool SkipList<Key, Cmp>::contains(const Key& key) const {
+  Node* x = find_greater_or_equal(key, nullptr);
+  return x != nullptr && cmp_(key, x->key) == 0;
+}
+
+} // namespace uringkv
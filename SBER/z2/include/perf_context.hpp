@@ -0,0 +1,111 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace uringkv {
+
+// Детализация perf-контекста; задаётся для каждого потока отдельно
+enum class PerfLevel : uint8_t {
+  DISABLE      = 0, // ничего не считается (по умолчанию)
+  ENABLE_COUNT = 1, // только счётчики
+  ENABLE_TIME  = 2, // счётчики и время стадий (два-три чтения часов на стадию)
+};
+
+// Разбивка операций потока по стадиям (как PerfContext в RocksDB). Копится,
+// пока его не сбросят: reset() перед операцией — её разбивка. Стадии GET
+// (*_ns до «из них») не пересекаются и в сумме дают почти всё время KV::get;
+// счётчики блоков растут и от итераторов и компактации в этом потоке.
+struct PerfContext {
+  // GET: стадии, нс
+  uint64_t get_memtable_ns    = 0; // MemTable и immutable
+  uint64_t get_table_cache_ns = 0; // выбор файлов версии и TableCache::get_table
+  uint64_t get_filter_ns      = 0; // range tombstone таблиц и bloom
+  uint64_t index_probe_ns     = 0; // хеш-индекс или поиск по индексу блоков
+  uint64_t block_read_ns      = 0; // блок: кэш блоков, pread, checksum, распаковка
+  uint64_t record_read_ns     = 0; // поиск записи в блоке и копия значения (SST v2 — чтение записи)
+  uint64_t blob_read_ns       = 0; // значение из blob-файла
+  // из них, нс
+  uint64_t table_open_ns       = 0; // открытие таблиц на промахе TableCache (в get_table_cache_ns)
+  uint64_t block_checksum_ns   = 0; // проверка checksum блоков с диска (в block_read_ns)
+  uint64_t block_decompress_ns = 0; // распаковка блоков (в block_read_ns)
+
+  // запись: лидер группы считает WAL и MemTable за всю группу
+  uint64_t write_delay_ns    = 0; // торможение/остановка записей
+  uint64_t write_wal_ns      = 0; // WAL вместе с fsync
+  uint64_t write_memtable_ns = 0;
+
+  // счётчики
+  uint64_t get_memtable_hits     = 0; // GET решён в MemTable (значение или удаление)
+  uint64_t get_tables_probed     = 0; // таблиц, в которых искали ключ
+  uint64_t table_open_count      = 0;
+  uint64_t bloom_useful_count    = 0; // таблиц, отсечённых bloom
+  uint64_t block_cache_hit_count = 0;
+  uint64_t block_read_count      = 0; // блоков прочитано с диска
+  uint64_t block_read_bytes      = 0;
+  uint64_t blob_read_count       = 0;
+
+  void reset() { *this = PerfContext{}; }
+  PerfContext& operator+=(const PerfContext& o);
+  // "name=value ..." по всем полям; exclude_zero — без нулевых
+  std::string to_string(bool exclude_zero = true) const;
+};
+
+namespace perf_detail {
+inline thread_local PerfLevel level = PerfLevel::DISABLE;
+inline thread_local PerfContext context;
+
+inline uint64_t now_ns() {
+  return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                   std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+} // namespace perf_detail
+
+inline void set_perf_level(PerfLevel l) { perf_detail::level = l; }
+inline PerfLevel get_perf_level() { return perf_detail::level; }
+// контекст текущего потока
+inline PerfContext& get_perf_context() { return perf_detail::context; }
+
+inline bool perf_count_enabled() { return perf_detail::level >= PerfLevel::ENABLE_COUNT; }
+inline bool perf_time_enabled() { return perf_detail::level >= PerfLevel::ENABLE_TIME; }
+
+inline void perf_count(uint64_t PerfContext::*field, uint64_t n = 1) {
+  if (perf_count_enabled()) perf_detail::context.*field += n;
+}
+
+// Отсечки для идущих подряд стадий: lap(f) относит к f время с прошлой отсечки,
+// restart() начинает отсчёт заново (время уже разнесено вложенными стадиями).
+// Без ENABLE_TIME (на момент создания) часы не читаются.
+class PerfStopwatch {
+public:
+  PerfStopwatch() : on_(perf_time_enabled()) { if (on_) last_ = perf_detail::now_ns(); }
+
+  void lap(uint64_t PerfContext::*field) {
+    if (!on_) return;
+    const uint64_t t = perf_detail::now_ns();
+    perf_detail::context.*field += t - last_;
+    last_ = t;
+  }
+  void restart() { if (on_) last_ = perf_detail::now_ns(); }
+  bool enabled() const { return on_; }
+
+private:
+  bool on_;
+  uint64_t last_ = 0;
+};
+
+// Время области целиком
+class PerfTimer {
+public:
+  explicit PerfTimer(uint64_t PerfContext::*field) : field_(field) {}
+  ~PerfTimer() { sw_.lap(field_); }
+
+  PerfTimer(const PerfTimer&) = delete;
+  PerfTimer& operator=(const PerfTimer&) = delete;
+
+private:
+  PerfStopwatch sw_;
+  uint64_t PerfContext::*field_;
+};
+
+} // namespace uringkv
@@ -0,0 +1,65 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+namespace uringkv {
+
+// Token bucket для фоновой записи (flush, компактация, blob GC): за секунду
+// выдаётся rate байт, запас — не больше чем на refill_period. Запрос больше
+// запаса выдаётся порциями. HIGH (flush) обслуживается раньше LOW (компактация):
+// пока ждёт хотя бы один HIGH, LOW токены не получает.
+// rate == 0 — без ограничения (request возвращается сразу).
+class RateLimiter {
+public:
+  enum class Priority { HIGH, LOW };
+
+  explicit RateLimiter(uint64_t bytes_per_sec,
+                       std::chrono::microseconds refill_period = std::chrono::milliseconds(100));
+
+  RateLimiter(const RateLimiter&) = delete;
+  RateLimiter& operator=(const RateLimiter&) = delete;
+
+  // Блокирует, пока не наберётся bytes токенов
+  void request(uint64_t bytes, Priority pri);
+
+  // Новая скорость действует сразу, в том числе для ждущих
+  void set_rate(uint64_t bytes_per_sec);
+  uint64_t rate() const { return rate_.load(std::memory_order_relaxed); }
+
+  // статистика: выдано байт и суммарное время ожидания (по приоритетам)
+  uint64_t bytes_through(Priority pri) const { return stat(pri).bytes.load(std::memory_order_relaxed); }
+  uint64_t wait_us(Priority pri) const { return stat(pri).wait_us.load(std::memory_order_relaxed); }
+  void reset_stats();
+
+private:
+  struct Stats {
+    std::atomic<uint64_t> bytes{0};
+    std::atomic<uint64_t> wait_us{0};
+  };
+  const Stats& stat(Priority pri) const { return pri == Priority::HIGH ? high_ : low_; }
+  Stats& stat(Priority pri) { return pri == Priority::HIGH ? high_ : low_; }
+
+  uint64_t burst_locked() const;
+  void refill_locked(std::chrono::steady_clock::time_point now);
+
+  std::atomic<uint64_t> rate_;
+  const std::chrono::microseconds period_;
+
+  std::mutex mu_;
+  std::condition_variable cv_;
+  double tokens_ = 0;
+  std::chrono::steady_clock::time_point last_refill_;
+  unsigned high_waiting_ = 0;
+
+  Stats high_, low_;
+};
+
+// Понизить приоритет дискового I/O вызывающего потока (ioprio best-effort, 7 —
+// самый низкий). Действует на планировщиках с поддержкой приоритетов (BFQ);
+// false — ядро не позволило.
+bool lower_thread_io_priority();
+
+} // namespace uringkv
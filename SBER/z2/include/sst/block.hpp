@@ -0,0 +1,209 @@
+// include/sst/block.hpp
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "sst/compression.hpp"
+
+namespace uringkv {
+
+// ---- SST v3: блоки данных ----
+// Записи упаковываются подряд в блоки целевого размера (по умолчанию 4 KiB).
+// Формат записи внутри блока (ключи префиксно сжаты относительно предыдущего):
+//   varint32 shared | varint32 non_shared | varint32 vlen | u8 flags
+//   [varint64 seqno — если в трейлере SST_BLOCK_F_SEQNO]
+//   key_delta[non_shared] | value[vlen]
+// Версии одного ключа идут подряд от новых к старым и не разрываются между блоками.
+// Хвост блока:
+//   uint32 restarts[n]  — смещения записей с shared == 0 (каждая restart_interval-я)
+//   uint32 n
+//   SstBlockTrailer     — checksum всего, что выше, + magic
+// Сжатый блок (кодек в трейлере) — см. sst/compression.hpp.
+struct SstBlockTrailer {
+  uint64_t checksum; // XXH64(records || restarts || n) | XXH64(compressed || raw_size)
+  uint32_t magic;    // 'SSTB' = 0x42545353
+  uint32_t reserved; // флаги блока (SST_BLOCK_F_*) | кодек << SST_BLOCK_CODEC_SHIFT
+};
+
+static constexpr uint32_t SST_BLOCK_F_SEQNO     = 1u; // записи несут seqno
+static constexpr uint32_t SST_BLOCK_CODEC_SHIFT = 8u; // биты 8..15 — SstCompression
+static constexpr uint32_t SST_BLOCK_CODEC_MASK  = 0xFFu << SST_BLOCK_CODEC_SHIFT;
+
+static constexpr uint32_t SST_BLOCK_MAGIC           = 0x42545353u; // 'SSTB'
+static constexpr uint32_t SST_RESTART_INTERVAL      = 16u;
+static constexpr uint32_t SST_MAX_BLOCK_SIZE        = 64u * 1024u; // rec_off должен влезать в 16 бит
+
+// Хеш-индекс v3 адресует запись парой (смещение блока, смещение внутри блока).
+inline uint64_t sst_pack_record_off(uint64_t block_off, uint32_t rec_off) {
+  return (block_off << 16) | (rec_off & 0xFFFFu);
+}
+inline uint64_t sst_record_block_off(uint64_t packed) { return packed >> 16; }
+inline uint32_t sst_record_in_block_off(uint64_t packed) {
+  return static_cast<uint32_t>(packed & 0xFFFFu);
+}
+
+struct SstBlockHandle {
+  uint64_t offset = 0;
+  uint32_t size   = 0; // включая трейлер
+};
+
+// Элемент блочного индекса (ordered): первый ключ блока + его handle.
+struct SstIndexEntry {
+  std::string    first_key;
+  SstBlockHandle handle;
+};
+
+// ---- on-disk заголовок sparse/блочного индекса ----
+// v1 (SST v2): {uint32 klen, uint64 off, key}
+// v2 (SST v3): {uint32 klen, uint64 off, uint32 size, key}
+struct SparseIndexHeader {
+  uint32_t magic;   // 'SIDX' = 0x53494458
+  uint32_t version; // 1 | 2
+  uint32_t count;   // number of entries
+};
+static constexpr uint32_t kSparseMagic        = 0x53494458u; // 'SIDX'
+static constexpr uint32_t kSparseVersion      = 1u;
+static constexpr uint32_t kBlockIndexVersion  = 2u;
+
+class SstBlockBuilder {
+public:
+  explicit SstBlockBuilder(uint32_t restart_interval = SST_RESTART_INTERVAL);
+
+  // смещение следующей записи внутри блока
+  uint32_t next_offset() const { return static_cast<uint32_t>(buf_.size()); }
+  bool empty() const { return count_ == 0; }
+  // оценка размера блока после finish()
+  size_t size_estimate() const;
+
+  void add(std::string_view key, uint32_t flags, std::string_view value, uint64_t seqno = 0);
+
+  // Дописывает restarts + трейлер; результат валиден до reset().
+  std::string_view finish();
+  void reset();
+
+private:
+  uint32_t restart_interval_;
+  std::string buf_;
+  std::string last_key_;
+  std::vector<uint32_t> restarts_;
+  uint32_t count_ = 0;
+};
+
+// Итератор по одному (уже проверенному) блоку.
+class SstBlockIter {
+public:
+  // Проверяет трейлер и checksum (checksum можно пропустить для блока,
+  // проверенного раньше — из кэша). Данные должны жить дольше итератора.
+  bool init(std::string_view block, bool verify_checksum = true);
+
+  void seek_to_first();
+  // первая запись с key >= target
+  void seek(std::string_view target);
+  // позиционироваться ровно на запись со смещением rec_off
+  bool seek_to_offset(uint32_t rec_off);
+  void next();
+
+  bool valid() const { return valid_; }
+  bool corrupted() const { return corrupted_; }
+
+  std::string_view key() const { return key_; }
+  std::string_view value() const { return value_; }
+  uint32_t flags() const { return flags_; }
+  // 0 — блок записан без seqno (старый v3)
+  uint64_t seqno() const { return seqno_; }
+  uint32_t offset() const { return cur_; }
+
+private:
+  uint32_t restart_point(uint32_t i) const;
+  void seek_to_restart(uint32_t i);
+  bool parse_next();
+
+  const char* data_ = nullptr;
+  uint32_t records_end_ = 0;  // конец секции записей
+  uint32_t num_restarts_ = 0;
+  uint32_t restarts_off_ = 0;
+
+  uint32_t cur_  = 0; // смещение текущей записи
+  uint32_t next_ = 0; // смещение следующей
+  std::string key_;
+  std::string_view value_;
+  uint32_t flags_ = 0;
+  uint64_t seqno_ = 0;
+  bool has_seqno_ = false;
+  bool valid_ = false;
+  bool corrupted_ = false;
+};
+
+// Сжать готовый блок (SstBlockBuilder::finish). false — блок надо писать как
+// есть: кодек не сработал или выигрыш меньше 1/8.
+bool sst_compress_block(std::string_view block, SstCompressor& c, const SstCompressionDict* dict,
+                        std::string& out);
+
+// Блок в том виде, как он лежит на диске: проверка трейлера и checksum.
+// Сжатый распаковывается в out (обычный блок, трейлер без кодека),
+// для несжатого out остаётся пустым — годен сам raw.
+// Результат отдаётся в SstBlockIter::init без повторной проверки checksum.
+bool sst_unpack_block(std::string_view raw, std::string& out, const SstCompressionDict* dict = nullptr);
+
+// pread блока целиком + sst_unpack_block; в out — проверенный несжатый блок
+bool sst_read_block(int fd, const SstBlockHandle& h, std::string& out,
+                    const SstCompressionDict* dict = nullptr);
+
+// Загрузка блочного индекса v3 в память
+bool sst_load_block_index(int fd, uint64_t off, uint64_t len, uint32_t count,
+                          std::vector<SstIndexEntry>& out);
+
+// Индекс блока, который может содержать key (последний first_key <= key); -1 если нет
+long sst_find_block(const std::vector<SstIndexEntry>& index, std::string_view key);
+
+// Точечный поиск в SST v3: через mmap-хеш-индекс (если hidx != nullptr),
+// иначе бинпоиском по блочному индексу. Возвращает {flag, value} самой новой
+// версии с seqno <= snapshot (записи без seqno видны любому снимку).
+// cache (опционально) — блоки файла file_id берутся/кладутся в BlockCache
+// (распакованными); dict — словарь zstd таблицы; seqno (опционально) — seqno
+// найденной версии.
+class MmapHashIndex;
+class BlockCache;
+std::optional<std::pair<uint32_t, std::string>>
+sst_v3_point_lookup(int fd, const std::vector<SstIndexEntry>& index,
+                    const MmapHashIndex* hidx,
+                    std::string_view key, BlockCache* cache = nullptr, uint64_t file_id = 0,
+                    uint64_t snapshot = UINT64_MAX, const SstCompressionDict* dict = nullptr,
+                    uint64_t* seqno = nullptr);
+
+// Найденная версия без копии значения: value (пусто для SST_FLAG_DEL) — вид в
+// блок, который держит hold (блок BlockCache) или buf (прочитан без кэша).
+// Вид живёт, пока жив этот объект; при перемещении объекта buf может сменить адрес.
+struct SstValueRef {
+  uint32_t flags = 0;
+  std::string_view value;
+  std::shared_ptr<const std::string> hold; // BlockCache::Handle
+  std::string buf;
+};
+// То же, что выше, без копии значения; false — подходящей версии нет
+bool sst_v3_point_lookup(int fd, const std::vector<SstIndexEntry>& index,
+                         const MmapHashIndex* hidx, std::string_view key, SstValueRef& out,
+                         BlockCache* cache = nullptr, uint64_t file_id = 0,
+                         uint64_t snapshot = UINT64_MAX, const SstCompressionDict* dict = nullptr,
+                         uint64_t* seqno = nullptr);
+
+// Первая половина точечного поиска без I/O: блок, в котором может лежать key, и
+// (если есть хеш-индекс v1) упакованная позиция записи, иначе packed = UINT64_MAX.
+// С хеш-индексом это первый кандидат: при несовпадении ключа нужен полный поиск.
+// false — ключа в файле точно нет. Используется пакетным чтением (KV::multi_get).
+bool sst_v3_locate(const std::vector<SstIndexEntry>& index,
+                   const MmapHashIndex* hidx,
+                   std::string_view key, SstBlockHandle& bh, uint64_t& packed);
+
+// Блок через кэш (cache может быть nullptr): it разбирает блок, данные держит
+// hold (блок BlockCache) или buf. Используется точечным поиском и итераторами SstTable.
+bool sst_load_block(int fd, const SstBlockHandle& bh, BlockCache* cache, uint64_t file_id,
+                    const SstCompressionDict* dict, std::shared_ptr<const std::string>& hold,
+                    std::string& buf, SstBlockIter& it);
+
+} // namespace uringkv
@@ -0,0 +1,103 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "kv.hpp" // SstCompression
+
+struct ZSTD_CDict_s;
+struct ZSTD_DDict_s;
+
+namespace uringkv {
+
+// ---- сжатие блоков SST v3 ----
+// Кодек (SstCompression) хранится в битах 8..15 SstBlockTrailer::reserved.
+// Сжатый блок на диске:
+//   codec(records || restarts || n) | uint32 raw_size | SstBlockTrailer
+// checksum трейлера считается по сжатым байтам, т.е. проверяется до распаковки.
+// В памяти и в BlockCache блок лежит уже распакованным, с трейлером без кодека.
+// Кодеки подключаются при сборке (HAVE_LZ4 / HAVE_ZSTD).
+
+bool sst_compression_supported(SstCompression c);
+const char* sst_compression_name(SstCompression c);
+// "none" | "lz4" | "zstd"
+bool parse_sst_compression(std::string_view s, SstCompression& out);
+
+// Словарь zstd: обучается по блокам SST при записи (компактация) и хранится в
+// самой таблице. Читатели загружают его один раз при открытии файла.
+class SstCompressionDict {
+public:
+  explicit SstCompressionDict(std::string raw);
+  ~SstCompressionDict();
+
+  SstCompressionDict(const SstCompressionDict&) = delete;
+  SstCompressionDict& operator=(const SstCompressionDict&) = delete;
+
+  bool good() const { return ddict_ != nullptr; }
+  const std::string& raw() const { return raw_; }
+  // подготовить словарь для сжатия (нужно только писателю)
+  bool prepare_compress(int level);
+
+  ZSTD_CDict_s* cdict() const { return cdict_; }
+  ZSTD_DDict_s* ddict() const { return ddict_; }
+
+private:
+  std::string raw_;
+  ZSTD_CDict_s* cdict_ = nullptr;
+  ZSTD_DDict_s* ddict_ = nullptr;
+};
+
+// Контекст сжатия одного писателя (ZSTD_CCtx переиспользуется между блоками).
+class SstCompressor {
+public:
+  SstCompressor(SstCompression c, int level);
+  ~SstCompressor();
+
+  SstCompressor(const SstCompressor&) = delete;
+  SstCompressor& operator=(const SstCompressor&) = delete;
+
+  SstCompression codec() const { return codec_; }
+  // false — кодек не собран или ошибка кодека
+  bool compress(std::string_view in, std::string& out, const SstCompressionDict* dict = nullptr);
+
+private:
+  SstCompression codec_;
+  int level_;
+  void* cctx_ = nullptr; // ZSTD_CCtx
+};
+
+// Распаковать ровно raw_size байт; dict — словарь таблицы (если есть).
+// Потокобезопасна (контекст zstd — на поток).
+bool sst_uncompress(SstCompression c, std::string_view in, std::size_t raw_size, std::string& out,
+                    const SstCompressionDict* dict = nullptr);
+
+// Обучение словаря zstd по образцам (подряд в samples, длины в sizes).
+// Пустая строка — образцов мало или кодек не собран.
+std::string sst_train_zstd_dict(const std::string& samples, const std::vector<std::size_t>& sizes,
+                                std::size_t max_bytes);
+
+// Блок словаря в SST: raw | uint64 XXH64(raw). Чтение возвращает nullptr, если
+// блок битый или zstd не собран.
+std::string sst_encode_dict_block(const std::string& raw);
+std::unique_ptr<SstCompressionDict> sst_read_dict_block(int fd, uint64_t off, uint64_t size);
+
+// Счётчики распаковки на процесс (BlockCache хранит уже распакованные блоки,
+// поэтому сюда попадают только чтения с диска).
+struct SstCodecStats {
+  std::atomic<uint64_t> blocks_decompressed{0};
+  std::atomic<uint64_t> bytes_decompressed{0};
+  std::atomic<uint64_t> decompress_ns{0};
+
+  void reset() {
+    blocks_decompressed.store(0, std::memory_order_relaxed);
+    bytes_decompressed.store(0, std::memory_order_relaxed);
+    decompress_ns.store(0, std::memory_order_relaxed);
+  }
+};
+SstCodecStats& sst_codec_stats();
+
+} // namespace uringkv
@@ -0,0 +1,64 @@
+// include/sst/filter.hpp
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace uringkv {
+
+// ---- SST v3: блок фильтра ----
+// Блочный bloom-фильтр (split block bloom, как в Parquet/Impala): блок 256 бит
+// = 8 слов по 32 бита. Ключ выбирает блок старшей половиной хеша и ставит по
+// одному биту в каждом слове (бит = (lo32 * salt[i]) >> 27). Проверка — 8
+// независимых операций над словами одного кэш-блока: векторизуется (AVX2).
+// На вход идёт 64-битный хеш ключа (sst_key_hash, 0 -> 1 как в хеш-индексе).
+//
+// На диске: SstFilterHeader | uint32 words[num_blocks * 8]
+// Положение блока в файле — SstFooterExt::reserved[0..1] (offset, size);
+// нули = фильтра нет (старые v3-файлы).
+struct SstFilterHeader {
+  uint32_t magic;        // 'BLMF' = 0x464D4C42
+  uint32_t kind;         // 1 = split block bloom
+  uint32_t num_blocks;
+  uint32_t bits_per_key; // с какой плотностью строился (справочно)
+  uint64_t checksum;     // XXH64(words)
+};
+
+static constexpr uint32_t kSstFilterMagic      = 0x464D4C42u; // 'BLMF'
+static constexpr uint32_t kSstFilterBlockBloom = 1u;
+
+inline uint64_t sst_filter_key_hash(uint64_t h) { return h == 0 ? 1 : h; }
+
+class BloomFilterBuilder {
+public:
+  explicit BloomFilterBuilder(uint32_t bits_per_key) : bits_per_key_(bits_per_key) {}
+
+  void add_hash(uint64_t h) { hashes_.push_back(h); }
+  bool empty() const { return hashes_.empty(); }
+
+  // заголовок + блоки
+  std::string finish();
+
+private:
+  uint32_t bits_per_key_;
+  std::vector<uint64_t> hashes_;
+};
+
+class BloomFilter {
+public:
+  // Проверяет заголовок и checksum; данные копируются (выровненно).
+  bool init(std::string_view data);
+  bool good() const { return num_blocks_ != 0; }
+
+  // false — ключа точно нет
+  bool may_contain(uint64_t h) const;
+
+  std::size_t memory_usage() const { return words_.size() * sizeof(uint32_t); }
+
+private:
+  std::vector<uint32_t> words_;
+  uint32_t num_blocks_ = 0;
+};
+
+} // namespace uringkv
@@ -6,16 +6,42 @@ namespace uringkv {
 
 // v2 footer: добавили оффсет/размер разреженного индекса (sparse)
 // и переименовали поля hash_* для явности.
+//
+// v3: тот же футер в самом конце файла, но данные упакованы в блоки
+// (см. sst/block.hpp). Поля трактуются так:
+//   hash_index_offset — начало HashIndexHeader; v1: entry.off = (block_off<<16)|rec_off,
+//                       v2: бакеты с номерами блоков (sst/index.hpp)
+//   sparse_offset     — начало блочного индекса (первый ключ + handle каждого блока)
+//   sparse_count      — кол-во блоков данных
+// Непосредственно перед SstFooter лежит SstFooterExt.
 struct SstFooter {
   uint64_t hash_index_offset; // начало HashIndexHeader
-  uint32_t hash_table_size;   // кол-во слотов хеш-таблицы (степень двойки)
-  uint32_t version;           // = 2
+  uint32_t hash_table_size;   // кол-во слотов (v1) / бакетов (v2) хеш-индекса (степень двойки)
+  uint32_t version;           // 2 | 3
   uint64_t sparse_offset;     // начало sparse-индекса (ordered)
   uint32_t sparse_count;      // кол-во опорных точек в sparse
   char     magic[8];          // "URKVSST"
 };
 
-inline constexpr const char* kSstMagic   = "URKVSST";
-inline constexpr uint32_t    kSstVersion = 2;
+// Расширение футера v3 (фиксированный размер, резерв под будущие блоки).
+struct SstFooterExt {
+  uint64_t data_end;          // конец секции блоков данных
+  uint64_t num_entries;       // кол-во записей
+  uint64_t index_size;        // размер блочного индекса в байтах (с заголовком)
+  uint32_t block_size;        // целевой размер блока при записи
+  uint32_t restart_interval;  // шаг restart-точек внутри блока
+  // reserved[0..1]: offset/size блока фильтра (sst/filter.hpp), 0 = нет
+  // reserved[2..3]: offset/size словаря zstd (sst/compression.hpp), 0 = нет
+  // reserved[4..5]: offset/size блока range tombstone'ов (sst/range_del.hpp), 0 = нет
+  uint64_t reserved[7];       // 0
+};
+
+inline constexpr const char* kSstMagic     = "URKVSST";
+inline constexpr uint32_t    kSstVersionV2 = 2;
+inline constexpr uint32_t    kSstVersionV3 = 3;
+inline constexpr uint32_t    kSstVersion   = kSstVersionV3; // формат записи по умолчанию
+
+// Читает футер (и расширение для v3) с конца файла; проверяет magic/version.
+bool sst_read_footer(int fd, SstFooter& f, SstFooterExt& ext);
 
 } // namespace uringkv
@@ -4,22 +4,30 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include <string>
+#include <vector>
 
 namespace uringkv {
 
 // ---- On-disk hash index layout ----
 // [HashIndexHeader]
-// [HashIndexEntry table[table_size]]
+// v1: [HashIndexEntry table[table_size]]
+// v2: [pad до 64 байт от начала файла][HashIndexBucket buckets[table_size]]
 // Footer (SstFooter) находится в самом конце файла.
 // Footer.index_offset указывает на начало HashIndexHeader.
-// Footer.index_count = table_size (кол-во слотов в таблице).
+// Footer.index_count = table_size (кол-во слотов v1 / бакетов v2).
 //
-// Пустой слот: entry.h == 0
+// v1: открытая адресация по слотам, LF <= 0.5; пустой слот: entry.h == 0.
+// v2 (SST v3): бакет = одна кэш-линия из 16 слотов {tag16, номер блока16}.
+//   Бакет выбирают младшие биты хеша, tag — старшие 16 бит (0 -> 1, 0 = пусто).
+//   Заполненный бакет переливается в следующий; поиск останавливается на бакете
+//   со свободным слотом. Tag'и бакета сравниваются одной SIMD-операцией (SSE2/AVX2).
+//   Позиции записи в блоке нет: ключ ищется в блоке по restart-точкам.
+//   Пишется, пока номер блока влезает в 16 бит, иначе — v1.
 
 struct HashIndexHeader {
   uint32_t magic;      // 'HIDX' (0x48494458)
-  uint32_t version;    // 1
-  uint64_t table_size; // количество слотов (степень двойки)
+  uint32_t version;    // 1 | 2
+  uint64_t table_size; // количество слотов (v1) / бакетов (v2), степень двойки
   uint64_t num_items;  // фактически занятых слотов
 };
 
@@ -28,12 +36,46 @@ struct HashIndexEntry {
   uint64_t off;  // файловое смещение SstRecordMeta (начало записи)
 };
 
-inline constexpr uint32_t kHidxMagic   = 0x48494458u; // 'HIDX'
-inline constexpr uint32_t kHidxVersion = 1u;
+inline constexpr uint32_t kHidxBucketSlots = 16;
+
+struct alignas(64) HashIndexBucket {
+  uint16_t tag[kHidxBucketSlots];   // 0 == empty
+  uint16_t block[kHidxBucketSlots]; // номер блока данных (порядок блочного индекса)
+};
+static_assert(sizeof(HashIndexBucket) == 64, "bucket must be one cache line");
+
+inline constexpr uint32_t kHidxMagic     = 0x48494458u; // 'HIDX'
+inline constexpr uint32_t kHidxVersionV1 = 1u;
+inline constexpr uint32_t kHidxVersionV2 = 2u;
+inline constexpr uint32_t kHidxVersion   = kHidxVersionV2; // для SST v3 по умолчанию
+inline constexpr uint64_t kHidxV2MaxBlocks = 1ull << 16;
 
 // только объявление (НЕ inline): определение в source/sst/index.cpp
 uint64_t sst_key_hash(const char* data, size_t len);
 
+inline uint16_t hidx_tag(uint64_t h) {
+  const auto t = static_cast<uint16_t>(h >> 48);
+  return t ? t : 1;
+}
+
+// Начало бакетов v2: сразу за заголовком, с выравниванием на 64 байта в файле
+// (mmap выровнен по странице, значит и в памяти бакет — ровно одна кэш-линия).
+inline uint64_t hidx_buckets_offset(uint64_t index_offset) {
+  return (index_offset + sizeof(HashIndexHeader) + 63) & ~uint64_t(63);
+}
+
+// Сравнение tag'ов бакета: бит i — слот i
+struct HashBucketMatch {
+  uint32_t hits;  // tag[i] == tag
+  uint32_t empty; // tag[i] == 0
+};
+HashBucketMatch hidx_match_scalar(const HashIndexBucket& b, uint16_t tag);
+HashBucketMatch hidx_match_simd(const HashIndexBucket& b, uint16_t tag); // AVX2 | SSE2 | scalar
+const char* hidx_simd_name();
+
+// items: {hash (0 -> 1), номер блока}; бакетов ~ items/12 (загрузка <= 0.75)
+std::vector<HashIndexBucket> sst_build_hash_buckets(const std::vector<HashIndexEntry>& items);
+
 // ---- MMap wrapper over index block ----
 class MmapHashIndex {
 public:
@@ -43,24 +85,65 @@ public:
   MmapHashIndex(const MmapHashIndex&) = delete;
   MmapHashIndex& operator=(const MmapHashIndex&) = delete;
 
-  // Map [index_offset, index_offset + size(header)+table_size*sizeof(entry))] RO
+  // Map [index_offset, конец таблицы/бакетов) RO; версия берётся из заголовка
   bool open(int fd, uint64_t index_offset, uint64_t table_size);
 
   void close();
 
-  bool good() const { return hdr_ && table_ && table_size_ != 0; }
+  bool good() const { return hdr_ && (table_ || buckets_) && table_size_ != 0; }
 
+  uint32_t version() const { return hdr_ ? hdr_->version : 0; }
   uint64_t table_size() const { return table_size_; }
+  // v1: слоты; у v2 — nullptr
   const HashIndexEntry* table() const { return table_; }
+  // байт таблицы/бакетов (то, что должно помещаться в кэш CPU)
+  uint64_t memory_usage() const {
+    return table_ ? table_size_ * sizeof(HashIndexEntry) : table_size_ * sizeof(HashIndexBucket);
+  }
+
+  // Кандидаты для хеша ключа h в порядке пробирования, пока fn не вернёт true.
+  // v1: fn(off) — упакованная позиция записи; v2: fn(n) — номер блока.
+  // Simd = false — скалярное сравнение tag'ов (для сравнения в бенчмарке).
+  template <bool Simd = true, class Fn>
+  void probe(uint64_t h, Fn&& fn) const;
 
 private:
   void*     map_base_   = nullptr;
   size_t    map_len_    = 0;
   size_t    page_off_   = 0;
 
-  const HashIndexHeader* hdr_   = nullptr;
-  const HashIndexEntry*  table_ = nullptr;
+  const HashIndexHeader* hdr_     = nullptr;
+  const HashIndexEntry*  table_   = nullptr;
+  const HashIndexBucket* buckets_ = nullptr;
   uint64_t table_size_ = 0;
 };
 
+template <bool Simd, class Fn>
+void MmapHashIndex::probe(uint64_t h, Fn&& fn) const {
+  if (h == 0) h = 1; // 0 зарезервирован под пустой слот
+  const uint64_t mask = table_size_ - 1;
+  uint64_t pos = h & mask;
+  if (table_) {
+    for (uint64_t step = 0; step < table_size_; ++step) {
+      const auto& e = table_[pos];
+      if (e.h == 0) return; // empty slot => not found
+      if (e.h == h && fn(e.off)) return;
+      pos = (pos + 1) & mask;
+    }
+    return;
+  }
+  if (!buckets_) return;
+  const uint16_t tag = hidx_tag(h);
+  for (uint64_t step = 0; step < table_size_; ++step) {
+    const auto& b = buckets_[pos];
+    HashBucketMatch m;
+    if constexpr (Simd) m = hidx_match_simd(b, tag);
+    else m = hidx_match_scalar(b, tag);
+    for (uint32_t hits = m.hits; hits; hits &= hits - 1)
+      if (fn(uint64_t(b.block[__builtin_ctz(hits)]))) return;
+    if (m.empty) return; // бакет не переполнялся => дальше ключа нет
+    pos = (pos + 1) & mask;
+  }
+}
+
 } // namespace uringkv
@@ -1,7 +1,9 @@
 #pragma once
+#include <cstddef>
+#include <cstdint>
 #include <string>
+#include <utility>
 #include <vector>
-#include <cstdint>
 
 namespace uringkv {
 
@@ -12,4 +14,95 @@ std::vector<std::string> list_sst_sorted(const std::string& sst_dir);
 
 std::string sst_name(uint64_t index); // "000001.sst"
 
+// ---- MANIFEST: состав LSM-дерева по уровням ----
+// Текстовый журнал правок sst/MANIFEST. Начинается со снимка (одна правка со
+// всеми файлами), дальше каждая правка дописывается с fsync:
+//   uringkv-manifest 2
+//   file <level> <index> <size> <min_seq> <max_seq> x<smallest hex> x<largest hex> [b<blob>,<blob>...] [r<n>]
+//   drop <index>                     -- SST выбыла из дерева
+//   blob <index> <bytes> <garbage>   -- новый blob-файл или его новый garbage
+//   dropblob <index>
+//   last <index>                     -- последний выданный индекс SST
+//   clean <next blob index>          -- база закрыта корректно: файлов вне журнала нет
+//   commit <xxh64 строк правки, hex>
+// file для уже известного индекса переносит таблицу на другой уровень.
+// Правка без commit (оборванная запись) при чтении отбрасывается. Журнал
+// длиннее порога переписывается новым снимком атомарно (tmp + rename + fsync
+// каталога). Формат 1 — один снимок без commit — читается как есть.
+struct SstFileMeta {
+  uint64_t    index = 0;
+  std::string path;     // полный путь (в MANIFEST хранится только индекс)
+  uint64_t    size = 0; // байт на диске
+  uint64_t    min_seq = 0;
+  uint64_t    max_seq = 0;
+  std::string smallest; // диапазон ключей [smallest, largest], включая range tombstone'ы
+  std::string largest;  // (их end — как включительная граница)
+  std::vector<uint64_t> blob_files; // blob-файлы, на которые ссылается таблица (по возрастанию)
+  uint64_t    range_dels = 0;       // range tombstone'ов в таблице (r<n>)
+};
+
+// blob-файл (blob/NNNNNN.blob): байт записей и сколько из них уже не нужны
+// (версии выброшены компактацией или перенесены GC). Файл без ссылок из SST удаляется.
+struct BlobFileMeta {
+  uint64_t index   = 0;
+  uint64_t bytes   = 0;
+  uint64_t garbage = 0;
+};
+
+// levels[0] — L0: диапазоны пересекаются, файлы по возрастанию индекса (старые раньше);
+// levels[1..] — непересекающиеся, по возрастанию smallest.
+using SstLevels = std::vector<std::vector<SstFileMeta>>;
+
+// Правка состава дерева (version edit): разница между соседними версиями
+struct VersionEdit {
+  uint64_t last_index = 0; // 0 — не менялся
+  std::vector<std::pair<std::size_t, SstFileMeta>> added; // уровень и файл (новый или перенесённый)
+  std::vector<uint64_t> removed;
+  std::vector<BlobFileMeta> blobs;  // новые blob-файлы и изменённый garbage
+  std::vector<uint64_t> blobs_removed;
+  uint64_t clean_next_blob = 0; // != 0 — отметка корректного закрытия
+};
+
+// Что известно о журнале после чтения
+struct ManifestStatus {
+  bool torn = false;       // хвост оборван или формат 1: перед дозаписью — rewrite
+  bool clean = false;      // последняя правка — отметка закрытия (сирот на диске нет)
+  uint64_t next_blob = 0;  // из отметки закрытия
+  uint64_t edits = 0;      // правок в журнале, включая снимок
+};
+
+// Новый журнал из одного снимка
+bool write_manifest_atomic(const std::string& sst_dir, uint64_t last_index, const SstLevels& levels,
+                           const std::vector<BlobFileMeta>& blobs = {});
+// false — MANIFEST нет или он битый; path заполняется по sst_dir. Уровни
+// упорядочены как в SstLevels.
+bool read_manifest(const std::string& sst_dir, uint64_t& last_index, SstLevels& levels,
+                   std::vector<BlobFileMeta>* blobs = nullptr, ManifestStatus* status = nullptr);
+
+// Дозапись правок в sst/MANIFEST (не потокобезопасно: вызывается под локом
+// владельца). Правка ставится одним write + fdatasync; после ошибки append
+// возвращает false, пока журнал не начат заново через rewrite.
+class ManifestLog {
+public:
+  explicit ManifestLog(std::string sst_dir) : dir_(std::move(sst_dir)) {}
+  ~ManifestLog();
+  ManifestLog(const ManifestLog&) = delete;
+  ManifestLog& operator=(const ManifestLog&) = delete;
+
+  // дописывать в существующий журнал (edits — сколько в нём правок, см. ManifestStatus)
+  bool open(uint64_t edits);
+  // начать журнал заново со снимка и открыть его на дозапись
+  bool rewrite(uint64_t last_index, const SstLevels& levels, const std::vector<BlobFileMeta>& blobs);
+  bool append(const VersionEdit& edit);
+
+  uint64_t bytes() const { return bytes_; } // размер журнала
+  uint64_t edits() const { return edits_; } // правок в журнале, включая снимок
+
+private:
+  std::string dir_;
+  int fd_ = -1;
+  uint64_t bytes_ = 0;
+  uint64_t edits_ = 0;
+};
+
 } // namespace uringkv
@@ -0,0 +1,35 @@
+// include/sst/range_del.hpp
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace uringkv {
+
+// ---- range tombstone: удаление всех ключей [start, end) ----
+// Накрывает версию (key, seqno) при start <= key < end и seqno < tombstone.seqno.
+// Хранится в WAL (запись пакета WAL_FLAG_RANGE_DEL), в MemTable (отдельный
+// skiplist) и в SST v3 (отдельный блок, см. ниже).
+struct RangeTombstone {
+  std::string start;
+  std::string end; // исключительная граница, не пустая
+  uint64_t seqno = 0;
+
+  bool contains(std::string_view key) const { return key >= start && key < end; }
+};
+
+// seqno самого нового tombstone'а, накрывающего key и видимого снимку
+// (seqno <= snapshot); 0 — такого нет. rts отсортированы по start.
+uint64_t range_del_covering_seq(const std::vector<RangeTombstone>& rts, std::string_view key,
+                                uint64_t snapshot = UINT64_MAX);
+
+// ---- SST v3: блок range tombstone'ов ----
+// u32 count | {varint32 slen | start | varint32 elen | end | u64 seqno} * count | u64 XXH64
+// по возрастанию start. Положение — SstFooterExt::reserved[4..5] (offset, size);
+// нули = блока нет.
+std::string sst_encode_range_del_block(std::vector<RangeTombstone> rts);
+// false — блок битый (таблица без него непригодна: удалённые ключи ожили бы)
+bool sst_read_range_del_block(int fd, uint64_t off, uint64_t size, std::vector<RangeTombstone>& out);
+
+} // namespace uringkv
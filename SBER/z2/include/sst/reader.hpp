@@ -1,7 +1,11 @@
 // include/sst/reader.hpp
 #pragma once
+#include "sst/block.hpp"
+#include "sst/footer.hpp"
 #include "sst/index.hpp"
+#include "sst/range_del.hpp"
 #include "sst/record.hpp"
+#include <memory>
 #include <optional>
 #include <string>
 #include <string_view>
@@ -12,6 +16,8 @@ namespace uringkv {
 // В этой версии Reader поддерживает:
 //  - mmap-хеш-индекс для point GET
 //  - разрежённый ordered-индекс для ускорения SCAN (lower_bound(start))
+//  - форматы v2 (запись на 4 KiB) и v3 (блоки с префиксным сжатием ключей,
+//    опционально сжатые LZ4/Zstd)
 
 class SstReader {
 public:
@@ -19,10 +25,67 @@ public:
   ~SstReader();
 
   bool good() const { return fd_ >= 0; }
+  // файл открыт и метаданные (футер, индексы, словарь, tombstone'ы) прочитаны
+  bool loaded() const { return loaded_; }
+  uint32_t version() const { return version_; }
 
   std::optional<std::pair<uint32_t, std::string>> get(std::string_view key);
   std::vector<std::pair<std::string, std::optional<std::string>>> scan(std::string_view start, std::string_view end);
 
+  // Ключи-границы для разбиения компактации по диапазонам: первые ключи блоков
+  // (v3) или записей разрежённого индекса (v2), по возрастанию
+  std::vector<std::string> boundary_keys() const;
+
+  // Range tombstone'ы (v3), по возрастанию start; итератор их не отдаёт
+  const std::vector<RangeTombstone>& range_tombstones() const { return range_dels_; }
+
+  // Потоковый итератор по всем записям (включая tombstone'ы и старые версии):
+  // key по возрастанию, версии ключа — от новых к старым.
+  // В памяти держит один блок (v3) или одну запись (v2); битые данные = конец,
+  // после которого corrupted() == true.
+  // Reader должен жить дольше итератора; читать им из нескольких потоков нельзя.
+  class Iterator {
+  public:
+    explicit Iterator(SstReader* r) : r_(r) {}
+
+    Iterator(const Iterator&) = delete;
+    Iterator& operator=(const Iterator&) = delete;
+
+    bool valid() const { return valid_; }
+    void seek_to_first();
+    // первая запись с key >= target
+    void seek(std::string_view target);
+    void next();
+
+    std::string_view key() const;
+    std::string_view value() const;
+    uint32_t flags() const;
+    // 0 — seqno не записан (v2 и v3 без SST_BLOCK_F_SEQNO)
+    uint64_t seqno() const;
+    // итерация оборвалась на ошибке чтения или контрольной суммы
+    bool corrupted() const { return corrupted_; }
+
+  private:
+    // v3: загрузить блок i (или закончить), пропуская пустые хвосты
+    void load_block(size_t i, std::string_view target);
+    // v2: прочитать запись по off_
+    void read_v2();
+
+    SstReader* r_;
+    bool valid_ = false;
+    bool corrupted_ = false;
+
+    // v3
+    size_t block_ = 0;
+    std::string buf_;
+    SstBlockIter it_;
+
+    // v2
+    uint64_t off_ = 0;
+    SstRecordMeta meta_{};
+    std::string key_, value_;
+  };
+
 private:
   bool load_footer_and_index();
   bool read_record_at(uint64_t off, SstRecordMeta &m, std::string &k,
@@ -35,6 +98,7 @@ private:
 
   std::string path_;
   int fd_ = -1;
+  bool loaded_ = false;
 
   // point-lookup индекс (mmap)
   MmapHashIndex index_;
@@ -45,6 +109,11 @@ private:
 
   // граница данных (начало индекса) берём из футера при загрузке
   uint64_t data_end_off_ = 0;
+
+  uint32_t version_ = 0;
+  std::vector<SstIndexEntry> blocks_; // v3: блочный индекс
+  std::unique_ptr<SstCompressionDict> dict_; // v3: словарь zstd, если записан
+  std::vector<RangeTombstone> range_dels_;   // v3: если записаны
 };
 
 } // namespace uringkv
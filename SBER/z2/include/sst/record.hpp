@@ -9,12 +9,14 @@ namespace uringkv {
 struct SstRecordMeta {
   uint32_t klen;
   uint32_t vlen;
-  uint32_t flags;    // 1=PUT, 2=DEL
+  uint32_t flags;    // 1=PUT, 2=DEL, 3=BLOB (только v3)
   uint64_t checksum; // XXH64(key||value)
 };
 
 static constexpr uint32_t SST_FLAG_PUT = 1u;
 static constexpr uint32_t SST_FLAG_DEL = 2u;
+// значение вынесено в blob-файл, в SST — закодированный BlobRef (blob/blob_file.hpp)
+static constexpr uint32_t SST_FLAG_BLOB = 3u;
 
 // ---- Torn-write protection for SST ----
 // Each SST record is followed by a small trailer and padding to 4 KiB.
@@ -1,19 +1,29 @@
 #pragma once
+#include <cstddef>
 #include <cstdint>
+#include <memory>
 #include <optional>
 #include <string>
 #include <string_view>
+#include <utility>
 #include <vector>
 
 #include "sst/record.hpp"
 #include "sst/index.hpp"
 #include "sst/footer.hpp"
+#include "sst/block.hpp"
+#include "sst/filter.hpp"
+#include "sst/range_del.hpp"
 
 namespace uringkv {
 
+class BlockCache;
+
 class SstTable {
 public:
-  explicit SstTable(std::string path);
+  // cache (опционально): блоки v3 / записи v2 читаются через BlockCache под ключом file_id.
+  // Сжатые блоки v3 распаковываются при чтении с диска и кэшируются распакованными.
+  explicit SstTable(std::string path, BlockCache* cache = nullptr, uint64_t file_id = 0);
   ~SstTable();
 
   SstTable(const SstTable&) = delete;
@@ -23,17 +33,124 @@ public:
   // Наличие mmap-хеш-индекса НЕ обязательно: get() умеет работать без него.
   bool good() const { return fd_ >= 0; }
   const std::string& path() const { return path_; }
+  uint32_t version() const { return footer_.version; }
+
+  // Возвращает {flag, value} самой новой версии с seqno <= snapshot или nullopt.
+  // v2 не хранит seqno — его записи видны любому снимку. Для SST_FLAG_BLOB
+  // value — закодированный BlobRef, значение читает KV из blob-файла.
+  // seqno (опционально) — seqno найденной версии (0 — не записан).
+  // Range tombstone'ы таблицы get не применяет — см. range_del_seq.
+  std::optional<std::pair<uint32_t, std::string>> get(std::string_view key,
+                                                      uint64_t snapshot = UINT64_MAX,
+                                                      uint64_t* seqno = nullptr) const;
+  // То же без копии значения (см. SstValueRef); false — подходящей версии нет.
+  // v2: запись закрепляется в BlockCache (без кэша — в out.buf).
+  bool get(std::string_view key, SstValueRef& out, uint64_t snapshot = UINT64_MAX,
+           uint64_t* seqno = nullptr) const;
+
+  // Двухфазный GET для пакетного чтения (KV::multi_get):
+  // prepare_get отвечает сразу (true, результат в out), если I/O не нужен —
+  // ключа точно нет или блок/запись уже в BlockCache; иначе заполняет rd.
+  // finish_get разбирает rd.size байт, прочитанных с rd.offset из fd().
+  // Ответ — самая новая версия с seqno <= rd.snapshot, как у get.
+  struct PendingRead {
+    uint64_t offset = 0;
+    uint32_t size   = 0;
+    uint64_t packed = UINT64_MAX; // v3: позиция записи из хеш-индекса
+    uint64_t snapshot = UINT64_MAX;
+  };
+  int fd() const { return fd_; }
+  bool prepare_get(std::string_view key, PendingRead& rd,
+                   std::optional<std::pair<uint32_t, std::string>>& out) const;
+  std::optional<std::pair<uint32_t, std::string>>
+  finish_get(std::string_view key, const PendingRead& rd, std::string_view data) const;
+
+  // Фильтр грузится один раз при открытии (таблица живёт в TableCache).
+  // key_hash = sst_key_hash(key); без фильтра — всегда true.
+  bool has_filter() const { return filter_.good(); }
+  bool may_contain(uint64_t key_hash) const {
+    return !filter_.good() || filter_.may_contain(sst_filter_key_hash(key_hash));
+  }
+
+  // Range tombstone'ы (v3) грузятся при открытии, по возрастанию start
+  const std::vector<RangeTombstone>& range_tombstones() const { return range_dels_; }
+  // seqno самого нового tombstone'а таблицы, накрывающего key (см. range_del_covering_seq)
+  uint64_t range_del_seq(std::string_view key, uint64_t snapshot = UINT64_MAX) const {
+    return range_dels_.empty() ? 0 : range_del_covering_seq(range_dels_, key, snapshot);
+  }
+
+  // Потоковый итератор по всем записям (tombstone'ы и старые версии включительно,
+  // как SstReader::Iterator), но блоки v3 / записи v2 читает через BlockCache
+  // таблицы. Таблица должна жить дольше итератора; один итератор — один поток.
+  class Iterator {
+  public:
+    explicit Iterator(const SstTable* t) : t_(t) {}
+
+    Iterator(const Iterator&) = delete;
+    Iterator& operator=(const Iterator&) = delete;
+
+    bool valid() const { return valid_; }
+    void seek_to_first();
+    // первая запись с key >= target
+    void seek(std::string_view target);
+    void next();
 
-  // Возвращает {flag, value} или nullopt (ключ не найден / tombstone).
-  std::optional<std::pair<uint32_t, std::string>> get(std::string_view key) const;
+    std::string_view key() const { return t_->footer_.version == kSstVersionV3 ? it_.key() : key_; }
+    std::string_view value() const { return t_->footer_.version == kSstVersionV3 ? it_.value() : value_; }
+    uint32_t flags() const { return t_->footer_.version == kSstVersionV3 ? it_.flags() : meta_.flags; }
+    // 0 — seqno не записан (v2 и v3 без SST_BLOCK_F_SEQNO)
+    uint64_t seqno() const { return t_->footer_.version == kSstVersionV3 ? it_.seqno() : 0; }
+
+  private:
+    // v3: загрузить блок i (или закончить), пропуская пустые хвосты
+    void load_block(size_t i, std::string_view target);
+    // v2: прочитать запись по off_
+    void read_v2();
+
+    const SstTable* t_;
+    bool valid_ = false;
+    SstValueRef blk_; // держит текущий блок v3 / запись v2 (hold или buf)
+
+    // v3
+    size_t block_ = 0;
+    SstBlockIter it_;
+
+    // v2
+    uint64_t off_ = 0;
+    SstRecordMeta meta_{};
+    std::string_view key_, value_;
+  };
+
+  // Хеш-индекс (mmap): версия (0 — нет) и байт слотов/бакетов
+  uint32_t hash_index_version() const { return index_.good() ? index_.version() : 0; }
+  uint64_t hash_index_bytes() const { return index_.good() ? index_.memory_usage() : 0; }
+
+  // Память под метаданные, которые таблица держит всё время жизни: индекс блоков,
+  // фильтр, словарь, range tombstone'ы (mmap хеш-индекса не в счёт)
+  std::size_t metadata_bytes() const;
 
 private:
   bool load_footer_and_index();
-  bool read_record_at(uint64_t off, SstRecordMeta& m, std::string& k, std::string& v) const;
+  bool load_sparse_index();
+  std::optional<std::pair<uint32_t, std::string>>
+  decode_read(std::string_view key, const PendingRead& rd, std::string_view data, bool from_cache) const;
+  // k, v — виды в запись, которую держит rec (hold из кэша или buf)
+  bool read_record_at(uint64_t off, SstRecordMeta& m, std::string_view& k, std::string_view& v,
+                      SstValueRef& rec) const;
 
   std::string path_;
   int fd_ = -1;
+  BlockCache* cache_ = nullptr;
+  uint64_t file_id_ = 0;
   MmapHashIndex index_;  // опционально используется для ускорения get()
+
+  SstFooter    footer_{};
+  SstFooterExt ext_{};
+  std::vector<SstIndexEntry> blocks_; // v3: блочный индекс в памяти
+  BloomFilter filter_;                // v3: если записан
+  std::unique_ptr<SstCompressionDict> dict_; // v3: словарь zstd, если записан
+  std::vector<RangeTombstone> range_dels_;   // v3: если записаны
+  std::vector<std::pair<std::string, uint64_t>> sparse_; // v2: разрежённый индекс (ключ, смещение записи)
 };
 
 } // namespace uringkv
@@ -1,14 +1,39 @@
 #pragma once
+#include <memory>
 #include <string>
 #include <optional>
 #include <vector>
 #include <string_view>
-#include <cstdint> 
+#include <cstdint>
+
+#include "sst/block.hpp"
+#include "sst/footer.hpp"
+#include "sst/index.hpp"
+#include "sst/range_del.hpp"
+#include "rate_limiter.hpp"
+
 namespace uringkv {
 
+struct SstWriterOptions {
+  uint32_t format_version   = kSstVersion;          // 2 = запись на 4 KiB, 3 = блоки
+  uint32_t block_size       = 4096;                 // целевой размер блока (v3)
+  uint32_t restart_interval = SST_RESTART_INTERVAL; // (v3)
+  uint32_t bloom_bits_per_key = 10;                 // (v3) блок фильтра; 0 = без фильтра
+  // (v3) хеш-индекс: 2 = бакеты по 64 байта (если блоков <= 65536), 1 = слоты {hash, off}
+  uint32_t hash_index_version = kHidxVersion;
+  // (v3) сжатие блоков данных; не собранный кодек заменяется на NONE
+  SstCompression compression = SstCompression::NONE;
+  int      compression_level = 0;
+  // (v3, ZSTD) размер словаря, обучаемого на первых блоках файла; 0 = без словаря
+  uint32_t zstd_dict_bytes   = 0;
+  // (v3) каждая запись в файл сначала берёт токены; nullptr — без ограничения
+  RateLimiter* rate_limiter = nullptr;
+  RateLimiter::Priority io_priority = RateLimiter::Priority::LOW;
+};
+
 class SstWriter {
 public:
-  explicit SstWriter(const std::string& path);
+  explicit SstWriter(const std::string& path, SstWriterOptions opts = {});
   ~SstWriter();
 
   SstWriter(const SstWriter&) = delete;
@@ -19,9 +44,75 @@ public:
       const std::vector<std::pair<std::string, std::optional<std::string>>>& entries,
       uint32_t index_step = 64);
 
+  // ---- потоковая запись: ключи по возрастанию, версии ключа — от новых к старым ----
+  // v3 пишет блоки по мере заполнения и хранит seqno; версии ключа не разрываются
+  // между блоками, хеш-индекс указывает на самую новую. v2 копит записи и пишет
+  // всё в finish(); seqno не хранит, поэтому оставляет только самую новую версию.
+  // SST_FLAG_BLOB пишется только в v3 (v2 знает лишь PUT/DEL).
+  bool add(std::string_view key, uint32_t flags, std::string_view value, uint64_t seqno = 0);
+  // (v3) range tombstone [start, end): копятся в памяти, блок пишется в finish();
+  // порядок добавления любой. v2 их не хранит — false.
+  bool add_range_tombstone(std::string_view start, std::string_view end, uint64_t seqno);
+  // дописать индексы/футер и fsync
+  bool finish();
+
+  uint64_t num_entries() const { return num_entries_; }
+  std::size_t num_range_tombstones() const { return range_dels_.size(); }
+  // v3: байт блоков данных до и после сжатия
+  uint64_t raw_block_bytes() const { return raw_block_bytes_; }
+  uint64_t stored_block_bytes() const { return stored_block_bytes_; }
+  bool has_dict() const { return dict_ != nullptr; }
+  // v3: версия записанного хеш-индекса (после finish)
+  uint32_t hash_index_version() const { return hidx_version_; }
+  // v2: оценка по уже добавленным записям (каждая занимает кратно 4 KiB);
+  // v3 со словарём: накопленные до обучения блоки считаются несжатыми
+  uint64_t file_size() const { return file_off_ + wbuf_.size() + v2_bytes_ + pending_bytes_; }
+
 private:
+  bool write_sorted_v2(
+      const std::vector<std::pair<std::string, std::optional<std::string>>>& entries,
+      uint32_t index_step);
+  bool flush_block();
+  bool emit_block(std::string_view block);
+  bool train_dict_and_emit();
+  bool append_out(std::string_view data);
+  bool flush_out();
+
   std::string path_;
   int fd_ = -1;
+  SstWriterOptions opts_;
+
+  // состояние v3
+  SstBlockBuilder block_;
+  std::string block_first_key_;
+  std::string last_key_; // последний добавленный ключ (границы версий)
+  std::vector<SstIndexEntry> index_;
+  std::size_t emitted_blocks_ = 0;     // блоков index_, уже записанных в файл
+  // {hash, (номер блока << 16) | rec_off}; в finish() номер заменяется смещением
+  std::vector<HashIndexEntry> hashes_;
+  std::string wbuf_;                   // буфер вывода (несколько блоков за один write)
+  uint64_t file_off_ = 0;              // сколько уже записано в файл
+  uint64_t num_entries_ = 0;
+  uint32_t hidx_version_ = 0;
+  std::vector<RangeTombstone> range_dels_;
+
+  // сжатие v3
+  std::unique_ptr<SstCompressor> compressor_;
+  std::unique_ptr<SstCompressionDict> dict_;
+  // пока словарь не обучен, готовые блоки копятся в памяти (они же — образцы)
+  bool dict_pending_ = false;
+  std::vector<std::string> pending_blocks_;
+  uint64_t pending_bytes_ = 0;
+  std::string cbuf_;
+  uint64_t raw_block_bytes_ = 0;
+  uint64_t stored_block_bytes_ = 0;
+
+  // состояние v2 (потоковый add)
+  std::vector<std::pair<std::string, std::optional<std::string>>> v2_pending_;
+  uint64_t v2_bytes_ = 0;
+
+  bool failed_ = false;
+  bool finished_ = false;
 };
 
 } // namespace uringkv
@@ -8,4 +8,11 @@ namespace uringkv {
 bool ensure_dir(const std::string& p);
 std::string join_path(std::string a, std::string b);
 uint64_t dummy_checksum(std::string_view a, std::string_view b);
+
+// ---- varint (LEB128) кодирование для компактных форматов (SST v3 блоки) ----
+void put_varint32(std::string& dst, uint32_t v);
+void put_varint64(std::string& dst, uint64_t v);
+// Декодирует varint из [p, limit); возвращает указатель за ним или nullptr при ошибке.
+const char* get_varint32(const char* p, const char* limit, uint32_t& v);
+const char* get_varint64(const char* p, const char* limit, uint64_t& v);
 } // namespace uringkv
@@ -1,5 +1,7 @@
 #pragma once
+#include <deque>
 #include <string>
+#include <string_view>
 #include <optional>
 #include <vector>
 #include "wal/record.hpp"
@@ -7,23 +9,45 @@
 
 namespace uringkv {
 
+// Записи одного сегмента WAL; key/value указывают в data/joined.
+struct WalSegment {
+  struct Record {
+    uint32_t flags; // WAL_FLAG_PUT | WAL_FLAG_DEL | WAL_FLAG_RANGE_DEL (пакеты уже раскрыты)
+    uint64_t seqno;
+    std::string_view key;
+    std::string_view value;
+  };
+  std::string data;               // файл целиком
+  std::deque<std::string> joined; // PACKED: записи, собранные из нескольких фрагментов
+  std::vector<Record> records;    // до первой битой/оборванной записи
+  uint64_t max_seqno = 0;
+};
+
+// Прочитать сегмент одним куском и проверить записи (XXH64 записи, XXH32
+// фрагментов PACKED). Пакет, битый хотя бы в одной записи, не попадает целиком.
+// false — файл не читается или это не сегмент WAL. Потокобезопасна: разные
+// сегменты можно разбирать параллельно.
+bool load_wal_segment(const std::string& path, WalSegment& seg);
+
+// Последовательное чтение всех сегментов каталога (по сегменту в памяти).
 class WalReader {
 public:
   explicit WalReader(const std::string& wal_dir);
-  ~WalReader();
 
   struct Item { uint32_t flags; uint64_t seqno; std::string key; std::string value; };
+  // Записи пакета (WAL_FLAG_BATCH) отдаются по одной как PUT/DEL/RANGE_DEL с seqno подряд;
+  // пакет с битой записью или кодировкой не отдаётся целиком.
   std::optional<Item> next();
   bool good() const { return !files_.empty(); }
 
 private:
-  bool open_next_file();
-  bool read_segment_header(int fd);
+  bool load_next();
 
   std::string wal_dir_;
   std::vector<std::string> files_;
   size_t file_pos_ = 0;
-  int fd_ = -1;
+  WalSegment seg_;
+  size_t rec_pos_ = 0;
 };
 
 } // namespace uringkv
@@ -6,12 +6,16 @@ namespace uringkv {
 struct WalRecordMeta {
   uint32_t klen;
   uint32_t vlen;
-  uint32_t flags;   // 1=PUT, 2=DEL
-  uint64_t seqno;
+  uint32_t flags;   // 1=PUT, 2=DEL, 4=BATCH
+  uint64_t seqno;   // BATCH: seqno первой записи пакета
   uint64_t checksum; // XXH64(key||value)
 };
 
 static constexpr uint32_t WAL_FLAG_PUT = 1u;
 static constexpr uint32_t WAL_FLAG_DEL = 2u;
+// пакет: klen = 0, value — закодированный WriteBatch (см. kv.hpp)
+static constexpr uint32_t WAL_FLAG_BATCH = 4u;
+// только внутри пакета: range tombstone, key = start, value = end (исключительно)
+static constexpr uint32_t WAL_FLAG_RANGE_DEL = 8u;
 
 } // namespace uringkv
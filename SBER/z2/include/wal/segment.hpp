@@ -1,13 +1,14 @@
 #pragma once
 #include <cstdint>
 #include <string>
+#include <vector>
 
 namespace uringkv {
 
 // Заголовок сегмента WAL (пишется ровно 4096 байт)
 struct WalSegmentHeader {
   char     magic[8];     // "URKVWAL"
-  uint32_t version;      // 1
+  uint32_t version;      // 1 = PADDED, 2 = PACKED
   uint32_t reserved;     // 0
   uint64_t start_seqno;  // seqno первой записи в сегменте
   // дальше padding до 4096
@@ -16,6 +17,7 @@ struct WalSegmentHeader {
 struct WalSegmentConst {
   static constexpr const char* MAGIC = "URKVWAL";
   static constexpr uint32_t VERSION = 1;
+  static constexpr uint32_t VERSION_PACKED = 2;
   static constexpr size_t   HEADER_SIZE = 4096;
   static constexpr size_t   BLOCK_SIZE  = 4096;   // НОВОЕ: выравнивание записей
 };
@@ -27,7 +29,30 @@ struct WalRecordTrailer {
 };
 static constexpr uint32_t WAL_TRAILER_MAGIC = 0x57414C52u; // 'WALR'
 
+// ---- PACKED (v2): записи подряд, фрагменты в стиле LevelDB ----
+// Сегмент после заголовка разбит на блоки BLOCK_SIZE. Запись
+// (WalRecordMeta+key+value) режется на фрагменты, не пересекающие границу блока:
+//   [WalFragmentHeader][payload]
+// Если в блоке осталось меньше sizeof(WalFragmentHeader) — хвост заполняется нулями.
+#pragma pack(push, 1)
+struct WalFragmentHeader {
+  uint32_t checksum; // XXH32(type || payload)
+  uint16_t length;   // длина payload
+  uint8_t  type;     // WalFragmentType
+};
+#pragma pack(pop)
+
+enum WalFragmentType : uint8_t {
+  WAL_FRAG_ZERO   = 0, // паддинг до конца блока
+  WAL_FRAG_FULL   = 1,
+  WAL_FRAG_FIRST  = 2,
+  WAL_FRAG_MIDDLE = 3,
+  WAL_FRAG_LAST   = 4
+};
+
 // имя файла сегмента: 000001.wal
 std::string wal_segment_name(uint64_t index);
+// имена сегментов каталога (NNNNNN.wal) по возрастанию индекса
+std::vector<std::string> list_wal_segments(const std::string& dir);
 
 } // namespace uringkv
@@ -2,6 +2,9 @@
 #pragma once
 #include <cstddef>
 #include <cstdint>
+#include <functional>
+#include <span>
+#include <string_view>
 #include <sys/uio.h> // struct iovec
 
 namespace uringkv {
@@ -25,6 +28,38 @@ public:
   bool writev(int fd, const struct ::iovec* iov, int iovcnt);
   bool fsync(int fd);
 
+  // Одно чтение пакета: res — прочитано байт или -errno.
+  struct ReadOp {
+    int      fd  = -1;
+    uint64_t off = 0;
+    uint32_t len = 0;
+    char*    dst = nullptr;
+    int      res = 0;
+  };
+  // Пакетное чтение: все SQE пакета уходят одним submit (порциями по глубине
+  // очереди), on_done(i) вызывается по мере прихода CQE. Чтения, влезающие в
+  // зарегистрированный fixed buffer, идут через READ_FIXED и копируются в dst.
+  // Без кольца (или если оно сломалось посреди пакета) — добирает pread'ом.
+  void read_batch(std::span<ReadOp> ops, const std::function<void(std::size_t)>& on_done);
+
+  // ---- асинхронная запись (WAL) ----
+  // cb(res): res — записано байт или -errno (ошибка write либо связанного fsync).
+  using WriteCallback = std::function<void(int)>;
+  // Запись data по смещению off; sync — следом fdatasync, связанный с записью
+  // IOSQE_IO_LINK (выполнится только после неё). Данные копируются: в
+  // зарегистрированный fixed buffer, используемый как кольцо (WRITE_FIXED; место
+  // освобождается по завершении в порядке отправки), а не влезающие — в кучу.
+  // SQE отправляются сами по набору submit_batch, иначе — в submit()/poll().
+  // false — кольца нет или оно сломано; тогда ничего не поставлено и cb не вызовется.
+  bool write_async(int fd, uint64_t off, std::string_view data, bool sync, WriteCallback cb);
+  // отправить подготовленные SQE одним io_uring_enter
+  bool submit();
+  // Забрать готовые CQE и вызвать колбэки (в вызывающем потоке);
+  // wait — отправить всё и дождаться всех завершений. Возвращает число колбэков.
+  std::size_t poll(bool wait);
+  // асинхронных записей, чьи колбэки ещё не вызваны
+  std::size_t inflight() const noexcept;
+
   // Optional stats (may return 0 if not implemented)
   uint64_t buf_acquires() const noexcept { return 0; }
   uint64_t buf_releases() const noexcept { return 0; }
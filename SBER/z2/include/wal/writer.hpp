@@ -1,10 +1,11 @@
 #pragma once
 #include <cstdint>
 #include <cstddef>
+#include <functional>
 #include <string>
 #include <string_view>
 
-#include "kv.hpp"                 // FlushMode
+#include "kv.hpp"                 // FlushMode, WalFormat
 #include "wal/uring_backend.hpp"  // UringBackend
 
 namespace uringkv {
@@ -19,7 +20,7 @@ public:
             unsigned uring_qd, bool uring_sqpoll,
             std::size_t uring_fixed_buffer_bytes, unsigned uring_submit_batch,
             uint64_t max_segment_bytes, uint64_t group_commit_bytes,
-            FlushMode flush_mode);
+            FlushMode flush_mode, WalFormat format = WalFormat::PADDED);
 
   ~WalWriter();
 
@@ -28,10 +29,38 @@ public:
 
   bool append_put(uint64_t seqno, std::string_view k, std::string_view v);
   bool append_del(uint64_t seqno, std::string_view k);
+  // весь пакет (WriteBatch::data()) — одна запись; seqno — у первой операции
+  bool append_batch(uint64_t first_seqno, std::string_view rep);
+
+  // PACKED: записать накопленные append_* одним write и, если набрался
+  // group_commit_bytes, сделать fsync. PADDED пишет сразу в append_*, тут no-op.
+  // С io_uring (async()) — commit_async + poll(true) для обоих форматов.
+  bool commit();
+
+  // Асинхронный commit (io_uring): накопленные записи — одна WRITE_FIXED из
+  // кольца в fixed buffer, и если набрался group_commit_bytes — связанный с ней
+  // fdatasync. on_durable(ok) вызывается из poll(), когда записи на диске (без
+  // fsync — когда записаны). Отправка — по uring_submit_batch SQE или в poll(true),
+  // так что несколько commit_async подряд уходят одним submit.
+  // Без io_uring пишет синхронно и вызывает on_durable сразу.
+  bool commit_async(std::function<void(bool)> on_durable);
+  // обработать завершения commit_async; wait — отправить всё и дождаться
+  void poll(bool wait);
+  bool async() const noexcept { return async_; }
 
   // принудительный fsync по политике
   void fsync_if_needed();
 
+  // Закрыть текущий сегмент (fsync) и начать новый; записи до него можно
+  // удалить, когда их данные окажутся в SST.
+  bool rotate(uint64_t next_seqno);
+  uint64_t segment_index() const noexcept { return seg_index_; }
+
+  WalFormat format() const noexcept { return format_; }
+  // байт записей в сегментах (с паддингом/заголовками фрагментов)
+  uint64_t appended_bytes() const noexcept { return appended_bytes_; }
+  uint64_t syncs() const noexcept { return sync_fsync_ + sync_fdatasync_ + sync_sfr_; }
+
   // useful for checking constructed state
   bool good() const noexcept { return fd_ >= 0; }
 
@@ -41,6 +70,10 @@ private:
   bool write_vectored(const struct ::iovec* iov, int iovcnt);
   bool fsync_backend();
   bool append_(const WalRecordMeta& m, std::string_view k, std::string_view v);
+  bool append_packed_(const WalRecordMeta& m, std::string_view k, std::string_view v);
+  void emit_fragments_(std::string_view rec);
+  bool write_pending_();
+  bool submit_async_(std::string_view data, bool sync, std::function<void(bool)> on_done);
 
 private:
   std::string wal_dir_;
@@ -48,17 +81,26 @@ private:
 
   bool         use_uring_ = false;
   UringBackend uring_;
+  // записи копятся в pending_ (и PADDED тоже) и уходят асинхронно по явным
+  // смещениям — файл сегмента открыт без O_APPEND
+  bool         async_ = false;
 
   int      fd_ = -1;
   uint64_t seg_index_ = 0;
   uint64_t seg_size_  = 0;
 
   uint64_t bytes_since_sync_ = 0;
+  uint64_t appended_bytes_   = 0;
 
   uint64_t max_segment_bytes_   = 64ull * 1024 * 1024;
   uint64_t group_commit_bytes_  = (1ull<<20);
   FlushMode flush_mode_         = FlushMode::FDATASYNC;
 
+  // PACKED: ещё не записанный хвост (целые фрагменты) и буфер сборки записи
+  WalFormat   format_ = WalFormat::PADDED;
+  std::string pending_;
+  std::string scratch_;
+
   // метрики durability (счётчики вызовов)
   uint64_t sync_fsync_      = 0;
   uint64_t sync_fdatasync_  = 0;
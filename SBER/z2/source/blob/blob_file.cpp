@@ -0,0 +1,148 @@
+#include "blob/blob_file.hpp"
+#include "util.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace uringkv {
+
+void encode_blob_ref(std::string& dst, const BlobRef& ref) {
+  put_varint64(dst, ref.file);
+  put_varint64(dst, ref.offset);
+  put_varint32(dst, ref.size);
+}
+
+bool decode_blob_ref(std::string_view src, BlobRef& ref) {
+  const char* p = src.data();
+  const char* limit = src.data() + src.size();
+  p = get_varint64(p, limit, ref.file);
+  if (p) p = get_varint64(p, limit, ref.offset);
+  if (p) p = get_varint32(p, limit, ref.size);
+  return p == limit;
+}
+
+std::string blob_name(uint64_t index) {
+  char b[32];
+  std::snprintf(b, sizeof(b), "%06llu.blob", (unsigned long long)index);
+  return std::string(b);
+}
+
+std::vector<std::string> list_blob_files(const std::string& blob_dir) {
+  std::vector<std::string> out;
+  DIR* d = ::opendir(blob_dir.c_str());
+  if (!d) return out;
+  while (auto* e = ::readdir(d)) {
+    std::string n = e->d_name;
+    if (n.size() == 11 && n.substr(6) == ".blob" && std::all_of(n.begin(), n.begin() + 6, ::isdigit))
+      out.push_back(std::move(n));
+  }
+  ::closedir(d);
+  std::sort(out.begin(), out.end());
+  return out;
+}
+
+// ---- BlobWriter ----
+
+BlobWriter::BlobWriter(const std::string& path, uint64_t index, RateLimiter* limiter,
+                       RateLimiter::Priority pri)
+    : path_(path), index_(index), limiter_(limiter), pri_(pri) {
+  fd_ = ::open(path_.c_str(), O_CREAT | O_TRUNC | O_WRONLY, 0644);
+  if (fd_ < 0) {
+    spdlog::error("Blob open failed: {} (errno={})", path_, errno);
+    return;
+  }
+  const BlobFileHeader h{BLOB_MAGIC, BLOB_VERSION};
+  wbuf_.append(reinterpret_cast<const char*>(&h), sizeof(h));
+}
+
+BlobWriter::~BlobWriter() {
+  if (fd_ >= 0) ::close(fd_);
+}
+
+bool BlobWriter::flush_out() {
+  if (limiter_ && !wbuf_.empty()) limiter_->request(wbuf_.size(), pri_);
+  const char* ptr = wbuf_.data();
+  size_t left = wbuf_.size();
+  while (left > 0) {
+    ssize_t w = ::write(fd_, ptr, left);
+    if (w < 0) {
+      if (errno == EINTR) continue;
+      spdlog::error("Blob write failed (errno={}): {}", errno, path_);
+      failed_ = true;
+      return false;
+    }
+    ptr += w;
+    left -= static_cast<size_t>(w);
+    file_off_ += static_cast<uint64_t>(w);
+  }
+  wbuf_.clear();
+  return true;
+}
+
+bool BlobWriter::add(std::string_view key, std::string_view value, BlobRef& ref) {
+  if (!good()) return false;
+  ref.file = index_;
+  ref.offset = file_size();
+  ref.size = static_cast<uint32_t>(value.size());
+
+  const BlobRecordHeader h{static_cast<uint32_t>(key.size()), static_cast<uint32_t>(value.size()),
+                           dummy_checksum(key, value)};
+  wbuf_.append(reinterpret_cast<const char*>(&h), sizeof(h));
+  wbuf_.append(key);
+  wbuf_.append(value);
+  if (wbuf_.size() >= 256 * 1024) return flush_out();
+  return true;
+}
+
+bool BlobWriter::finish() {
+  if (!good() || !flush_out()) return false;
+  if (::fdatasync(fd_) != 0) {
+    spdlog::error("Blob fdatasync failed (errno={}): {}", errno, path_);
+    failed_ = true;
+    return false;
+  }
+  return true;
+}
+
+// ---- BlobFile ----
+
+BlobFile::BlobFile(const std::string& path) : path_(path) {
+  fd_ = ::open(path_.c_str(), O_RDONLY);
+  if (fd_ < 0) spdlog::error("Blob open for read failed: {} (errno={})", path_, errno);
+}
+
+BlobFile::~BlobFile() {
+  if (fd_ >= 0) ::close(fd_);
+}
+
+bool BlobFile::read(const BlobRef& ref, std::string_view key, std::string& value) const {
+  if (fd_ < 0) return false;
+  std::string buf(blob_record_bytes(key.size(), ref.size), '\0');
+  size_t got = 0;
+  while (got < buf.size()) {
+    ssize_t r = ::pread(fd_, buf.data() + got, buf.size() - got, static_cast<off_t>(ref.offset + got));
+    if (r < 0 && errno == EINTR) continue;
+    if (r <= 0) break;
+    got += static_cast<size_t>(r);
+  }
+  BlobRecordHeader h{};
+  if (got == buf.size()) std::memcpy(&h, buf.data(), sizeof(h));
+  const std::string_view k(buf.data() + sizeof(h), key.size());
+  const std::string_view v(buf.data() + sizeof(h) + key.size(), ref.size);
+  if (got != buf.size() || h.klen != key.size() || h.vlen != ref.size || k != key ||
+      h.checksum != dummy_checksum(k, v)) {
+    spdlog::error("Blob record corrupted: {} @{}", path_, ref.offset);
+    return false;
+  }
+  value.assign(v);
+  return true;
+}
+
+} // namespace uringkv
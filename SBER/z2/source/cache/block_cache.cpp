@@ -0,0 +1,96 @@
+#include "cache/block_cache.hpp"
+
+namespace uringkv {
+
+// накладные расходы на запись (узел списка, слот хеш-таблицы, shared_ptr)
+static constexpr std::size_t kEntryOverhead = 96;
+
+BlockCache::BlockCache(std::size_t capacity_bytes, unsigned num_shard_bits)
+    : capacity_(capacity_bytes), shard_bits_(num_shard_bits > 8 ? 8 : num_shard_bits) {
+  const std::size_t n = std::size_t(1) << shard_bits_;
+  shard_capacity_ = (capacity_ + n - 1) / n;
+  shards_.reserve(n);
+  for (std::size_t i = 0; i < n; ++i) shards_.push_back(std::make_unique<Shard>());
+}
+
+BlockCache::Shard& BlockCache::shard_for(const Key& k) {
+  const uint64_t h = KeyHash{}(k);
+  return *shards_[shard_bits_ ? (h >> (64 - shard_bits_)) : 0];
+}
+
+BlockCache::Handle BlockCache::lookup(uint64_t file_id, uint64_t offset) {
+  const Key k{file_id, offset};
+  Shard& s = shard_for(k);
+  std::lock_guard<std::mutex> lk(s.mu);
+  auto it = s.map.find(k);
+  if (it == s.map.end()) {
+    misses_.fetch_add(1, std::memory_order_relaxed);
+    return nullptr;
+  }
+  hits_.fetch_add(1, std::memory_order_relaxed);
+  s.lru.splice(s.lru.begin(), s.lru, it->second);
+  return it->second->data;
+}
+
+void BlockCache::evict_locked(Shard& s) {
+  while (s.usage > shard_capacity_ && !s.lru.empty()) {
+    auto& back = s.lru.back();
+    s.usage -= back.charge;
+    s.map.erase(back.key);
+    s.lru.pop_back();
+    evictions_.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+BlockCache::Handle BlockCache::insert(uint64_t file_id, uint64_t offset, std::string data) {
+  const Key k{file_id, offset};
+  const std::size_t charge = data.size() + kEntryOverhead;
+  auto h = std::make_shared<const std::string>(std::move(data));
+  if (charge > shard_capacity_) return h; // не влезет — отдаём без кэширования
+
+  Shard& s = shard_for(k);
+  std::lock_guard<std::mutex> lk(s.mu);
+  auto it = s.map.find(k);
+  if (it != s.map.end()) {
+    s.lru.splice(s.lru.begin(), s.lru, it->second);
+    return it->second->data;
+  }
+  s.lru.push_front(Entry{k, h, charge});
+  s.map.emplace(k, s.lru.begin());
+  s.usage += charge;
+  evict_locked(s);
+  return h;
+}
+
+void BlockCache::erase_file(uint64_t file_id) {
+  for (auto& sp : shards_) {
+    Shard& s = *sp;
+    std::lock_guard<std::mutex> lk(s.mu);
+    for (auto it = s.lru.begin(); it != s.lru.end();) {
+      if (it->key.file_id == file_id) {
+        s.usage -= it->charge;
+        s.map.erase(it->key);
+        it = s.lru.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+}
+
+std::size_t BlockCache::usage() const {
+  std::size_t n = 0;
+  for (const auto& sp : shards_) {
+    std::lock_guard<std::mutex> lk(sp->mu);
+    n += sp->usage;
+  }
+  return n;
+}
+
+void BlockCache::reset_stats() {
+  hits_.store(0, std::memory_order_relaxed);
+  misses_.store(0, std::memory_order_relaxed);
+  evictions_.store(0, std::memory_order_relaxed);
+}
+
+} // namespace uringkv
@@ -0,0 +1,106 @@
+#include "cache/table_cache.hpp"
+#include "perf_context.hpp"
+
+#include <chrono>
+
+namespace uringkv {
+
+TableCache::TableCache(std::size_t capacity_files, BlockCache* block_cache, unsigned num_shard_bits)
+    : capacity_(capacity_files ? capacity_files : 1), block_cache_(block_cache) {
+  // не меньше 4 таблиц на шард, иначе неравномерное хеширование вытесняет раньше ёмкости
+  shard_bits_ = num_shard_bits > 8 ? 8 : num_shard_bits;
+  while (shard_bits_ > 0 && (capacity_ >> shard_bits_) < 4) --shard_bits_;
+  const std::size_t n = std::size_t(1) << shard_bits_;
+  shard_capacity_ = (capacity_ + n - 1) / n;
+  shards_.reserve(n);
+  for (std::size_t i = 0; i < n; ++i) shards_.push_back(std::make_unique<Shard>());
+}
+
+TableCache::Shard& TableCache::shard_for(uint64_t file) {
+  const uint64_t h = file * 0x9E3779B97F4A7C15ull;
+  return *shards_[shard_bits_ ? (h >> (64 - shard_bits_)) : 0];
+}
+
+std::shared_ptr<SstTable> TableCache::get_table(uint64_t file_number, const std::string& path) {
+  Shard& s = shard_for(file_number);
+  {
+    std::lock_guard<std::mutex> lk(s.mu);
+    auto it = s.map.find(file_number);
+    if (it != s.map.end()) {
+      hits_.fetch_add(1, std::memory_order_relaxed);
+      s.lru.splice(s.lru.begin(), s.lru, it->second);
+      return it->second->table;
+    }
+  }
+  misses_.fetch_add(1, std::memory_order_relaxed);
+
+  const auto t0 = std::chrono::steady_clock::now();
+  auto tbl = std::make_shared<SstTable>(path, block_cache_, block_cache_ ? file_number : 0);
+  const uint64_t ns = static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0).count());
+  const uint64_t us = ns / 1000;
+  perf_count(&PerfContext::table_open_count);
+  if (perf_time_enabled()) get_perf_context().table_open_ns += ns;
+  if (!tbl->good())
+    return nullptr;
+  opens_.fetch_add(1, std::memory_order_relaxed);
+  open_us_.fetch_add(us, std::memory_order_relaxed);
+  uint64_t mx = open_max_us_.load(std::memory_order_relaxed);
+  while (us > mx && !open_max_us_.compare_exchange_weak(mx, us, std::memory_order_relaxed)) {
+  }
+
+  std::lock_guard<std::mutex> lk(s.mu);
+  auto it = s.map.find(file_number);
+  if (it != s.map.end()) { // открыл параллельный читатель — берём его копию
+    s.lru.splice(s.lru.begin(), s.lru, it->second);
+    return it->second->table;
+  }
+  const std::size_t charge = tbl->metadata_bytes();
+  s.lru.push_front(Entry{file_number, tbl, charge});
+  s.map.emplace(file_number, s.lru.begin());
+  s.pinned += charge;
+  while (s.lru.size() > shard_capacity_) {
+    auto& back = s.lru.back();
+    s.pinned -= back.charge;
+    s.map.erase(back.file);
+    s.lru.pop_back();
+    evictions_.fetch_add(1, std::memory_order_relaxed);
+  }
+  return tbl;
+}
+
+void TableCache::erase_file(uint64_t file_number) {
+  Shard& s = shard_for(file_number);
+  std::lock_guard<std::mutex> lk(s.mu);
+  auto it = s.map.find(file_number);
+  if (it == s.map.end())
+    return;
+  s.pinned -= it->second->charge;
+  s.lru.erase(it->second);
+  s.map.erase(it);
+}
+
+std::size_t TableCache::size() const {
+  std::size_t n = 0;
+  for (const auto& sp : shards_) {
+    std::lock_guard<std::mutex> lk(sp->mu);
+    n += sp->lru.size();
+  }
+  return n;
+}
+
+std::size_t TableCache::pinned_bytes() const {
+  std::size_t n = 0;
+  for (const auto& sp : shards_) {
+    std::lock_guard<std::mutex> lk(sp->mu);
+    n += sp->pinned;
+  }
+  return n;
+}
+
+void TableCache::reset_stats() {
+  for (auto* c : {&hits_, &misses_, &opens_, &evictions_, &open_us_, &open_max_us_})
+    c->store(0, std::memory_order_relaxed);
+}
+
+} // namespace uringkv
@@ -0,0 +1,57 @@
+#include "histogram.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace uringkv {
+
+LatencyHistogram::LatencyHistogram() : counts_(new std::atomic<uint64_t>[kBuckets]) {
+  for (std::size_t i = 0; i < kBuckets; ++i) counts_[i].store(0, std::memory_order_relaxed);
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& o) {
+  for (std::size_t i = 0; i < kBuckets; ++i) {
+    const uint64_t c = o.counts_[i].load(std::memory_order_relaxed);
+    if (c) counts_[i].fetch_add(c, std::memory_order_relaxed);
+  }
+  total_.fetch_add(o.count(), std::memory_order_relaxed);
+  sum_.fetch_add(o.sum(), std::memory_order_relaxed);
+  if (o.count()) {
+    const uint64_t omax = o.max(), omin = o.min();
+    uint64_t m = max_.load(std::memory_order_relaxed);
+    while (omax > m && !max_.compare_exchange_weak(m, omax, std::memory_order_relaxed)) {}
+    m = min_.load(std::memory_order_relaxed);
+    while (omin < m && !min_.compare_exchange_weak(m, omin, std::memory_order_relaxed)) {}
+  }
+}
+
+void LatencyHistogram::reset() {
+  for (std::size_t i = 0; i < kBuckets; ++i) counts_[i].store(0, std::memory_order_relaxed);
+  total_.store(0, std::memory_order_relaxed);
+  sum_.store(0, std::memory_order_relaxed);
+  min_.store(UINT64_MAX, std::memory_order_relaxed);
+  max_.store(0, std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::bucket_high(std::size_t i) {
+  if (i < kLinear) return i;
+  const std::size_t j = i - kLinear;
+  const unsigned shift = static_cast<unsigned>(j >> kSubBits) + 1;
+  const uint64_t sub = (uint64_t(1) << kSubBits) + (j & ((std::size_t(1) << kSubBits) - 1));
+  return ((sub + 1) << shift) - 1;
+}
+
+uint64_t LatencyHistogram::percentile(double p) const {
+  const uint64_t n = count();
+  if (n == 0) return 0;
+  // ранг p-го перцентиля, не меньше первого значения
+  const auto rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(std::clamp(p, 0.0, 100.0) / 100.0 * double(n))));
+  uint64_t seen = 0;
+  for (std::size_t i = 0; i < kBuckets; ++i) {
+    seen += counts_[i].load(std::memory_order_relaxed);
+    if (seen >= rank) return std::min(bucket_high(i), max());
+  }
+  return max();
+}
+
+} // namespace uringkv
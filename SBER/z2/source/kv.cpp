@@ -1,5 +1,12 @@
 #include "kv.hpp"
+#include "blob/blob_file.hpp"
+#include "cache/block_cache.hpp"
 #include "cache/table_cache.hpp"
+#include "histogram.hpp"
+#include "memtable/memtable.hpp"
+#include "perf_context.hpp"
+#include "rate_limiter.hpp"
+#include "sst/compression.hpp"
 #include "sst/manifest.hpp"
 #include "sst/reader.hpp"
 #include "sst/writer.hpp"
@@ -9,11 +16,20 @@
 
 #include <algorithm>
 #include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
 #include <condition_variable>
+#include <deque>
 #include <dirent.h>
 #include <fcntl.h>
 #include <filesystem>
+#include <functional>
+#include <map>
+#include <memory>
 #include <mutex>
+#include <queue>
+#include <set>
 #include <spdlog/spdlog.h>
 #include <thread>
 #include <unistd.h>
@@ -21,10 +37,33 @@
 
 namespace uringkv {
 
+// Какие версии ключа сохранить при flush/компактации: самую новую и для каждого
+// живого снимка самую новую из видимых ему. Версии подаются от новых к старым;
+// "полоса" версии — число снимков старше неё (версии одной полосы неразличимы).
+struct VersionFilter {
+  std::vector<uint64_t> snapshots; // по возрастанию
+  std::size_t prev = SIZE_MAX;
+
+  void new_key() { prev = SIZE_MAX; }
+  std::size_t stripe(uint64_t seq) const {
+    return static_cast<std::size_t>(std::lower_bound(snapshots.begin(), snapshots.end(), seq) -
+                                    snapshots.begin());
+  }
+  // false — версию заслоняет более новая из той же полосы
+  bool keep(uint64_t seq) {
+    const std::size_t st = stripe(seq);
+    if (st == prev)
+      return false;
+    prev = st;
+    return true;
+  }
+};
+
 struct KV::Impl {
   KVOptions opts;
   std::string wal_dir;
   std::string sst_dir;
+  std::string blob_dir;
 
   WalWriter wal{std::string{},
                 false,
@@ -36,43 +75,783 @@ struct KV::Impl {
                 (1ull << 20),
                 FlushMode::FDATASYNC};
 
-  // MemTable: key -> value / tombstone
-  std::unordered_map<std::string, std::optional<std::string>> mem;
-  uint64_t mem_bytes = 0;
-
-  // L0 SST list (full paths), ascending by index
-  std::vector<std::string> ssts;
+  // MemTable (skiplist). Указатель меняется только под mu,
+  // читатели берут его через std::atomic_load и mu не трогают.
+  std::shared_ptr<MemTable> mem = std::make_shared<MemTable>();
+
+  // Immutable MemTable: ждёт записи в SST фоновым flush-потоком.
+  // WAL-сегменты с индексом < imm_wal_seg покрыты ею и удаляются после flush.
+  std::shared_ptr<MemTable> imm;
+  uint64_t imm_wal_seg = 0;
+  std::thread bg_flusher;
+  std::condition_variable flush_cv;    // flush-потоку: появилась imm / стоп
+  std::condition_variable imm_done_cv; // писателям: imm сброшена
+  bool stop_flush = false;
+
+  // LSM-дерево (см. SstLevels): только L0 для SIZE_TIERED, L0..Ln для LEVELED.
+  // Рабочая копия для фона, под mu; читатели берут версию (current).
+  // Правка сначала дописывается в MANIFEST, затем публикуется новая версия.
+  SstLevels levels;
   uint64_t next_sst_index = 0;
+  std::vector<std::string> compact_pointer; // LEVELED: largest последнего слитого файла уровня
+
+  // Кэш блоков SST (свои локи по шардам); объявлен раньше tcache — таблицы
+  // держат на него указатель
+  std::unique_ptr<BlockCache> bcache;
+
+  // Кэш открытых таблиц (свои локи по шардам): после компактации закрываются
+  // только выбывшие файлы
+  std::unique_ptr<TableCache> tcache;
+
+  // Blob-файлы (разделение значений). Метаданные меняются под mu и пишутся в
+  // MANIFEST вместе с деревом; открытые на чтение файлы входят в версию
+  // неизменяемым набором: читатель дочитывает даже файл, выброшенный GC.
+  struct BlobSet {
+    std::map<uint64_t, std::shared_ptr<BlobFile>> files;
+  };
+  std::map<uint64_t, BlobFileMeta> blob_meta;
+  std::atomic<uint64_t> next_blob_index{1};
+
+  // Файл дерева (SST или blob), на который ссылаются версии. Выбывший из
+  // дерева файл удаляется с диска, когда его отпустит последняя версия;
+  // тогда же on_retire закрывает его таблицу и блоки в кэшах (раньше нельзя:
+  // читатель старой версии открыл бы таблицу заново и держал удалённый файл).
+  struct LiveFile {
+    LiveFile(std::string p, std::atomic<uint64_t> *counter, std::function<void()> retire = {})
+        : path(std::move(p)), deleted(counter), on_retire(std::move(retire)) {}
+    ~LiveFile() {
+      if (!obsolete.load(std::memory_order_acquire))
+        return;
+      if (on_retire)
+        on_retire();
+      if (::unlink(path.c_str()) == 0)
+        deleted->fetch_add(1, std::memory_order_relaxed);
+    }
+    std::string path;
+    std::atomic<uint64_t> *deleted; // счётчик удалённых файлов (метрика)
+    std::function<void()> on_retire;
+    std::atomic<bool> obsolete{false};
+  };
+
+  // Версия дерева — неизменяемый снимок уровней и blob-файлов. Публикуется
+  // std::atomic_store; читатель берёт её std::atomic_load без локов и держит
+  // сколько нужно (get, итератор), файлы версии всё это время на диске.
+  struct Version {
+    explicit Version(std::atomic<uint64_t> *counter) : live(counter) { live->fetch_add(1); }
+    ~Version() { live->fetch_sub(1); }
+    Version(const Version &) = delete;
+    Version &operator=(const Version &) = delete;
+
+    SstLevels levels;
+    std::shared_ptr<const BlobSet> blobs = std::make_shared<BlobSet>();
+    std::vector<std::shared_ptr<LiveFile>> files;
+    std::atomic<uint64_t> *live; // счётчик живых версий (метрика)
+  };
+  std::atomic<uint64_t> m_versions_live{0};
+  std::shared_ptr<const Version> current = std::make_shared<Version>(&m_versions_live);
+  // файлы текущей версии по индексам (под mu)
+  std::map<uint64_t, std::shared_ptr<LiveFile>> live_ssts, live_blobs;
+  std::unique_ptr<ManifestLog> manifest; // журнал правок (под mu)
+
+  std::shared_ptr<const Version> current_version() const { return std::atomic_load(&current); }
+
+  // Новые blob-файлы одного flush или компактации; файл режется по blob_file_bytes.
+  // Пока результат не установлен в MANIFEST, файлы принадлежат заданию (discard).
+  struct BlobSink {
+    explicit BlobSink(Impl *d, RateLimiter::Priority p = RateLimiter::Priority::LOW) : db(d), pri(p) {}
+
+    Impl *db;
+    RateLimiter::Priority pri; // flush — HIGH, компактация и GC — LOW
+    std::unique_ptr<BlobWriter> wr;
+    std::vector<BlobFileMeta> files;
+
+    // ref — закодированный BlobRef для SST
+    bool add(std::string_view key, std::string_view value, std::string &ref, uint64_t &file) {
+      if (wr && wr->record_bytes() >= db->opts.blob_file_bytes && !close_current())
+        return false;
+      if (!wr) {
+        if (files.empty() && !ensure_dir(db->blob_dir))
+          return false;
+        const uint64_t idx = db->next_blob_index.fetch_add(1);
+        wr = std::make_unique<BlobWriter>(join_path(db->blob_dir, blob_name(idx)), idx, &db->limiter, pri);
+        files.push_back(BlobFileMeta{idx, 0, 0});
+      }
+      BlobRef r;
+      if (!wr->add(key, value, r))
+        return false;
+      files.back().bytes = wr->record_bytes();
+      ref.clear();
+      encode_blob_ref(ref, r);
+      file = r.file;
+      return true;
+    }
+    bool close_current() {
+      const bool ok = wr->finish();
+      wr.reset();
+      return ok;
+    }
+    // fsync файлов и каталога
+    bool finish() {
+      if (wr && !close_current())
+        return false;
+      if (files.empty())
+        return true;
+      int dfd = ::open(db->blob_dir.c_str(), O_RDONLY | O_DIRECTORY);
+      if (dfd >= 0) {
+        (void)::fsync(dfd);
+        ::close(dfd);
+      }
+      return true;
+    }
+    void discard() {
+      wr.reset();
+      for (const auto &f : files)
+        (void)::unlink(join_path(db->blob_dir, blob_name(f.index)).c_str());
+      files.clear();
+    }
+    uint64_t bytes() const {
+      uint64_t n = 0;
+      for (const auto &f : files)
+        n += f.bytes;
+      return n;
+    }
+  };
+
+  // Точечное чтение MemTable, затем immutable: true — ключ решён (v — значение
+  // или nullopt). Range tombstone источника накрывает его более старые версии;
+  // в более старых источниках все версии ключа старше — там искать нечего.
+  // v — вид в арену src (m0 или m1).
+  static bool memtables_get(const MemTable *m0, const MemTable *m1, std::string_view key, uint64_t snap,
+                            std::optional<std::string_view> &v, const MemTable *&src) {
+    for (const MemTable *m : {m0, m1}) {
+      if (!m)
+        continue;
+      const uint64_t rdel = m->range_del_seq(key, snap);
+      uint64_t seq = 0;
+      if (m->get(key, v, snap, &seq)) {
+        if (rdel > seq)
+          v.reset();
+        src = m;
+        return true;
+      }
+      if (rdel) {
+        v.reset();
+        return true;
+      }
+    }
+    return false;
+  }
 
-  // LRU-кэш таблиц
-  TableCache tcache{64};
+  static bool memtables_get(const MemTable *m0, const MemTable *m1, std::string_view key, uint64_t snap,
+                            std::optional<std::string> &v) {
+    std::optional<std::string_view> view;
+    const MemTable *src = nullptr;
+    if (!memtables_get(m0, m1, key, snap, view, src))
+      return false;
+    if (view)
+      v.emplace(*view);
+    else
+      v.reset();
+    return true;
+  }
 
-  // Фоновая компактация
-  std::thread bg_compactor;
+  // Значение по ссылке из SST; false — файла нет в наборе или запись битая
+  static bool read_blob(const std::shared_ptr<const BlobSet> &set, std::string_view key,
+                        std::string_view enc, std::string &out) {
+    BlobRef ref;
+    if (!decode_blob_ref(enc, ref)) {
+      spdlog::error("Bad blob reference ({} bytes)", enc.size());
+      return false;
+    }
+    if (set) {
+      auto it = set->files.find(ref.file);
+      if (it != set->files.end())
+        return it->second->read(ref, key, out);
+    }
+    spdlog::error("Blob file {} is not live", blob_name(ref.file));
+    return false;
+  }
+
+  static void add_blob_ref(std::vector<uint64_t> &files, uint64_t file) {
+    auto it = std::lower_bound(files.begin(), files.end(), file);
+    if (it == files.end() || *it != file)
+      files.insert(it, file);
+  }
+
+  // Кольца io_uring для пакетного чтения (multi_get при use_uring). UringBackend
+  // не потокобезопасен — каждый вызов берёт своё кольцо из пула и возвращает его.
+  std::mutex rings_mu;
+  std::vector<std::unique_ptr<UringBackend>> rings;
+  bool rings_unavailable = false;
+
+  std::unique_ptr<UringBackend> acquire_ring() {
+    if (!opts.use_uring)
+      return nullptr;
+    {
+      std::lock_guard lk(rings_mu);
+      if (rings_unavailable)
+        return nullptr;
+      if (!rings.empty()) {
+        auto r = std::move(rings.back());
+        rings.pop_back();
+        return r;
+      }
+    }
+    auto r = std::make_unique<UringBackend>(opts.uring_queue_depth, false,
+                                            opts.uring_fixed_buffer_bytes, opts.uring_submit_batch);
+    if (r->initialized())
+      return r;
+    std::lock_guard lk(rings_mu);
+    rings_unavailable = true;
+    return nullptr;
+  }
+  void release_ring(std::unique_ptr<UringBackend> r) {
+    if (!r)
+      return;
+    std::lock_guard lk(rings_mu);
+    rings.push_back(std::move(r));
+  }
+
+  // Фоновая компактация: compaction_threads потоков берут задания по убыванию
+  // score. Файлы входа идущих заданий (и blob GC) помечены в compacting, другие
+  // задания их не берут; running — диапазоны ключей, куда задания пишут выход
+  // (на L1+ новое задание не должно в них попадать). Всё под mu.
+  std::vector<std::thread> bg_compactors;
   std::condition_variable cv;
+  std::condition_variable job_done_cv; // завершилось задание (GC ждёт свои входы)
   bool need_compact = false;
   bool stopping = false;
+  std::set<uint64_t> compacting;
+  struct RunningJob {
+    uint64_t id;
+    std::size_t out_level;
+    std::string lo, hi;
+  };
+  std::vector<RunningJob> running;
+
+  // Range tombstone'ы SST-держателей (по номеру файла) для выбрасывания накрытых
+  // файлов. Читаются вне mu (refresh_range_del_tables); проверка под mu идёт,
+  // только если появился новый держатель или прошлая нашла ещё не готовый файл.
+  std::mutex rdel_mu; // после mu
+  std::map<uint64_t, std::vector<RangeTombstone>> rdel_tables;
+  std::atomic<bool> rdel_dirty{false};
+  uint64_t next_job_id = 1;
+  // blob GC (фоновый и KV::gc_blobs) — по одному
+  std::mutex gc_mu;
+
+  // Фоновая запись: общий ограничитель flush и компактации (rate 0 — только
+  // счётчики). Долг компактации пересчитывается при каждой смене дерева;
+  // остановленные записи ждут stall_cv (под mu).
+  mutable RateLimiter limiter{0};
+  std::atomic<uint64_t> pending_compaction{0};
+  std::condition_variable stall_cv;
 
   std::mutex mu;
   std::atomic<uint64_t> seq{1};
+  // последний seqno, применённый к MemTable (снимок для итераторов)
+  std::atomic<uint64_t> last_seq{0};
+
+  // живые снимки (seqno, с повторами)
+  mutable std::mutex snap_mu;
+  std::multiset<uint64_t> snapshots;
+
+  VersionFilter version_filter() const {
+    std::lock_guard lk(snap_mu);
+    VersionFilter f;
+    f.snapshots.assign(snapshots.begin(), snapshots.end());
+    f.snapshots.erase(std::unique(f.snapshots.begin(), f.snapshots.end()), f.snapshots.end());
+    return f;
+  }
+
+  // ---- group commit: очередь писателей (лидер/ведомые, как в LevelDB) ----
+  // Первый в очереди становится лидером: забирает всех ожидающих, пишет их в
+  // WAL одним commit() без mu, затем под mu применяет к MemTable и будит остальных.
+  struct Writer {
+    uint32_t flags = 0;
+    std::string_view key;
+    std::string_view value;
+    const WriteBatch *batch = nullptr; // пакет: одна запись WAL, count() seqno подряд
+    uint64_t seqno = 0;                // первый seqno, выдаёт лидер
+    bool ok = false;
+    bool done = false;
+    std::condition_variable cv;
+  };
+  static constexpr std::size_t MAX_GROUP_BYTES = 1u << 20;
+  std::deque<Writer *> writers;
+  std::vector<Writer *> group; // батч текущего лидера
 
   // ---- метрики (внутренние атомики) ----
   std::atomic<uint64_t> m_puts{0}, m_gets{0}, m_dels{0};
   std::atomic<uint64_t> m_get_hits{0}, m_get_misses{0};
   std::atomic<uint64_t> m_wal_bytes{0};
+  std::atomic<uint64_t> m_wal_syncs{0}, m_wal_batches{0};
   std::atomic<uint64_t> m_sst_flushes{0};
   std::atomic<uint64_t> m_compactions{0};
+  std::atomic<uint64_t> m_bloom_checks{0}, m_bloom_useful{0};
+  std::atomic<uint64_t> m_bloom_hits{0}, m_bloom_false_positives{0};
+  std::atomic<uint64_t> m_blob_bytes_written{0}, m_blob_gc_runs{0};
+  std::atomic<uint64_t> m_blob_gc_relocated{0}, m_blob_files_deleted{0};
+  std::atomic<uint64_t> m_sst_raw_bytes{0}, m_sst_stored_bytes{0};
+  std::atomic<uint64_t> m_write_slowdowns{0}, m_write_stalls{0}, m_write_stall_us{0};
+  std::atomic<uint64_t> m_subcompactions{0}, m_compaction_peak{0};
+  std::atomic<uint64_t> m_sst_files_deleted{0}, m_manifest_rewrites{0};
+  std::atomic<uint64_t> m_range_deletes{0}, m_range_del_keys{0}, m_range_del_files{0};
+  // заполняются в конструкторе
+  uint64_t startup_us = 0, replay_us = 0, replay_records = 0, replay_bytes = 0;
+
+  // гистограммы задержек, нс (opts.latency_histograms, иначе nullptr)
+  struct OpLatency {
+    LatencyHistogram put, get, del, scan, flush, compaction, wal_sync;
+  };
+  std::unique_ptr<OpLatency> lat;
+
+  LatencyHistogram *latency(LatencyHistogram OpLatency::*h) const { return lat ? &(lat.get()->*h) : nullptr; }
 
   // ---- helpers ----
 
-  // Подсчёт точного объёма записи WAL (мета+key+value+трейлер+паддинг)
-  static uint64_t wal_bytes_for_record(size_t klen, size_t vlen) {
-    const uint64_t meta = sizeof(WalRecordMeta) + klen + vlen;
-    const uint64_t trailer = sizeof(WalRecordTrailer);
-    const uint64_t used = meta + trailer;
-    const uint64_t rem = used % WalSegmentConst::BLOCK_SIZE;
-    const uint64_t pad = rem ? (WalSegmentConst::BLOCK_SIZE - rem) : 0;
-    return used + pad;
+  // словарь zstd обучается только для выхода компактации: L0 после flush живёт недолго
+  SstWriterOptions sst_writer_opts(bool compaction = false) const {
+    SstWriterOptions o;
+    o.format_version = opts.sst_format_version;
+    o.block_size     = static_cast<uint32_t>(opts.sst_block_size);
+    o.bloom_bits_per_key = opts.bloom_bits_per_key;
+    o.compression    = opts.sst_compression;
+    o.compression_level = opts.sst_compression_level;
+    o.zstd_dict_bytes = compaction ? opts.sst_zstd_dict_bytes : 0;
+    o.rate_limiter   = &limiter;
+    o.io_priority    = compaction ? RateLimiter::Priority::LOW : RateLimiter::Priority::HIGH;
+    return o;
+  }
+
+  void count_block_bytes(const SstWriter &wr) {
+    m_sst_raw_bytes.fetch_add(wr.raw_block_bytes(), std::memory_order_relaxed);
+    m_sst_stored_bytes.fetch_add(wr.stored_block_bytes(), std::memory_order_relaxed);
+  }
+
+  WalWriter make_wal() const {
+    return WalWriter(wal_dir,
+                     opts.use_uring,
+                     opts.uring_queue_depth,
+                     opts.uring_sqpoll,
+                     opts.uring_fixed_buffer_bytes,   // NEW
+                     opts.uring_submit_batch,         // NEW
+                     opts.wal_max_segment_bytes,
+                     opts.wal_group_commit_bytes,
+                     opts.flush_mode,
+                     opts.wal_format);
+  }
+
+  bool leveled() const { return opts.compaction_policy == CompactionPolicy::LEVELED; }
+
+  // ссылка на blob есть только в SST v3
+  bool blobs_enabled() const {
+    return opts.blob_value_threshold > 0 && opts.sst_format_version == kSstVersionV3;
+  }
+
+  std::size_t configured_levels() const {
+    return leveled() ? std::max<std::size_t>(2, opts.max_levels) : 1;
+  }
+
+  static uint64_t file_bytes(const std::string &path) {
+    std::error_code ec;
+    const auto sz = std::filesystem::file_size(path, ec);
+    return ec ? 0 : static_cast<uint64_t>(sz);
+  }
+
+  static uint64_t level_bytes(const std::vector<SstFileMeta> &files) {
+    uint64_t n = 0;
+    for (const auto &f : files)
+      n += f.size;
+    return n;
+  }
+
+  // лимит уровня L >= 1
+  uint64_t level_target_bytes(std::size_t level) const {
+    uint64_t t = std::max<uint64_t>(1, opts.level_base_bytes);
+    for (std::size_t i = 1; i < level; ++i)
+      t *= std::max<uint32_t>(2, opts.level_size_multiplier);
+    return t;
+  }
+
+  // >= 1 — уровень пора разгружать. L0 — по числу файлов, остальные — по байтам.
+  // idle — только файлы, которые не сливаются сейчас (есть ли работа для потока)
+  double level_score_locked(std::size_t level, bool idle = false) const {
+    std::size_t files = 0;
+    uint64_t bytes = 0;
+    for (const auto &f : levels[level]) {
+      if (idle && compacting.count(f.index))
+        continue;
+      ++files;
+      bytes += f.size;
+    }
+    if (level == 0)
+      return double(files) / double(std::max<std::size_t>(1, opts.l0_compact_threshold));
+    return double(bytes) / double(level_target_bytes(level));
+  }
+
+  uint64_t sst_count_locked() const {
+    uint64_t n = 0;
+    for (const auto &l : levels)
+      n += l.size();
+    return n;
+  }
+
+  static bool key_range_overlaps(const SstFileMeta &f, std::string_view lo, std::string_view hi) {
+    return !(f.largest < lo || f.smallest > hi);
+  }
+
+  // L0 — по возрасту, остальные уровни — по ключам
+  static void sort_level(std::vector<SstFileMeta> &files, std::size_t level) {
+    std::sort(files.begin(), files.end(), [level](const SstFileMeta &a, const SstFileMeta &b) {
+      return level == 0 ? a.index < b.index : a.smallest < b.smallest;
+    });
+  }
+
+  // Долг компактации (оценка): L0 целиком, когда его пора сливать, и превышение
+  // лимита на уровнях L1+ (LEVELED)
+  uint64_t pending_compaction_bytes_locked() const {
+    uint64_t n = level_score_locked(0) >= 1.0 ? level_bytes(levels[0]) : 0;
+    for (std::size_t l = 1; leveled() && l + 1 < levels.size(); ++l) {
+      const uint64_t bytes = level_bytes(levels[l]), target = level_target_bytes(l);
+      if (bytes > target)
+        n += bytes - target;
+    }
+    return n;
+  }
+
+  // После смены дерева: долг, лимит фоновой записи (автоподстройка) и
+  // пробуждение остановленных записей
+  void update_bg_io_locked() {
+    const uint64_t pending = pending_compaction_bytes_locked();
+    pending_compaction.store(pending, std::memory_order_relaxed);
+    if (opts.bg_rate_auto_tune && opts.bg_rate_bytes_per_sec) {
+      const uint64_t max_rate = opts.bg_rate_bytes_per_sec, min_rate = std::max<uint64_t>(1, max_rate / 8);
+      const double debt = opts.soft_pending_compaction_bytes
+                              ? std::min(1.0, double(pending) / double(opts.soft_pending_compaction_bytes))
+                              : 1.0;
+      limiter.set_rate(min_rate + static_cast<uint64_t>(double(max_rate - min_rate) * debt));
+    }
+    stall_cv.notify_all();
+  }
+
+  enum class WriteControl { NORMAL, SLOWDOWN, STOP };
+
+  WriteControl write_control_locked() const {
+    if (!opts.background_compaction || stopping)
+      return WriteControl::NORMAL; // без фона разгружать дерево некому
+    const std::size_t l0 = levels[0].size();
+    const std::size_t min_l0 = std::max<std::size_t>(1, opts.l0_compact_threshold);
+    const uint64_t pending = pending_compaction.load(std::memory_order_relaxed);
+    if ((opts.l0_stop_trigger && l0 >= std::max(opts.l0_stop_trigger, min_l0)) ||
+        (opts.hard_pending_compaction_bytes && pending >= opts.hard_pending_compaction_bytes))
+      return WriteControl::STOP;
+    if ((opts.l0_slowdown_trigger && l0 >= std::max(opts.l0_slowdown_trigger, min_l0)) ||
+        (opts.soft_pending_compaction_bytes && pending >= opts.soft_pending_compaction_bytes))
+      return WriteControl::SLOWDOWN;
+    return WriteControl::NORMAL;
+  }
+
+  void record_latency(LatencyHistogram OpLatency::*h, std::chrono::steady_clock::time_point t0) {
+    if (lat)
+      (lat.get()->*h).record(static_cast<uint64_t>(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0).count()));
+  }
+
+  void add_stall_time(std::chrono::steady_clock::time_point t0) {
+    m_write_stall_us.fetch_add(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+                                                         std::chrono::steady_clock::now() - t0)
+                                                         .count()),
+                               std::memory_order_relaxed);
+  }
+
+  // Лидер группы перед записью (под mu, очередь стоит за ним): компактация не
+  // успевает — задержка или остановка до разгрузки дерева
+  void delay_write_locked(std::unique_lock<std::mutex> &lk) {
+    const WriteControl c = write_control_locked();
+    if (c == WriteControl::NORMAL)
+      return;
+    const auto t0 = std::chrono::steady_clock::now();
+    if (c == WriteControl::SLOWDOWN) {
+      m_write_slowdowns.fetch_add(1, std::memory_order_relaxed);
+      lk.unlock();
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      lk.lock();
+    } else {
+      m_write_stalls.fetch_add(1, std::memory_order_relaxed);
+      spdlog::warn("Write stall: L0 {} files, pending compaction {} bytes", levels[0].size(),
+                   pending_compaction.load(std::memory_order_relaxed));
+      while (write_control_locked() == WriteControl::STOP) {
+        maybe_schedule_compaction_locked(); // на случай неудачной компактации
+        stall_cv.wait_for(lk, std::chrono::milliseconds(100));
+      }
+    }
+    add_stall_time(t0);
+  }
+
+  static std::size_t writer_ops(const Writer &w) { return w.batch ? w.batch->count() : 1; }
+  static std::size_t writer_bytes(const Writer &w) {
+    return w.batch ? w.batch->byte_size() : w.key.size() + w.value.size();
+  }
+
+  // счётчики puts/dels копятся на всю группу и публикуются одним fetch_add
+  void apply_locked(const Writer &w, uint64_t &puts, uint64_t &dels) {
+    auto one = [&](uint64_t seqno, uint32_t flags, std::string_view k, std::string_view v) {
+      mem->add(seqno, flags, k, v);
+      if (flags == WAL_FLAG_RANGE_DEL)
+        m_range_deletes.fetch_add(1, std::memory_order_relaxed);
+      else
+        ++(flags == WAL_FLAG_PUT ? puts : dels);
+    };
+    if (!w.batch) {
+      one(w.seqno, w.flags, w.key, w.value);
+      return;
+    }
+    uint64_t seqno = w.seqno;
+    (void)WriteBatch::for_each(w.batch->data(), [&](uint32_t flags, std::string_view k, std::string_view v) {
+      one(seqno++, flags, k, v);
+    });
+  }
+
+  // MemTable уже отсортирована: пишем потоково и заодно собираем метаданные
+  // для MANIFEST (index/path выдаёт install_flushed_sst_locked). Большие значения
+  // уходят в blob-файлы sink, в SST — ссылка. Range tombstone'ы идут в свой блок
+  // и расширяют диапазон ключей файла.
+  bool write_memtable_sst(const MemTable &m, const std::string &path, SstFileMeta &meta,
+                          BlobSink &sink) {
+    SstWriter wr(path, sst_writer_opts());
+    MemTable::Iterator it(&m);
+    meta = SstFileMeta{};
+    meta.min_seq = UINT64_MAX;
+    VersionFilter vf = version_filter(); // старые версии — только для живых снимков
+    std::string_view last; // ключи живут в арене MemTable
+    std::string ref;
+    for (it.seek_to_first(); it.valid(); it.next()) {
+      if (last.data() == nullptr || it.key() != last)
+        vf.new_key();
+      if (!vf.keep(it.seqno())) {
+        last = it.key();
+        continue;
+      }
+      uint32_t flags = (it.flags() == WAL_FLAG_DEL) ? SST_FLAG_DEL : SST_FLAG_PUT;
+      std::string_view value = it.value();
+      if (flags == SST_FLAG_PUT && blobs_enabled() && value.size() >= opts.blob_value_threshold) {
+        uint64_t file = 0;
+        if (!sink.add(it.key(), value, ref, file))
+          return false;
+        flags = SST_FLAG_BLOB;
+        value = ref;
+        add_blob_ref(meta.blob_files, file);
+      }
+      if (!wr.add(it.key(), flags, value, it.seqno()))
+        return false;
+      if (wr.num_entries() == 1)
+        meta.smallest.assign(it.key());
+      last = it.key();
+      meta.min_seq = std::min(meta.min_seq, it.seqno());
+      meta.max_seq = std::max(meta.max_seq, it.seqno());
+    }
+    if (wr.num_entries() > 0)
+      meta.largest.assign(last);
+    std::vector<RangeTombstone> rdels;
+    m.range_tombstones(rdels);
+    for (const auto &t : rdels) {
+      if (!wr.add_range_tombstone(t.start, t.end, t.seqno))
+        return false;
+      if ((wr.num_entries() == 0 && &t == &rdels.front()) || t.start < meta.smallest)
+        meta.smallest = t.start;
+      meta.largest = std::max(meta.largest, t.end);
+      meta.min_seq = std::min(meta.min_seq, t.seqno);
+      meta.max_seq = std::max(meta.max_seq, t.seqno);
+    }
+    meta.range_dels = rdels.size();
+    if (!wr.finish() || !sink.finish())
+      return false;
+    count_block_bytes(wr);
+    meta.size = file_bytes(path);
+    return true;
+  }
+
+  // GET без копирования: значение из MemTable закрепляется за ней, из SST — за
+  // блоком BlockCache; blob и чтение без кэша отдают свой буфер.
+  bool get(std::string_view key, const ReadOptions &ro, PinnableSlice &value) {
+    PerfStopwatch sw; // стадии GET в perf-контекст потока
+    value.reset();
+    m_gets.fetch_add(1, std::memory_order_relaxed);
+    const uint64_t snap = ro.snapshot ? ro.snapshot->seqno() : UINT64_MAX;
+
+    // MemTable, затем immutable — без локов (порядок загрузки важен). Без снимка
+    // MemTable читается до last_seq: недоприменённый пакет ещё не виден.
+    const uint64_t mem_snap = ro.snapshot ? snap : last_seq.load(std::memory_order_acquire);
+    auto m0 = std::atomic_load(&mem);
+    auto m1 = std::atomic_load(&imm);
+    std::optional<std::string_view> v;
+    const MemTable *src = nullptr;
+    const bool in_mem = memtables_get(m0.get(), m1.get(), key, mem_snap, v, src);
+    sw.lap(&PerfContext::get_memtable_ns);
+    if (in_mem) {
+      perf_count(&PerfContext::get_memtable_hits);
+      if (!v.has_value()) {
+        m_get_misses.fetch_add(1, std::memory_order_relaxed);
+        return false;
+      }
+      m_get_hits.fetch_add(1, std::memory_order_relaxed);
+      value.pin(*v, src == m0.get() ? std::move(m0) : std::move(m1));
+      return true;
+    }
+
+    // Версия берётся без локов и держит файлы до конца чтения; кэш таблиц
+    // шардирован и своих локов не требует. L0 пересекается — от новых к старым; на L1+
+    // кандидат один: первый файл с largest >= key. Таблицы открываются по мере
+    // поиска. Blob-ссылки читаются по набору той же версии.
+    const auto ver = current_version();
+    const uint64_t h = sst_key_hash(key.data(), key.size()); // один раз на все таблицы
+    SstValueRef st;
+    // true — ключ решён в таблице f (значение или удаление в st)
+    auto probe = [&](const SstFileMeta &f) {
+      const auto tbl = tcache->get_table(f.index, f.path);
+      sw.lap(&PerfContext::get_table_cache_ns);
+      if (!tbl)
+        return false;
+      // range tombstone таблицы проверяется до bloom: он накрывает и ключи, которых в ней нет
+      const uint64_t rdel = tbl->range_del_seq(key, snap);
+      const bool filtered = !rdel && tbl->has_filter();
+      if (filtered) {
+        m_bloom_checks.fetch_add(1, std::memory_order_relaxed);
+        if (!tbl->may_contain(h)) {
+          m_bloom_useful.fetch_add(1, std::memory_order_relaxed);
+          perf_count(&PerfContext::bloom_useful_count);
+          sw.lap(&PerfContext::get_filter_ns);
+          return false;
+        }
+      }
+      sw.lap(&PerfContext::get_filter_ns);
+      perf_count(&PerfContext::get_tables_probed);
+      // версии новее снимка пропускаются: тогда ключ ищется в более старых таблицах
+      // (стадии индекса, блока и записи таблица разносит сама)
+      uint64_t seq = 0;
+      bool hit = tbl->get(key, st, snap, &seq);
+      sw.restart();
+      if (filtered)
+        (hit ? m_bloom_hits : m_bloom_false_positives).fetch_add(1, std::memory_order_relaxed);
+      if (rdel && (!hit || rdel > seq)) {
+        st.flags = SST_FLAG_DEL;
+        st.value = {};
+        hit = true;
+      }
+      return hit;
+    };
+    bool decided = false;
+    for (auto itf = ver->levels[0].rbegin(); !decided && itf != ver->levels[0].rend(); ++itf)
+      if (key >= itf->smallest && key <= itf->largest)
+        decided = probe(*itf);
+    for (std::size_t l = 1; !decided && l < ver->levels.size(); ++l) {
+      const auto &files = ver->levels[l];
+      auto itf = std::lower_bound(files.begin(), files.end(), key,
+                                  [](const SstFileMeta &f, std::string_view k) { return f.largest < k; });
+      if (itf != files.end() && key >= itf->smallest)
+        decided = probe(*itf);
+    }
+
+    bool found = decided && st.flags != SST_FLAG_DEL;
+    if (found && st.flags == SST_FLAG_BLOB) {
+      perf_count(&PerfContext::blob_read_count);
+      const std::shared_ptr<const BlobSet> blobs = ver->blobs->files.empty() ? nullptr : ver->blobs;
+      std::string blob_value;
+      found = read_blob(blobs, key, st.value, blob_value);
+      sw.lap(&PerfContext::blob_read_ns);
+      if (found)
+        value.own(std::move(blob_value));
+    } else if (found) {
+      if (st.hold)
+        value.pin(st.value, std::move(st.hold));
+      else // блок (запись v2), прочитанный без кэша, переходит к value целиком
+        value.own(std::move(st.buf), st.value.empty() ? 0 : st.value.data() - st.buf.data(), st.value.size());
+    }
+    (found ? m_get_hits : m_get_misses).fetch_add(1, std::memory_order_relaxed);
+    return found;
+  }
+
+  bool write(uint32_t flags, std::string_view key, std::string_view value) {
+    Writer w;
+    w.flags = flags;
+    w.key = key;
+    w.value = value;
+    return write(w);
+  }
+
+  bool write(Writer &w) {
+    std::unique_lock<std::mutex> lk(mu);
+    writers.push_back(&w);
+    w.cv.wait(lk, [&] { return w.done || writers.front() == &w; });
+    if (w.done)
+      return w.ok; // нас записал лидер
+    PerfStopwatch sw;
+    delay_write_locked(lk);
+    sw.lap(&PerfContext::write_delay_ns);
+
+    // лидер: забираем очередь (ограничение по объёму)
+    group.clear();
+    std::size_t bytes = 0, ops = 0;
+    for (Writer *x : writers) {
+      group.push_back(x);
+      ops += writer_ops(*x);
+      bytes += writer_bytes(*x);
+      if (bytes >= MAX_GROUP_BYTES)
+        break;
+    }
+    const uint64_t first_seq = seq.fetch_add(ops);
+    for (uint64_t s = first_seq; Writer *x : group) {
+      x->seqno = s;
+      s += writer_ops(*x);
+    }
+    const uint64_t wal_bytes0 = wal.appended_bytes();
+    const uint64_t wal_syncs0 = wal.syncs();
+
+    // WAL пишет только лидер, поэтому mu на время I/O отпускаем
+    lk.unlock();
+    bool ok = true;
+    for (std::size_t i = 0; ok && i < group.size(); ++i) {
+      const Writer *x = group[i];
+      ok = x->batch                   ? wal.append_batch(x->seqno, x->batch->data())
+           : x->flags == WAL_FLAG_PUT ? wal.append_put(x->seqno, x->key, x->value)
+                                      : wal.append_del(x->seqno, x->key);
+    }
+    {
+      const auto t_commit = lat ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
+      ok = ok && wal.commit();
+      if (lat && wal.syncs() != wal_syncs0)
+        lat->wal_sync.record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                                       std::chrono::steady_clock::now() - t_commit)
+                                                       .count()));
+    }
+    lk.lock();
+    sw.lap(&PerfContext::write_wal_ns);
+
+    m_wal_bytes.fetch_add(wal.appended_bytes() - wal_bytes0, std::memory_order_relaxed);
+    m_wal_syncs.fetch_add(wal.syncs() - wal_syncs0, std::memory_order_relaxed);
+    m_wal_batches.fetch_add(1, std::memory_order_relaxed);
+    if (ok) {
+      uint64_t puts = 0, dels = 0;
+      for (const Writer *x : group)
+        apply_locked(*x, puts, dels);
+      sw.lap(&PerfContext::write_memtable_ns);
+      m_puts.fetch_add(puts, std::memory_order_relaxed);
+      m_dels.fetch_add(dels, std::memory_order_relaxed);
+      // читатели без снимка сравнивают MemTable с last_seq — пакет виден целиком
+      last_seq.store(first_seq + ops - 1, std::memory_order_release);
+      maybe_flush_locked(lk);
+    }
+
+    for (Writer *x : group) {
+      writers.pop_front();
+      x->ok = ok;
+      x->done = true;
+      if (x != &w)
+        x->cv.notify_one();
+    }
+    if (!writers.empty())
+      writers.front()->cv.notify_one();
+    return ok;
   }
 
   void purge_wal_files_locked() {
@@ -96,179 +875,1073 @@ struct KV::Impl {
       ::close(dfd);
     }
 
- wal = WalWriter(wal_dir,
-                opts.use_uring,
-                opts.uring_queue_depth,
-                opts.uring_sqpoll,
-                opts.uring_fixed_buffer_bytes,   // NEW
-                opts.uring_submit_batch,         // NEW
-                opts.wal_max_segment_bytes,
-                opts.wal_group_commit_bytes,
-                opts.flush_mode);
+    wal = make_wal();
+  }
+
+  struct CompactionJob {
+    uint64_t id = 0;                 // в running (begin_job_locked)
+    std::size_t level = 0;           // уровень, который разгружаем
+    std::size_t out_level = 0;       // куда пишем результат
+    std::vector<SstFileMeta> inputs; // от старых к новым: на равных ключах побеждает последний
+    std::string lo, hi;              // диапазон ключей входа (выход в нём же)
+    // [smallest, largest] файлов уровней глубже out_level (каждый уровень
+    // отсортирован): tombstone нужен, только если ключ может быть там
+    std::vector<std::vector<std::pair<std::string, std::string>>> below;
+    uint64_t relocate = 0; // blob GC: живые значения этого blob-файла переносятся в новый
+    // blob GC на L1+: входы не обязательно соседние, выход режется на их
+    // границах (smallest входов, кроме первого), чтобы не накрыть файлы между ними
+    std::vector<std::string> split_keys;
+
+    bool key_may_exist_below(std::string_view key) const {
+      for (const auto &lvl : below) {
+        auto it = std::lower_bound(lvl.begin(), lvl.end(), key,
+                                   [](const auto &r, std::string_view k) { return r.second < k; });
+        if (it != lvl.end() && it->first <= key)
+          return true;
+      }
+      return false;
+    }
+    // то же для диапазона [start, end) range tombstone'а
+    bool range_may_exist_below(std::string_view start, std::string_view end) const {
+      for (const auto &lvl : below) {
+        auto it = std::lower_bound(lvl.begin(), lvl.end(), start,
+                                   [](const auto &r, std::string_view k) { return r.second < k; });
+        if (it != lvl.end() && it->first < end)
+          return true;
+      }
+      return false;
+    }
+  };
+
+  static void key_range(const std::vector<SstFileMeta> &files, std::string &lo, std::string &hi) {
+    lo = files.front().smallest;
+    hi = files.front().largest;
+    for (const auto &f : files) {
+      lo = std::min(lo, f.smallest);
+      hi = std::max(hi, f.largest);
+    }
+  }
+
+  bool any_compacting_locked(const std::vector<SstFileMeta> &files) const {
+    return std::any_of(files.begin(), files.end(),
+                       [&](const SstFileMeta &f) { return compacting.count(f.index) != 0; });
+  }
+
+  // На L1+ выход идущего задания ещё не виден в levels: новое задание с выходом
+  // на тот же уровень не должно пересекаться с ним по ключам (L0 пересекается всегда)
+  bool range_busy_locked(std::size_t out_level, std::string_view lo, std::string_view hi) const {
+    if (out_level == 0)
+      return false;
+    return std::any_of(running.begin(), running.end(), [&](const RunningJob &r) {
+      return r.out_level == out_level && !(r.hi < lo || r.lo > hi);
+    });
+  }
+
+  // Выбор компактации (под mu); файлы, которые сливаются сейчас, не берутся.
+  //  SIZE_TIERED: весь L0, когда в нём >= l0_compact_threshold свободных файлов.
+  //  LEVELED: уровни с score >= 1 по убыванию score; вход — весь L0 либо
+  //  следующий по кругу свободный файл Li, плюс пересекающиеся с ним по ключам
+  //  файлы L(i+1). Задание, задевающее занятые файлы или чужой выход, пропускается.
+  bool pick_compaction_locked(CompactionJob &job) {
+    if (!leveled()) {
+      // только файлы новее всех сливаемых: выход получит индекс новее выхода
+      // идущих заданий, и порядок версий в L0 сохранится
+      uint64_t newest_busy = 0;
+      for (const auto &f : levels[0])
+        if (compacting.count(f.index))
+          newest_busy = std::max(newest_busy, f.index);
+      for (const auto &f : levels[0])
+        if (f.index > newest_busy)
+          job.inputs.push_back(f);
+      if (job.inputs.empty() || job.inputs.size() < opts.l0_compact_threshold) {
+        job.inputs.clear();
+        return false;
+      }
+      job.level = job.out_level = 0;
+    } else {
+      std::vector<std::pair<double, std::size_t>> cand;
+      for (std::size_t l = 0; l + 1 < levels.size(); ++l) { // последний уровень не разгружается
+        const double score = level_score_locked(l, /*idle=*/true);
+        if (score >= 1.0)
+          cand.emplace_back(score, l);
+      }
+      std::stable_sort(cand.begin(), cand.end(), [](const auto &a, const auto &b) { return a.first > b.first; });
+      const bool found = std::any_of(cand.begin(), cand.end(),
+                                     [&](const auto &c) { return pick_level_locked(c.second, job); });
+      if (!found)
+        return false;
+    }
+    key_range(job.inputs, job.lo, job.hi);
+    fill_below_locked(job);
+    return true;
+  }
+
+  bool pick_level_locked(std::size_t level, CompactionJob &job) {
+    if (level == 0) // L0 -> L1 — одно задание за раз, L0 целиком
+      return !any_compacting_locked(levels[0]) && try_job_locked(0, levels[0], job);
+
+    const auto &files = levels[level];
+    auto &ptr = compact_pointer[level];
+    std::size_t start = 0;
+    if (!ptr.empty()) {
+      auto it = std::find_if(files.begin(), files.end(), [&](const SstFileMeta &f) { return f.largest > ptr; });
+      start = it == files.end() ? 0 : static_cast<std::size_t>(it - files.begin());
+    }
+    for (std::size_t n = 0; n < files.size(); ++n) {
+      const auto &f = files[(start + n) % files.size()];
+      if (compacting.count(f.index) || !try_job_locked(level, {f}, job))
+        continue;
+      ptr = f.largest;
+      return true;
+    }
+    return false;
+  }
+
+  // upper (файлы level) + пересекающиеся файлы level+1, если никто их не держит
+  bool try_job_locked(std::size_t level, const std::vector<SstFileMeta> &upper, CompactionJob &job) {
+    std::string lo, hi;
+    key_range(upper, lo, hi);
+    std::vector<SstFileMeta> inputs;
+    for (const auto &f : levels[level + 1])
+      if (key_range_overlaps(f, lo, hi))
+        inputs.push_back(f);
+    if (any_compacting_locked(inputs))
+      return false;
+    inputs.insert(inputs.end(), upper.begin(), upper.end());
+    key_range(inputs, lo, hi);
+    if (range_busy_locked(level + 1, lo, hi))
+      return false;
+    job.level = level;
+    job.out_level = level + 1;
+    job.inputs = std::move(inputs);
+    return true;
+  }
+
+  void fill_below_locked(CompactionJob &job) const {
+    if (job.out_level == 0) {
+      // SIZE_TIERED: более старые файлы L0 вне входа (их сливает другое задание)
+      uint64_t oldest = UINT64_MAX;
+      for (const auto &f : job.inputs)
+        oldest = std::min(oldest, f.index);
+      for (const auto &f : levels[0])
+        if (f.index < oldest)
+          job.below.push_back({{f.smallest, f.largest}});
+    }
+    for (std::size_t l = job.out_level + 1; l < levels.size(); ++l) {
+      job.below.emplace_back();
+      for (const auto &f : levels[l])
+        job.below.back().emplace_back(f.smallest, f.largest);
+    }
+  }
+
+  // Blob GC: файл с наибольшей ненулевой долей мусора, не меньшей ratio; 0 — нет
+  uint64_t pick_blob_gc_locked(double ratio) const {
+    uint64_t best = 0;
+    double best_ratio = 0;
+    for (const auto &[idx, b] : blob_meta) {
+      const double r = b.bytes ? double(b.garbage) / double(b.bytes) : 0.0;
+      if (r >= ratio && r > best_ratio) {
+        best = idx;
+        best_ratio = r;
+      }
+    }
+    return best;
+  }
+
+  // Задание GC: SST уровня, ссылающиеся на file, переписываются на тот же уровень
+  // с переносом его живых значений. L0 берётся целиком: выход получает индексы
+  // новее входа, и без более новых файлов L0 порядок версий нарушился бы.
+  // busy — нужные файлы сейчас сливаются (задание надо подождать).
+  bool pick_blob_gc_job_locked(uint64_t file, CompactionJob &job, bool &busy) {
+    auto refs = [file](const SstFileMeta &f) {
+      return std::binary_search(f.blob_files.begin(), f.blob_files.end(), file);
+    };
+    busy = false;
+    for (std::size_t l = 0; l < levels.size(); ++l) {
+      if (std::none_of(levels[l].begin(), levels[l].end(), refs))
+        continue;
+      job.level = job.out_level = l;
+      job.relocate = file;
+      if (l == 0)
+        job.inputs = levels[0];
+      else
+        std::copy_if(levels[l].begin(), levels[l].end(), std::back_inserter(job.inputs), refs);
+      key_range(job.inputs, job.lo, job.hi);
+      if (any_compacting_locked(job.inputs) || range_busy_locked(l, job.lo, job.hi)) {
+        busy = true;
+        job.inputs.clear();
+        return false;
+      }
+      for (std::size_t i = 1; l > 0 && i < job.inputs.size(); ++i)
+        job.split_keys.push_back(job.inputs[i].smallest);
+      fill_below_locked(job);
+      return true;
+    }
+    return false;
+  }
+
+  // Задание начато/закончено (под mu): пометка входа и диапазона выхода
+  void begin_job_locked(CompactionJob &job) {
+    job.id = next_job_id++;
+    for (const auto &f : job.inputs)
+      compacting.insert(f.index);
+    running.push_back(RunningJob{job.id, job.out_level, job.lo, job.hi});
+    uint64_t peak = m_compaction_peak.load(std::memory_order_relaxed);
+    if (running.size() > peak)
+      m_compaction_peak.store(running.size(), std::memory_order_relaxed);
+  }
+
+  void end_job_locked(const CompactionJob &job) {
+    for (const auto &f : job.inputs)
+      compacting.erase(f.index);
+    running.erase(std::remove_if(running.begin(), running.end(),
+                                 [&](const RunningJob &r) { return r.id == job.id; }),
+                  running.end());
+    job_done_cv.notify_all();
+    maybe_schedule_compaction_locked();
+  }
+
+  // Зафиксировать новый состав дерева: MANIFEST, затем память (под mu)
+  bool install_levels_locked(SstLevels next) { return install_locked(std::move(next), blob_meta); }
+
+  // То же вместе с составом blob-файлов. Файлы, на которые не ссылается ни одна
+  // SST, выбрасываются из MANIFEST; с диска выбывшие файлы удаляются, когда
+  // их отпустит последняя версия.
+  bool install_locked(SstLevels next, std::map<uint64_t, BlobFileMeta> next_blobs) {
+    std::set<uint64_t> referenced;
+    for (const auto &lvl : next)
+      for (const auto &f : lvl)
+        referenced.insert(f.blob_files.begin(), f.blob_files.end());
+    std::vector<uint64_t> dropped;
+    for (auto it = next_blobs.begin(); it != next_blobs.end();) {
+      if (!referenced.count(it->first)) {
+        dropped.push_back(it->first);
+        it = next_blobs.erase(it);
+        continue;
+      }
+      ++it;
+    }
+
+    // правка — разница с текущим составом
+    VersionEdit edit;
+    std::unordered_map<uint64_t, std::size_t> was;
+    for (std::size_t l = 0; l < levels.size(); ++l)
+      for (const auto &f : levels[l])
+        was[f.index] = l;
+    for (std::size_t l = 0; l < next.size(); ++l)
+      for (const auto &f : next[l]) {
+        auto it = was.find(f.index);
+        if (it == was.end() || it->second != l)
+          edit.added.emplace_back(l, f);
+        if (it != was.end())
+          was.erase(it);
+      }
+    for (const auto &[idx, l] : was)
+      edit.removed.push_back(idx);
+    for (const auto &[idx, b] : next_blobs) {
+      auto it = blob_meta.find(idx);
+      if (it == blob_meta.end() || it->second.bytes != b.bytes || it->second.garbage != b.garbage)
+        edit.blobs.push_back(b);
+    }
+    for (uint64_t idx : dropped)
+      if (blob_meta.count(idx))
+        edit.blobs_removed.push_back(idx);
+    edit.last_index = next_sst_index;
+    if (!log_edit_locked(edit, next, next_blobs)) {
+      spdlog::error("Failed to write MANIFEST in {}", sst_dir);
+      return false;
+    }
+
+    levels.swap(next);
+    blob_meta.swap(next_blobs);
+    for (uint64_t idx : edit.removed)
+      retire_file(live_ssts, idx);
+    for (uint64_t idx : dropped) {
+      if (live_blobs.count(idx)) {
+        retire_file(live_blobs, idx);
+      } else if (::unlink(join_path(blob_dir, blob_name(idx)).c_str()) == 0) {
+        m_blob_files_deleted.fetch_add(1, std::memory_order_relaxed); // ещё не был в версии
+      }
+      spdlog::info("Blob: dropped {} (no references left)", blob_name(idx));
+    }
+    publish_version_locked();
+    update_bg_io_locked();
+    return true;
+  }
+
+  // Правка в журнал; журнал длиннее manifest_max_bytes (или после сбоя
+  // дозаписи) начинается заново снимком нового состава
+  bool log_edit_locked(const VersionEdit &edit, const SstLevels &next,
+                       const std::map<uint64_t, BlobFileMeta> &next_blobs) {
+    if (manifest->bytes() < opts.manifest_max_bytes && manifest->append(edit))
+      return true;
+    std::vector<BlobFileMeta> blob_list;
+    for (const auto &[idx, b] : next_blobs)
+      blob_list.push_back(b);
+    if (!manifest->rewrite(next_sst_index, next, blob_list))
+      return false;
+    m_manifest_rewrites.fetch_add(1, std::memory_order_relaxed);
+    return true;
   }
 
-  // Одна итерация L0-компактации
-  bool compact_l0_once() {
-    // Шаг 1: снимок входа под локом
-    std::vector<std::string> input;
-    uint64_t new_idx = 0;
+  static void retire_file(std::map<uint64_t, std::shared_ptr<LiveFile>> &live, uint64_t idx) {
+    auto it = live.find(idx);
+    if (it == live.end())
+      return;
+    it->second->obsolete.store(true, std::memory_order_release);
+    live.erase(it);
+  }
+
+  // Новая версия из levels/blob_meta (под mu). Прежняя освобождается, когда
+  // её отпустят читатели; вместе с ней — файлы, которых больше нигде нет.
+  void publish_version_locked() {
+    const auto prev = current_version();
+    auto v = std::make_shared<Version>(&m_versions_live);
+    v->levels = levels;
+    for (const auto &lvl : levels)
+      for (const auto &f : lvl) {
+        auto &ref = live_ssts[f.index];
+        if (!ref)
+          ref = std::make_shared<LiveFile>(f.path, &m_sst_files_deleted, [this, idx = f.index] {
+            tcache->erase_file(idx);
+            if (bcache)
+              bcache->erase_file(idx);
+          });
+        v->files.push_back(ref);
+      }
+    auto set = std::make_shared<BlobSet>();
+    for (const auto &[idx, b] : blob_meta) {
+      auto cur = prev->blobs->files.find(idx);
+      set->files[idx] = cur != prev->blobs->files.end()
+                            ? cur->second
+                            : std::make_shared<BlobFile>(join_path(blob_dir, blob_name(idx)));
+      auto &ref = live_blobs[idx];
+      if (!ref)
+        ref = std::make_shared<LiveFile>(join_path(blob_dir, blob_name(idx)), &m_blob_files_deleted);
+      v->files.push_back(ref);
+    }
+    v->blobs = std::move(set);
+    std::atomic_store(&current, std::shared_ptr<const Version>(std::move(v)));
+  }
+
+  // Один файл без пересечений на следующем уровне — переносим без перезаписи
+  bool move_file_locked(const CompactionJob &job) {
+    const auto &f = job.inputs.front();
+    SstLevels next = levels;
+    auto &src = next[job.level];
+    src.erase(std::remove_if(src.begin(), src.end(),
+                             [&](const SstFileMeta &x) { return x.index == f.index; }),
+              src.end());
+    next[job.out_level].push_back(f);
+    sort_level(next[job.out_level], job.out_level);
+    if (!install_levels_locked(std::move(next)))
+      return false;
+    spdlog::info("BG-Compaction: moved {} L{} -> L{}", sst_name(f.index), job.level, job.out_level);
+    maybe_schedule_compaction_locked();
+    return true;
+  }
+
+  // Одна компактация (см. pick_compaction_locked); true — дерево изменилось.
+  // Слияние — k-way merge потоковых итераторов входа: в памяти по одному блоку
+  // на вход и текущий блок выхода; выход режется по sst_target_file_bytes.
+  // Потоков компактации может быть несколько: вход помечен до конца задания.
+  bool compact_once() {
+    // Шаг 1: выбор входа под локом
+    CompactionJob job;
+    uint64_t first_idx = 0, per_sub = 0;
     {
+      refresh_range_del_tables(); // чтение таблиц — до mu
       std::unique_lock<std::mutex> lk(mu);
       if (stopping)
-        return true;
-      if (ssts.size() < opts.l0_compact_threshold)
-        return true;
-      input = ssts;
-      new_idx = next_sst_index + 1;
-      next_sst_index = new_idx; // бронируем имя
+        return false;
+      // выбывшие целиком файлы — тоже работа, но слияние ещё может понадобиться
+      const bool dropped = drop_range_deleted_files_locked();
+      if (!pick_compaction_locked(job))
+        return dropped;
+      if (job.inputs.size() == 1 && job.level != job.out_level)
+        return move_file_locked(job);
+      reserve_outputs_locked(job, first_idx, per_sub);
+      begin_job_locked(job);
+      maybe_schedule_compaction_locked(); // работа для других потоков
     }
 
-    spdlog::info("BG-Compaction: merging {} SST files", input.size());
+    spdlog::info("BG-Compaction: L{} -> L{}, merging {} SST files", job.level, job.out_level,
+                 job.inputs.size());
+    const bool ok = run_compaction(job, first_idx, per_sub);
+    std::lock_guard<std::mutex> lk(mu);
+    end_job_locked(job);
+    return ok;
+  }
 
-    // Шаг 2: финальный view — идём с конца, чтобы новые перекрывали старые
-    std::unordered_map<std::string, std::optional<std::string>> view;
-    view.reserve(1024);
+  // Tombstone'ы новых SST-держателей текущей версии — в rdel_tables (таблицы
+  // открываются без mu), выбывших — долой
+  void refresh_range_del_tables() {
+    const auto ver = current_version();
+    std::lock_guard<std::mutex> lk(rdel_mu);
+    std::set<uint64_t> live;
+    for (const auto &lvl : ver->levels)
+      for (const auto &f : lvl) {
+        if (!f.range_dels)
+          continue;
+        live.insert(f.index);
+        if (rdel_tables.count(f.index))
+          continue;
+        if (auto tbl = tcache->get_table(f.index, f.path)) {
+          rdel_tables.emplace(f.index, tbl->range_tombstones());
+          rdel_dirty.store(true, std::memory_order_relaxed);
+        }
+      }
+    std::erase_if(rdel_tables, [&](const auto &e) { return !live.count(e.first); });
+  }
 
-    for (auto it = input.rbegin(); it != input.rend(); ++it) {
-      SstReader r(*it);
-      if (!r.good())
-        continue;
-      auto items = r.scan(std::string_view{}, std::string_view{});
-      for (auto &kv : items) {
-        if (view.find(kv.first) != view.end())
+  // SST, целиком накрытые более новым range tombstone'ом другой таблицы, выбывают
+  // из дерева без переписывания: все их версии старше tombstone'а, и ни один
+  // живой снимок не видит их в обход него (нет снимка в [min_seq, seqno)).
+  // Таблицы со ссылками на blob-файлы оставлены компактации — она учтёт мусор.
+  // Берутся только tombstone'ы держателей, которые есть в levels сейчас.
+  bool drop_range_deleted_files_locked() {
+    if (!rdel_dirty.exchange(false, std::memory_order_relaxed))
+      return false;
+    std::lock_guard<std::mutex> rl(rdel_mu);
+    std::vector<const RangeTombstone *> rdels;
+    for (const auto &lvl : levels)
+      for (const auto &f : lvl) {
+        if (!f.range_dels)
           continue;
-        view.emplace(kv.first, kv.second);
+        auto it = rdel_tables.find(f.index);
+        if (it == rdel_tables.end()) {
+          rdel_dirty.store(true, std::memory_order_relaxed); // ещё не прочитан — в следующий проход
+          continue;
+        }
+        for (const auto &t : it->second)
+          rdels.push_back(&t);
       }
-    }
+    if (rdels.empty())
+      return false;
+
+    // файл в работе или отделённый от tombstone'а снимком может выбыть позже
+    const VersionFilter vf = version_filter();
+    std::set<uint64_t> gone;
+    for (const auto &lvl : levels)
+      for (const auto &f : lvl) {
+        if (!f.blob_files.empty())
+          continue;
+        for (const auto *t : rdels) {
+          if (!(t->start <= f.smallest && f.largest < t->end && f.max_seq < t->seqno))
+            continue;
+          if (compacting.count(f.index) || vf.stripe(f.min_seq) != vf.stripe(t->seqno)) {
+            rdel_dirty.store(true, std::memory_order_relaxed);
+            continue;
+          }
+          gone.insert(f.index);
+          break;
+        }
+      }
+    if (gone.empty())
+      return false;
 
-    std::vector<std::pair<std::string, std::optional<std::string>>> entries;
-    entries.reserve(view.size());
-    for (auto &[k, v] : view)
-      if (v.has_value())
-        entries.emplace_back(k, v);
-    std::sort(entries.begin(), entries.end(),
-              [](const auto &a, const auto &b) { return a.first < b.first; });
+    SstLevels next = levels;
+    for (auto &lvl : next)
+      std::erase_if(lvl, [&](const SstFileMeta &f) { return gone.count(f.index) > 0; });
+    if (!install_levels_locked(std::move(next)))
+      return false;
+    m_range_del_files.fetch_add(gone.size(), std::memory_order_relaxed);
+    spdlog::info("BG-Compaction: dropped {} SST file(s) covered by range tombstones", gone.size());
+    maybe_schedule_compaction_locked();
+    return true;
+  }
 
-    // Шаг 3: пишем новый SST
-    const auto out_name = sst_name(new_idx);
-    const auto out_path = join_path(sst_dir, out_name);
+  // бронируем имена заранее: выходы в L0 должны быть старше SST, которые flush
+  // добавит за время компактации. Выход не больше входа => части задания хватит
+  // bytes/target + 2 имён (плюс разрезы blob GC); частей — до max_subcompactions.
+  void reserve_outputs_locked(const CompactionJob &job, uint64_t &first_idx, uint64_t &per_sub) {
+    const uint64_t target = std::max<uint64_t>(1, opts.sst_target_file_bytes);
+    const uint64_t subs = job.relocate ? 1 : std::max(1u, opts.max_subcompactions);
+    first_idx = next_sst_index + 1;
+    per_sub = level_bytes(job.inputs) / target + 2 + job.split_keys.size();
+    next_sst_index = first_idx + subs * per_sub - 1;
+  }
 
-    SstWriter wr(out_path);
-    if (!wr.write_sorted(entries)) {
-      spdlog::error("BG-Compaction failed to write {}", out_path);
+  // Часть задания: ключи [start, end) (пустая граница — без ограничения) и свои
+  // имена выходов [first_idx, last_idx]
+  struct Subcompaction {
+    Subcompaction(Impl *d, std::string s, std::string e, uint64_t first, uint64_t last)
+        : start(std::move(s)), end(std::move(e)), first_idx(first), last_idx(last), sink(d) {}
+
+    std::string start, end;
+    uint64_t first_idx = 0, last_idx = 0;
+    BlobSink sink;
+    std::vector<SstFileMeta> outputs;
+    std::map<uint64_t, uint64_t> garbage; // blob-файл -> байт выброшенных/перенесённых записей
+    uint64_t relocated = 0;
+    bool ok = false;
+
+    void discard() {
+      for (const auto &f : outputs)
+        (void)::unlink(f.path.c_str());
+      outputs.clear();
+      sink.discard();
+    }
+  };
+
+  // Границы частей задания: квантили первых ключей блоков входа. Часть — не
+  // меньше kMinSubcompactionBytes входа; blob GC и вход с range tombstone'ами
+  // (они не режутся по границам частей) не делятся.
+  static constexpr uint64_t kMinSubcompactionBytes = 1ull << 20;
+  std::vector<std::string> subcompaction_bounds(const CompactionJob &job) const {
+    if (job.relocate || opts.max_subcompactions <= 1 ||
+        std::any_of(job.inputs.begin(), job.inputs.end(), [](const SstFileMeta &f) { return f.range_dels; }))
+      return {};
+    std::size_t n = std::min<uint64_t>(opts.max_subcompactions, level_bytes(job.inputs) / kMinSubcompactionBytes);
+    if (n < 2)
+      return {};
+    std::vector<std::string> keys;
+    for (const auto &f : job.inputs) {
+      SstReader rd(f.path);
+      for (auto &k : rd.boundary_keys())
+        keys.push_back(std::move(k));
+    }
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    n = std::min(n, keys.size());
+    std::vector<std::string> bounds;
+    for (std::size_t i = 1; i < n; ++i)
+      bounds.push_back(keys[i * keys.size() / n]);
+    return bounds;
+  }
+
+  // Шаги 2-4 компактации (и задания blob GC) с уже выбранным входом: части
+  // сливаются параллельно (первая — в этом потоке), выход ставится одним коммитом.
+  // Ссылки на blob-файлы копируются как есть; выброшенные версии копят мусор своих файлов.
+  bool run_compaction(const CompactionJob &job, uint64_t first_idx, uint64_t per_sub) {
+    const auto t_start = std::chrono::steady_clock::now();
+    const auto version = current_version(); // держит вход и blob-файлы на диске
+    const auto &bset = version->blobs;
+
+    const auto bounds = subcompaction_bounds(job);
+    std::vector<Subcompaction> subs;
+    subs.reserve(bounds.size() + 1);
+    for (std::size_t i = 0; i <= bounds.size(); ++i) {
+      const uint64_t first = first_idx + i * per_sub;
+      subs.emplace_back(this, i ? bounds[i - 1] : std::string{}, i < bounds.size() ? bounds[i] : std::string{},
+                        first, first + per_sub - 1);
+    }
+    std::vector<std::thread> workers;
+    for (std::size_t i = 1; i < subs.size(); ++i)
+      workers.emplace_back([&, i] {
+        if (opts.bg_io_low_priority)
+          (void)lower_thread_io_priority();
+        subs[i].ok = run_subcompaction(job, bset, subs[i]);
+      });
+    subs[0].ok = run_subcompaction(job, bset, subs[0]);
+    for (auto &t : workers)
+      t.join();
+    if (subs.size() > 1)
+      m_subcompactions.fetch_add(subs.size(), std::memory_order_relaxed);
+
+    auto drop_outputs = [&] {
+      for (auto &sc : subs)
+        sc.discard();
       return false;
+    };
+    if (std::any_of(subs.begin(), subs.end(), [](const Subcompaction &sc) { return !sc.ok; }))
+      return drop_outputs();
+
+    std::vector<SstFileMeta> outputs;
+    std::map<uint64_t, uint64_t> garbage;
+    uint64_t relocated = 0, blob_bytes = 0;
+    for (const auto &sc : subs) {
+      outputs.insert(outputs.end(), sc.outputs.begin(), sc.outputs.end());
+      for (const auto &[idx, bytes] : sc.garbage)
+        garbage[idx] += bytes;
+      relocated += sc.relocated;
+      blob_bytes += sc.sink.bytes();
     }
 
     // Шаг 4: коммит под локом
     {
       std::unique_lock<std::mutex> lk(mu);
       if (stopping)
-        return true;
+        return drop_outputs();
+
+      // вход заменяется выходом; SST, добавленные flush'ем или другими
+      // заданиями за время компактации, остаются
+      SstLevels next = levels;
+      for (auto &lvl : next) {
+        lvl.erase(std::remove_if(lvl.begin(), lvl.end(),
+                                 [&](const SstFileMeta &f) {
+                                   return std::any_of(job.inputs.begin(), job.inputs.end(),
+                                                      [&](const SstFileMeta &x) {
+                                                        return x.index == f.index;
+                                                      });
+                                 }),
+                  lvl.end());
+      }
+      auto &dst = next[job.out_level];
+      dst.insert(dst.end(), outputs.begin(), outputs.end());
+      sort_level(dst, job.out_level);
+      auto next_blobs = blob_meta;
+      for (const auto &[idx, bytes] : garbage) {
+        auto itb = next_blobs.find(idx);
+        if (itb != next_blobs.end())
+          itb->second.garbage = std::min(itb->second.bytes, itb->second.garbage + bytes);
+      }
+      for (const auto &sc : subs)
+        for (const auto &b : sc.sink.files)
+          next_blobs[b.index] = b;
+      if (!install_locked(std::move(next), std::move(next_blobs)))
+        return drop_outputs();
+      m_blob_bytes_written.fetch_add(blob_bytes, std::memory_order_relaxed);
+      m_blob_gc_relocated.fetch_add(relocated, std::memory_order_relaxed);
+
+      // таблицы и блоки выбывших файлов закроются вместе с последней версией,
+      // где они есть (LiveFile); остальные остаются в кэше
+      if (!job.relocate) {
+        m_compactions.fetch_add(1, std::memory_order_relaxed);
+        record_latency(&OpLatency::compaction, t_start);
+      }
+    }
 
-      std::vector<std::string> new_list;
-      new_list.reserve(ssts.size() + 1);
-      for (auto &p : ssts) {
-        if (std::find(input.begin(), input.end(), p) == input.end())
-          new_list.push_back(p);
+    spdlog::info("BG-Compaction: done -> {} file(s) in L{} ({} part(s))", outputs.size(), job.out_level,
+                 subs.size());
+    return true;
+  }
+
+  // Шаги 2-3 для одной части: k-way merge её диапазона ключей, выход пишется
+  // потоково. При ошибке свои выходы и blob-файлы удаляются.
+  bool run_subcompaction(const CompactionJob &job, const std::shared_ptr<const BlobSet> &bset, Subcompaction &sc) {
+    const bool v3_out = opts.sst_format_version == kSstVersionV3;
+
+    // на равных ключах из кучи первым выходит самый новый источник
+    struct Source {
+      std::unique_ptr<SstReader> rd;
+      std::unique_ptr<SstReader::Iterator> it;
+      uint64_t legacy_seq; // для записей без seqno: max_seq файла (только порядок)
+      uint64_t order_seq() const { return it->seqno() ? it->seqno() : legacy_seq; }
+    };
+    // вход не читается целиком — задание отменяется, вход остаётся на месте
+    // (иначе выход без хвоста входа заменил бы его)
+    auto fail_input = [&](const SstFileMeta &f) {
+      spdlog::error("BG-Compaction failed to read {}", f.path);
+      sc.discard();
+      return false;
+    };
+    std::vector<Source> src; // src[i] — job.inputs[i]
+    src.reserve(job.inputs.size());
+    std::vector<RangeTombstone> rdels; // range tombstone'ы входа (задание с ними не делится)
+    uint64_t min_seq = UINT64_MAX, max_seq = 0;
+    for (const auto &f : job.inputs) {
+      min_seq = std::min(min_seq, f.min_seq);
+      max_seq = std::max(max_seq, f.max_seq);
+      auto rd = std::make_unique<SstReader>(f.path);
+      if (!rd->loaded())
+        return fail_input(f);
+      rdels.insert(rdels.end(), rd->range_tombstones().begin(), rd->range_tombstones().end());
+      auto it = std::make_unique<SstReader::Iterator>(rd.get());
+      if (sc.start.empty())
+        it->seek_to_first();
+      else
+        it->seek(sc.start);
+      if (it->corrupted())
+        return fail_input(f);
+      src.push_back(Source{std::move(rd), std::move(it), f.max_seq});
+    }
+
+    auto heap_cmp = [&src](size_t a, size_t b) {
+      const int c = src[a].it->key().compare(src[b].it->key());
+      if (c != 0)
+        return c > 0; // min-heap по ключу
+      const uint64_t sa = src[a].order_seq(), sb = src[b].order_seq();
+      if (sa != sb)
+        return sa < sb; // затем версии от новых к старым
+      return a < b;     // при равенстве новее источник (больший индекс)
+    };
+    std::priority_queue<size_t, std::vector<size_t>, decltype(heap_cmp)> heap(heap_cmp);
+    for (size_t i = 0; i < src.size(); ++i)
+      if (src[i].it->valid())
+        heap.push(i);
+
+    auto &outputs = sc.outputs;
+    std::unique_ptr<SstWriter> wr;
+    std::string rdel_end; // наибольший end range tombstone'ов текущего выхода
+    auto finish_output = [&] {
+      auto &f = outputs.back();
+      f.largest = std::max(f.largest, rdel_end);
+      rdel_end.clear();
+      const bool ok = wr->finish();
+      if (ok)
+        count_block_bytes(*wr);
+      wr.reset();
+      f.size = file_bytes(f.path);
+      return ok;
+    };
+    auto open_output = [&](std::string_view smallest) {
+      SstFileMeta f;
+      f.index = sc.first_idx + outputs.size();
+      f.path = join_path(sst_dir, sst_name(f.index));
+      f.min_seq = min_seq;
+      f.max_seq = max_seq;
+      f.smallest = smallest;
+      outputs.push_back(std::move(f));
+      wr = std::make_unique<SstWriter>(outputs.back().path, sst_writer_opts(/*compaction=*/true));
+    };
+    auto fail = [&] {
+      spdlog::error("BG-Compaction failed to write {}", outputs.empty() ? sst_dir : outputs.back().path);
+      wr.reset();
+      sc.discard();
+      return false;
+    };
+
+    // версии, заслонённые для всех живых снимков, выбрасываются
+    VersionFilter vf = version_filter();
+
+    // Range tombstone'ы: версия под более новым tombstone'ом из той же полосы
+    // выбрасывается. Сам tombstone выбрасывается, если все его снимки видят его
+    // (самая старая полоса) и под выходным уровнем диапазона нет. Остальные
+    // переходят в выход: в файл, где лежит их start, и пока он не закрыт,
+    // выход не режется внутри tombstone'а (диапазоны файлов L1+ не пересекаются).
+    std::sort(rdels.begin(), rdels.end(),
+              [](const RangeTombstone &a, const RangeTombstone &b) { return a.start < b.start; });
+    std::vector<RangeTombstone> out_rdels;
+    for (const auto &t : rdels)
+      if (vf.stripe(t.seqno) > 0 || job.range_may_exist_below(t.start, t.end))
+        out_rdels.push_back(t);
+    std::size_t rdel_pos = 0;
+    auto covered = [&](std::string_view k, uint64_t seq) {
+      for (const auto &t : rdels) {
+        if (t.start > k)
+          break;
+        if (seq < t.seqno && t.contains(k) && vf.stripe(seq) == vf.stripe(t.seqno))
+          return true;
+      }
+      return false;
+    };
+    // tombstone'ы со start < upto (все — при all) — в текущий выход
+    auto attach_rdels = [&](std::string_view upto, bool all) {
+      for (; rdel_pos < out_rdels.size() && (all || out_rdels[rdel_pos].start < upto); ++rdel_pos) {
+        const auto &t = out_rdels[rdel_pos];
+        if (!wr->add_range_tombstone(t.start, t.end, t.seqno))
+          return false;
+        auto &f = outputs.back();
+        f.smallest = std::min(f.smallest, t.start);
+        rdel_end = std::max(rdel_end, t.end);
+        ++f.range_dels;
+      }
+      return true;
+    };
+
+    std::string key, blob_value, ref_buf;
+    bool have_key = false;
+    std::size_t split_pos = 0;
+    while (!heap.empty()) {
+      const size_t top = heap.top();
+      auto &it = *src[top].it;
+      if (!sc.end.empty() && it.key() >= sc.end)
+        break; // дальше — следующая часть
+      heap.pop();
+      const bool new_key = !have_key || it.key() != key;
+      bool crossed = false; // GC: ключ перешёл в следующий входной файл
+      if (new_key) {
+        key.assign(it.key());
+        have_key = true;
+        vf.new_key();
+        for (; split_pos < job.split_keys.size() && job.split_keys[split_pos] <= key; ++split_pos)
+          crossed = true;
       }
-      new_list.push_back(out_path);
-      ssts.swap(new_list);
 
-      if (!write_current_atomic(sst_dir, new_idx)) {
-        spdlog::warn("BG-Compaction: failed CURRENT -> {}", new_idx);
+      // tombstone в самой старой полосе выбрасываем, если под выходным уровнем
+      // ключа быть не может
+      const uint32_t flags = it.flags();
+      const uint64_t seq = it.seqno();
+      bool keep = vf.keep(seq) &&
+                  (flags == SST_FLAG_PUT || flags == SST_FLAG_BLOB ||
+                   (flags == SST_FLAG_DEL && (vf.stripe(seq) > 0 || job.key_may_exist_below(key))));
+      if (keep && !rdels.empty() && covered(key, seq)) {
+        keep = false;
+        m_range_del_keys.fetch_add(1, std::memory_order_relaxed);
       }
-      for (const auto &p : input) {
-        (void)::unlink(p.c_str());
+      BlobRef ref;
+      const bool blob = flags == SST_FLAG_BLOB && decode_blob_ref(it.value(), ref);
+      if (blob && (!keep || ref.file == job.relocate || !v3_out))
+        sc.garbage[ref.file] += blob_record_bytes(key.size(), ref.size);
+      if (keep) {
+        uint32_t out_flags = flags;
+        std::string_view out_value = flags == SST_FLAG_DEL ? std::string_view{} : it.value();
+        uint64_t out_blob = 0;
+        if (blob && (ref.file == job.relocate || !v3_out)) {
+          // перенос живого значения (GC) или возврат в SST v2
+          if (!read_blob(bset, key, it.value(), blob_value))
+            return fail();
+          if (ref.file == job.relocate)
+            sc.relocated += blob_record_bytes(key.size(), ref.size);
+          if (!v3_out) {
+            out_flags = SST_FLAG_PUT;
+            out_value = blob_value;
+          } else {
+            if (!sc.sink.add(key, blob_value, ref_buf, out_blob))
+              return fail();
+            out_value = ref_buf;
+          }
+        } else if (blob) {
+          out_blob = ref.file;
+        }
+
+        // выход режется только на границе ключей: версии ключа — в одном файле
+        if (new_key && wr && !attach_rdels(key, false))
+          return fail();
+        if (new_key && wr && (crossed || wr->file_size() >= opts.sst_target_file_bytes) &&
+            (rdel_end.empty() || rdel_end < key) && sc.first_idx + outputs.size() <= sc.last_idx) {
+          if (!finish_output())
+            return fail();
+        }
+        if (!wr) {
+          open_output(key);
+          if (!attach_rdels(key, false))
+            return fail();
+        }
+        if (!wr->add(key, out_flags, out_value, seq))
+          return fail();
+        outputs.back().largest = key;
+        if (out_blob)
+          add_blob_ref(outputs.back().blob_files, out_blob);
       }
 
-      tcache = TableCache(opts.table_cache_capacity ? opts.table_cache_capacity
-                                                    : 64);
-      m_compactions.fetch_add(1, std::memory_order_relaxed);
+      it.next();
+      if (it.valid())
+        heap.push(top);
+      else if (it.corrupted()) {
+        wr.reset();
+        return fail_input(job.inputs[top]);
+      }
+    }
+    // оставшиеся tombstone'ы — в последний выход (или отдельный файл без записей)
+    if (rdel_pos < out_rdels.size()) {
+      if (!wr)
+        open_output(out_rdels[rdel_pos].start);
+      if (!attach_rdels({}, true))
+        return fail();
     }
+    if ((wr && !finish_output()) || !sc.sink.finish())
+      return fail();
+    return true;
+  }
 
-    spdlog::info("BG-Compaction: done -> {}", out_path);
+  // Один проход blob GC (см. KV::gc_blobs): все уровни, ссылающиеся на выбранный
+  // файл, переписываются заданиями компактации; true — файл освобождён.
+  // Задание ждёт, пока его входы сливают другие потоки.
+  bool blob_gc_once(double ratio) {
+    std::lock_guard<std::mutex> glk(gc_mu);
+    uint64_t file = 0;
+    {
+      std::lock_guard<std::mutex> lk(mu);
+      if (stopping || !(file = pick_blob_gc_locked(ratio)))
+        return false;
+    }
+    spdlog::info("Blob GC: relocating live values of {}", blob_name(file));
+    m_blob_gc_runs.fetch_add(1, std::memory_order_relaxed);
+    for (std::size_t jobs = 0;; ++jobs) {
+      CompactionJob job;
+      uint64_t first_idx = 0, per_sub = 0;
+      {
+        std::unique_lock<std::mutex> lk(mu);
+        bool busy = false;
+        while (blob_meta.count(file) && !stopping && jobs <= levels.size() &&
+               !pick_blob_gc_job_locked(file, job, busy) && busy)
+          job_done_cv.wait(lk);
+        if (!blob_meta.count(file))
+          break; // ссылок не осталось — файл удалён при установке
+        if (stopping || jobs > levels.size() || job.inputs.empty())
+          return false;
+        reserve_outputs_locked(job, first_idx, per_sub);
+        begin_job_locked(job);
+      }
+      const bool ok = run_compaction(job, first_idx, per_sub);
+      std::lock_guard<std::mutex> lk(mu);
+      end_job_locked(job);
+      if (!ok)
+        return false;
+    }
+    std::lock_guard<std::mutex> lk(mu);
+    maybe_schedule_compaction_locked();
     return true;
   }
 
   void maybe_schedule_compaction_locked() {
     if (!opts.background_compaction)
       return;
-    if (ssts.size() >= opts.l0_compact_threshold) {
+    // без учёта файлов, которые уже сливают другие потоки
+    bool need = level_score_locked(0, /*idle=*/true) >= 1.0;
+    for (std::size_t l = 1; leveled() && !need && l + 1 < levels.size(); ++l)
+      need = level_score_locked(l, /*idle=*/true) >= 1.0;
+    need = need || pick_blob_gc_locked(opts.blob_gc_garbage_ratio) != 0;
+    if (need && running.size() < std::max(1u, opts.compaction_threads)) {
       need_compact = true;
-      cv.notify_one();
+      cv.notify_all();
     }
   }
 
-  void maybe_flush_locked() {
-    if (mem_bytes < opts.sst_flush_threshold_bytes)
+  // Удалить WAL-сегменты с индексом < seg (их данные уже в SST)
+  void purge_wal_segments_below(uint64_t seg) {
+    bool removed = false;
+    if (DIR *d = ::opendir(wal_dir.c_str())) {
+      while (auto *e = ::readdir(d)) {
+        std::string n{e->d_name};
+        if (n.size() != 10 || n.substr(6) != ".wal" ||
+            !std::all_of(n.begin(), n.begin() + 6, ::isdigit))
+          continue;
+        if (std::stoull(n.substr(0, 6)) < seg) {
+          ::unlink(join_path(wal_dir, n).c_str());
+          removed = true;
+        }
+      }
+      ::closedir(d);
+    }
+    if (!removed)
       return;
+    int dfd = ::open(wal_dir.c_str(), O_RDONLY | O_DIRECTORY);
+    if (dfd >= 0) {
+      (void)::fsync(dfd);
+      ::close(dfd);
+    }
+  }
 
-    std::vector<std::pair<std::string, std::optional<std::string>>> entries;
-    entries.reserve(mem.size());
-    for (auto &[k, v] : mem)
-      entries.emplace_back(k, v);
-    std::sort(entries.begin(), entries.end(),
-              [](const auto &a, const auto &b) { return a.first < b.first; });
-
-    const uint64_t idx = next_sst_index + 1;
-    const auto name = sst_name(idx);
-    const auto path = join_path(sst_dir, name);
+  std::string flush_tmp_path() const { return join_path(sst_dir, "flush.tmp"); }
+
+  // Опубликовать записанный flush'ем SST в L0 (под mu): индекс выдаётся в момент
+  // коммита, чтобы он был больше, чем у идущей параллельно компактации.
+  // t_start — начало записи SST (задержка flush).
+  bool install_flushed_sst_locked(const std::string &tmp, SstFileMeta meta, const BlobSink &sink,
+                                  std::chrono::steady_clock::time_point t_start) {
+    meta.index = next_sst_index + 1;
+    meta.path = join_path(sst_dir, sst_name(meta.index));
+    if (::rename(tmp.c_str(), meta.path.c_str()) != 0) {
+      spdlog::error("SST flush: rename {} -> {} failed", tmp, meta.path);
+      return false;
+    }
+    next_sst_index = meta.index;
+    // MANIFEST + fsync каталога (закрепляет и rename); сначала SST, потом
+    // сброс MemTable: читатель не потеряет ключи
+    SstLevels next = levels;
+    next[0].push_back(meta);
+    auto next_blobs = blob_meta;
+    for (const auto &b : sink.files)
+      next_blobs[b.index] = b;
+    if (!install_locked(std::move(next), std::move(next_blobs))) {
+      (void)::unlink(meta.path.c_str());
+      return false;
+    }
+    m_sst_flushes.fetch_add(1, std::memory_order_relaxed);
+    m_blob_bytes_written.fetch_add(sink.bytes(), std::memory_order_relaxed);
+    record_latency(&OpLatency::flush, t_start);
+    // накрытые range tombstone'ом SST удаляет проход компактации
+    if (meta.range_dels && opts.background_compaction) {
+      need_compact = true;
+      cv.notify_all();
+    }
+    return true;
+  }
 
-    SstWriter wr(path);
-    if (!wr.write_sorted(entries)) {
-      spdlog::error("SST flush failed: {}", path);
+  // Активная MemTable переполнена: делаем её immutable и отдаём flush-потоку.
+  // Если предыдущая imm ещё пишется — ждём (единственный случай, когда put
+  // блокируется на flush).
+  void maybe_flush_locked(std::unique_lock<std::mutex> &lk) {
+    if (mem->data_bytes() < opts.sst_flush_threshold_bytes)
       return;
+    if (imm) {
+      // предыдущая imm ещё пишется — это тоже остановка записи
+      m_write_stalls.fetch_add(1, std::memory_order_relaxed);
+      const auto t0 = std::chrono::steady_clock::now();
+      imm_done_cv.wait(lk, [&] { return !imm || stop_flush; });
+      add_stall_time(t0);
     }
-    if (!write_current_atomic(sst_dir, idx)) {
-      spdlog::warn("Failed to update CURRENT for SST {}", idx);
+    if (imm)
+      return;
+
+    // новый сегмент: всё до него покрыто imm
+    if (!wal.rotate(seq.load())) {
+      spdlog::error("WAL rotate failed; MemTable stays active");
+      return;
     }
-    next_sst_index = idx;
-    ssts.push_back(path);
+    imm_wal_seg = wal.segment_index();
+    // порядок важен для читателей (они грузят mem, затем imm)
+    std::atomic_store(&imm, mem);
+    std::atomic_store(&mem, std::make_shared<MemTable>());
+    flush_cv.notify_one();
+  }
 
-    // purge WAL и очистка MemTable
-    purge_wal_files_locked();
-    mem.clear();
-    mem_bytes = 0;
+  void flusher_thread() {
+    std::unique_lock<std::mutex> lk(mu);
+    while (true) {
+      flush_cv.wait(lk, [&] { return stop_flush || imm; });
+      if (!imm)
+        break; // стоп и сбрасывать нечего
 
-    m_sst_flushes.fetch_add(1, std::memory_order_relaxed);
-    spdlog::info("Flushed MemTable to {}", path);
+      const auto m = imm;
+      const uint64_t wal_seg = imm_wal_seg;
+      const auto tmp = flush_tmp_path();
 
-    maybe_schedule_compaction_locked();
+      SstFileMeta meta;
+      BlobSink sink(this, RateLimiter::Priority::HIGH);
+      const auto t_start = std::chrono::steady_clock::now();
+      lk.unlock();
+      const bool ok = write_memtable_sst(*m, tmp, meta, sink);
+      lk.lock();
+
+      if (!ok || !install_flushed_sst_locked(tmp, std::move(meta), sink, t_start)) {
+        spdlog::error("SST flush failed: {}", tmp);
+        sink.discard();
+        if (stop_flush)
+          break; // данные остаются в WAL
+        flush_cv.wait_for(lk, std::chrono::seconds(1));
+        continue;
+      }
+      std::atomic_store(&imm, std::shared_ptr<MemTable>{});
+      imm_done_cv.notify_all();
+      purge_wal_segments_below(wal_seg);
+      spdlog::info("Flushed MemTable to {}", levels[0].back().path);
+
+      maybe_schedule_compaction_locked();
+    }
+  }
+
+  void stop_flusher() {
+    {
+      std::lock_guard<std::mutex> lk(mu);
+      stop_flush = true;
+    }
+    flush_cv.notify_all();
+    imm_done_cv.notify_all();
+    if (bg_flusher.joinable())
+      bg_flusher.join();
   }
 
+  // Финальный flush (flush-поток уже остановлен). imm остаётся только если
+  // её flush не удался — пробуем ещё раз; при ошибке WAL не трогаем.
   void flush_all_locked() {
-    if (!mem.empty()) {
-      std::vector<std::pair<std::string, std::optional<std::string>>> entries;
-      entries.reserve(mem.size());
-      for (auto &[k, v] : mem)
-        entries.emplace_back(k, v);
-      std::sort(entries.begin(), entries.end(),
-                [](const auto &a, const auto &b) { return a.first < b.first; });
-
-      const uint64_t idx = next_sst_index + 1;
-      const auto name = sst_name(idx);
-      const auto path = join_path(sst_dir, name);
-
-      SstWriter wr(path);
-      if (!wr.write_sorted(entries)) {
-        spdlog::error("SST final flush failed: {}", path);
-      } else {
-        if (!write_current_atomic(sst_dir, idx)) {
-          spdlog::warn("Failed to update CURRENT for SST {}", idx);
-        }
-        next_sst_index = idx;
-        ssts.push_back(path);
-        m_sst_flushes.fetch_add(1, std::memory_order_relaxed);
-        spdlog::info("Flushed MemTable to {} (final)", path);
+    for (const auto &mt : {imm, mem}) { // imm старше — получает меньший индекс
+      if (!mt || mt->empty())
+        continue;
+      const auto tmp = flush_tmp_path();
+      SstFileMeta meta;
+      BlobSink sink(this, RateLimiter::Priority::HIGH);
+      const auto t_start = std::chrono::steady_clock::now();
+      if (!write_memtable_sst(*mt, tmp, meta, sink) ||
+          !install_flushed_sst_locked(tmp, std::move(meta), sink, t_start)) {
+        spdlog::error("SST final flush failed: {}", tmp);
+        sink.discard();
+        return;
       }
+      spdlog::info("Flushed MemTable to {} (final)", levels[0].back().path);
     }
 
     purge_wal_files_locked();
-    mem.clear();
-    mem_bytes = 0;
+    std::atomic_store(&imm, std::shared_ptr<MemTable>{});
+    std::atomic_store(&mem, std::make_shared<MemTable>());
   }
 
   void compactor_thread() {
+    if (opts.bg_io_low_priority && !lower_thread_io_priority())
+      spdlog::debug("BG-Compaction: ioprio_set failed (errno={})", errno);
     std::unique_lock<std::mutex> lk(mu);
     while (true) {
       cv.wait_for(lk, std::chrono::milliseconds(200),
@@ -280,7 +1953,8 @@ struct KV::Impl {
       need_compact = false;
 
       lk.unlock();
-      (void)compact_l0_once();
+      (void)compact_once();
+      (void)blob_gc_once(opts.blob_gc_garbage_ratio);
       lk.lock();
     }
   }
@@ -295,67 +1969,289 @@ struct KV::Impl {
       need_compact = false;
     }
     cv.notify_all();
-    if (bg_compactor.joinable())
-      bg_compactor.join();
+    stall_cv.notify_all();
+    job_done_cv.notify_all();
+    for (auto &t : bg_compactors)
+      t.join();
+    bg_compactors.clear();
+  }
+
+  // Диапазон ключей и seqno SST без MANIFEST (каталог старого формата)
+  static bool describe_sst(SstFileMeta &f) {
+    SstReader rd(f.path);
+    if (!rd.good())
+      return false;
+    SstReader::Iterator it(&rd);
+    it.seek_to_first();
+    const auto &rdels = rd.range_tombstones();
+    if (!it.valid() && rdels.empty())
+      return false;
+    f.smallest.assign(it.valid() ? it.key() : std::string_view(rdels.front().start));
+    f.min_seq = UINT64_MAX;
+    f.max_seq = 0;
+    for (; it.valid(); it.next()) {
+      f.largest.assign(it.key());
+      f.min_seq = std::min(f.min_seq, it.seqno());
+      f.max_seq = std::max(f.max_seq, it.seqno());
+    }
+    for (const auto &t : rdels) {
+      f.smallest = std::min(f.smallest, t.start);
+      f.largest = std::max(f.largest, t.end);
+      f.min_seq = std::min(f.min_seq, t.seqno);
+      f.max_seq = std::max(f.max_seq, t.seqno);
+    }
+    f.range_dels = rdels.size();
+    f.size = file_bytes(f.path);
+    return true;
+  }
+
+  // Состав дерева из журнала MANIFEST. После корректного закрытия каталоги не
+  // читаются и SST не открываются: сирот нет, индексы продолжаются из журнала.
+  // После сбоя SST и blob-файлы вне MANIFEST (недокоммиченный flush, компактация
+  // или GC) удаляются; без MANIFEST (старый каталог) все SST идут в L0.
+  void load_levels() {
+    uint64_t last = 0;
+    SstLevels loaded;
+    std::vector<BlobFileMeta> loaded_blobs;
+    ManifestStatus st;
+    const bool have_manifest = read_manifest(sst_dir, last, loaded, &loaded_blobs, &st);
+    const bool recover = !have_manifest || !st.clean;
+    levels.assign(std::max(configured_levels(), loaded.size()), {});
+
+    std::unordered_map<uint64_t, bool> listed;
+    for (std::size_t l = 0; l < loaded.size(); ++l) {
+      for (auto &f : loaded[l]) {
+        if (recover && ::access(f.path.c_str(), F_OK) != 0) {
+          spdlog::warn("MANIFEST: missing SST {}", f.path);
+          continue;
+        }
+        listed[f.index] = true;
+        levels[l].push_back(std::move(f));
+      }
+    }
+    next_sst_index = last;
+
+    for (auto &name : recover ? list_sst_sorted(sst_dir) : std::vector<std::string>{}) {
+      SstFileMeta f;
+      f.index = std::stoull(name.substr(0, 6));
+      f.path = join_path(sst_dir, name);
+      next_sst_index = std::max(next_sst_index, f.index);
+      if (have_manifest) {
+        if (!listed.count(f.index)) {
+          spdlog::warn("Removing SST {} not listed in MANIFEST", f.path);
+          (void)::unlink(f.path.c_str());
+        }
+        continue;
+      }
+      if (!describe_sst(f)) {
+        spdlog::warn("Skipping unreadable SST {}", f.path);
+        continue;
+      }
+      levels[0].push_back(std::move(f));
+    }
+    uint64_t cur = 0;
+    if (!have_manifest && read_current(sst_dir, cur))
+      next_sst_index = std::max(next_sst_index, cur);
+    compact_pointer.assign(levels.size(), std::string{});
+    load_blobs(loaded_blobs, recover ? 0 : st.next_blob);
+
+    // журнал дописывается дальше, если он цел и не раздут; иначе — снимок.
+    // Пустая правка снимает отметку закрытия: после сбоя с этого места
+    // следующее открытие сверит каталоги.
+    manifest = std::make_unique<ManifestLog>(sst_dir);
+    bool logged = have_manifest && !st.torn && manifest->open(st.edits) &&
+                  manifest->bytes() < opts.manifest_max_bytes && manifest->append(VersionEdit{});
+    if (!logged) {
+      std::vector<BlobFileMeta> blob_list;
+      for (const auto &[idx, b] : blob_meta)
+        blob_list.push_back(b);
+      logged = manifest->rewrite(next_sst_index, levels, blob_list);
+      if (!logged)
+        spdlog::warn("Failed to write MANIFEST in {}", sst_dir);
+    }
+    publish_version_locked();
+    update_bg_io_locked();
+  }
+
+  // Метаданные blob-файлов из MANIFEST; при сверке (next_blob == 0) файлы вне
+  // MANIFEST — недокоммиченный flush или задание GC — удаляются.
+  void load_blobs(const std::vector<BlobFileMeta> &loaded, uint64_t next_blob) {
+    uint64_t max_index = 0;
+    for (const auto &b : loaded) {
+      blob_meta[b.index] = b;
+      max_index = std::max(max_index, b.index);
+    }
+    if (next_blob) {
+      next_blob_index.store(std::max(next_blob, max_index + 1));
+      return;
+    }
+    std::set<uint64_t> on_disk;
+    for (const auto &name : list_blob_files(blob_dir)) {
+      const uint64_t idx = std::stoull(name.substr(0, 6));
+      max_index = std::max(max_index, idx);
+      on_disk.insert(idx);
+      if (!blob_meta.count(idx)) {
+        spdlog::warn("Removing blob file {} not listed in MANIFEST", name);
+        (void)::unlink(join_path(blob_dir, name).c_str());
+      }
+    }
+    for (const auto &[idx, b] : blob_meta)
+      if (!on_disk.count(idx))
+        spdlog::warn("MANIFEST: missing blob file {}", blob_name(idx));
+    next_blob_index.store(max_index + 1);
+  }
+
+  // Отметка корректного закрытия (фон остановлен): файлов вне MANIFEST нет,
+  // следующее открытие не читает каталоги
+  void mark_clean_shutdown() {
+    std::lock_guard<std::mutex> lk(mu);
+    if (!manifest)
+      return;
+    VersionEdit edit;
+    edit.last_index = next_sst_index;
+    edit.clean_next_blob = next_blob_index.load();
+    if (!manifest->append(edit))
+      spdlog::warn("MANIFEST: failed to mark clean shutdown in {}", sst_dir);
+  }
+
+
+  // WAL replay: сегменты читаются одним куском и проверяются параллельно (не
+  // дальше окна вперёд — память), в MemTable применяются по порядку в этом потоке
+  // по мере готовности. Битая запись обрывает только свой сегмент.
+  void replay_wal() {
+    const auto t0 = std::chrono::steady_clock::now();
+    const auto files = list_wal_segments(wal_dir);
+    if (files.empty())
+      return;
+    unsigned threads = opts.wal_replay_threads ? opts.wal_replay_threads
+                                               : std::max(1u, std::thread::hardware_concurrency());
+    threads = static_cast<unsigned>(std::min<std::size_t>(threads, files.size()));
+    const std::size_t window = std::size_t(threads) * 2;
+
+    struct Slot {
+      WalSegment seg;
+      bool loaded = false;
+      bool ok = false;
+    };
+    std::vector<std::unique_ptr<Slot>> slots(files.size());
+    std::mutex smu;
+    std::condition_variable scv;
+    std::size_t next_load = 0, applied = 0;
+
+    auto load_loop = [&] {
+      while (true) {
+        std::size_t i;
+        {
+          std::unique_lock lk(smu);
+          scv.wait(lk, [&] { return next_load >= files.size() || next_load < applied + window; });
+          if (next_load >= files.size())
+            return;
+          i = next_load++;
+        }
+        auto slot = std::make_unique<Slot>();
+        slot->ok = load_wal_segment(join_path(wal_dir, files[i]), slot->seg);
+        slot->loaded = true;
+        std::lock_guard lk(smu);
+        slots[i] = std::move(slot);
+        scv.notify_all();
+      }
+    };
+    std::vector<std::thread> loaders;
+    for (unsigned t = 0; threads > 1 && t < threads; ++t)
+      loaders.emplace_back(load_loop);
+
+    uint64_t records = 0, bytes = 0, max_seq = 0;
+    for (std::size_t i = 0; i < files.size(); ++i) {
+      std::unique_ptr<Slot> slot;
+      {
+        std::unique_lock lk(smu);
+        if (threads == 1) {
+          ++next_load; // загрузчиков нет — читаем сами
+        } else {
+          scv.wait(lk, [&] { return slots[i] != nullptr; });
+          slot = std::move(slots[i]);
+        }
+      }
+      if (!slot) {
+        slot = std::make_unique<Slot>();
+        slot->ok = load_wal_segment(join_path(wal_dir, files[i]), slot->seg);
+      }
+      if (slot->ok) {
+        for (const auto &r : slot->seg.records)
+          mem->add(r.seqno, r.flags, r.key, r.value);
+        records += slot->seg.records.size();
+        bytes += slot->seg.data.size();
+        max_seq = std::max(max_seq, slot->seg.max_seqno);
+      }
+      slot.reset(); // память сегмента — до загрузки следующих
+      std::lock_guard lk(smu);
+      ++applied;
+      scv.notify_all();
+    }
+    for (auto &t : loaders)
+      t.join();
+
+    if (records)
+      seq.store(std::max<uint64_t>(seq.load(), max_seq + 1));
+    replay_us = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+                                          std::chrono::steady_clock::now() - t0)
+                                          .count());
+    replay_records = records;
+    replay_bytes = bytes;
+    spdlog::info("Replayed {} WAL records from {} segments ({} bytes, {} threads) in {} us", records,
+                 files.size(), bytes, threads, replay_us);
   }
 
   // init
   Impl(const KVOptions &o) : opts(o) {
+    const auto t_start = std::chrono::steady_clock::now();
     wal_dir = join_path(opts.path, "wal");
     sst_dir = join_path(opts.path, "sst");
+    blob_dir = join_path(opts.path, "blob");
     ensure_dir(opts.path);
     ensure_dir(wal_dir);
     ensure_dir(sst_dir);
 
-    tcache =
-        TableCache(opts.table_cache_capacity ? opts.table_cache_capacity : 64);
+    if (!sst_compression_supported(opts.sst_compression))
+      spdlog::warn("SST compression '{}' is not built in, blocks are written uncompressed",
+                   sst_compression_name(opts.sst_compression));
+    limiter.set_rate(opts.bg_rate_bytes_per_sec);
+    if (opts.latency_histograms)
+      lat = std::make_unique<OpLatency>();
+    if (opts.block_cache_bytes)
+      bcache = std::make_unique<BlockCache>(opts.block_cache_bytes);
+    tcache = std::make_unique<TableCache>(opts.table_cache_capacity ? opts.table_cache_capacity : 64,
+                                          bcache.get());
 
     // Создаём WAL по opts
-   wal = WalWriter(wal_dir,
-                opts.use_uring,
-                opts.uring_queue_depth,
-                opts.uring_sqpoll,
-                opts.uring_fixed_buffer_bytes,   // NEW
-                opts.uring_submit_batch,         // NEW
-                opts.wal_max_segment_bytes,
-                opts.wal_group_commit_bytes,
-                opts.flush_mode);
-
-    // Прочитать SST и вычислить next_sst_index
-    ssts.clear();
-    for (auto &name : list_sst_sorted(sst_dir)) {
-      ssts.push_back(join_path(sst_dir, name));
-      const uint64_t idx = std::stoull(name.substr(0, 6));
-      next_sst_index = std::max(next_sst_index, idx);
-    }
-    uint64_t cur = 0;
-    if (read_current(sst_dir, cur))
-      next_sst_index = std::max(next_sst_index, cur);
+    wal = make_wal();
 
-    // WAL replay
-    WalReader rd(wal_dir);
-    if (rd.good()) {
-      size_t replayed = 0;
-      while (auto it = rd.next()) {
-        if (it->flags == WAL_FLAG_PUT) {
-          mem[it->key] = it->value;
-          mem_bytes += it->key.size() + it->value.size();
-        } else if (it->flags == WAL_FLAG_DEL) {
-          mem[it->key] = std::nullopt;
-          mem_bytes += it->key.size();
-        }
-        seq.store(std::max<uint64_t>(seq.load(), it->seqno + 1));
-        ++replayed;
-      }
-      spdlog::info("Replayed {} WAL records", replayed);
-    }
+    // Прочитать состав дерева и вычислить next_sst_index
+    ::unlink(flush_tmp_path().c_str()); // недописанный flush
+    load_levels();
+    // seqno продолжается после самых новых записей в SST (WAL мог быть пуст)
+    for (const auto &lvl : levels)
+      for (const auto &f : lvl)
+        seq.store(std::max<uint64_t>(seq.load(), f.max_seq + 1));
+
+    replay_wal();
+    last_seq.store(seq.load() - 1);
 
+    bg_flusher = std::thread([this] { flusher_thread(); });
     if (opts.background_compaction) {
-      bg_compactor = std::thread([this] { compactor_thread(); });
+      for (unsigned i = 0; i < std::max(1u, opts.compaction_threads); ++i)
+        bg_compactors.emplace_back([this] { compactor_thread(); });
     }
+    startup_us = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+                                           std::chrono::steady_clock::now() - t_start)
+                                           .count());
   }
 
-  ~Impl() { stop_bg_if_any(); }
+  ~Impl() {
+    stop_bg_if_any();
+    stop_flusher();
+    mark_clean_shutdown();
+  }
 };
 
 // ===== KV API =====
@@ -366,8 +2262,9 @@ KV::~KV() {
   if (!p_)
     return;
 
-  // остановить фон
+  // остановить фон; flush-поток перед выходом сбрасывает imm
   p_->stop_bg_if_any();
+  p_->stop_flusher();
 
   // финальный flush под локом (опционально)
   {
@@ -377,9 +2274,11 @@ KV::~KV() {
     }
   }
 
-  // при выключенной фоновой компактации — один проход уже БЕЗ лока
+  // при выключенной фоновой компактации — проход уже БЕЗ лока
+  // (LEVELED — пока уровни не придут в норму)
   if (!p_->opts.background_compaction) {
-    (void)p_->compact_l0_once();
+    while (p_->compact_once() && p_->leveled()) {
+    }
   }
 
   delete p_;
@@ -396,111 +2295,581 @@ bool KV::init_storage_layout() {
 }
 
 bool KV::put(std::string_view key, std::string_view value) {
-  std::lock_guard lk(p_->mu);
-  const uint64_t s = p_->seq.fetch_add(1);
-  if (!p_->wal.append_put(s, key, value))
-    return false;
+  ScopedLatency t(p_->latency(&Impl::OpLatency::put));
+  return p_->write(WAL_FLAG_PUT, key, value);
+}
 
-  auto &slot = p_->mem[std::string(key)];
-  if (slot.has_value())
-    p_->mem_bytes -= slot->size();
-  slot = std::string(value);
-  p_->mem_bytes += key.size() + value.size();
+std::optional<std::string> KV::get(std::string_view key) { return get(key, ReadOptions{}); }
 
-  // метрики
-  p_->m_puts.fetch_add(1, std::memory_order_relaxed);
-  p_->m_wal_bytes.fetch_add(
-      Impl::wal_bytes_for_record(key.size(), value.size()),
-      std::memory_order_relaxed);
+std::optional<std::string> KV::get(std::string_view key, const ReadOptions &ro) {
+  ScopedLatency t(p_->latency(&Impl::OpLatency::get));
+  PinnableSlice v;
+  if (!p_->get(key, ro, v))
+    return std::nullopt;
+  return v.release();
+}
 
-  p_->maybe_flush_locked();
-  return true;
+bool KV::get(std::string_view key, PinnableSlice &value, const ReadOptions &ro) {
+  ScopedLatency t(p_->latency(&Impl::OpLatency::get));
+  return p_->get(key, ro, value);
 }
 
-std::optional<std::string> KV::get(std::string_view key) {
-  std::lock_guard lk(p_->mu);
-  p_->m_gets.fetch_add(1, std::memory_order_relaxed);
+std::vector<std::optional<std::string>> KV::multi_get(std::span<const std::string_view> keys,
+                                                      const ReadOptions &ro) {
+  using Found = std::optional<std::pair<uint32_t, std::string>>;
+  struct Probe {
+    std::shared_ptr<SstTable> tbl;
+    bool filtered;
+    uint64_t rdel; // накрывающий ключ range tombstone таблицы: она последняя, читается синхронно
+  };
+  struct Pending {
+    std::size_t slot = 0;
+    std::vector<Probe> probes; // от новых к старым, уже отфильтрованные bloom
+    std::size_t next = 0;
+    SstTable::PendingRead rd;
+    std::string buf;
+  };
+
+  std::vector<std::optional<std::string>> out(keys.size());
+  p_->m_gets.fetch_add(keys.size(), std::memory_order_relaxed);
+
+  // 1) MemTable и immutable — без I/O (до снимка или last_seq, как в get)
+  const uint64_t snap = ro.snapshot ? ro.snapshot->seqno() : UINT64_MAX;
+  const uint64_t mem_snap = ro.snapshot ? snap : p_->last_seq.load(std::memory_order_acquire);
+  const auto mem = std::atomic_load(&p_->mem);
+  const auto imm = std::atomic_load(&p_->imm);
+  std::vector<Pending> pend;
+  for (std::size_t i = 0; i < keys.size(); ++i) {
+    if (!Impl::memtables_get(mem.get(), imm.get(), keys[i], mem_snap, out[i]))
+      pend.emplace_back().slot = i;
+  }
 
-  auto it = p_->mem.find(std::string(key));
-  if (it != p_->mem.end()) {
-    if (!it->second.has_value()) {
-      p_->m_get_misses.fetch_add(1, std::memory_order_relaxed);
-      return std::nullopt;
+  // 2) Кандидаты по уровням версии, как в get(). Версия держит файлы на диске
+  // до конца чтения.
+  const auto ver = p_->current_version();
+  const std::shared_ptr<const Impl::BlobSet> blobs = ver->blobs->files.empty() ? nullptr : ver->blobs;
+  for (auto &pk : pend) {
+    const std::string_view key = keys[pk.slot];
+    const uint64_t h = sst_key_hash(key.data(), key.size());
+    bool covered = false; // дальше только версии старше range tombstone'а
+    auto add = [&](const SstFileMeta &f) {
+      if (covered || key < f.smallest || key > f.largest)
+        return;
+      auto tbl = p_->tcache->get_table(f.index, f.path);
+      if (!tbl)
+        return;
+      const uint64_t rdel = tbl->range_del_seq(key, snap);
+      const bool filtered = !rdel && tbl->has_filter();
+      if (filtered) {
+        p_->m_bloom_checks.fetch_add(1, std::memory_order_relaxed);
+        if (!tbl->may_contain(h)) {
+          p_->m_bloom_useful.fetch_add(1, std::memory_order_relaxed);
+          return;
+        }
+      }
+      covered = rdel != 0;
+      pk.probes.push_back({std::move(tbl), filtered, rdel});
+    };
+    const auto &l0 = ver->levels[0];
+    for (auto itf = l0.rbegin(); itf != l0.rend(); ++itf)
+      add(*itf);
+    for (std::size_t l = 1; l < ver->levels.size(); ++l) {
+      const auto &files = ver->levels[l];
+      auto itf = std::lower_bound(files.begin(), files.end(), key,
+                                  [](const SstFileMeta &f, std::string_view k) { return f.largest < k; });
+      if (itf != files.end())
+        add(*itf);
     }
-    p_->m_get_hits.fetch_add(1, std::memory_order_relaxed);
-    return it->second.value();
   }
 
-  for (auto itf = p_->ssts.rbegin(); itf != p_->ssts.rend(); ++itf) {
-    auto tbl = p_->tcache.get_table(*itf);
-    if (!tbl)
-      continue;
-    auto st = tbl->get(key);
-    if (!st)
-      continue;
-    if (st->first == SST_FLAG_DEL) {
-      p_->m_get_misses.fetch_add(1, std::memory_order_relaxed);
-      return std::nullopt;
+  // ответ текущей таблицы: найден (PUT/DEL/BLOB) — ключ решён, иначе к следующей.
+  // Значение из blob-файла дочитывается сразу (pread).
+  auto settle = [&](Pending &pk, Found st) {
+    if (pk.probes[pk.next].filtered)
+      (st ? p_->m_bloom_hits : p_->m_bloom_false_positives).fetch_add(1, std::memory_order_relaxed);
+    if (!st) {
+      ++pk.next;
+      return;
+    }
+    if (st->first == SST_FLAG_PUT) {
+      out[pk.slot] = std::move(st->second);
+    } else if (st->first == SST_FLAG_BLOB) {
+      std::string v;
+      if (Impl::read_blob(blobs, keys[pk.slot], st->second, v))
+        out[pk.slot] = std::move(v);
     }
-    p_->m_get_hits.fetch_add(1, std::memory_order_relaxed);
-    return st->second;
+    pk.next = pk.probes.size();
+  };
+
+  // 3) Раунды: все чтения раунда уходят одним пакетом, ответы разбираются по
+  // мере прихода CQE. Обычно (bloom, кэш блоков) хватает одного раунда.
+  auto ring = p_->acquire_ring();
+  std::vector<Pending *> active;
+  for (auto &pk : pend)
+    active.push_back(&pk);
+  std::vector<UringBackend::ReadOp> ops;
+  std::vector<Pending *> owners;
+  while (!active.empty()) {
+    ops.clear();
+    owners.clear();
+    for (Pending *pk : active) {
+      while (pk->next < pk->probes.size()) {
+        const auto &probe = pk->probes[pk->next];
+        const auto &tbl = probe.tbl;
+        Found st;
+        if (probe.rdel) {
+          uint64_t seq = 0;
+          st = tbl->get(keys[pk->slot], snap, &seq);
+          if (!st || probe.rdel > seq)
+            st.emplace(SST_FLAG_DEL, std::string{});
+          settle(*pk, std::move(st));
+          continue;
+        }
+        pk->rd = {.snapshot = snap};
+        if (!tbl->prepare_get(keys[pk->slot], pk->rd, st)) {
+          pk->buf.resize(pk->rd.size);
+          ops.push_back({tbl->fd(), pk->rd.offset, pk->rd.size, pk->buf.data(), 0});
+          owners.push_back(pk);
+          break;
+        }
+        settle(*pk, std::move(st));
+      }
+    }
+    if (ops.empty())
+      break;
+
+    auto on_done = [&](std::size_t i) {
+      Pending &pk = *owners[i];
+      const auto &tbl = pk.probes[pk.next].tbl;
+      const std::string_view key = keys[pk.slot];
+      // короткое чтение/ошибка — повторить обычным путём
+      settle(pk, ops[i].res == static_cast<int>(ops[i].len) ? tbl->finish_get(key, pk.rd, pk.buf)
+                                                            : tbl->get(key, snap));
+    };
+    if (ring) {
+      ring->read_batch(ops, on_done);
+    } else {
+      for (std::size_t i = 0; i < ops.size(); ++i) {
+        const ssize_t r = ::pread(ops[i].fd, ops[i].dst, ops[i].len, static_cast<off_t>(ops[i].off));
+        ops[i].res = r < 0 ? -errno : static_cast<int>(r);
+        on_done(i);
+      }
+    }
+
+    active.clear();
+    for (Pending *pk : owners)
+      if (pk->next < pk->probes.size())
+        active.push_back(pk);
   }
-  p_->m_get_misses.fetch_add(1, std::memory_order_relaxed);
-  return std::nullopt;
+  p_->release_ring(std::move(ring));
+
+  uint64_t hits = 0;
+  for (const auto &v : out)
+    hits += v.has_value();
+  p_->m_get_hits.fetch_add(hits, std::memory_order_relaxed);
+  p_->m_get_misses.fetch_add(keys.size() - hits, std::memory_order_relaxed);
+  return out;
 }
 
 bool KV::del(std::string_view key) {
-  std::lock_guard lk(p_->mu);
-  const uint64_t s = p_->seq.fetch_add(1);
-  if (!p_->wal.append_del(s, key))
-    return false;
+  ScopedLatency t(p_->latency(&Impl::OpLatency::del));
+  return p_->write(WAL_FLAG_DEL, key, std::string_view{});
+}
 
-  auto &slot = p_->mem[std::string(key)];
-  if (slot.has_value())
-    p_->mem_bytes -= slot->size();
-  slot = std::nullopt;
-  p_->mem_bytes += key.size();
+bool KV::delete_range(std::string_view start, std::string_view end) {
+  WriteBatch b;
+  b.delete_range(start, end);
+  return write(b); // проверки диапазона — там
+}
 
-  // метрики
-  p_->m_dels.fetch_add(1, std::memory_order_relaxed);
-  p_->m_wal_bytes.fetch_add(Impl::wal_bytes_for_record(key.size(), 0),
-                            std::memory_order_relaxed);
+bool KV::delete_prefix(std::string_view prefix) {
+  // ближайший ключ за всеми ключами с префиксом: отбросить хвост 0xFF и увеличить последний байт
+  std::string end(prefix);
+  while (!end.empty() && static_cast<unsigned char>(end.back()) == 0xFF)
+    end.pop_back();
+  if (end.empty()) {
+    spdlog::error("delete_prefix: prefix covers the whole key space");
+    return false;
+  }
+  end.back() = static_cast<char>(static_cast<unsigned char>(end.back()) + 1);
+  return delete_range(prefix, end);
+}
 
-  p_->maybe_flush_locked();
-  return true;
+bool KV::write(const WriteBatch &batch) {
+  if (batch.empty())
+    return true;
+  // пустой диапазон или SST v2 сорвали бы каждый flush — отказ до WAL
+  if (batch.range_deletes()) {
+    if (p_->opts.sst_format_version != kSstVersionV3) {
+      spdlog::error("delete_range: range tombstones need SST v3");
+      return false;
+    }
+    bool ok = true;
+    (void)WriteBatch::for_each(batch.data(), [&](uint32_t flags, std::string_view k, std::string_view v) {
+      if (ok && flags == WAL_FLAG_RANGE_DEL && !(k < v)) {
+        spdlog::error("delete_range: empty range [{}, {})", k, v);
+        ok = false;
+      }
+    });
+    if (!ok)
+      return false;
+  }
+  Impl::Writer w;
+  w.batch = &batch;
+  return p_->write(w);
 }
 
-std::vector<RangeItem> KV::scan(std::string_view start, std::string_view end) {
-  std::lock_guard lk(p_->mu);
+// -------- Iterator --------
+
+// Источник слияния: одна MemTable (только версии со seqno <= снимка) либо
+// цепочка SST — один файл L0 или непересекающиеся файлы уровня L1+ по порядку.
+// На каждый ключ источник отдаёт одну запись, tombstone'ы включительно.
+// Таблицы цепочки берутся из TableCache по мере прохода (блоки — через
+// BlockCache); метаданные файлов держит версия итератора.
+struct MergeSource {
+  std::shared_ptr<MemTable> mem;
+  std::unique_ptr<MemTable::Iterator> mit;
+  uint64_t snapshot = 0;
+
+  TableCache *tcache = nullptr;
+  std::vector<const SstFileMeta *> files;
+  std::size_t file = 0;
+  std::shared_ptr<SstTable> tbl; // таблица текущего файла (живёт дольше sit)
+  std::unique_ptr<SstTable::Iterator> sit;
+  std::string cur; // текущий ключ SST-цепочки (для пропуска старых версий)
+
+  bool valid() const { return mit ? mit->valid() : (sit && sit->valid()); }
+  std::string_view key() const { return mit ? mit->key() : sit->key(); }
+  std::string_view value() const { return mit ? mit->value() : sit->value(); }
+  bool deleted() const { return mit ? mit->flags() == WAL_FLAG_DEL : sit->flags() == SST_FLAG_DEL; }
+  // 0 — запись старого формата без seqno
+  uint64_t seqno() const { return mit ? mit->seqno() : sit->seqno(); }
+  // value() — ссылка на blob-файл
+  bool blob() const { return !mit && sit->flags() == SST_FLAG_BLOB; }
+
+  void seek_to_first() {
+    if (mit) {
+      mit->seek_to_first();
+      skip_invisible();
+      return;
+    }
+    open_file(0);
+    if (sit)
+      sit->seek_to_first();
+    skip_empty_files();
+    skip_invisible_sst();
+  }
+
+  void seek(std::string_view target) {
+    if (mit) {
+      mit->seek(target);
+      skip_invisible();
+      return;
+    }
+    // первый файл, который может содержать ключ >= target
+    auto it = std::lower_bound(files.begin(), files.end(), target,
+                               [](const SstFileMeta *f, std::string_view t) { return f->largest < t; });
+    open_file(static_cast<std::size_t>(it - files.begin()));
+    if (sit)
+      sit->seek(target);
+    skip_empty_files();
+    skip_invisible_sst();
+  }
 
-  std::unordered_map<std::string, std::optional<std::string>> view;
-  for (auto &[k, v] : p_->mem)
-    view[k] = v;
+  void next() {
+    if (mit) {
+      mit->next_key();
+      skip_invisible();
+      return;
+    }
+    // остальные версии текущего ключа (в пределах одного файла)
+    cur.assign(sit->key());
+    do {
+      sit->next();
+      skip_empty_files();
+    } while (sit && sit->key() == cur);
+    skip_invisible_sst();
+  }
 
-  for (auto itf = p_->ssts.rbegin(); itf != p_->ssts.rend(); ++itf) {
-    SstReader r(*itf);
-    if (!r.good())
-      continue;
-    auto items = r.scan(start, end);
-    for (auto &kv : items) {
-      if (view.find(kv.first) == view.end())
-        view[kv.first] = kv.second;
+private:
+  // версии одного ключа идут от новых к старым: первая с seqno <= снимка — видимая
+  void skip_invisible() {
+    while (mit->valid() && mit->seqno() > snapshot)
+      mit->next();
+  }
+  // записи без seqno (старые форматы) видны любому снимку
+  void skip_invisible_sst() {
+    while (sit && sit->seqno() > snapshot) {
+      sit->next();
+      skip_empty_files();
     }
   }
+  // файл i, а если он не открылся — следующий
+  void open_file(std::size_t i) {
+    sit.reset();
+    tbl.reset();
+    for (file = i; file < files.size(); ++file) {
+      if ((tbl = tcache->get_table(files[file]->index, files[file]->path))) {
+        sit = std::make_unique<SstTable::Iterator>(tbl.get());
+        return;
+      }
+    }
+  }
+  void skip_empty_files() {
+    while (sit && !sit->valid()) {
+      open_file(file + 1);
+      if (sit)
+        sit->seek_to_first();
+    }
+  }
+};
 
-  std::vector<RangeItem> out;
-  out.reserve(view.size());
-  for (auto &[k, v] : view) {
-    if ((!start.empty() && k < start) || (!end.empty() && k > end))
+struct KV::Iterator::Impl {
+  IteratorOptions opts;
+  std::vector<MergeSource> sources; // от новых к старым
+  std::shared_ptr<const KV::Impl::Version> version; // держит файлы SST и blob на диске
+  std::shared_ptr<const KV::Impl::BlobSet> blobs;
+  std::vector<RangeTombstone> rdels; // видимые снимку range tombstone'ы всех источников, по start
+  std::vector<std::size_t> heap;    // min-heap по (key, номер источника)
+  std::string key, value;
+  bool valid = false;
+  std::size_t returned = 0;
+
+  bool heap_less(std::size_t a, std::size_t b) const {
+    const auto ka = sources[a].key(), kb = sources[b].key();
+    return ka != kb ? ka > kb : a > b; // для std::*_heap: "меньше" = ниже в куче
+  }
+  void push(std::size_t i) {
+    if (!sources[i].valid())
+      return;
+    heap.push_back(i);
+    std::push_heap(heap.begin(), heap.end(), [this](std::size_t a, std::size_t b) { return heap_less(a, b); });
+  }
+  std::size_t pop() {
+    std::pop_heap(heap.begin(), heap.end(), [this](std::size_t a, std::size_t b) { return heap_less(a, b); });
+    const std::size_t i = heap.back();
+    heap.pop_back();
+    return i;
+  }
+
+  void rebuild() {
+    heap.clear();
+    for (std::size_t i = 0; i < sources.size(); ++i)
+      push(i);
+    returned = 0;
+    find_next();
+  }
+
+  // Верх кучи — самый новый вариант наименьшего ключа. Снимаем все его
+  // варианты; tombstone, более новый range tombstone (и непрочитанная
+  // blob-ссылка) пропускают ключ целиком.
+  void find_next() {
+    valid = false;
+    while (!heap.empty()) {
+      const std::size_t top = heap.front();
+      const std::string_view k = sources[top].key();
+      if (!opts.end.empty() && k > opts.end)
+        return;
+      if (!opts.prefix.empty() && !k.starts_with(opts.prefix))
+        return;
+      bool deleted = sources[top].deleted();
+      key.assign(k);
+      if (!deleted && !rdels.empty())
+        deleted = range_del_covering_seq(rdels, key) > sources[top].seqno();
+      if (!deleted && sources[top].blob())
+        deleted = !KV::Impl::read_blob(blobs, key, sources[top].value(), value);
+      else if (!deleted)
+        value.assign(sources[top].value());
+      while (!heap.empty() && sources[heap.front()].key() == key) {
+        const std::size_t i = pop();
+        sources[i].next();
+        push(i);
+      }
+      if (!deleted) {
+        valid = !opts.limit || returned < opts.limit;
+        return;
+      }
+    }
+  }
+};
+
+KV::Iterator::Iterator(KV *kv, IteratorOptions opts) : p_(new Impl{}) {
+  p_->opts = std::move(opts);
+  auto *db = kv->p_;
+
+  // снимок: seqno, затем MemTable'ы, затем версия — данные, уже ушедшие из
+  // MemTable к моменту её взятия, лежат в SST
+  const uint64_t snapshot = p_->opts.snapshot ? p_->opts.snapshot->seqno()
+                                              : db->last_seq.load(std::memory_order_acquire);
+  for (auto mt : {std::atomic_load(&db->mem), std::atomic_load(&db->imm)}) {
+    if (!mt)
       continue;
-    if (v.has_value())
-      out.push_back({k, *v});
+    mt->range_tombstones(p_->rdels, snapshot);
+    auto &src = p_->sources.emplace_back();
+    src.mit = std::make_unique<MemTable::Iterator>(mt.get());
+    src.mem = std::move(mt);
+    src.snapshot = snapshot;
   }
-  std::sort(out.begin(), out.end(),
-            [](const auto &a, const auto &b) { return a.key < b.key; });
+
+  const auto &o = p_->opts;
+  auto in_range = [&](const SstFileMeta &f) {
+    if (!o.end.empty() && f.smallest > o.end)
+      return false;
+    if (!o.prefix.empty() && f.largest < o.prefix)
+      return false;
+    return true;
+  };
+  // Открываются только таблицы с range tombstone'ами (они нужны до первого seek),
+  // остальные — при проходе источника
+  auto add_file = [this, db, snapshot](MergeSource &src, const SstFileMeta &f) {
+    src.snapshot = snapshot;
+    src.tcache = db->tcache.get();
+    if (f.range_dels) {
+      if (auto tbl = db->tcache->get_table(f.index, f.path))
+        for (const auto &t : tbl->range_tombstones())
+          if (t.seqno <= snapshot)
+            p_->rdels.push_back(t);
+    }
+    src.files.push_back(&f);
+  };
+
+  p_->version = db->current_version();
+  p_->blobs = p_->version->blobs;
+  const auto &levels = p_->version->levels;
+  const auto &l0 = levels[0];
+  for (auto itf = l0.rbegin(); itf != l0.rend(); ++itf) {
+    if (!in_range(*itf))
+      continue;
+    MergeSource src;
+    add_file(src, *itf);
+    if (!src.files.empty())
+      p_->sources.push_back(std::move(src));
+  }
+  for (std::size_t l = 1; l < levels.size(); ++l) {
+    MergeSource src;
+    for (const auto &f : levels[l])
+      if (in_range(f))
+        add_file(src, f);
+    if (!src.files.empty())
+      p_->sources.push_back(std::move(src));
+  }
+  std::sort(p_->rdels.begin(), p_->rdels.end(),
+            [](const RangeTombstone &a, const RangeTombstone &b) { return a.start < b.start; });
+}
+
+KV::Iterator::~Iterator() { delete p_; }
+
+void KV::Iterator::seek_to_first() {
+  if (!p_->opts.prefix.empty()) {
+    seek(p_->opts.prefix);
+    return;
+  }
+  for (auto &s : p_->sources)
+    s.seek_to_first();
+  p_->rebuild();
+}
+
+void KV::Iterator::seek(std::string_view target) {
+  const std::string_view t = std::max(target, std::string_view(p_->opts.prefix));
+  for (auto &s : p_->sources)
+    s.seek(t);
+  p_->rebuild();
+}
+
+void KV::Iterator::next() {
+  if (!p_->valid)
+    return;
+  ++p_->returned;
+  p_->find_next();
+}
+
+bool KV::Iterator::valid() const { return p_->valid; }
+std::string_view KV::Iterator::key() const { return p_->key; }
+std::string_view KV::Iterator::value() const { return p_->value; }
+
+std::vector<RangeItem> KV::scan(std::string_view start, std::string_view end, const ReadOptions &ro) {
+  ScopedLatency t(p_->latency(&Impl::OpLatency::scan));
+  Iterator it(this, IteratorOptions{.end = std::string(end), .snapshot = ro.snapshot});
+  if (start.empty())
+    it.seek_to_first();
+  else
+    it.seek(start);
+
+  std::vector<RangeItem> out;
+  for (; it.valid(); it.next())
+    out.push_back({std::string(it.key()), std::string(it.value())});
+  return out;
+}
+
+// -------- Снимки --------
+
+std::shared_ptr<const Snapshot> KV::snapshot() {
+  std::lock_guard lk(p_->snap_mu);
+  const uint64_t seq = p_->last_seq.load(std::memory_order_acquire);
+  p_->snapshots.insert(seq);
+  return std::shared_ptr<const Snapshot>(new Snapshot(this, seq));
+}
+
+void KV::release_snapshot(uint64_t seqno) {
+  std::lock_guard lk(p_->snap_mu);
+  auto it = p_->snapshots.find(seqno);
+  if (it != p_->snapshots.end())
+    p_->snapshots.erase(it);
+}
+
+Snapshot::~Snapshot() { kv_->release_snapshot(seqno_); }
+
+// -------- PinnableSlice --------
+
+PinnableSlice &PinnableSlice::operator=(PinnableSlice &&o) noexcept {
+  if (this == &o)
+    return *this;
+  pin_ = std::move(o.pin_);
+  buf_ = std::move(o.buf_);
+  off_ = o.off_;
+  // у своего буфера адрес мог смениться (SSO) — вид строится заново
+  data_ = pin_ ? o.data_ : std::string_view(buf_).substr(off_, o.data_.size());
+  o.reset();
+  return *this;
+}
+
+void PinnableSlice::reset() {
+  data_ = {};
+  buf_.clear();
+  pin_.reset();
+  off_ = 0;
+}
+
+void PinnableSlice::pin(std::string_view v, std::shared_ptr<const void> pin) {
+  buf_.clear();
+  off_ = 0;
+  pin_ = std::move(pin);
+  data_ = v;
+}
+
+void PinnableSlice::own(std::string &&buf, std::size_t off, std::size_t len) {
+  pin_.reset();
+  buf_ = std::move(buf);
+  off_ = off;
+  data_ = std::string_view(buf_).substr(off, len);
+}
+
+std::string PinnableSlice::release() {
+  std::string out = !pin_ && off_ == 0 && data_.size() == buf_.size() ? std::move(buf_) : std::string(data_);
+  reset();
   return out;
 }
 
+// -------- Blob GC --------
+
+bool KV::gc_blobs(double min_garbage_ratio) {
+  const double ratio = min_garbage_ratio < 0 ? p_->opts.blob_gc_garbage_ratio : min_garbage_ratio;
+  bool any = false;
+  while (p_->blob_gc_once(ratio))
+    any = true;
+  return any;
+}
+
 // -------- Метрики: API --------
 
 KVMetrics KV::get_metrics() const {
@@ -509,18 +2878,94 @@ KVMetrics KV::get_metrics() const {
   m.puts = p_->m_puts.load(std::memory_order_relaxed);
   m.gets = p_->m_gets.load(std::memory_order_relaxed);
   m.dels = p_->m_dels.load(std::memory_order_relaxed);
+  m.range_deletes = p_->m_range_deletes.load(std::memory_order_relaxed);
+  m.range_del_dropped_keys = p_->m_range_del_keys.load(std::memory_order_relaxed);
+  m.range_del_dropped_files = p_->m_range_del_files.load(std::memory_order_relaxed);
   m.get_hits = p_->m_get_hits.load(std::memory_order_relaxed);
   m.get_misses = p_->m_get_misses.load(std::memory_order_relaxed);
   m.wal_bytes = p_->m_wal_bytes.load(std::memory_order_relaxed);
+  m.wal_syncs = p_->m_wal_syncs.load(std::memory_order_relaxed);
+  m.wal_batches = p_->m_wal_batches.load(std::memory_order_relaxed);
   m.sst_flushes = p_->m_sst_flushes.load(std::memory_order_relaxed);
   m.compactions = p_->m_compactions.load(std::memory_order_relaxed);
+  m.subcompactions = p_->m_subcompactions.load(std::memory_order_relaxed);
+  m.compactions_running = p_->running.size();
+  m.compaction_parallel_peak = p_->m_compaction_peak.load(std::memory_order_relaxed);
+  m.bloom_checks = p_->m_bloom_checks.load(std::memory_order_relaxed);
+  m.bloom_useful = p_->m_bloom_useful.load(std::memory_order_relaxed);
+  m.bloom_hits = p_->m_bloom_hits.load(std::memory_order_relaxed);
+  m.bloom_false_positives = p_->m_bloom_false_positives.load(std::memory_order_relaxed);
+  m.blob_files = p_->blob_meta.size();
+  for (const auto &[idx, b] : p_->blob_meta) {
+    m.blob_bytes += b.bytes;
+    m.blob_garbage_bytes += b.garbage;
+  }
+  m.blob_bytes_written = p_->m_blob_bytes_written.load(std::memory_order_relaxed);
+  m.blob_gc_runs = p_->m_blob_gc_runs.load(std::memory_order_relaxed);
+  m.blob_gc_relocated_bytes = p_->m_blob_gc_relocated.load(std::memory_order_relaxed);
+  m.blob_files_deleted = p_->m_blob_files_deleted.load(std::memory_order_relaxed);
+  m.sst_block_raw_bytes = p_->m_sst_raw_bytes.load(std::memory_order_relaxed);
+  m.sst_block_stored_bytes = p_->m_sst_stored_bytes.load(std::memory_order_relaxed);
+  m.pending_compaction_bytes = p_->pending_compaction.load(std::memory_order_relaxed);
+  m.bg_rate_limit = p_->limiter.rate();
+  m.bg_flush_bytes = p_->limiter.bytes_through(RateLimiter::Priority::HIGH);
+  m.bg_compaction_bytes = p_->limiter.bytes_through(RateLimiter::Priority::LOW);
+  m.bg_flush_wait_us = p_->limiter.wait_us(RateLimiter::Priority::HIGH);
+  m.bg_compaction_wait_us = p_->limiter.wait_us(RateLimiter::Priority::LOW);
+  m.write_slowdowns = p_->m_write_slowdowns.load(std::memory_order_relaxed);
+  m.write_stalls = p_->m_write_stalls.load(std::memory_order_relaxed);
+  m.write_stall_us = p_->m_write_stall_us.load(std::memory_order_relaxed);
+  const auto &cs = sst_codec_stats();
+  m.sst_blocks_decompressed = cs.blocks_decompressed.load(std::memory_order_relaxed);
+  m.sst_decompressed_bytes = cs.bytes_decompressed.load(std::memory_order_relaxed);
+  m.sst_decompress_ns = cs.decompress_ns.load(std::memory_order_relaxed);
+
+  m.table_cache_hits = p_->tcache->hits();
+  m.table_cache_misses = p_->tcache->misses();
+  m.table_cache_opens = p_->tcache->opens();
+  m.table_cache_evictions = p_->tcache->evictions();
+  m.table_cache_open_us = p_->tcache->open_us();
+  m.table_cache_open_max_us = p_->tcache->open_max_us();
+  m.table_cache_files = p_->tcache->size();
+  m.table_cache_pinned_bytes = p_->tcache->pinned_bytes();
+  if (p_->bcache) {
+    m.block_cache_hits = p_->bcache->hits();
+    m.block_cache_misses = p_->bcache->misses();
+    m.block_cache_evictions = p_->bcache->evictions();
+    m.block_cache_usage = p_->bcache->usage();
+  }
 
-  m.table_cache_hits = p_->tcache.hits();
-  m.table_cache_misses = p_->tcache.misses();
-  m.table_cache_opens = p_->tcache.opens();
-
-  m.mem_bytes = p_->mem_bytes;
-  m.sst_count = static_cast<uint64_t>(p_->ssts.size());
+  m.mem_bytes = p_->mem->data_bytes() + (p_->imm ? p_->imm->data_bytes() : 0);
+  m.sst_count = p_->sst_count_locked();
+  m.live_versions = p_->m_versions_live.load(std::memory_order_relaxed);
+  m.sst_files_deleted = p_->m_sst_files_deleted.load(std::memory_order_relaxed);
+  m.manifest_bytes = p_->manifest ? p_->manifest->bytes() : 0;
+  m.manifest_edits = p_->manifest ? p_->manifest->edits() : 0;
+  m.manifest_rewrites = p_->m_manifest_rewrites.load(std::memory_order_relaxed);
+  m.startup_us = p_->startup_us;
+  m.wal_replay_us = p_->replay_us;
+  m.wal_replay_records = p_->replay_records;
+  m.wal_replay_bytes = p_->replay_bytes;
+  if (const auto *l = p_->lat.get()) {
+    auto stats = [](const LatencyHistogram &h) {
+      LatencyStats s;
+      s.count = h.count();
+      s.sum_ns = h.sum();
+      s.p50_ns = h.percentile(50.0);
+      s.p90_ns = h.percentile(90.0);
+      s.p99_ns = h.percentile(99.0);
+      s.p999_ns = h.percentile(99.9);
+      s.max_ns = h.max();
+      return s;
+    };
+    m.put_latency = stats(l->put);
+    m.get_latency = stats(l->get);
+    m.del_latency = stats(l->del);
+    m.scan_latency = stats(l->scan);
+    m.flush_latency = stats(l->flush);
+    m.compaction_latency = stats(l->compaction);
+    m.wal_sync_latency = stats(l->wal_sync);
+  }
   return m;
 }
 
@@ -529,13 +2974,43 @@ void KV::reset_metrics(bool reset_cache_stats) {
   p_->m_puts.store(0, std::memory_order_relaxed);
   p_->m_gets.store(0, std::memory_order_relaxed);
   p_->m_dels.store(0, std::memory_order_relaxed);
+  p_->m_range_deletes.store(0, std::memory_order_relaxed);
+  p_->m_range_del_keys.store(0, std::memory_order_relaxed);
+  p_->m_range_del_files.store(0, std::memory_order_relaxed);
   p_->m_get_hits.store(0, std::memory_order_relaxed);
   p_->m_get_misses.store(0, std::memory_order_relaxed);
   p_->m_wal_bytes.store(0, std::memory_order_relaxed);
+  p_->m_wal_syncs.store(0, std::memory_order_relaxed);
+  p_->m_wal_batches.store(0, std::memory_order_relaxed);
   p_->m_sst_flushes.store(0, std::memory_order_relaxed);
   p_->m_compactions.store(0, std::memory_order_relaxed);
-  if (reset_cache_stats)
-    p_->tcache.reset_stats();
+  p_->m_subcompactions.store(0, std::memory_order_relaxed);
+  p_->m_sst_files_deleted.store(0, std::memory_order_relaxed);
+  p_->m_manifest_rewrites.store(0, std::memory_order_relaxed);
+  p_->m_compaction_peak.store(0, std::memory_order_relaxed);
+  p_->m_bloom_checks.store(0, std::memory_order_relaxed);
+  p_->m_bloom_useful.store(0, std::memory_order_relaxed);
+  p_->m_bloom_hits.store(0, std::memory_order_relaxed);
+  p_->m_bloom_false_positives.store(0, std::memory_order_relaxed);
+  p_->m_blob_bytes_written.store(0, std::memory_order_relaxed);
+  p_->m_blob_gc_runs.store(0, std::memory_order_relaxed);
+  p_->m_blob_gc_relocated.store(0, std::memory_order_relaxed);
+  p_->m_blob_files_deleted.store(0, std::memory_order_relaxed);
+  p_->m_sst_raw_bytes.store(0, std::memory_order_relaxed);
+  p_->m_sst_stored_bytes.store(0, std::memory_order_relaxed);
+  p_->m_write_slowdowns.store(0, std::memory_order_relaxed);
+  p_->m_write_stalls.store(0, std::memory_order_relaxed);
+  p_->m_write_stall_us.store(0, std::memory_order_relaxed);
+  p_->limiter.reset_stats();
+  if (auto *l = p_->lat.get())
+    for (auto *h : {&l->put, &l->get, &l->del, &l->scan, &l->flush, &l->compaction, &l->wal_sync})
+      h->reset();
+  if (reset_cache_stats) {
+    p_->tcache->reset_stats();
+    if (p_->bcache)
+      p_->bcache->reset_stats();
+    sst_codec_stats().reset();
+  }
 }
 
 } // namespace uringkv
@@ -0,0 +1,50 @@
+// source/memtable/arena.cpp
+#include "memtable/arena.hpp"
+
+#include <cstdint>
+
+namespace uringkv {
+
+Arena::~Arena() {
+  for (char* b : blocks_) delete[] b;
+}
+
+char* Arena::allocate_fallback(std::size_t bytes) {
+  if (bytes > BLOCK_SIZE / 4) {
+    // крупный объект — отдельным блоком, текущий не трогаем
+    return allocate_new_block(bytes);
+  }
+  ptr_ = allocate_new_block(BLOCK_SIZE);
+  remaining_ = BLOCK_SIZE;
+
+  char* r = ptr_;
+  ptr_ += bytes;
+  remaining_ -= bytes;
+  return r;
+}
+
+char* Arena::allocate_aligned(std::size_t bytes) {
+  constexpr std::size_t align = alignof(void*);
+  static_assert((align & (align - 1)) == 0, "alignment must be a power of 2");
+
+  const std::size_t mod = reinterpret_cast<std::uintptr_t>(ptr_) & (align - 1);
+  const std::size_t slop = mod ? align - mod : 0;
+  const std::size_t needed = bytes + slop;
+  if (needed <= remaining_) {
+    char* r = ptr_ + slop;
+    ptr_ += needed;
+    remaining_ -= needed;
+    return r;
+  }
+  // new[] возвращает память, выровненную как минимум под void*
+  return allocate_fallback(bytes);
+}
+
+char* Arena::allocate_new_block(std::size_t bytes) {
+  char* b = new char[bytes];
+  blocks_.push_back(b);
+  usage_.fetch_add(bytes + sizeof(char*), std::memory_order_relaxed);
+  return b;
+}
+
+} // namespace uringkv
@@ -0,0 +1,172 @@
+// source/memtable/memtable.cpp
+#include "memtable/memtable.hpp"
+#include "util.hpp"
+#include "wal/record.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace uringkv {
+
+// Разбор записи: ключ и указатель на tag сразу за ним.
+// Записи кладёт только add(), поэтому границы не проверяются.
+static inline std::string_view entry_key(const char* p, const char** tag) {
+  uint32_t klen = 0;
+  p = get_varint32(p, p + 5, klen);
+  *tag = p + klen;
+  return std::string_view(p, klen);
+}
+
+static inline uint64_t load_tag(const char* p) {
+  uint64_t t = 0;
+  std::memcpy(&t, p, sizeof(t));
+  return t;
+}
+
+int MemTable::KeyCmp::operator()(const char* a, const char* b) const {
+  const char *ta = nullptr, *tb = nullptr;
+  const std::string_view ka = entry_key(a, &ta);
+  const std::string_view kb = entry_key(b, &tb);
+  if (int r = ka.compare(kb)) return r;
+  // тот же ключ: новее (больший seqno) — раньше
+  const uint64_t sa = load_tag(ta) >> 8, sb = load_tag(tb) >> 8;
+  if (sa > sb) return -1;
+  if (sa < sb) return 1;
+  return 0;
+}
+
+int MemTable::KeyCmp::operator()(const char* a, const LookupKey& b) const {
+  const char* ta = nullptr;
+  if (int r = entry_key(a, &ta).compare(b.key)) return r;
+  const uint64_t sa = load_tag(ta) >> 8;
+  if (sa > b.seq) return -1;
+  if (sa < b.seq) return 1;
+  return 0;
+}
+
+// seqno снимка => первая версия ключа с seqno <= snapshot (seqno в tag — 56 бит,
+// snapshot = UINT64_MAX — самая новая)
+static MemTable::LookupKey lookup_key(std::string_view key, uint64_t snapshot) {
+  return MemTable::LookupKey{key, std::min<uint64_t>(snapshot, ~0ull >> 8)};
+}
+
+MemTable::MemTable() : table_(KeyCmp{}, &arena_), range_dels_(KeyCmp{}, &arena_) {}
+
+static inline std::size_t varint32_len(uint32_t v) {
+  std::size_t n = 1;
+  while (v >= 0x80) { v >>= 7; ++n; }
+  return n;
+}
+
+static inline char* encode_varint32(char* p, uint32_t v) {
+  while (v >= 0x80) {
+    *p++ = static_cast<char>(v | 0x80);
+    v >>= 7;
+  }
+  *p++ = static_cast<char>(v);
+  return p;
+}
+
+void MemTable::add(uint64_t seqno, uint32_t flags, std::string_view key, std::string_view value) {
+  const uint32_t klen = static_cast<uint32_t>(key.size());
+  const uint32_t vlen = static_cast<uint32_t>(value.size());
+  const uint64_t tag = (seqno << 8) | (flags & 0xFFu);
+
+  // запись выделяется одним куском
+  const std::size_t total =
+      varint32_len(klen) + klen + sizeof(tag) + varint32_len(vlen) + vlen;
+  char* buf = arena_.allocate(total);
+  char* p = encode_varint32(buf, klen);
+  if (klen) std::memcpy(p, key.data(), klen);
+  p += klen;
+  std::memcpy(p, &tag, sizeof(tag));
+  p += sizeof(tag);
+  p = encode_varint32(p, vlen);
+  if (vlen) std::memcpy(p, value.data(), vlen);
+
+  if (flags == WAL_FLAG_RANGE_DEL) {
+    range_dels_.insert(buf);
+    range_dels_count_.fetch_add(1, std::memory_order_release);
+  } else {
+    table_.insert(buf);
+  }
+  data_bytes_.fetch_add(key.size() + value.size(), std::memory_order_relaxed);
+  entries_.fetch_add(1, std::memory_order_release);
+}
+
+bool MemTable::get(std::string_view key, std::optional<std::string>& value, uint64_t snapshot,
+                   uint64_t* seqno) const {
+  std::optional<std::string_view> v;
+  if (!get(key, v, snapshot, seqno)) return false;
+  if (v) value.emplace(*v);
+  else value.reset();
+  return true;
+}
+
+bool MemTable::get(std::string_view key, std::optional<std::string_view>& value, uint64_t snapshot,
+                   uint64_t* seqno) const {
+  Iterator it(this);
+  it.seek(key, snapshot);
+  if (!it.valid() || it.key() != key) return false;
+  if (it.flags() == WAL_FLAG_DEL) value.reset();
+  else value.emplace(it.value());
+  if (seqno) *seqno = it.seqno();
+  return true;
+}
+
+// Range tombstone'ов обычно единицы — линейный проход до первого start > key
+uint64_t MemTable::range_del_seq(std::string_view key, uint64_t snapshot) const {
+  if (range_dels() == 0) return 0;
+  uint64_t best = 0;
+  Table::Iterator it(&range_dels_);
+  for (it.seek_to_first(); it.valid(); it.next()) {
+    const char* tag = nullptr;
+    const std::string_view start = entry_key(it.key(), &tag);
+    if (start > key) break;
+    const uint64_t seq = load_tag(tag) >> 8;
+    if (seq > snapshot || seq <= best) continue;
+    uint32_t elen = 0;
+    const char* e = get_varint32(tag + sizeof(uint64_t), tag + sizeof(uint64_t) + 5, elen);
+    if (key < std::string_view(e, elen)) best = seq;
+  }
+  return best;
+}
+
+void MemTable::range_tombstones(std::vector<RangeTombstone>& out, uint64_t snapshot) const {
+  if (range_dels() == 0) return;
+  Table::Iterator it(&range_dels_);
+  for (it.seek_to_first(); it.valid(); it.next()) {
+    const char* tag = nullptr;
+    const std::string_view start = entry_key(it.key(), &tag);
+    const uint64_t seq = load_tag(tag) >> 8;
+    if (seq > snapshot) continue;
+    uint32_t elen = 0;
+    const char* e = get_varint32(tag + sizeof(uint64_t), tag + sizeof(uint64_t) + 5, elen);
+    out.push_back(RangeTombstone{std::string(start), std::string(e, elen), seq});
+  }
+}
+
+void MemTable::Iterator::seek(std::string_view target, uint64_t snapshot) {
+  it_.seek(lookup_key(target, snapshot));
+  decode();
+}
+
+void MemTable::Iterator::next_key() {
+  const std::string_view cur = key_;
+  do {
+    it_.next();
+    decode();
+  } while (it_.valid() && key_ == cur); // key_ указывает в арену — остаётся валидным
+}
+
+void MemTable::Iterator::decode() {
+  if (!it_.valid()) { key_ = value_ = {}; tag_ = 0; return; }
+  const char* tag = nullptr;
+  key_ = entry_key(it_.key(), &tag);
+  tag_ = load_tag(tag);
+  uint32_t vlen = 0;
+  const char* v = get_varint32(tag + sizeof(uint64_t), tag + sizeof(uint64_t) + 5, vlen);
+  value_ = std::string_view(v, vlen);
+}
+
+} // namespace uringkv
@@ -0,0 +1,61 @@
+#include "perf_context.hpp"
+
+#include <fmt/format.h>
+
+#include <iterator>
+
+namespace uringkv {
+
+namespace {
+
+struct PerfField {
+  const char* name;
+  uint64_t PerfContext::*field;
+};
+
+constexpr PerfField kPerfFields[] = {
+    {"get_memtable_ns", &PerfContext::get_memtable_ns},
+    {"get_table_cache_ns", &PerfContext::get_table_cache_ns},
+    {"get_filter_ns", &PerfContext::get_filter_ns},
+    {"index_probe_ns", &PerfContext::index_probe_ns},
+    {"block_read_ns", &PerfContext::block_read_ns},
+    {"record_read_ns", &PerfContext::record_read_ns},
+    {"blob_read_ns", &PerfContext::blob_read_ns},
+    {"table_open_ns", &PerfContext::table_open_ns},
+    {"block_checksum_ns", &PerfContext::block_checksum_ns},
+    {"block_decompress_ns", &PerfContext::block_decompress_ns},
+    {"write_delay_ns", &PerfContext::write_delay_ns},
+    {"write_wal_ns", &PerfContext::write_wal_ns},
+    {"write_memtable_ns", &PerfContext::write_memtable_ns},
+    {"get_memtable_hits", &PerfContext::get_memtable_hits},
+    {"get_tables_probed", &PerfContext::get_tables_probed},
+    {"table_open_count", &PerfContext::table_open_count},
+    {"bloom_useful_count", &PerfContext::bloom_useful_count},
+    {"block_cache_hit_count", &PerfContext::block_cache_hit_count},
+    {"block_read_count", &PerfContext::block_read_count},
+    {"block_read_bytes", &PerfContext::block_read_bytes},
+    {"blob_read_count", &PerfContext::blob_read_count},
+};
+
+// новое поле без строки в таблице не попадёт ни в +=, ни в to_string
+static_assert(std::size(kPerfFields) * sizeof(uint64_t) == sizeof(PerfContext));
+
+} // namespace
+
+PerfContext& PerfContext::operator+=(const PerfContext& o) {
+  for (const auto& f : kPerfFields) this->*f.field += o.*f.field;
+  return *this;
+}
+
+std::string PerfContext::to_string(bool exclude_zero) const {
+  std::string out;
+  for (const auto& f : kPerfFields) {
+    const uint64_t v = this->*f.field;
+    if (exclude_zero && v == 0) continue;
+    if (!out.empty()) out.push_back(' ');
+    fmt::format_to(std::back_inserter(out), "{}={}", f.name, v);
+  }
+  return out;
+}
+
+} // namespace uringkv
@@ -0,0 +1,95 @@
+#include "rate_limiter.hpp"
+
+#include <algorithm>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace uringkv {
+
+RateLimiter::RateLimiter(uint64_t bytes_per_sec, std::chrono::microseconds refill_period)
+    : rate_(bytes_per_sec), period_(std::max(refill_period, std::chrono::microseconds(1000))),
+      last_refill_(std::chrono::steady_clock::now()) {
+  tokens_ = static_cast<double>(burst_locked());
+}
+
+uint64_t RateLimiter::burst_locked() const {
+  const double b = double(rate_.load(std::memory_order_relaxed)) * double(period_.count()) / 1e6;
+  return std::max<uint64_t>(1, static_cast<uint64_t>(b));
+}
+
+void RateLimiter::refill_locked(std::chrono::steady_clock::time_point now) {
+  const double us = double(std::chrono::duration_cast<std::chrono::microseconds>(now - last_refill_).count());
+  last_refill_ = now;
+  tokens_ = std::min(double(burst_locked()),
+                     tokens_ + us * double(rate_.load(std::memory_order_relaxed)) / 1e6);
+}
+
+void RateLimiter::request(uint64_t bytes, Priority pri) {
+  auto& st = stat(pri);
+  st.bytes.fetch_add(bytes, std::memory_order_relaxed);
+  if (rate() == 0)
+    return;
+
+  std::unique_lock lk(mu_);
+  const auto t0 = std::chrono::steady_clock::now();
+  bool waited = false;
+  while (bytes > 0) {
+    const uint64_t r = rate();
+    if (r == 0)
+      break; // ограничение сняли, пока ждали
+    refill_locked(std::chrono::steady_clock::now());
+    const uint64_t chunk = std::min(bytes, burst_locked());
+    if (tokens_ >= double(chunk) && (pri == Priority::HIGH || high_waiting_ == 0)) {
+      tokens_ -= double(chunk);
+      bytes -= chunk;
+      continue;
+    }
+    // дефицит набирается за (chunk - tokens) / rate; LOW заодно ждёт очереди HIGH
+    const double deficit = std::max(0.0, double(chunk) - tokens_);
+    const auto wait = std::chrono::microseconds(
+        std::max<int64_t>(100, static_cast<int64_t>(deficit * 1e6 / double(r))));
+    waited = true;
+    if (pri == Priority::HIGH)
+      ++high_waiting_;
+    cv_.wait_for(lk, std::min<std::chrono::microseconds>(wait, period_));
+    if (pri == Priority::HIGH && --high_waiting_ == 0)
+      cv_.notify_all();
+  }
+  if (waited)
+    st.wait_us.fetch_add(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+                                                   std::chrono::steady_clock::now() - t0)
+                                                   .count()),
+                         std::memory_order_relaxed);
+}
+
+void RateLimiter::set_rate(uint64_t bytes_per_sec) {
+  if (rate() == bytes_per_sec)
+    return;
+  {
+    std::lock_guard lk(mu_);
+    refill_locked(std::chrono::steady_clock::now());
+    rate_.store(bytes_per_sec, std::memory_order_relaxed);
+    tokens_ = std::min(tokens_, double(burst_locked()));
+  }
+  cv_.notify_all();
+}
+
+void RateLimiter::reset_stats() {
+  for (Stats* s : {&high_, &low_}) {
+    s->bytes.store(0, std::memory_order_relaxed);
+    s->wait_us.store(0, std::memory_order_relaxed);
+  }
+}
+
+bool lower_thread_io_priority() {
+#if defined(__linux__) && defined(SYS_ioprio_set)
+  constexpr int IOPRIO_WHO_PROCESS = 1; // для потока — его tid (0 = вызывающий)
+  constexpr int IOPRIO_CLASS_BE = 2;
+  constexpr int IOPRIO_CLASS_SHIFT = 13;
+  return ::syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0, (IOPRIO_CLASS_BE << IOPRIO_CLASS_SHIFT) | 7) == 0;
+#else
+  return false;
+#endif
+}
+
+} // namespace uringkv
@@ -0,0 +1,450 @@
+// source/sst/block.cpp
+#include "sst/block.hpp"
+#include "cache/block_cache.hpp"
+#include "perf_context.hpp"
+#include "sst/index.hpp"
+#include "sst/record.hpp"
+#include "util.hpp"
+
+#include <xxhash.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace uringkv {
+
+// ---------------- builder ----------------
+
+SstBlockBuilder::SstBlockBuilder(uint32_t restart_interval)
+    : restart_interval_(restart_interval ? restart_interval : SST_RESTART_INTERVAL) {
+  buf_.reserve(4096 + 256);
+}
+
+size_t SstBlockBuilder::size_estimate() const {
+  return buf_.size() + (restarts_.size() + 1) * sizeof(uint32_t) + sizeof(SstBlockTrailer);
+}
+
+void SstBlockBuilder::add(std::string_view key, uint32_t flags, std::string_view value,
+                          uint64_t seqno) {
+  uint32_t shared = 0;
+  if (count_ % restart_interval_ == 0) {
+    restarts_.push_back(static_cast<uint32_t>(buf_.size()));
+  } else {
+    const size_t lim = std::min(last_key_.size(), key.size());
+    while (shared < lim && last_key_[shared] == key[shared]) ++shared;
+  }
+  const uint32_t non_shared = static_cast<uint32_t>(key.size()) - shared;
+
+  put_varint32(buf_, shared);
+  put_varint32(buf_, non_shared);
+  put_varint32(buf_, static_cast<uint32_t>(value.size()));
+  buf_.push_back(static_cast<char>(flags & 0xFFu));
+  put_varint64(buf_, seqno);
+  buf_.append(key.data() + shared, non_shared);
+  buf_.append(value.data(), value.size());
+
+  last_key_.assign(key.data(), key.size());
+  ++count_;
+}
+
+std::string_view SstBlockBuilder::finish() {
+  for (uint32_t r : restarts_) buf_.append(reinterpret_cast<const char*>(&r), sizeof(r));
+  const uint32_t n = static_cast<uint32_t>(restarts_.size());
+  buf_.append(reinterpret_cast<const char*>(&n), sizeof(n));
+
+  SstBlockTrailer tr{};
+  tr.checksum = static_cast<uint64_t>(XXH64(buf_.data(), buf_.size(), 0));
+  tr.magic    = SST_BLOCK_MAGIC;
+  tr.reserved = SST_BLOCK_F_SEQNO;
+  buf_.append(reinterpret_cast<const char*>(&tr), sizeof(tr));
+  return buf_;
+}
+
+void SstBlockBuilder::reset() {
+  buf_.clear();
+  last_key_.clear();
+  restarts_.clear();
+  count_ = 0;
+}
+
+// ---------------- iterator ----------------
+
+bool SstBlockIter::init(std::string_view block, bool verify_checksum) {
+  valid_ = false;
+  corrupted_ = true;
+  if (block.size() < sizeof(SstBlockTrailer) + sizeof(uint32_t)) return false;
+
+  SstBlockTrailer tr{};
+  const size_t payload = block.size() - sizeof(tr);
+  std::memcpy(&tr, block.data() + payload, sizeof(tr));
+  if (tr.magic != SST_BLOCK_MAGIC || (tr.reserved & SST_BLOCK_CODEC_MASK) != 0) return false;
+  if (verify_checksum && tr.checksum != static_cast<uint64_t>(XXH64(block.data(), payload, 0)))
+    return false;
+
+  uint32_t n = 0;
+  std::memcpy(&n, block.data() + payload - sizeof(n), sizeof(n));
+  const uint64_t restarts_bytes = uint64_t(n) * sizeof(uint32_t);
+  if (restarts_bytes + sizeof(n) > payload) return false;
+
+  data_ = block.data();
+  has_seqno_ = (tr.reserved & SST_BLOCK_F_SEQNO) != 0;
+  seqno_ = 0;
+  num_restarts_ = n;
+  restarts_off_ = static_cast<uint32_t>(payload - sizeof(n) - restarts_bytes);
+  records_end_ = restarts_off_;
+  corrupted_ = false;
+  cur_ = next_ = 0;
+  return true;
+}
+
+uint32_t SstBlockIter::restart_point(uint32_t i) const {
+  uint32_t r = 0;
+  std::memcpy(&r, data_ + restarts_off_ + i * sizeof(uint32_t), sizeof(r));
+  return r;
+}
+
+void SstBlockIter::seek_to_restart(uint32_t i) {
+  key_.clear();
+  next_ = (i < num_restarts_) ? restart_point(i) : records_end_;
+}
+
+bool SstBlockIter::parse_next() {
+  cur_ = next_;
+  if (cur_ >= records_end_) { valid_ = false; return false; }
+
+  const char* p     = data_ + cur_;
+  const char* limit = data_ + records_end_;
+  uint32_t shared = 0, non_shared = 0, vlen = 0;
+  if (!(p = get_varint32(p, limit, shared)) ||
+      !(p = get_varint32(p, limit, non_shared)) ||
+      !(p = get_varint32(p, limit, vlen)) || p >= limit ||
+      shared > key_.size() ||
+      static_cast<uint64_t>(limit - p) < 1ull + non_shared + vlen) {
+    valid_ = false;
+    corrupted_ = true;
+    return false;
+  }
+  flags_ = static_cast<unsigned char>(*p++);
+  if (has_seqno_ && (!(p = get_varint64(p, limit, seqno_)) ||
+                     static_cast<uint64_t>(limit - p) < uint64_t(non_shared) + vlen)) {
+    valid_ = false;
+    corrupted_ = true;
+    return false;
+  }
+  key_.resize(shared);
+  key_.append(p, non_shared);
+  p += non_shared;
+  value_ = std::string_view(p, vlen);
+  p += vlen;
+  next_ = static_cast<uint32_t>(p - data_);
+  valid_ = true;
+  return true;
+}
+
+void SstBlockIter::seek_to_first() {
+  if (corrupted_) { valid_ = false; return; }
+  seek_to_restart(0);
+  (void)parse_next();
+}
+
+void SstBlockIter::next() {
+  if (!valid_) return;
+  (void)parse_next();
+}
+
+void SstBlockIter::seek(std::string_view target) {
+  if (corrupted_ || num_restarts_ == 0) { valid_ = false; return; }
+
+  // бинпоиск последней restart-точки с ключом < target
+  uint32_t lo = 0, hi = num_restarts_ - 1;
+  while (lo < hi) {
+    const uint32_t mid = (lo + hi + 1) / 2;
+    seek_to_restart(mid);
+    if (!parse_next()) { valid_ = false; return; }
+    if (std::string_view(key_) < target) lo = mid;
+    else hi = mid - 1;
+  }
+  seek_to_restart(lo);
+  while (parse_next()) {
+    if (std::string_view(key_) >= target) return;
+  }
+}
+
+bool SstBlockIter::seek_to_offset(uint32_t rec_off) {
+  if (corrupted_ || num_restarts_ == 0 || rec_off >= records_end_) { valid_ = false; return false; }
+
+  // последняя restart-точка с offset <= rec_off
+  uint32_t lo = 0, hi = num_restarts_;
+  while (lo < hi) {
+    const uint32_t mid = (lo + hi) / 2;
+    if (restart_point(mid) <= rec_off) lo = mid + 1;
+    else hi = mid;
+  }
+  if (lo == 0) { valid_ = false; return false; }
+  seek_to_restart(lo - 1);
+  while (parse_next()) {
+    if (cur_ == rec_off) return true;
+    if (cur_ > rec_off) break;
+  }
+  valid_ = false;
+  return false;
+}
+
+// ---------------- file helpers ----------------
+
+static bool pread_full(int fd, uint64_t off, size_t len, std::string& out) {
+  out.resize(len);
+  size_t done = 0;
+  while (done < len) {
+    ssize_t r = ::pread(fd, out.data() + done, len - done, static_cast<off_t>(off + done));
+    if (r <= 0) return false;
+    done += static_cast<size_t>(r);
+  }
+  return true;
+}
+
+bool sst_compress_block(std::string_view block, SstCompressor& c, const SstCompressionDict* dict,
+                        std::string& out) {
+  if (block.size() < sizeof(SstBlockTrailer)) return false;
+  SstBlockTrailer tr{};
+  const std::string_view payload = block.substr(0, block.size() - sizeof(tr));
+  std::memcpy(&tr, block.data() + payload.size(), sizeof(tr));
+
+  if (!c.compress(payload, out, dict)) return false;
+  const uint32_t raw_size = static_cast<uint32_t>(payload.size());
+  if (out.size() + sizeof(raw_size) > payload.size() - payload.size() / 8) return false;
+  out.append(reinterpret_cast<const char*>(&raw_size), sizeof(raw_size));
+
+  tr.checksum = static_cast<uint64_t>(XXH64(out.data(), out.size(), 0));
+  tr.reserved = (tr.reserved & ~SST_BLOCK_CODEC_MASK) |
+                (static_cast<uint32_t>(c.codec()) << SST_BLOCK_CODEC_SHIFT);
+  out.append(reinterpret_cast<const char*>(&tr), sizeof(tr));
+  return true;
+}
+
+bool sst_unpack_block(std::string_view raw, std::string& out, const SstCompressionDict* dict) {
+  out.clear();
+  if (raw.size() < sizeof(SstBlockTrailer) + sizeof(uint32_t)) return false;
+  SstBlockTrailer tr{};
+  const size_t payload = raw.size() - sizeof(tr);
+  std::memcpy(&tr, raw.data() + payload, sizeof(tr));
+  {
+    PerfTimer pt(&PerfContext::block_checksum_ns);
+    if (tr.magic != SST_BLOCK_MAGIC ||
+        tr.checksum != static_cast<uint64_t>(XXH64(raw.data(), payload, 0)))
+      return false;
+  }
+
+  const auto codec = static_cast<SstCompression>((tr.reserved & SST_BLOCK_CODEC_MASK) >> SST_BLOCK_CODEC_SHIFT);
+  if (codec == SstCompression::NONE) return true;
+
+  uint32_t raw_size = 0;
+  std::memcpy(&raw_size, raw.data() + payload - sizeof(raw_size), sizeof(raw_size));
+  if (raw_size < sizeof(uint32_t) || raw_size > (1u << 30)) return false;
+
+  const auto t0 = std::chrono::steady_clock::now();
+  if (!sst_uncompress(codec, raw.substr(0, payload - sizeof(raw_size)), raw_size, out, dict)) {
+    out.clear();
+    return false;
+  }
+  const auto ns = static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0).count());
+  auto& st = sst_codec_stats();
+  st.blocks_decompressed.fetch_add(1, std::memory_order_relaxed);
+  st.bytes_decompressed.fetch_add(raw_size, std::memory_order_relaxed);
+  st.decompress_ns.fetch_add(ns, std::memory_order_relaxed);
+  if (perf_time_enabled()) get_perf_context().block_decompress_ns += ns;
+
+  // распакованный блок уже проверен: checksum в его трейлере не используется
+  tr.checksum = 0;
+  tr.reserved &= ~SST_BLOCK_CODEC_MASK;
+  out.append(reinterpret_cast<const char*>(&tr), sizeof(tr));
+  return true;
+}
+
+bool sst_read_block(int fd, const SstBlockHandle& h, std::string& out, const SstCompressionDict* dict) {
+  if (h.size < sizeof(SstBlockTrailer) + sizeof(uint32_t)) return false;
+  if (!pread_full(fd, h.offset, h.size, out)) return false;
+  perf_count(&PerfContext::block_read_count);
+  perf_count(&PerfContext::block_read_bytes, h.size);
+  std::string unpacked;
+  if (!sst_unpack_block(out, unpacked, dict)) return false;
+  if (!unpacked.empty()) out.swap(unpacked);
+  return true;
+}
+
+bool sst_load_block_index(int fd, uint64_t off, uint64_t len, uint32_t count,
+                          std::vector<SstIndexEntry>& out) {
+  out.clear();
+  if (len < sizeof(SparseIndexHeader)) return false;
+
+  // индекс небольшой — читаем одним pread и разбираем в памяти
+  std::string buf;
+  if (!pread_full(fd, off, static_cast<size_t>(len), buf)) return false;
+  const char* p   = buf.data();
+  const char* end = buf.data() + buf.size();
+
+  SparseIndexHeader sh{};
+  std::memcpy(&sh, p, sizeof(sh));
+  p += sizeof(sh);
+  if (sh.magic != kSparseMagic || sh.version != kBlockIndexVersion || sh.count != count) return false;
+
+  out.reserve(count);
+  for (uint32_t i = 0; i < count; ++i) {
+    uint32_t klen = 0, size = 0;
+    uint64_t boff = 0;
+    if (end - p < static_cast<long>(sizeof(klen) + sizeof(boff) + sizeof(size))) return false;
+    std::memcpy(&klen, p, sizeof(klen)); p += sizeof(klen);
+    std::memcpy(&boff, p, sizeof(boff)); p += sizeof(boff);
+    std::memcpy(&size, p, sizeof(size)); p += sizeof(size);
+    if (end - p < static_cast<long>(klen)) return false;
+    out.push_back(SstIndexEntry{std::string(p, klen), SstBlockHandle{boff, size}});
+    p += klen;
+  }
+  return true;
+}
+
+long sst_find_block(const std::vector<SstIndexEntry>& index, std::string_view key) {
+  auto it = std::upper_bound(index.begin(), index.end(), key,
+                             [](std::string_view k, const SstIndexEntry& e) { return k < e.first_key; });
+  if (it == index.begin()) return -1;
+  return static_cast<long>(std::distance(index.begin(), it)) - 1;
+}
+
+static const SstBlockHandle* find_block_by_offset(const std::vector<SstIndexEntry>& index,
+                                                  uint64_t block_off) {
+  auto it = std::lower_bound(index.begin(), index.end(), block_off,
+                             [](const SstIndexEntry& e, uint64_t o) { return e.handle.offset < o; });
+  if (it == index.end() || it->handle.offset != block_off) return nullptr;
+  return &it->handle;
+}
+
+// it стоит на самой новой версии key; все версии ключа лежат в этом блоке.
+// true — it на версии, видимой снимку
+static bool visible_version(SstBlockIter& it, std::string_view key, uint64_t snapshot, uint64_t* seqno) {
+  while (it.valid() && it.key() == key) {
+    if (it.seqno() <= snapshot) {
+      if (seqno) *seqno = it.seqno();
+      return true;
+    }
+    it.next();
+  }
+  return false;
+}
+
+static void set_value_ref(const SstBlockIter& it, SstValueRef& out) {
+  out.flags = it.flags() == SST_FLAG_DEL || it.flags() == SST_FLAG_BLOB ? it.flags() : SST_FLAG_PUT;
+  out.value = out.flags == SST_FLAG_DEL ? std::string_view{} : it.value();
+}
+
+// В кэш попадают только проверенные и распакованные блоки, поэтому на
+// попадании checksum не пересчитывается
+bool sst_load_block(int fd, const SstBlockHandle& bh, BlockCache* cache, uint64_t file_id,
+                    const SstCompressionDict* dict, std::shared_ptr<const std::string>& hold,
+                    std::string& buf, SstBlockIter& it) {
+  if (!cache) return sst_read_block(fd, bh, buf, dict) && it.init(buf, /*verify_checksum=*/false);
+  if ((hold = cache->lookup(file_id, bh.offset))) {
+    perf_count(&PerfContext::block_cache_hit_count);
+    return it.init(*hold, /*verify_checksum=*/false);
+  }
+  if (!sst_read_block(fd, bh, buf, dict) || !it.init(buf, /*verify_checksum=*/false)) return false;
+  hold = cache->insert(file_id, bh.offset, std::move(buf));
+  return it.init(*hold, /*verify_checksum=*/false);
+}
+
+// Блок кандидата из хеш-индекса: v1 хранит смещение блока, v2 — его номер
+static const SstBlockHandle* hidx_candidate_block(const std::vector<SstIndexEntry>& index,
+                                                  const MmapHashIndex& hidx, uint64_t ref) {
+  if (hidx.version() == kHidxVersionV2) return ref < index.size() ? &index[ref].handle : nullptr;
+  return find_block_by_offset(index, sst_record_block_off(ref));
+}
+
+bool sst_v3_point_lookup(int fd, const std::vector<SstIndexEntry>& index,
+                         const MmapHashIndex* hidx, std::string_view key, SstValueRef& out,
+                         BlockCache* cache, uint64_t file_id, uint64_t snapshot,
+                         const SstCompressionDict* dict, uint64_t* seqno) {
+  out.value = {};
+  out.hold.reset();
+  SstBlockIter it;
+  // стадии: индекс -> блок -> запись (у коллизии снова индекс)
+  PerfStopwatch sw;
+
+  if (hidx && hidx->good()) {
+    const bool by_number = hidx->version() == kHidxVersionV2;
+    const SstBlockHandle* cached_block = nullptr;
+    bool found = false;
+    hidx->probe(sst_key_hash(key.data(), key.size()), [&](uint64_t ref) {
+      const SstBlockHandle* bh = hidx_candidate_block(index, *hidx, ref);
+      if (!bh) return true;
+      sw.lap(&PerfContext::index_probe_ns);
+      if (bh != cached_block) {
+        const bool loaded = sst_load_block(fd, *bh, cache, file_id, dict, out.hold, out.buf, it);
+        sw.lap(&PerfContext::block_read_ns);
+        if (!loaded) return true;
+        cached_block = bh;
+      }
+      // v2: tag совпал — ищем ключ в блоке; v1: сразу на запись
+      const bool at_key = by_number ? (it.seek(key), it.valid() && it.key() == key)
+                                    : it.seek_to_offset(sst_record_in_block_off(ref)) && it.key() == key;
+      if (at_key && (found = visible_version(it, key, snapshot, seqno))) set_value_ref(it, out);
+      sw.lap(&PerfContext::record_read_ns);
+      return at_key; // collision — continue probing
+    });
+    sw.lap(&PerfContext::index_probe_ns);
+    return found;
+  }
+
+  const long bi = sst_find_block(index, key);
+  sw.lap(&PerfContext::index_probe_ns);
+  if (bi < 0) return false;
+  const bool loaded = sst_load_block(fd, index[static_cast<size_t>(bi)].handle, cache, file_id, dict,
+                                 out.hold, out.buf, it);
+  sw.lap(&PerfContext::block_read_ns);
+  if (!loaded) return false;
+  it.seek(key);
+  const bool found = it.valid() && it.key() == key && visible_version(it, key, snapshot, seqno);
+  if (found) set_value_ref(it, out);
+  sw.lap(&PerfContext::record_read_ns);
+  return found;
+}
+
+std::optional<std::pair<uint32_t, std::string>>
+sst_v3_point_lookup(int fd, const std::vector<SstIndexEntry>& index,
+                    const MmapHashIndex* hidx,
+                    std::string_view key, BlockCache* cache, uint64_t file_id,
+                    uint64_t snapshot, const SstCompressionDict* dict, uint64_t* seqno) {
+  SstValueRef ref;
+  if (!sst_v3_point_lookup(fd, index, hidx, key, ref, cache, file_id, snapshot, dict, seqno))
+    return std::nullopt;
+  PerfTimer t(&PerfContext::record_read_ns); // копия значения
+  return std::pair<uint32_t, std::string>(ref.flags, std::string(ref.value));
+}
+
+bool sst_v3_locate(const std::vector<SstIndexEntry>& index,
+                   const MmapHashIndex* hidx,
+                   std::string_view key, SstBlockHandle& bh, uint64_t& packed) {
+  packed = UINT64_MAX;
+  if (hidx && hidx->good()) {
+    bool found = false;
+    hidx->probe(sst_key_hash(key.data(), key.size()), [&](uint64_t ref) {
+      // первый кандидат; коллизию разрешит повторный поиск через get()
+      const SstBlockHandle* p = hidx_candidate_block(index, *hidx, ref);
+      if (p) {
+        bh = *p;
+        if (hidx->version() != kHidxVersionV2) packed = ref;
+        found = true;
+      }
+      return true;
+    });
+    return found;
+  }
+
+  const long bi = sst_find_block(index, key);
+  if (bi < 0) return false;
+  bh = index[static_cast<size_t>(bi)].handle;
+  return true;
+}
+
+} // namespace uringkv
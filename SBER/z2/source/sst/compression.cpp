@@ -0,0 +1,205 @@
+#include "sst/compression.hpp"
+
+#include <spdlog/spdlog.h>
+#include <xxhash.h>
+
+#include <cstring>
+#include <unistd.h>
+
+#ifdef HAVE_LZ4
+#include <lz4.h>
+#endif
+#ifdef HAVE_ZSTD
+#include <zdict.h>
+#include <zstd.h>
+#endif
+
+namespace uringkv {
+
+bool sst_compression_supported(SstCompression c) {
+  switch (c) {
+  case SstCompression::NONE: return true;
+#ifdef HAVE_LZ4
+  case SstCompression::LZ4: return true;
+#endif
+#ifdef HAVE_ZSTD
+  case SstCompression::ZSTD: return true;
+#endif
+  default: return false;
+  }
+}
+
+const char* sst_compression_name(SstCompression c) {
+  switch (c) {
+  case SstCompression::NONE: return "none";
+  case SstCompression::LZ4: return "lz4";
+  case SstCompression::ZSTD: return "zstd";
+  }
+  return "unknown";
+}
+
+bool parse_sst_compression(std::string_view s, SstCompression& out) {
+  if (s == "none") out = SstCompression::NONE;
+  else if (s == "lz4") out = SstCompression::LZ4;
+  else if (s == "zstd") out = SstCompression::ZSTD;
+  else return false;
+  return true;
+}
+
+SstCodecStats& sst_codec_stats() {
+  static SstCodecStats stats;
+  return stats;
+}
+
+// ---- SstCompressionDict ----
+
+SstCompressionDict::SstCompressionDict(std::string raw) : raw_(std::move(raw)) {
+#ifdef HAVE_ZSTD
+  if (!raw_.empty()) ddict_ = ZSTD_createDDict(raw_.data(), raw_.size());
+#endif
+}
+
+SstCompressionDict::~SstCompressionDict() {
+#ifdef HAVE_ZSTD
+  ZSTD_freeCDict(cdict_);
+  ZSTD_freeDDict(ddict_);
+#endif
+}
+
+bool SstCompressionDict::prepare_compress([[maybe_unused]] int level) {
+#ifdef HAVE_ZSTD
+  if (!cdict_ && !raw_.empty())
+    cdict_ = ZSTD_createCDict(raw_.data(), raw_.size(), level ? level : ZSTD_CLEVEL_DEFAULT);
+#endif
+  return cdict_ != nullptr;
+}
+
+// ---- SstCompressor ----
+
+SstCompressor::SstCompressor(SstCompression c, int level) : codec_(c), level_(level) {
+#ifdef HAVE_ZSTD
+  if (codec_ == SstCompression::ZSTD) cctx_ = ZSTD_createCCtx();
+#endif
+}
+
+SstCompressor::~SstCompressor() {
+#ifdef HAVE_ZSTD
+  ZSTD_freeCCtx(static_cast<ZSTD_CCtx*>(cctx_));
+#endif
+}
+
+bool SstCompressor::compress([[maybe_unused]] std::string_view in, [[maybe_unused]] std::string& out,
+                             [[maybe_unused]] const SstCompressionDict* dict) {
+  switch (codec_) {
+#ifdef HAVE_LZ4
+  case SstCompression::LZ4: {
+    out.resize(static_cast<std::size_t>(LZ4_compressBound(static_cast<int>(in.size()))));
+    const int n = LZ4_compress_default(in.data(), out.data(), static_cast<int>(in.size()),
+                                       static_cast<int>(out.size()));
+    if (n <= 0) return false;
+    out.resize(static_cast<std::size_t>(n));
+    return true;
+  }
+#endif
+#ifdef HAVE_ZSTD
+  case SstCompression::ZSTD: {
+    auto* cctx = static_cast<ZSTD_CCtx*>(cctx_);
+    if (!cctx) return false;
+    out.resize(ZSTD_compressBound(in.size()));
+    const std::size_t n =
+        dict && dict->cdict()
+            ? ZSTD_compress_usingCDict(cctx, out.data(), out.size(), in.data(), in.size(), dict->cdict())
+            : ZSTD_compressCCtx(cctx, out.data(), out.size(), in.data(), in.size(),
+                                level_ ? level_ : ZSTD_CLEVEL_DEFAULT);
+    if (ZSTD_isError(n)) return false;
+    out.resize(n);
+    return true;
+  }
+#endif
+  default:
+    (void)level_;
+    return false;
+  }
+}
+
+// ---- распаковка ----
+
+#ifdef HAVE_ZSTD
+namespace {
+struct DCtxHolder {
+  ZSTD_DCtx* ctx = ZSTD_createDCtx();
+  ~DCtxHolder() { ZSTD_freeDCtx(ctx); }
+};
+} // namespace
+#endif
+
+bool sst_uncompress(SstCompression c, [[maybe_unused]] std::string_view in, std::size_t raw_size, std::string& out,
+                    [[maybe_unused]] const SstCompressionDict* dict) {
+  out.resize(raw_size);
+  switch (c) {
+#ifdef HAVE_LZ4
+  case SstCompression::LZ4:
+    return LZ4_decompress_safe(in.data(), out.data(), static_cast<int>(in.size()),
+                               static_cast<int>(raw_size)) == static_cast<int>(raw_size);
+#endif
+#ifdef HAVE_ZSTD
+  case SstCompression::ZSTD: {
+    thread_local DCtxHolder dctx;
+    if (!dctx.ctx) return false;
+    const std::size_t n =
+        dict && dict->ddict()
+            ? ZSTD_decompress_usingDDict(dctx.ctx, out.data(), raw_size, in.data(), in.size(), dict->ddict())
+            : ZSTD_decompressDCtx(dctx.ctx, out.data(), raw_size, in.data(), in.size());
+    return !ZSTD_isError(n) && n == raw_size;
+  }
+#endif
+  default:
+    spdlog::error("SST block codec {} is not supported by this build", static_cast<unsigned>(c));
+    return false;
+  }
+}
+
+// ---- словарь ----
+
+std::string sst_train_zstd_dict([[maybe_unused]] const std::string& samples,
+                                [[maybe_unused]] const std::vector<std::size_t>& sizes,
+                                [[maybe_unused]] std::size_t max_bytes) {
+#ifdef HAVE_ZSTD
+  // ZDICT требует несколько образцов; на паре блоков словарь бесполезен
+  if (sizes.size() < 8 || max_bytes == 0) return {};
+  std::string dict(max_bytes, '\0');
+  const std::size_t n = ZDICT_trainFromBuffer(dict.data(), dict.size(), samples.data(), sizes.data(),
+                                              static_cast<unsigned>(sizes.size()));
+  if (ZDICT_isError(n)) {
+    spdlog::debug("zstd dictionary training failed: {}", ZDICT_getErrorName(n));
+    return {};
+  }
+  dict.resize(n);
+  return dict;
+#else
+  return {};
+#endif
+}
+
+std::string sst_encode_dict_block(const std::string& raw) {
+  std::string out = raw;
+  const uint64_t h = static_cast<uint64_t>(XXH64(raw.data(), raw.size(), 0));
+  out.append(reinterpret_cast<const char*>(&h), sizeof(h));
+  return out;
+}
+
+std::unique_ptr<SstCompressionDict> sst_read_dict_block(int fd, uint64_t off, uint64_t size) {
+  if (size <= sizeof(uint64_t) || size > 16ull * 1024 * 1024) return nullptr;
+  std::string buf(size, '\0');
+  if (::pread(fd, buf.data(), buf.size(), static_cast<off_t>(off)) != static_cast<ssize_t>(buf.size()))
+    return nullptr;
+  uint64_t h = 0;
+  std::memcpy(&h, buf.data() + size - sizeof(h), sizeof(h));
+  buf.resize(size - sizeof(h));
+  if (h != static_cast<uint64_t>(XXH64(buf.data(), buf.size(), 0))) return nullptr;
+  auto dict = std::make_unique<SstCompressionDict>(std::move(buf));
+  if (!dict->good()) return nullptr;
+  return dict;
+}
+
+} // namespace uringkv
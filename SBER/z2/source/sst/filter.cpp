@@ -0,0 +1,86 @@
+// source/sst/filter.cpp
+#include "sst/filter.hpp"
+
+#include <xxhash.h>
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace uringkv {
+
+// нечётные константы из split block bloom (Impala/Parquet)
+alignas(32) static constexpr uint32_t kSalt[8] = {
+    0x47b6137bu, 0x44974d91u, 0x8824ad5bu, 0xa2b7289du,
+    0x705495c7u, 0x2df1424bu, 0x9efc4947u, 0x5c6bfb31u};
+
+static inline uint32_t block_of(uint64_t h, uint32_t num_blocks) {
+  // fastrange: равномерно в [0, num_blocks) без деления
+  return static_cast<uint32_t>(((h >> 32) * num_blocks) >> 32);
+}
+
+std::string BloomFilterBuilder::finish() {
+  const uint64_t bits = uint64_t(hashes_.size()) * (bits_per_key_ ? bits_per_key_ : 10);
+  const uint32_t num_blocks = static_cast<uint32_t>(std::max<uint64_t>(1, (bits + 255) / 256));
+
+  std::vector<uint32_t> words(uint64_t(num_blocks) * 8, 0);
+  for (uint64_t h : hashes_) {
+    uint32_t* blk = words.data() + uint64_t(block_of(h, num_blocks)) * 8;
+    const uint32_t lo = static_cast<uint32_t>(h);
+    for (int i = 0; i < 8; ++i) blk[i] |= 1u << ((lo * kSalt[i]) >> 27);
+  }
+
+  SstFilterHeader hdr{};
+  hdr.magic        = kSstFilterMagic;
+  hdr.kind         = kSstFilterBlockBloom;
+  hdr.num_blocks   = num_blocks;
+  hdr.bits_per_key = bits_per_key_;
+  hdr.checksum     = static_cast<uint64_t>(XXH64(words.data(), words.size() * sizeof(uint32_t), 0));
+
+  std::string out(reinterpret_cast<const char*>(&hdr), sizeof(hdr));
+  out.append(reinterpret_cast<const char*>(words.data()), words.size() * sizeof(uint32_t));
+  return out;
+}
+
+bool BloomFilter::init(std::string_view data) {
+  words_.clear();
+  num_blocks_ = 0;
+  if (data.size() < sizeof(SstFilterHeader)) return false;
+  SstFilterHeader hdr{};
+  std::memcpy(&hdr, data.data(), sizeof(hdr));
+  const uint64_t bytes = uint64_t(hdr.num_blocks) * 8 * sizeof(uint32_t);
+  if (hdr.magic != kSstFilterMagic || hdr.kind != kSstFilterBlockBloom || hdr.num_blocks == 0 ||
+      data.size() - sizeof(hdr) != bytes)
+    return false;
+  const char* p = data.data() + sizeof(hdr);
+  if (hdr.checksum != static_cast<uint64_t>(XXH64(p, bytes, 0))) return false;
+
+  words_.resize(bytes / sizeof(uint32_t));
+  std::memcpy(words_.data(), p, bytes);
+  num_blocks_ = hdr.num_blocks;
+  return true;
+}
+
+bool BloomFilter::may_contain(uint64_t h) const {
+  if (num_blocks_ == 0) return true;
+  const uint32_t* blk = words_.data() + uint64_t(block_of(h, num_blocks_)) * 8;
+  const uint32_t lo = static_cast<uint32_t>(h);
+#if defined(__AVX2__)
+  // маски всех 8 слов за раз: 1 << ((lo * salt) >> 27)
+  const __m256i salt = _mm256_load_si256(reinterpret_cast<const __m256i*>(kSalt));
+  const __m256i prod = _mm256_mullo_epi32(_mm256_set1_epi32(static_cast<int>(lo)), salt);
+  const __m256i mask = _mm256_sllv_epi32(_mm256_set1_epi32(1), _mm256_srli_epi32(prod, 27));
+  const __m256i b    = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(blk));
+  // все биты маски выставлены в блоке <=> (~b & mask) == 0
+  return _mm256_testc_si256(b, mask) != 0;
+#else
+  uint32_t miss = 0;
+  for (int i = 0; i < 8; ++i) miss |= ~blk[i] & (1u << ((lo * kSalt[i]) >> 27));
+  return miss == 0;
+#endif
+}
+
+} // namespace uringkv
@@ -0,0 +1,31 @@
+// source/sst/footer.cpp
+#include "sst/footer.hpp"
+
+#include <cstring>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace uringkv {
+
+bool sst_read_footer(int fd, SstFooter& f, SstFooterExt& ext) {
+  if (fd < 0) return false;
+
+  struct stat st{};
+  if (::fstat(fd, &st) != 0) return false;
+  const off_t end = st.st_size;
+  if (end < (off_t)sizeof(SstFooter)) return false;
+
+  if (::pread(fd, &f, sizeof(f), end - (off_t)sizeof(SstFooter)) != (ssize_t)sizeof(f)) return false;
+  if (std::memcmp(f.magic, kSstMagic, 7) != 0) return false;
+
+  std::memset(&ext, 0, sizeof(ext));
+  if (f.version == kSstVersionV2) return true;
+  if (f.version != kSstVersionV3) return false;
+
+  const off_t ext_off = end - (off_t)sizeof(SstFooter) - (off_t)sizeof(SstFooterExt);
+  if (ext_off < 0) return false;
+  if (::pread(fd, &ext, sizeof(ext), ext_off) != (ssize_t)sizeof(ext)) return false;
+  return ext.data_end <= f.hash_index_offset;
+}
+
+} // namespace uringkv
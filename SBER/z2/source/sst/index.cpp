@@ -5,6 +5,12 @@
 #include <cstring>
 #include <algorithm>
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 namespace uringkv {
 
 inline size_t page_size_cached() {
@@ -16,15 +22,100 @@ uint64_t sst_key_hash(const char* data, size_t len) {
   return static_cast<uint64_t>(XXH64(data, len, 0));
 }
 
+HashBucketMatch hidx_match_scalar(const HashIndexBucket& b, uint16_t tag) {
+  HashBucketMatch m{0, 0};
+  for (uint32_t i = 0; i < kHidxBucketSlots; ++i) {
+    m.hits  |= uint32_t(b.tag[i] == tag) << i;
+    m.empty |= uint32_t(b.tag[i] == 0) << i;
+  }
+  return m;
+}
+
+HashBucketMatch hidx_match_simd(const HashIndexBucket& b, uint16_t tag) {
+#if defined(__AVX2__)
+  // 16 tag'ов одним регистром; packs сводит два сравнения в байты:
+  // в каждой 128-битной половине [hits 8 слотов | empty 8 слотов]
+  const __m256i t  = _mm256_load_si256(reinterpret_cast<const __m256i*>(b.tag));
+  const __m256i eq = _mm256_cmpeq_epi16(t, _mm256_set1_epi16(static_cast<short>(tag)));
+  const __m256i ez = _mm256_cmpeq_epi16(t, _mm256_setzero_si256());
+  const auto bits = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_packs_epi16(eq, ez)));
+  return {(bits & 0xFFu) | ((bits >> 8) & 0xFF00u), ((bits >> 8) & 0xFFu) | ((bits >> 16) & 0xFF00u)};
+#elif defined(__SSE2__)
+  const __m128i lo  = _mm_load_si128(reinterpret_cast<const __m128i*>(b.tag));
+  const __m128i hi  = _mm_load_si128(reinterpret_cast<const __m128i*>(b.tag + 8));
+  const __m128i key = _mm_set1_epi16(static_cast<short>(tag));
+  const __m128i zero = _mm_setzero_si128();
+  const auto hits  = _mm_movemask_epi8(_mm_packs_epi16(_mm_cmpeq_epi16(lo, key), _mm_cmpeq_epi16(hi, key)));
+  const auto empty = _mm_movemask_epi8(_mm_packs_epi16(_mm_cmpeq_epi16(lo, zero), _mm_cmpeq_epi16(hi, zero)));
+  return {static_cast<uint32_t>(hits), static_cast<uint32_t>(empty)};
+#else
+  return hidx_match_scalar(b, tag);
+#endif
+}
+
+const char* hidx_simd_name() {
+#if defined(__AVX2__)
+  return "avx2";
+#elif defined(__SSE2__)
+  return "sse2";
+#else
+  return "scalar";
+#endif
+}
+
+static inline uint64_t next_pow2(uint64_t x) {
+  if (x <= 1) return 1;
+  return uint64_t(1) << (64 - __builtin_clzll(x - 1));
+}
+
+std::vector<HashIndexBucket> sst_build_hash_buckets(const std::vector<HashIndexEntry>& items) {
+  // не больше 12 ключей на бакет: переполнения (второй бакет = второй промах) редки
+  const uint64_t n = next_pow2(std::max<uint64_t>(1, (items.size() + 11) / 12));
+  std::vector<HashIndexBucket> buckets(n);
+  std::memset(buckets.data(), 0, n * sizeof(HashIndexBucket));
+  const uint64_t mask = n - 1;
+  for (const auto& it : items) {
+    const uint16_t tag = hidx_tag(it.h);
+    uint64_t pos = it.h & mask;
+    for (uint64_t step = 0; step < n; ++step) {
+      auto& b = buckets[pos];
+      const uint32_t empty = hidx_match_scalar(b, tag).empty;
+      if (empty) {
+        const int slot = __builtin_ctz(empty);
+        b.tag[slot]   = tag;
+        b.block[slot] = static_cast<uint16_t>(it.off);
+        break;
+      }
+      pos = (pos + 1) & mask;
+    }
+  }
+  return buckets;
+}
+
 bool MmapHashIndex::open(int fd, uint64_t index_offset, uint64_t table_sz) {
   close();
 
+  HashIndexHeader h{};
+  if (::pread(fd, &h, sizeof(h), static_cast<off_t>(index_offset)) != static_cast<ssize_t>(sizeof(h)) ||
+      h.magic != kHidxMagic || h.table_size != table_sz || table_sz == 0)
+    return false;
+
+  uint64_t body_off = 0, body_len = 0;
+  if (h.version == kHidxVersionV1) {
+    body_off = sizeof(HashIndexHeader);
+    body_len = table_sz * sizeof(HashIndexEntry);
+  } else if (h.version == kHidxVersionV2) {
+    if (table_sz & (table_sz - 1)) return false;
+    body_off = hidx_buckets_offset(index_offset) - index_offset;
+    body_len = table_sz * sizeof(HashIndexBucket);
+  } else {
+    return false;
+  }
+
   const size_t ps = page_size_cached();
   const size_t off_page = static_cast<size_t>(index_offset % ps);
   const off_t  map_off  = static_cast<off_t>(index_offset - off_page);
-
-  const size_t need = sizeof(HashIndexHeader) + table_sz * sizeof(HashIndexEntry);
-  const size_t map_len = off_page + need;
+  const size_t map_len  = off_page + body_off + body_len;
 
   void* p = ::mmap(nullptr, map_len, PROT_READ, MAP_SHARED, fd, map_off);
   if (p == MAP_FAILED) return false;
@@ -33,14 +124,16 @@ bool MmapHashIndex::open(int fd, uint64_t index_offset, uint64_t table_sz) {
   map_len_  = map_len;
   page_off_ = off_page;
 
-  auto* hdr = reinterpret_cast<const HashIndexHeader*>(static_cast<const char*>(p) + off_page);
-  if (!hdr || hdr->magic != kHidxMagic || hdr->version != kHidxVersion || hdr->table_size != table_sz) {
+  const char* base = static_cast<const char*>(p) + off_page;
+  auto* hdr = reinterpret_cast<const HashIndexHeader*>(base);
+  if (hdr->magic != kHidxMagic || hdr->version != h.version || hdr->table_size != table_sz) {
     close();
     return false;
   }
 
   hdr_ = hdr;
-  table_ = reinterpret_cast<const HashIndexEntry*>(hdr_ + 1);
+  if (h.version == kHidxVersionV1) table_ = reinterpret_cast<const HashIndexEntry*>(hdr_ + 1);
+  else buckets_ = reinterpret_cast<const HashIndexBucket*>(base + body_off);
   table_size_ = hdr_->table_size;
   return true;
 }
@@ -54,6 +147,7 @@ void MmapHashIndex::close() {
   page_off_ = 0;
   hdr_      = nullptr;
   table_    = nullptr;
+  buckets_  = nullptr;
   table_size_ = 0;
 }
 
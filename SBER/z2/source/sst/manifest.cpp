@@ -4,9 +4,13 @@
 #include <dirent.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include <cerrno>
 #include <cstdio>
 #include <cstring>
 #include <algorithm>
+#include <map>
+#include <sstream>
+#include <xxhash.h>
 
 namespace uringkv {
 
@@ -77,4 +81,280 @@ std::vector<std::string> list_sst_sorted(const std::string& sst_dir) {
   return out;
 }
 
+// ---- MANIFEST ----
+
+static constexpr const char* kManifestHeader = "uringkv-manifest 2";
+static constexpr const char* kManifestHeaderV1 = "uringkv-manifest 1";
+
+static std::string hex_key(std::string_view k) {
+  static const char* digits = "0123456789abcdef";
+  std::string out = "x"; // пустой ключ тоже остаётся отдельным токеном
+  out.reserve(1 + k.size() * 2);
+  for (unsigned char c : k) {
+    out.push_back(digits[c >> 4]);
+    out.push_back(digits[c & 0xF]);
+  }
+  return out;
+}
+
+static bool unhex_key(const std::string& s, std::string& out) {
+  if (s.empty() || s[0] != 'x' || (s.size() - 1) % 2 != 0) return false;
+  auto nib = [](char c) -> int {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+  };
+  out.clear();
+  for (size_t i = 1; i < s.size(); i += 2) {
+    const int hi = nib(s[i]), lo = nib(s[i + 1]);
+    if (hi < 0 || lo < 0) return false;
+    out.push_back(static_cast<char>((hi << 4) | lo));
+  }
+  return true;
+}
+
+static void append_file_line(std::string& body, size_t level, const SstFileMeta& f) {
+  body += "file " + std::to_string(level) + ' ' + std::to_string(f.index) + ' ' +
+          std::to_string(f.size) + ' ' + std::to_string(f.min_seq) + ' ' +
+          std::to_string(f.max_seq) + ' ' + hex_key(f.smallest) + ' ' +
+          hex_key(f.largest);
+  for (size_t i = 0; i < f.blob_files.size(); ++i)
+    body += (i == 0 ? " b" : ",") + std::to_string(f.blob_files[i]);
+  if (f.range_dels) body += " r" + std::to_string(f.range_dels);
+  body += '\n';
+}
+
+static void append_blob_line(std::string& body, const BlobFileMeta& b) {
+  body += "blob " + std::to_string(b.index) + ' ' + std::to_string(b.bytes) + ' ' +
+          std::to_string(b.garbage) + '\n';
+}
+
+// строки правки + "commit <xxh64>"
+static std::string encode_edit(const VersionEdit& e) {
+  std::string body;
+  for (uint64_t idx : e.removed) body += "drop " + std::to_string(idx) + '\n';
+  for (const auto& [level, f] : e.added) append_file_line(body, level, f);
+  for (uint64_t idx : e.blobs_removed) body += "dropblob " + std::to_string(idx) + '\n';
+  for (const auto& b : e.blobs) append_blob_line(body, b);
+  if (e.last_index) body += "last " + std::to_string(e.last_index) + '\n';
+  if (e.clean_next_blob) body += "clean " + std::to_string(e.clean_next_blob) + '\n';
+  char tail[40];
+  std::snprintf(tail, sizeof(tail), "commit %016llx\n",
+                static_cast<unsigned long long>(XXH64(body.data(), body.size(), 0)));
+  return body + tail;
+}
+
+static bool write_all(int fd, const std::string& data) {
+  const char* p = data.data();
+  size_t left = data.size();
+  while (left > 0) {
+    ssize_t w = ::write(fd, p, left);
+    if (w < 0) { if (errno == EINTR) continue; return false; }
+    p += w; left -= static_cast<size_t>(w);
+  }
+  return true;
+}
+
+bool write_manifest_atomic(const std::string& sst_dir, uint64_t last_index, const SstLevels& levels,
+                           const std::vector<BlobFileMeta>& blobs) {
+  VersionEdit snap;
+  snap.last_index = last_index;
+  for (size_t l = 0; l < levels.size(); ++l)
+    for (const auto& f : levels[l]) snap.added.emplace_back(l, f);
+  snap.blobs = blobs;
+  std::string body = std::string(kManifestHeader) + '\n' + encode_edit(snap);
+
+  auto tmp = join_path(sst_dir, "MANIFEST.tmp");
+  auto man = join_path(sst_dir, "MANIFEST");
+
+  int fd = ::open(tmp.c_str(), O_CREAT|O_TRUNC|O_WRONLY, 0644);
+  if (fd < 0) return false;
+  bool ok = write_all(fd, body) && ::fsync(fd) == 0;
+  ::close(fd);
+
+  if (!ok || ::rename(tmp.c_str(), man.c_str()) != 0) {
+    ::unlink(tmp.c_str());
+    return false;
+  }
+  fsync_dir_path(sst_dir);
+  return true;
+}
+
+// "b1,2,3" -> {1,2,3}
+static bool parse_blob_list(const std::string& s, std::vector<uint64_t>& out) {
+  if (s.size() < 2 || s[0] != 'b') return false;
+  std::istringstream in(s.substr(1));
+  std::string tok;
+  while (std::getline(in, tok, ',')) {
+    if (tok.empty() || !std::all_of(tok.begin(), tok.end(), ::isdigit)) return false;
+    out.push_back(std::stoull(tok));
+  }
+  return !out.empty();
+}
+
+// Состояние при чтении журнала: файл -> уровень, blob-файлы
+struct ManifestState {
+  std::map<uint64_t, std::pair<size_t, SstFileMeta>> files;
+  std::map<uint64_t, BlobFileMeta> blobs;
+  uint64_t last = 0;
+  uint64_t clean_next_blob = 0;
+};
+
+// Одна строка журнала; false — строка битая
+static bool apply_line(const std::string& sst_dir, const std::string& line, ManifestState& st) {
+  std::istringstream ls(line);
+  std::string tag;
+  ls >> tag;
+  if (tag == "last") {
+    return static_cast<bool>(ls >> st.last);
+  } else if (tag == "clean") {
+    return static_cast<bool>(ls >> st.clean_next_blob);
+  } else if (tag == "file") {
+    size_t level = 0;
+    SstFileMeta f;
+    std::string lo, hi, opt;
+    if (!(ls >> level >> f.index >> f.size >> f.min_seq >> f.max_seq >> lo >> hi) ||
+        !unhex_key(lo, f.smallest) || !unhex_key(hi, f.largest))
+      return false;
+    while (ls >> opt) {
+      if (opt[0] == 'b') {
+        if (!parse_blob_list(opt, f.blob_files)) return false;
+      } else if (opt[0] == 'r' && opt.size() > 1 && std::all_of(opt.begin() + 1, opt.end(), ::isdigit)) {
+        f.range_dels = std::stoull(opt.substr(1));
+      } else {
+        return false;
+      }
+    }
+    f.path = join_path(sst_dir, sst_name(f.index));
+    const uint64_t idx = f.index;
+    st.files[idx] = {level, std::move(f)};
+  } else if (tag == "drop") {
+    uint64_t idx = 0;
+    if (!(ls >> idx)) return false;
+    st.files.erase(idx);
+  } else if (tag == "blob") {
+    BlobFileMeta b;
+    if (!(ls >> b.index >> b.bytes >> b.garbage)) return false;
+    st.blobs[b.index] = b;
+  } else if (tag == "dropblob") {
+    uint64_t idx = 0;
+    if (!(ls >> idx)) return false;
+    st.blobs.erase(idx);
+  } else {
+    return false;
+  }
+  return true;
+}
+
+bool read_manifest(const std::string& sst_dir, uint64_t& last_index, SstLevels& levels,
+                   std::vector<BlobFileMeta>* blobs, ManifestStatus* status) {
+  auto man = join_path(sst_dir, "MANIFEST");
+  int fd = ::open(man.c_str(), O_RDONLY);
+  if (fd < 0) return false;
+  std::string body;
+  char buf[64 * 1024];
+  while (true) {
+    ssize_t r = ::read(fd, buf, sizeof(buf));
+    if (r < 0 && errno == EINTR) continue;
+    if (r <= 0) break;
+    body.append(buf, static_cast<size_t>(r));
+  }
+  ::close(fd);
+
+  std::istringstream in(body);
+  std::string line;
+  if (!std::getline(in, line)) return false;
+  const bool v1 = line == kManifestHeaderV1;
+  if (!v1 && line != kManifestHeader) return false;
+
+  ManifestState st;
+  bool cut = false;
+  uint64_t edits = v1 ? 1 : 0;
+  if (v1) {
+    // снимок без commit
+    while (std::getline(in, line))
+      if (!line.empty() && !apply_line(sst_dir, line, st)) return false;
+  } else {
+    // строки копятся до commit; правка с неверной суммой или без commit — конец журнала
+    std::vector<std::string> pending;
+    std::string raw;
+    while (std::getline(in, line)) {
+      if (line.rfind("commit ", 0) == 0) {
+        const uint64_t want = std::strtoull(line.c_str() + 7, nullptr, 16);
+        if (want != static_cast<uint64_t>(XXH64(raw.data(), raw.size(), 0))) { cut = true; break; }
+        st.clean_next_blob = 0; // отметка закрытия действует до следующей правки
+        for (const auto& l : pending)
+          if (!apply_line(sst_dir, l, st)) return false;
+        pending.clear();
+        raw.clear();
+        ++edits;
+        continue;
+      }
+      pending.push_back(line);
+      raw += line + '\n';
+    }
+    if (edits == 0) return false; // нет даже снимка
+    cut = cut || !pending.empty() || (!body.empty() && body.back() != '\n');
+  }
+
+  SstLevels out;
+  for (auto& [idx, lf] : st.files) {
+    if (out.size() <= lf.first) out.resize(lf.first + 1);
+    out[lf.first].push_back(std::move(lf.second));
+  }
+  // L0 — по возрастанию индекса (уже так: map), L1+ — по smallest
+  for (size_t l = 1; l < out.size(); ++l)
+    std::sort(out[l].begin(), out[l].end(),
+              [](const SstFileMeta& a, const SstFileMeta& b) { return a.smallest < b.smallest; });
+  std::vector<BlobFileMeta> blob_out;
+  for (const auto& [idx, b] : st.blobs) blob_out.push_back(b);
+
+  last_index = st.last;
+  levels.swap(out);
+  if (blobs) blobs->swap(blob_out);
+  if (status) {
+    status->torn = v1 || cut;
+    status->clean = st.clean_next_blob != 0 && !cut;
+    status->next_blob = st.clean_next_blob;
+    status->edits = edits;
+  }
+  return true;
+}
+
+// ---- ManifestLog ----
+
+ManifestLog::~ManifestLog() {
+  if (fd_ >= 0) ::close(fd_);
+}
+
+bool ManifestLog::open(uint64_t edits) {
+  if (fd_ >= 0) ::close(fd_);
+  fd_ = ::open(join_path(dir_, "MANIFEST").c_str(), O_WRONLY | O_APPEND);
+  if (fd_ < 0) return false;
+  struct stat sb{};
+  bytes_ = ::fstat(fd_, &sb) == 0 ? static_cast<uint64_t>(sb.st_size) : 0;
+  edits_ = edits;
+  return true;
+}
+
+bool ManifestLog::rewrite(uint64_t last_index, const SstLevels& levels, const std::vector<BlobFileMeta>& blobs) {
+  if (!write_manifest_atomic(dir_, last_index, levels, blobs)) return false;
+  return open(1);
+}
+
+bool ManifestLog::append(const VersionEdit& edit) {
+  if (fd_ < 0) return false; // журнал не открыт или после сбоя: нужен rewrite
+  const std::string rec = encode_edit(edit);
+  if (!write_all(fd_, rec) || ::fdatasync(fd_) != 0) {
+    // недописанная правка отбросится при чтении, но дописывать за ней нельзя:
+    // дальше только rewrite
+    ::close(fd_);
+    fd_ = -1;
+    return false;
+  }
+  bytes_ += rec.size();
+  ++edits_;
+  return true;
+}
+
 } // namespace uringkv
@@ -0,0 +1,71 @@
+#include "sst/range_del.hpp"
+#include "util.hpp"
+
+#include <xxhash.h>
+
+#include <algorithm>
+#include <cstring>
+#include <unistd.h>
+
+namespace uringkv {
+
+uint64_t range_del_covering_seq(const std::vector<RangeTombstone>& rts, std::string_view key,
+                                uint64_t snapshot) {
+  uint64_t best = 0;
+  for (const auto& t : rts) {
+    if (t.start > key) break; // дальше только более правые
+    if (t.seqno <= snapshot && t.seqno > best && key < t.end) best = t.seqno;
+  }
+  return best;
+}
+
+std::string sst_encode_range_del_block(std::vector<RangeTombstone> rts) {
+  std::sort(rts.begin(), rts.end(), [](const RangeTombstone& a, const RangeTombstone& b) {
+    return a.start != b.start ? a.start < b.start : a.seqno > b.seqno;
+  });
+  std::string out;
+  const uint32_t n = static_cast<uint32_t>(rts.size());
+  out.append(reinterpret_cast<const char*>(&n), sizeof(n));
+  for (const auto& t : rts) {
+    put_varint32(out, static_cast<uint32_t>(t.start.size()));
+    out.append(t.start);
+    put_varint32(out, static_cast<uint32_t>(t.end.size()));
+    out.append(t.end);
+    out.append(reinterpret_cast<const char*>(&t.seqno), sizeof(t.seqno));
+  }
+  const uint64_t h = static_cast<uint64_t>(XXH64(out.data(), out.size(), 0));
+  out.append(reinterpret_cast<const char*>(&h), sizeof(h));
+  return out;
+}
+
+bool sst_read_range_del_block(int fd, uint64_t off, uint64_t size, std::vector<RangeTombstone>& out) {
+  out.clear();
+  if (size < sizeof(uint32_t) + sizeof(uint64_t) || size > 64ull * 1024 * 1024) return false;
+  std::string buf(size, '\0');
+  if (::pread(fd, buf.data(), buf.size(), static_cast<off_t>(off)) != static_cast<ssize_t>(buf.size()))
+    return false;
+  uint64_t h = 0;
+  std::memcpy(&h, buf.data() + size - sizeof(h), sizeof(h));
+  if (h != static_cast<uint64_t>(XXH64(buf.data(), size - sizeof(h), 0))) return false;
+
+  uint32_t n = 0;
+  std::memcpy(&n, buf.data(), sizeof(n));
+  const char* p = buf.data() + sizeof(n);
+  const char* limit = buf.data() + size - sizeof(h);
+  for (uint32_t i = 0; i < n; ++i) {
+    RangeTombstone t;
+    uint32_t len = 0;
+    if (!(p = get_varint32(p, limit, len)) || uint64_t(limit - p) < len) return false;
+    t.start.assign(p, len);
+    p += len;
+    if (!(p = get_varint32(p, limit, len)) || uint64_t(limit - p) < len + sizeof(t.seqno)) return false;
+    t.end.assign(p, len);
+    p += len;
+    std::memcpy(&t.seqno, p, sizeof(t.seqno));
+    p += sizeof(t.seqno);
+    out.push_back(std::move(t));
+  }
+  return p == limit;
+}
+
+} // namespace uringkv
@@ -17,7 +17,7 @@ namespace uringkv {
 
 SstReader::SstReader(const std::string& path) : path_(path) {
   fd_ = ::open(path_.c_str(), O_RDONLY);
-  if (fd_ >= 0) (void)load_footer_and_index();
+  if (fd_ >= 0) loaded_ = load_footer_and_index();
 }
 
 SstReader::~SstReader() {
@@ -28,19 +28,34 @@ SstReader::~SstReader() {
 bool SstReader::load_footer_and_index() {
   if (fd_ < 0) return false;
 
-  // read footer from end
-  off_t end = ::lseek(fd_, 0, SEEK_END);
-  if (end < (off_t)sizeof(SstFooter)) return false;
-  if (::lseek(fd_, end - (off_t)sizeof(SstFooter), SEEK_SET) < 0) return false;
-
   SstFooter f{};
-  if (::read(fd_, &f, sizeof(f)) != (ssize_t)sizeof(f)) return false;
-  if (std::memcmp(f.magic, kSstMagic, 7) != 0 || f.version != kSstVersion) return false;
+  SstFooterExt ext{};
+  if (!sst_read_footer(fd_, f, ext)) return false;
 
-  data_end_off_ = f.hash_index_offset;
+  version_      = f.version;
+  data_end_off_ = (f.version == kSstVersionV3) ? ext.data_end : f.hash_index_offset;
   sparse_off_   = f.sparse_offset;
   sparse_cnt_   = f.sparse_count;
 
+  if (f.version == kSstVersionV3 &&
+      !sst_load_block_index(fd_, f.sparse_offset, ext.index_size, f.sparse_count, blocks_)) {
+    data_end_off_ = 0; // без индекса блоки не найти — ведём себя как пустая таблица
+    return false;
+  }
+  if (f.version == kSstVersionV3 && ext.reserved[3] > 0 &&
+      !(dict_ = sst_read_dict_block(fd_, ext.reserved[2], ext.reserved[3]))) {
+    data_end_off_ = 0; // блоки со словарём без него не распаковать
+    blocks_.clear();
+    return false;
+  }
+
+  if (f.version == kSstVersionV3 && ext.reserved[5] > 0 &&
+      !sst_read_range_del_block(fd_, ext.reserved[4], ext.reserved[5], range_dels_)) {
+    data_end_off_ = 0; // без tombstone'ов данные таблицы выдавать нельзя
+    blocks_.clear();
+    return false;
+  }
+
   // mmap hash-index block (header + table)
   (void)index_.open(fd_, f.hash_index_offset, f.hash_table_size);
   return true;
@@ -70,8 +85,12 @@ bool SstReader::read_record_at(uint64_t off, SstRecordMeta& m, std::string& k, s
 std::optional<std::pair<uint32_t, std::string>> SstReader::get(std::string_view key) {
   if (fd_ < 0) return std::nullopt;
 
-  // 1) fast path via hash index if available
-  if (index_.good()) {
+  if (version_ == kSstVersionV3) {
+    return sst_v3_point_lookup(fd_, blocks_, &index_, key, nullptr, 0, UINT64_MAX, dict_.get());
+  }
+
+  // 1) fast path via hash index if available (v2 SST: индекс v1)
+  if (index_.good() && index_.table()) {
     const uint64_t h0 = sst_key_hash(key.data(), key.size());
     const uint64_t h  = (h0 == 0) ? 1 : h0;
     const uint64_t n = index_.table_size();
@@ -123,14 +142,9 @@ bool SstReader::load_sparse_into(std::vector<std::pair<std::string,uint64_t>>& o
 
   // SparseIndexHeader {magic,version,count} already known via footer; skip struct and read entries directly.
   // But for robustness, read and validate header again.
-  struct SparseIndexHeader {
-    uint32_t magic;
-    uint32_t version;
-    uint32_t count;
-  } sh{};
-
+  SparseIndexHeader sh{};
   if (::read(fd_, &sh, sizeof(sh)) != (ssize_t)sizeof(sh)) return false;
-  if (sh.count != sparse_cnt_ || sh.magic != 0x53494458u || sh.version != 1u) return false;
+  if (sh.count != sparse_cnt_ || sh.magic != kSparseMagic || sh.version != kSparseVersion) return false;
 
   out.reserve(sh.count);
   for (uint32_t i=0; i<sh.count; ++i) {
@@ -144,6 +158,19 @@ bool SstReader::load_sparse_into(std::vector<std::pair<std::string,uint64_t>>& o
   return true;
 }
 
+std::vector<std::string> SstReader::boundary_keys() const {
+  std::vector<std::string> out;
+  if (version_ == kSstVersionV3) {
+    out.reserve(blocks_.size());
+    for (const auto& b : blocks_) out.push_back(b.first_key);
+    return out;
+  }
+  std::vector<std::pair<std::string, uint64_t>> sparse;
+  if (load_sparse_into(sparse))
+    for (auto& e : sparse) out.push_back(std::move(e.first));
+  return out;
+}
+
 uint64_t SstReader::find_scan_start_offset(std::string_view start) const {
   if (start.empty()) return 0;
 
@@ -166,26 +193,103 @@ SstReader::scan(std::string_view start, std::string_view end) {
   std::vector<std::pair<std::string,std::optional<std::string>>> out;
   if (fd_ < 0) return out;
 
-  uint64_t off = find_scan_start_offset(start);
+  Iterator it(this);
+  if (start.empty()) it.seek_to_first();
+  else it.seek(start);
+
+  for (; it.valid(); it.next()) {
+    if (!end.empty() && it.key() > end) break;
+    if (!out.empty() && it.key() == out.back().first) continue; // старая версия
+    if (it.flags() == SST_FLAG_PUT) {
+      out.emplace_back(std::string(it.key()), std::optional<std::string>(std::string(it.value())));
+    } else if (it.flags() == SST_FLAG_DEL) {
+      out.emplace_back(std::string(it.key()), std::nullopt);
+    }
+  }
+  // уже упорядочено по ключу в пределах SST
+  return out;
+}
 
-  while (off < data_end_off_) {
-    SstRecordMeta m{}; std::string k; std::string v;
-    if (!read_record_at(off, m, k, v)) break; // stop on torn tail
-    const uint64_t used   = sizeof(SstRecordMeta) + m.klen + m.vlen + sizeof(SstRecordTrailer);
-    const uint64_t padded = (used + (SST_BLOCK_SIZE - 1)) & ~(SST_BLOCK_SIZE - 1);
-    off += padded;
+// ---- Iterator ----
+
+void SstReader::Iterator::seek_to_first() {
+  valid_ = false;
+  corrupted_ = false;
+  if (r_->fd_ < 0) return;
+  if (r_->version_ == kSstVersionV3) {
+    load_block(0, {});
+  } else {
+    off_ = 0;
+    read_v2();
+  }
+}
 
-    if ((!start.empty() && k < start)) continue;
-    if ((!end.empty()   && k > end))   break;
+void SstReader::Iterator::seek(std::string_view target) {
+  valid_ = false;
+  corrupted_ = false;
+  if (r_->fd_ < 0) return;
+  if (r_->version_ == kSstVersionV3) {
+    const long bi = target.empty() ? 0 : sst_find_block(r_->blocks_, target);
+    load_block(bi < 0 ? 0 : static_cast<size_t>(bi), target);
+    return;
+  }
+  // v2: от ближайшей точки sparse-индекса вперёд по записям
+  off_ = r_->find_scan_start_offset(target);
+  read_v2();
+  while (valid_ && std::string_view(key_) < target) next();
+}
 
-    if (m.flags == SST_FLAG_PUT) {
-      out.emplace_back(std::move(k), std::optional<std::string>(std::move(v)));
-    } else if (m.flags == SST_FLAG_DEL) {
-      out.emplace_back(std::move(k), std::nullopt);
+void SstReader::Iterator::next() {
+  if (!valid_) return;
+  if (r_->version_ == kSstVersionV3) {
+    it_.next();
+    if (it_.valid()) return;
+    if (it_.corrupted()) { valid_ = false; corrupted_ = true; return; }
+    load_block(block_ + 1, {});
+  } else {
+    read_v2();
+  }
+}
+
+void SstReader::Iterator::load_block(size_t i, std::string_view target) {
+  valid_ = false;
+  for (block_ = i; block_ < r_->blocks_.size(); ++block_) {
+    if (!sst_read_block(r_->fd_, r_->blocks_[block_].handle, buf_, r_->dict_.get()) ||
+        !it_.init(buf_, /*verify_checksum=*/false)) {
+      corrupted_ = true;
+      return;
     }
+    if (!target.empty() && block_ == i) it_.seek(target);
+    else it_.seek_to_first();
+    if (it_.valid()) { valid_ = true; return; }
+    if (it_.corrupted()) { corrupted_ = true; return; }
   }
-  // уже упорядочено по ключу в пределах SST
-  return out;
+}
+
+void SstReader::Iterator::read_v2() {
+  valid_ = false;
+  if (off_ >= r_->data_end_off_) return;
+  // запись до конца данных не читается — файл испорчен
+  if (!r_->read_record_at(off_, meta_, key_, value_)) { corrupted_ = true; return; }
+  const uint64_t used   = sizeof(SstRecordMeta) + meta_.klen + meta_.vlen + sizeof(SstRecordTrailer);
+  off_ += (used + (SST_BLOCK_SIZE - 1)) & ~(SST_BLOCK_SIZE - 1);
+  valid_ = true;
+}
+
+std::string_view SstReader::Iterator::key() const {
+  return r_->version_ == kSstVersionV3 ? it_.key() : std::string_view(key_);
+}
+
+std::string_view SstReader::Iterator::value() const {
+  return r_->version_ == kSstVersionV3 ? it_.value() : std::string_view(value_);
+}
+
+uint32_t SstReader::Iterator::flags() const {
+  return r_->version_ == kSstVersionV3 ? it_.flags() : meta_.flags;
+}
+
+uint64_t SstReader::Iterator::seqno() const {
+  return r_->version_ == kSstVersionV3 ? it_.seqno() : 0;
 }
 
 } // namespace uringkv
@@ -1,11 +1,14 @@
 // source/sst/table.cpp
 #include "sst/table.hpp"
+#include "cache/block_cache.hpp"
+#include "perf_context.hpp"
 #include "util.hpp"
 #include "sst/index.hpp"
 #include "sst/footer.hpp"
 
 #include <algorithm>
 #include <cstring>
+#include <iterator>
 #include <fcntl.h>
 #include <sys/stat.h>
 #include <sys/mman.h>
@@ -13,7 +16,8 @@
 
 namespace uringkv {
 
-SstTable::SstTable(std::string path) : path_(std::move(path)) {
+SstTable::SstTable(std::string path, BlockCache* cache, uint64_t file_id)
+    : path_(std::move(path)), cache_(cache), file_id_(file_id) {
   fd_ = ::open(path_.c_str(), O_RDONLY);
   if (fd_ >= 0) (void)load_footer_and_index();
 }
@@ -26,34 +30,154 @@ SstTable::~SstTable() {
 bool SstTable::load_footer_and_index() {
   if (fd_ < 0) return false;
 
-  off_t end = ::lseek(fd_, 0, SEEK_END);
-  if (end < (off_t)sizeof(SstFooter)) return false;
-  if (::lseek(fd_, end - (off_t)sizeof(SstFooter), SEEK_SET) < 0) return false;
+  if (!sst_read_footer(fd_, footer_, ext_)) {
+    // неизвестный формат/битый футер — таблица непригодна
+    ::close(fd_);
+    fd_ = -1;
+    return false;
+  }
+
+  if (footer_.version == kSstVersionV3 &&
+      !sst_load_block_index(fd_, footer_.sparse_offset, ext_.index_size, footer_.sparse_count, blocks_)) {
+    ::close(fd_);
+    fd_ = -1;
+    return false;
+  }
+
+  // словарь обязателен, если записан: без него блоки не распаковать
+  if (footer_.version == kSstVersionV3 && ext_.reserved[3] > 0 &&
+      !(dict_ = sst_read_dict_block(fd_, ext_.reserved[2], ext_.reserved[3]))) {
+    ::close(fd_);
+    fd_ = -1;
+    return false;
+  }
+
+  // range tombstone'ы тоже обязательны: без них удалённые ключи ожили бы
+  if (footer_.version == kSstVersionV3 && ext_.reserved[5] > 0 &&
+      !sst_read_range_del_block(fd_, ext_.reserved[4], ext_.reserved[5], range_dels_)) {
+    ::close(fd_);
+    fd_ = -1;
+    return false;
+  }
 
-  SstFooter f{};
-  if (::read(fd_, &f, sizeof(f)) != (ssize_t)sizeof(f)) return false;
-  if (std::memcmp(f.magic, kSstMagic, 7) != 0 || f.version != kSstVersion) return false;
+  // фильтр необязателен: без него (или если битый) get() просто идёт в индекс
+  if (footer_.version == kSstVersionV3 && ext_.reserved[1] > 0 &&
+      ext_.reserved[1] <= 64ull * 1024 * 1024) {
+    std::string buf(ext_.reserved[1], '\0');
+    if (::pread(fd_, buf.data(), buf.size(), (off_t)ext_.reserved[0]) == (ssize_t)buf.size())
+      (void)filter_.init(buf);
+  }
+
+  // v2: разрежённый индекс для seek итераторов; без него итерация идёт с начала
+  if (footer_.version != kSstVersionV3) (void)load_sparse_index();
 
   // Try to mmap the hash index; fallback path in get() works even if it fails
-  (void)index_.open(fd_, f.hash_index_offset, f.hash_table_size);
+  (void)index_.open(fd_, footer_.hash_index_offset, footer_.hash_table_size);
   return true;
 }
 
-bool SstTable::read_record_at(uint64_t off, SstRecordMeta& m, std::string& k, std::string& v) const {
-  if (::lseek(fd_, (off_t)off, SEEK_SET) < 0) return false;
-  if (::read(fd_, &m, sizeof(m)) != (ssize_t)sizeof(m)) return false;
-  k.resize(m.klen); v.resize(m.vlen);
-  if (m.klen && ::read(fd_, k.data(), m.klen) != (ssize_t)m.klen) return false;
-  if (m.vlen && ::read(fd_, v.data(), m.vlen) != (ssize_t)m.vlen) return false;
+// v2: SparseIndexHeader и count записей {u32 klen, u64 off, key} до футера
+bool SstTable::load_sparse_index() {
+  struct stat st{};
+  if (footer_.sparse_offset == 0 || footer_.sparse_count == 0 || ::fstat(fd_, &st) != 0 ||
+      uint64_t(st.st_size) <= footer_.sparse_offset)
+    return false;
+  std::string buf(uint64_t(st.st_size) - footer_.sparse_offset, '\0');
+  if (::pread(fd_, buf.data(), buf.size(), (off_t)footer_.sparse_offset) != (ssize_t)buf.size()) return false;
+  SparseIndexHeader sh{};
+  if (buf.size() < sizeof(sh)) return false;
+  std::memcpy(&sh, buf.data(), sizeof(sh));
+  if (sh.magic != kSparseMagic || sh.version != kSparseVersion || sh.count != footer_.sparse_count) return false;
+  std::size_t p = sizeof(sh);
+  sparse_.reserve(sh.count);
+  for (uint32_t i = 0; i < sh.count; ++i) {
+    uint32_t klen = 0;
+    uint64_t off = 0;
+    if (buf.size() - p < sizeof(klen) + sizeof(off)) break;
+    std::memcpy(&klen, buf.data() + p, sizeof(klen));
+    std::memcpy(&off, buf.data() + p + sizeof(klen), sizeof(off));
+    p += sizeof(klen) + sizeof(off);
+    if (buf.size() - p < klen) break;
+    sparse_.emplace_back(buf.substr(p, klen), off);
+    p += klen;
+  }
+  if (sparse_.size() != sh.count) sparse_.clear();
+  return !sparse_.empty();
+}
+
+std::size_t SstTable::metadata_bytes() const {
+  std::size_t n = sizeof(*this) + path_.capacity() + filter_.memory_usage();
+  n += blocks_.capacity() * sizeof(SstIndexEntry);
+  for (const auto& e : blocks_) n += e.first_key.capacity();
+  for (const auto& t : range_dels_) n += sizeof(t) + t.start.capacity() + t.end.capacity();
+  n += sparse_.capacity() * sizeof(sparse_[0]);
+  for (const auto& e : sparse_) n += e.first.capacity();
+  if (dict_) n += dict_->raw().size();
+  return n;
+}
+
+// В кэше запись v2 хранится как meta | key | value.
+static bool decode_cached_record(std::string_view rec, SstRecordMeta& m, std::string_view& k,
+                                 std::string_view& v) {
+  if (rec.size() < sizeof(m)) return false;
+  std::memcpy(&m, rec.data(), sizeof(m));
+  if (rec.size() != sizeof(m) + uint64_t(m.klen) + m.vlen) return false;
+  k = rec.substr(sizeof(m), m.klen);
+  v = rec.substr(sizeof(m) + m.klen, m.vlen);
   return true;
 }
 
-std::optional<std::pair<uint32_t, std::string>> SstTable::get(std::string_view key) const {
-  if (fd_ < 0) return std::nullopt;
+bool SstTable::read_record_at(uint64_t off, SstRecordMeta& m, std::string_view& k, std::string_view& v,
+                              SstValueRef& rec) const {
+  rec.hold.reset();
+  if (cache_) {
+    if ((rec.hold = cache_->lookup(file_id_, off))) {
+      perf_count(&PerfContext::block_cache_hit_count);
+      return decode_cached_record(*rec.hold, m, k, v);
+    }
+  }
+  // pread: meta, затем key+value одним вызовом
+  if (::pread(fd_, &m, sizeof(m), (off_t)off) != (ssize_t)sizeof(m)) return false;
+  const size_t kv_len = size_t(m.klen) + m.vlen;
+  std::string& buf = rec.buf;
+  buf.resize(sizeof(m) + kv_len);
+  std::memcpy(buf.data(), &m, sizeof(m));
+  if (kv_len && ::pread(fd_, buf.data() + sizeof(m), kv_len, (off_t)(off + sizeof(m))) != (ssize_t)kv_len)
+    return false;
+  perf_count(&PerfContext::block_read_count);
+  perf_count(&PerfContext::block_read_bytes, buf.size());
+  if (cache_) rec.hold = cache_->insert(file_id_, off, std::move(buf));
+  return decode_cached_record(rec.hold ? std::string_view(*rec.hold) : std::string_view(buf), m, k, v);
+}
+
+std::optional<std::pair<uint32_t, std::string>> SstTable::get(std::string_view key,
+                                                              uint64_t snapshot, uint64_t* seqno) const {
+  SstValueRef ref;
+  if (!get(key, ref, snapshot, seqno)) return std::nullopt;
+  PerfTimer pt(&PerfContext::record_read_ns); // копия значения
+  return std::pair<uint32_t, std::string>(ref.flags, std::string(ref.value));
+}
+
+bool SstTable::get(std::string_view key, SstValueRef& out, uint64_t snapshot, uint64_t* seqno) const {
+  if (seqno) *seqno = 0;
+  if (fd_ < 0) return false;
+
+  if (footer_.version == kSstVersionV3)
+    return sst_v3_point_lookup(fd_, blocks_, &index_, key, out, cache_, file_id_, snapshot, dict_.get(), seqno);
 
-  // 1) Fast path via mmap’ed hash index
-  if (index_.good()) {
-    const uint64_t h = sst_key_hash(key.data(), key.size());
+  // у записей v2 нет блоков: вся точечная выборка — чтение записи
+  PerfTimer pt(&PerfContext::record_read_ns);
+  auto found = [&](const SstRecordMeta& m, std::string_view k, std::string_view v) {
+    if (m.checksum != dummy_checksum(k, v)) return false;
+    out.flags = m.flags == SST_FLAG_DEL ? SST_FLAG_DEL : SST_FLAG_PUT;
+    out.value = m.flags == SST_FLAG_DEL ? std::string_view{} : v;
+    return true;
+  };
+
+  // 1) Fast path via mmap’ed hash index (v2 SST пишет только индекс v1)
+  if (index_.good() && index_.table()) {
+    uint64_t h = sst_key_hash(key.data(), key.size());
+    if (h == 0) h = 1; // 0 зарезервирован под пустой слот
     const uint64_t n = index_.table_size();
     const auto*    T = index_.table();
     const uint64_t mask = n - 1;
@@ -63,41 +187,183 @@ std::optional<std::pair<uint32_t, std::string>> SstTable::get(std::string_view k
       const auto& e = T[pos];
       if (e.h == 0) break; // empty slot => not found
       if (e.h == h) {
-        SstRecordMeta m{}; std::string k; std::string v;
-        if (!read_record_at(e.off, m, k, v)) return std::nullopt;
-        if (k == key) {
-          if (m.checksum != dummy_checksum(k, v)) return std::nullopt;
-          if (m.flags == SST_FLAG_DEL) return std::make_pair(SST_FLAG_DEL, std::string{});
-          return std::make_pair(SST_FLAG_PUT, std::move(v));
-        }
+        SstRecordMeta m{}; std::string_view k, v;
+        if (!read_record_at(e.off, m, k, v, out)) return false;
+        if (k == key) return found(m, k, v);
       }
       pos = (pos + 1) & mask;
     }
-    return std::nullopt;
+    return false;
   }
 
   // 2) Fallback: linear pass up to hash_index_offset (data section end)
-  off_t end = ::lseek(fd_, 0, SEEK_END);
-  if (end < (off_t)sizeof(SstFooter)) return std::nullopt;
-  if (::lseek(fd_, end - (off_t)sizeof(SstFooter), SEEK_SET) < 0) return std::nullopt;
+  uint64_t off = 0;
+  while (off < footer_.hash_index_offset) {
+    SstRecordMeta m{}; std::string_view k, v;
+    if (!read_record_at(off, m, k, v, out)) break;
+    const uint64_t used = sizeof(m) + m.klen + m.vlen + sizeof(SstRecordTrailer);
+    off += (used + (SST_BLOCK_SIZE - 1)) & ~(SST_BLOCK_SIZE - 1); // записи v2 выровнены на 4 KiB
 
-  SstFooter f{};
-  if (::read(fd_, &f, sizeof(f)) != (ssize_t)sizeof(f)) return std::nullopt;
+    if (k == key) return found(m, k, v);
+    if (k > key) break;
+  }
+  return false;
+}
 
-  uint64_t off = 0;
-  while (off < f.hash_index_offset) {
-    SstRecordMeta m{}; std::string k; std::string v;
-    if (!read_record_at(off, m, k, v)) break;
-    off += sizeof(m) + m.klen + m.vlen; // trailer/padding is only validated in SstReader
-
-    if (k == key) {
-      if (m.checksum != dummy_checksum(k, v)) return std::nullopt;
-      if (m.flags == SST_FLAG_DEL) return std::make_pair(SST_FLAG_DEL, std::string{});
-      return std::make_pair(SST_FLAG_PUT, std::move(v));
+bool SstTable::prepare_get(std::string_view key, PendingRead& rd,
+                           std::optional<std::pair<uint32_t, std::string>>& out) const {
+  out.reset();
+  if (fd_ < 0) return true;
+
+  if (footer_.version == kSstVersionV3) {
+    SstBlockHandle bh{};
+    if (!sst_v3_locate(blocks_, &index_, key, bh, rd.packed))
+      return true;
+    rd.offset = bh.offset;
+    rd.size = bh.size;
+  } else {
+    // v2: без хеш-индекса — синхронный линейный проход
+    if (!index_.good() || !index_.table()) {
+      out = get(key, rd.snapshot);
+      return true;
+    }
+    uint64_t h = sst_key_hash(key.data(), key.size());
+    if (h == 0) h = 1;
+    const uint64_t n = index_.table_size();
+    const auto* T = index_.table();
+    uint64_t pos = h & (n - 1), step = 0;
+    for (; step < n && T[pos].h != 0 && T[pos].h != h; ++step) pos = (pos + 1) & (n - 1);
+    if (step == n || T[pos].h == 0) return true;
+    // запись выровнена на 4 KiB: обычно целиком помещается в одну страницу
+    rd.offset = T[pos].off;
+    rd.size = static_cast<uint32_t>(
+        std::min<uint64_t>(SST_BLOCK_SIZE, footer_.hash_index_offset - rd.offset));
+  }
+
+  if (cache_) {
+    if (auto hit = cache_->lookup(file_id_, rd.offset)) {
+      out = decode_read(key, rd, *hit, /*from_cache=*/true);
+      return true;
     }
-    if (k > key) break;
   }
-  return std::nullopt;
+  return false;
+}
+
+std::optional<std::pair<uint32_t, std::string>>
+SstTable::finish_get(std::string_view key, const PendingRead& rd, std::string_view data) const {
+  return decode_read(key, rd, data, /*from_cache=*/false);
+}
+
+// data — блок v3 целиком, либо для v2 начало записи (из кэша — ровно запись).
+// Прочитанное с диска проверяется (блок v3 ещё и распаковывается) и кладётся в BlockCache.
+std::optional<std::pair<uint32_t, std::string>>
+SstTable::decode_read(std::string_view key, const PendingRead& rd, std::string_view data,
+                      bool from_cache) const {
+  if (footer_.version == kSstVersionV3) {
+    std::string unpacked;
+    BlockCache::Handle hold;
+    if (!from_cache) {
+      if (data.size() != rd.size || !sst_unpack_block(data, unpacked, dict_.get())) return std::nullopt;
+      if (!unpacked.empty()) data = unpacked;
+      if (cache_) {
+        hold = cache_->insert(file_id_, rd.offset, unpacked.empty() ? std::string(data) : std::move(unpacked));
+        data = *hold;
+      }
+    }
+    SstBlockIter it;
+    if (!it.init(data, /*verify_checksum=*/false)) return std::nullopt;
+    if (rd.packed != UINT64_MAX) {
+      if (!it.seek_to_offset(sst_record_in_block_off(rd.packed)) || it.key() != key)
+        return get(key, rd.snapshot); // коллизия хеша — полный поиск
+    } else {
+      it.seek(key);
+      // блок из хеш-индекса v2 — лишь первый кандидат по tag'у
+      if (!it.valid() || it.key() != key) return index_.good() ? get(key, rd.snapshot) : std::nullopt;
+    }
+    // версии ключа лежат в одном блоке, от новых к старым
+    while (it.valid() && it.key() == key && it.seqno() > rd.snapshot) it.next();
+    if (!it.valid() || it.key() != key) return std::nullopt;
+    if (it.flags() == SST_FLAG_DEL) return std::make_pair(SST_FLAG_DEL, std::string{});
+    if (it.flags() == SST_FLAG_BLOB) return std::make_pair(SST_FLAG_BLOB, std::string(it.value()));
+    return std::make_pair(SST_FLAG_PUT, std::string(it.value()));
+  }
+
+  SstRecordMeta m{};
+  if (data.size() < sizeof(m)) return get(key, rd.snapshot);
+  std::memcpy(&m, data.data(), sizeof(m));
+  const uint64_t rec_len = sizeof(m) + uint64_t(m.klen) + m.vlen;
+  if (rec_len > data.size()) return get(key, rd.snapshot); // длинная запись — дочитать обычным путём
+  std::string k(data.substr(sizeof(m), m.klen));
+  if (k != key) return get(key, rd.snapshot);
+  std::string v(data.substr(sizeof(m) + m.klen, m.vlen));
+  if (m.checksum != dummy_checksum(k, v)) return std::nullopt;
+  if (!from_cache && cache_) (void)cache_->insert(file_id_, rd.offset, std::string(data.substr(0, rec_len)));
+  if (m.flags == SST_FLAG_DEL) return std::make_pair(SST_FLAG_DEL, std::string{});
+  return std::make_pair(SST_FLAG_PUT, std::move(v));
+}
+
+// ---- Iterator ----
+
+void SstTable::Iterator::seek_to_first() {
+  valid_ = false;
+  if (!t_->good()) return;
+  if (t_->footer_.version == kSstVersionV3) {
+    load_block(0, {});
+  } else {
+    off_ = 0;
+    read_v2();
+  }
+}
+
+void SstTable::Iterator::seek(std::string_view target) {
+  valid_ = false;
+  if (!t_->good()) return;
+  if (t_->footer_.version == kSstVersionV3) {
+    const long bi = target.empty() ? 0 : sst_find_block(t_->blocks_, target);
+    load_block(bi < 0 ? 0 : static_cast<size_t>(bi), target);
+    return;
+  }
+  // v2: от ближайшей точки разрежённого индекса (ключ <= target) вперёд по записям
+  const auto& sp = t_->sparse_;
+  auto it = std::upper_bound(sp.begin(), sp.end(), target,
+                             [](std::string_view k, const auto& e) { return k < e.first; });
+  off_ = it == sp.begin() ? 0 : std::prev(it)->second;
+  read_v2();
+  while (valid_ && key_ < target) next();
+}
+
+void SstTable::Iterator::next() {
+  if (!valid_) return;
+  if (t_->footer_.version == kSstVersionV3) {
+    it_.next();
+    if (it_.valid()) return;
+    if (it_.corrupted()) { valid_ = false; return; }
+    load_block(block_ + 1, {});
+  } else {
+    read_v2();
+  }
+}
+
+void SstTable::Iterator::load_block(size_t i, std::string_view target) {
+  valid_ = false;
+  for (block_ = i; block_ < t_->blocks_.size(); ++block_) {
+    if (!sst_load_block(t_->fd_, t_->blocks_[block_].handle, t_->cache_, t_->file_id_, t_->dict_.get(),
+                        blk_.hold, blk_.buf, it_))
+      return;
+    if (!target.empty() && block_ == i) it_.seek(target);
+    else it_.seek_to_first();
+    if (it_.valid()) { valid_ = true; return; }
+    if (it_.corrupted()) return;
+  }
+}
+
+void SstTable::Iterator::read_v2() {
+  valid_ = false;
+  if (off_ >= t_->footer_.hash_index_offset) return;
+  if (!t_->read_record_at(off_, meta_, key_, value_, blk_)) return; // torn tail -> конец
+  const uint64_t used = sizeof(SstRecordMeta) + meta_.klen + meta_.vlen + sizeof(SstRecordTrailer);
+  off_ += (used + (SST_BLOCK_SIZE - 1)) & ~(SST_BLOCK_SIZE - 1);
+  valid_ = true;
 }
 
 } // namespace uringkv
@@ -1,5 +1,6 @@
 // source/sst/writer.cpp
 #include "sst/writer.hpp"
+#include "sst/filter.hpp"
 #include "sst/footer.hpp"
 #include "sst/record.hpp"
 #include "sst/index.hpp"
@@ -17,7 +18,14 @@
 
 namespace uringkv {
 
-SstWriter::SstWriter(const std::string& path) : path_(path) {
+SstWriter::SstWriter(const std::string& path, SstWriterOptions opts)
+    : path_(path), opts_(opts), block_(opts.restart_interval) {
+  if (opts_.block_size == 0 || opts_.block_size > SST_MAX_BLOCK_SIZE) opts_.block_size = 4096;
+  if (!sst_compression_supported(opts_.compression)) opts_.compression = SstCompression::NONE;
+  if (opts_.format_version != kSstVersionV2 && opts_.compression != SstCompression::NONE) {
+    compressor_ = std::make_unique<SstCompressor>(opts_.compression, opts_.compression_level);
+    dict_pending_ = opts_.compression == SstCompression::ZSTD && opts_.zstd_dict_bytes > 0;
+  }
   fd_ = ::open(path_.c_str(), O_CREAT | O_TRUNC | O_WRONLY, 0644);
   if (fd_ < 0) {
     spdlog::error("SST open failed: {} (errno={})", path_, errno);
@@ -56,21 +64,298 @@ static inline uint64_t roundup_4k(uint64_t n) {
   return rem ? (n + (SST_BLOCK_SIZE - rem)) : n;
 }
 
-// ---- Sparse index on-disk structures (ordered, for fast scan) ----
-struct SparseIndexHeader {
-  uint32_t magic;   // 'SIDX' = 0x53494458
-  uint32_t version; // 1
-  uint32_t count;   // number of entries
-};
-static constexpr uint32_t kSparseMagic   = 0x53494458u; // 'SIDX'
-static constexpr uint32_t kSparseVersion = 1u;
+// Открытая адресация, LF <= 0.5; hash == 0 зарезервирован под пустой слот.
+static std::vector<HashIndexEntry> build_hash_table(const std::vector<HashIndexEntry>& items) {
+  const uint64_t table_size = next_pow2(std::max<uint64_t>(1, items.size() * 2));
+  std::vector<HashIndexEntry> table(table_size, HashIndexEntry{0, 0});
+  const uint64_t mask = table_size - 1;
+  for (const auto& it : items) {
+    uint64_t pos = it.h & mask;
+    for (uint64_t step = 0; step < table_size; ++step) {
+      if (table[pos].h == 0) {
+        table[pos] = it;
+        break;
+      }
+      pos = (pos + 1) & mask;
+    }
+  }
+  return table;
+}
 
 bool SstWriter::write_sorted(
     const std::vector<std::pair<std::string, std::optional<std::string>>>& entries,
     uint32_t index_step)
 {
   if (fd_ < 0) return false;
+  if (opts_.format_version == kSstVersionV2) return write_sorted_v2(entries, index_step);
+
+  for (size_t i = 1; i < entries.size(); ++i) {
+    if (entries[i-1].first >= entries[i].first) {
+      spdlog::error("SST entries not strictly sorted: {}", path_);
+      return false;
+    }
+  }
+  for (const auto& kv : entries) {
+    const bool is_put = kv.second.has_value();
+    if (!add(kv.first, is_put ? SST_FLAG_PUT : SST_FLAG_DEL,
+             is_put ? std::string_view(*kv.second) : std::string_view()))
+      return false;
+  }
+  return finish();
+}
+
+// ---------------- v3: блоки ----------------
+
+bool SstWriter::append_out(std::string_view data) {
+  wbuf_.append(data.data(), data.size());
+  if (wbuf_.size() >= 256 * 1024) return flush_out();
+  return true;
+}
+
+bool SstWriter::flush_out() {
+  if (opts_.rate_limiter && !wbuf_.empty()) opts_.rate_limiter->request(wbuf_.size(), opts_.io_priority);
+  const char* ptr = wbuf_.data();
+  size_t left = wbuf_.size();
+  while (left > 0) {
+    ssize_t w = ::write(fd_, ptr, left);
+    if (w < 0) {
+      if (errno == EINTR) continue;
+      spdlog::error("SST write failed (errno={}): {}", errno, path_);
+      failed_ = true;
+      return false;
+    }
+    ptr  += w;
+    left -= static_cast<size_t>(w);
+    file_off_ += static_cast<uint64_t>(w);
+  }
+  wbuf_.clear();
+  return true;
+}
+
+bool SstWriter::flush_block() {
+  if (block_.empty()) return true;
+  std::string_view data = block_.finish();
+  // handle заполнит emit_block: размер известен только после сжатия
+  index_.push_back(SstIndexEntry{std::move(block_first_key_), SstBlockHandle{}});
+  block_first_key_.clear();
+  bool ok = true;
+  if (dict_pending_) {
+    // образцов для словаря ~ в 100 раз больше его размера (рекомендация zstd)
+    pending_blocks_.emplace_back(data);
+    pending_bytes_ += data.size();
+    if (pending_bytes_ >= uint64_t(opts_.zstd_dict_bytes) * 100) ok = train_dict_and_emit();
+  } else {
+    ok = emit_block(data);
+  }
+  block_.reset();
+  return ok;
+}
+
+bool SstWriter::emit_block(std::string_view block) {
+  std::string_view out = block;
+  if (compressor_ && sst_compress_block(block, *compressor_, dict_.get(), cbuf_)) out = cbuf_;
+  raw_block_bytes_ += block.size();
+  stored_block_bytes_ += out.size();
+  index_[emitted_blocks_++].handle =
+      SstBlockHandle{file_off_ + wbuf_.size(), static_cast<uint32_t>(out.size())};
+  return append_out(out);
+}
+
+bool SstWriter::train_dict_and_emit() {
+  dict_pending_ = false;
+  std::string samples;
+  std::vector<std::size_t> sizes;
+  samples.reserve(pending_bytes_);
+  for (const auto& b : pending_blocks_) {
+    const std::size_t n = b.size() - sizeof(SstBlockTrailer);
+    samples.append(b.data(), n);
+    sizes.push_back(n);
+  }
+  std::string raw = sst_train_zstd_dict(samples, sizes, opts_.zstd_dict_bytes);
+  if (!raw.empty()) {
+    dict_ = std::make_unique<SstCompressionDict>(std::move(raw));
+    if (!dict_->good() || !dict_->prepare_compress(opts_.compression_level)) dict_.reset();
+  }
+
+  auto blocks = std::move(pending_blocks_);
+  pending_blocks_.clear();
+  pending_bytes_ = 0;
+  for (const auto& b : blocks)
+    if (!emit_block(b)) return false;
+  return true;
+}
+
+bool SstWriter::add(std::string_view key, uint32_t flags, std::string_view value, uint64_t seqno) {
+  if (fd_ < 0 || failed_ || finished_) return false;
+  const bool same_key = num_entries_ > 0 && key == last_key_;
+  if (!same_key) last_key_.assign(key.data(), key.size());
+
+  if (opts_.format_version == kSstVersionV2) {
+    if (same_key) return true; // старые версии в v2 не хранятся
+    // v2 пишется целиком в finish(): копим записи (память ~ размер таблицы)
+    const bool is_put = flags != SST_FLAG_DEL;
+    v2_pending_.emplace_back(std::string(key),
+                             is_put ? std::optional<std::string>(std::string(value)) : std::nullopt);
+    v2_bytes_ += roundup_4k(sizeof(SstRecordMeta) + key.size() + (is_put ? value.size() : 0) +
+                            sizeof(SstRecordTrailer));
+    ++num_entries_;
+    return true;
+  }
+
+  // новый ключ начинает новый блок, если текущий уже набран
+  if (!same_key && !block_.empty() && block_.size_estimate() >= opts_.block_size) {
+    if (!flush_block()) return false;
+  }
+  if (block_.empty()) block_first_key_.assign(key.data(), key.size());
+
+  if (!same_key) {
+    uint64_t h = sst_key_hash(key.data(), key.size());
+    if (h == 0) h = 1; // reserve 0 for "empty"
+    hashes_.push_back(HashIndexEntry{h, sst_pack_record_off(index_.size(), block_.next_offset())});
+  }
+
+  block_.add(key, flags, value, seqno);
+  ++num_entries_;
+  return true;
+}
+
+bool SstWriter::add_range_tombstone(std::string_view start, std::string_view end, uint64_t seqno) {
+  if (fd_ < 0 || failed_ || finished_ || opts_.format_version == kSstVersionV2) return false;
+  range_dels_.push_back(RangeTombstone{std::string(start), std::string(end), seqno});
+  return true;
+}
+
+bool SstWriter::finish() {
+  if (fd_ < 0 || failed_ || finished_) return false;
+  finished_ = true;
+
+  if (opts_.format_version == kSstVersionV2) {
+    auto pending = std::move(v2_pending_);
+    return write_sorted_v2(pending, 64);
+  }
+
+  if (!flush_block()) return false;
+  if (dict_pending_ && !train_dict_and_emit()) return false;
+  const uint64_t data_end = file_size();
+
+  // ---- словарь zstd (нужен для распаковки блоков) ----
+  uint64_t dict_offset = 0, dict_size = 0;
+  if (dict_) {
+    const std::string dblock = sst_encode_dict_block(dict_->raw());
+    dict_offset = file_size();
+    dict_size   = dblock.size();
+    if (!append_out(dblock)) return false;
+  }
+
+  // ---- filter (по тем же хешам, что и хеш-индекс) ----
+  uint64_t filter_offset = 0, filter_size = 0;
+  if (opts_.bloom_bits_per_key > 0 && !hashes_.empty()) {
+    BloomFilterBuilder fb(opts_.bloom_bits_per_key);
+    for (const auto& e : hashes_) fb.add_hash(e.h);
+    const std::string fblock = fb.finish();
+    filter_offset = file_size();
+    filter_size   = fblock.size();
+    if (!append_out(fblock)) return false;
+  }
+
+  // ---- range tombstone'ы ----
+  uint64_t rdel_offset = 0, rdel_size = 0;
+  if (!range_dels_.empty()) {
+    const std::string rblock = sst_encode_range_del_block(range_dels_);
+    rdel_offset = file_size();
+    rdel_size   = rblock.size();
+    if (!append_out(rblock)) return false;
+  }
+
+  // ---- hash index ----
+  // v2: бакеты хранят номер блока; v1: номера блоков -> смещения
+  hidx_version_ = opts_.hash_index_version == kHidxVersionV2 && index_.size() <= kHidxV2MaxBlocks
+                      ? kHidxVersionV2 : kHidxVersionV1;
+  std::vector<HashIndexEntry> table;
+  std::vector<HashIndexBucket> buckets;
+  if (hidx_version_ == kHidxVersionV2) {
+    for (auto& e : hashes_) e.off = sst_record_block_off(e.off);
+    buckets = sst_build_hash_buckets(hashes_);
+  } else {
+    for (auto& e : hashes_)
+      e.off = sst_pack_record_off(index_[sst_record_block_off(e.off)].handle.offset,
+                                  sst_record_in_block_off(e.off));
+    table = build_hash_table(hashes_);
+  }
+  const uint64_t hash_index_offset = file_size();
+  HashIndexHeader hdr{};
+  hdr.magic      = kHidxMagic;
+  hdr.version    = hidx_version_;
+  hdr.table_size = buckets.empty() ? table.size() : buckets.size();
+  hdr.num_items  = hashes_.size();
+  if (!append_out(std::string_view(reinterpret_cast<const char*>(&hdr), sizeof(hdr))))
+    return false;
+  if (!buckets.empty()) {
+    const std::string pad(hidx_buckets_offset(hash_index_offset) - file_size(), '\0');
+    if (!append_out(pad) ||
+        !append_out(std::string_view(reinterpret_cast<const char*>(buckets.data()),
+                                     buckets.size() * sizeof(HashIndexBucket))))
+      return false;
+  } else if (!append_out(std::string_view(reinterpret_cast<const char*>(table.data()),
+                                          table.size() * sizeof(HashIndexEntry)))) {
+    return false;
+  }
+
+  // ---- block index: {uint32 klen, uint64 off, uint32 size, key} ----
+  const uint64_t index_offset = file_size();
+  std::string ib;
+  SparseIndexHeader sh{kSparseMagic, kBlockIndexVersion, static_cast<uint32_t>(index_.size())};
+  ib.append(reinterpret_cast<const char*>(&sh), sizeof(sh));
+  for (const auto& e : index_) {
+    const uint32_t klen = static_cast<uint32_t>(e.first_key.size());
+    ib.append(reinterpret_cast<const char*>(&klen), sizeof(klen));
+    ib.append(reinterpret_cast<const char*>(&e.handle.offset), sizeof(e.handle.offset));
+    ib.append(reinterpret_cast<const char*>(&e.handle.size), sizeof(e.handle.size));
+    ib.append(e.first_key);
+  }
+  if (!append_out(ib)) return false;
+
+  // ---- footer ext + footer v3 ----
+  SstFooterExt ext{};
+  ext.data_end         = data_end;
+  ext.num_entries      = num_entries_;
+  ext.index_size       = ib.size();
+  ext.block_size       = opts_.block_size;
+  ext.restart_interval = opts_.restart_interval;
+  ext.reserved[0]      = filter_offset;
+  ext.reserved[1]      = filter_size;
+  ext.reserved[2]      = dict_offset;
+  ext.reserved[3]      = dict_size;
+  ext.reserved[4]      = rdel_offset;
+  ext.reserved[5]      = rdel_size;
 
+  SstFooter f{};
+  std::memset(&f, 0, sizeof(f));
+  f.hash_index_offset = hash_index_offset;
+  f.hash_table_size   = static_cast<uint32_t>(hdr.table_size);
+  f.version           = kSstVersionV3;
+  f.sparse_offset     = index_offset;
+  f.sparse_count      = static_cast<uint32_t>(index_.size());
+  std::memcpy(f.magic, kSstMagic, 7);
+
+  if (!append_out(std::string_view(reinterpret_cast<const char*>(&ext), sizeof(ext))) ||
+      !append_out(std::string_view(reinterpret_cast<const char*>(&f), sizeof(f))) ||
+      !flush_out()) {
+    spdlog::error("SST v3 tail write failed: {}", path_);
+    return false;
+  }
+
+  // Durability of SST file (best-effort).
+  ::fsync(fd_);
+  return true;
+}
+
+// ---------------- v2: запись на 4 KiB ----------------
+
+bool SstWriter::write_sorted_v2(
+    const std::vector<std::pair<std::string, std::optional<std::string>>>& entries,
+    uint32_t index_step)
+{
   if (!entries.empty()) {
     for (size_t i = 1; i < entries.size(); ++i) {
       if (entries[i-1].first > entries[i].first) {
@@ -162,36 +447,25 @@ bool SstWriter::write_sorted(
   }
 
   // ---- build mmap-able hash index in memory ----
-  const uint64_t items = static_cast<uint64_t>(entries.size());
-  const uint64_t table_size = next_pow2(std::max<uint64_t>(1, items * 2)); // load factor <= 0.5
-  std::vector<HashIndexEntry> table(table_size);
-  std::fill(table.begin(), table.end(), HashIndexEntry{0, 0});
-
+  std::vector<HashIndexEntry> items;
+  items.reserve(entries.size());
   for (size_t i = 0; i < entries.size(); ++i) {
     const auto& k = entries[i].first;
     uint64_t h = sst_key_hash(k.data(), k.size());
     if (h == 0) h = 1; // reserve 0 for "empty"
-    const uint64_t mask = table_size - 1;
-    uint64_t pos = h & mask;
-
-    for (uint64_t step = 0; step < table_size; ++step) {
-      if (table[pos].h == 0) {
-        table[pos].h   = h;
-        table[pos].off = rec_offsets[i]; // start of record
-        break;
-      }
-      pos = (pos + 1) & mask;
-    }
+    items.push_back(HashIndexEntry{h, rec_offsets[i]}); // start of record
   }
+  const auto table = build_hash_table(items);
+  const uint64_t table_size = table.size();
 
   // ---- write hash index block ----
   const uint64_t hash_index_offset = file_off;
 
   HashIndexHeader hdr{};
   hdr.magic      = kHidxMagic;
-  hdr.version    = kHidxVersion;
+  hdr.version    = kHidxVersionV1;
   hdr.table_size = table_size;
-  hdr.num_items  = items;
+  hdr.num_items  = items.size();
 
   {
     ssize_t w = ::write(fd_, &hdr, sizeof(hdr));
@@ -245,7 +519,7 @@ bool SstWriter::write_sorted(
   SstFooter f{};
   f.hash_index_offset = hash_index_offset;                    // start of HashIndexHeader
   f.hash_table_size   = static_cast<uint32_t>(table_size);    // table size (power of two)
-  f.version           = kSstVersion;                          // = 2
+  f.version           = kSstVersionV2;                        // = 2
   f.sparse_offset     = sparse_offset;                        // start of sparse block
   f.sparse_count      = static_cast<uint32_t>(sparse.size()); // number of sparse samples
   std::memset(f.magic, 0, sizeof(f.magic));
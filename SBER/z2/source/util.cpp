@@ -35,4 +35,38 @@ uint64_t dummy_checksum(std::string_view a, std::string_view b) {
   return h;
 }
 
+void put_varint32(std::string &dst, uint32_t v) {
+  put_varint64(dst, v);
+}
+
+void put_varint64(std::string &dst, uint64_t v) {
+  while (v >= 0x80) {
+    dst.push_back(static_cast<char>((v & 0x7F) | 0x80));
+    v >>= 7;
+  }
+  dst.push_back(static_cast<char>(v));
+}
+
+const char *get_varint64(const char *p, const char *limit, uint64_t &v) {
+  uint64_t result = 0;
+  for (uint32_t shift = 0; shift <= 63 && p < limit; shift += 7) {
+    const uint64_t byte = static_cast<unsigned char>(*p++);
+    result |= (byte & 0x7F) << shift;
+    if ((byte & 0x80) == 0) {
+      v = result;
+      return p;
+    }
+  }
+  return nullptr;
+}
+
+const char *get_varint32(const char *p, const char *limit, uint32_t &v) {
+  uint64_t x = 0;
+  p = get_varint64(p, limit, x);
+  if (!p || x > 0xFFFFFFFFull)
+    return nullptr;
+  v = static_cast<uint32_t>(x);
+  return p;
+}
+
 } // namespace uringkv
@@ -1,117 +1,177 @@
 #include "wal/reader.hpp"
+#include "kv.hpp"
 #include "util.hpp"
+#include <xxhash.h>
 #include <sys/stat.h>
 #include <unistd.h>
 #include <fcntl.h>
-#include <dirent.h>
+#include <cerrno>
 #include <cstring>
 #include <algorithm>
 
 namespace uringkv {
 
-static inline bool is_digit_uc(unsigned char c){ return std::isdigit(c) != 0; }
-
-static std::vector<std::string> list_wal_segments_sorted(const std::string& dir) {
-  std::vector<std::string> out;
-  DIR* d = ::opendir(dir.c_str());
-  if (!d) return out;
-  while (auto* ent = ::readdir(d)) {
-    std::string n = ent->d_name;
-    if (n.size() == 10 && n.substr(6) == ".wal") {
-      bool digits = std::all_of(n.begin(), n.begin()+6,
-                                [](char c){ return is_digit_uc(static_cast<unsigned char>(c)); });
-      if (digits) out.push_back(n);
-    }
+// Файл целиком: один буфер, чтения по 8 MiB.
+static bool read_whole_file(const std::string& path, std::string& out) {
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) return false;
+  struct stat st{};
+  if (::fstat(fd, &st) != 0) { ::close(fd); return false; }
+#ifdef POSIX_FADV_SEQUENTIAL
+  (void)::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+  out.resize(static_cast<size_t>(st.st_size));
+  constexpr size_t CHUNK = 8u << 20;
+  size_t got = 0;
+  while (got < out.size()) {
+    ssize_t r = ::pread(fd, out.data() + got, std::min(CHUNK, out.size() - got), static_cast<off_t>(got));
+    if (r < 0 && errno == EINTR) continue;
+    if (r <= 0) break; // файл укоротили — разбираем прочитанное
+    got += static_cast<size_t>(r);
   }
-  ::closedir(d);
-  std::sort(out.begin(), out.end());
-  return out;
-}
-
-WalReader::WalReader(const std::string& wal_dir) : wal_dir_(wal_dir) {
-  files_ = list_wal_segments_sorted(wal_dir_);
-  file_pos_ = 0;
-  fd_ = -1;
-  (void)open_next_file();
+  out.resize(got);
+  ::close(fd);
+  return true;
 }
 
-WalReader::~WalReader(){ if(fd_>=0) ::close(fd_); }
+// Проверенная запись (meta+key+value) → records; пакет раскрывается целиком или
+// не добавляется. false — запись битая.
+static bool add_record(std::string_view rec, WalSegment& seg) {
+  WalRecordMeta m{};
+  if (rec.size() < sizeof(m)) return false;
+  std::memcpy(&m, rec.data(), sizeof(m));
+  if (uint64_t(m.klen) + m.vlen != rec.size() - sizeof(m)) return false;
+  std::string_view k(rec.data() + sizeof(m), m.klen);
+  std::string_view v(rec.data() + sizeof(m) + m.klen, m.vlen);
+  if (m.checksum != dummy_checksum(k, v)) return false;
 
-bool WalReader::read_segment_header(int fd) {
-  char pad[WalSegmentConst::HEADER_SIZE];
-  ssize_t r = ::read(fd, pad, sizeof(pad));
-  if (r == 0) return false;
-  if (r != (ssize_t)sizeof(pad)) return false;
-  WalSegmentHeader hdr{};
-  std::memcpy(&hdr, pad, sizeof(hdr));
-  if (std::memcmp(hdr.magic, WalSegmentConst::MAGIC, 7) != 0) return false;
-  if (hdr.version != WalSegmentConst::VERSION) return false;
+  if (m.flags != WAL_FLAG_BATCH) {
+    seg.records.push_back({m.flags, m.seqno, k, v});
+    seg.max_seqno = std::max(seg.max_seqno, m.seqno);
+    return true;
+  }
+  const size_t before = seg.records.size();
+  uint64_t seqno = m.seqno;
+  const bool ok = WriteBatch::for_each(v, [&](uint32_t flags, std::string_view bk, std::string_view bv) {
+    seg.records.push_back({flags, seqno++, bk, bv});
+  });
+  if (!ok) {
+    seg.records.resize(before);
+    return false;
+  }
+  if (seqno > m.seqno) seg.max_seqno = std::max(seg.max_seqno, seqno - 1);
   return true;
 }
 
-bool WalReader::open_next_file() {
-  if (fd_ >= 0) { ::close(fd_); fd_ = -1; }
-  while (file_pos_ < files_.size()) {
-    auto p = join_path(wal_dir_, files_[file_pos_++]);
-    int fd = ::open(p.c_str(), O_RDONLY);
-    if (fd < 0) continue;
-    if (!read_segment_header(fd)) { ::close(fd); continue; }
-    fd_ = fd;
-    return true;
+// PADDED (v1): [meta][key][value][trailer] + нули до границы 4 KiB
+static void parse_padded(WalSegment& seg) {
+  const std::string_view d = seg.data;
+  size_t pos = WalSegmentConst::HEADER_SIZE;
+  while (pos + sizeof(WalRecordMeta) <= d.size()) {
+    WalRecordMeta m{};
+    std::memcpy(&m, d.data() + pos, sizeof(m));
+    const uint64_t body = sizeof(m) + uint64_t(m.klen) + m.vlen;
+    if (pos + body + sizeof(WalRecordTrailer) > d.size()) return; // оборванная запись
+
+    WalRecordTrailer tr{};
+    std::memcpy(&tr, d.data() + pos + body, sizeof(tr));
+    if (tr.magic != WAL_TRAILER_MAGIC || tr.rec_len != body) return;
+    if (!add_record(d.substr(pos, body), seg)) return;
+
+    const uint64_t used = body + sizeof(WalRecordTrailer);
+    const uint64_t rem  = used % WalSegmentConst::BLOCK_SIZE;
+    pos += used + (rem ? WalSegmentConst::BLOCK_SIZE - rem : 0);
   }
-  return false;
 }
 
-std::optional<WalReader::Item> WalReader::next() {
-  if (fd_ < 0) return std::nullopt;
+// PACKED (v2): фрагменты внутри 4 KiB блоков, см. segment.hpp
+static void parse_packed(WalSegment& seg) {
+  constexpr size_t H  = sizeof(WalFragmentHeader);
+  constexpr size_t BS = WalSegmentConst::BLOCK_SIZE;
+  const std::string_view d = seg.data;
+  size_t pos = WalSegmentConst::HEADER_SIZE;
 
-  WalRecordMeta m{};
-  ssize_t r = ::read(fd_, &m, sizeof(m));
-  if (r == 0) {
-    if (open_next_file()) return next();
-    return std::nullopt;
-  }
-  if (r != (ssize_t)sizeof(m)) {
-    if (open_next_file()) return next();
-    return std::nullopt;
-  }
+  auto read_fragment = [&](uint8_t& type, std::string_view& payload) -> bool {
+    while (true) {
+      const size_t left = BS - (pos - WalSegmentConst::HEADER_SIZE) % BS;
+      if (left < H) { pos += left; continue; } // нулевой хвост блока
+      if (pos + H > d.size()) return false;
+      WalFragmentHeader h{};
+      std::memcpy(&h, d.data() + pos, H);
+      // нулевой заголовок там, где он помещается, — конец записанных данных
+      if (h.type == WAL_FRAG_ZERO) return false;
+      if (H + h.length > left || pos + H + h.length > d.size()) return false; // оборванный фрагмент
+      const char* data = d.data() + pos + H;
+      if (h.checksum != static_cast<uint32_t>(XXH32(data, h.length, h.type))) return false;
+      type = h.type;
+      payload = std::string_view(data, h.length);
+      pos += H + h.length;
+      return true;
+    }
+  };
 
-  std::string k; k.resize(m.klen);
-  if (m.klen && ::read(fd_, k.data(), m.klen) != (ssize_t)m.klen) {
-    if (open_next_file()) return next();
-    return std::nullopt;
-  }
-  std::string v; v.resize(m.vlen);
-  if (m.vlen && ::read(fd_, v.data(), m.vlen) != (ssize_t)m.vlen) {
-    if (open_next_file()) return next();
-    return std::nullopt;
-  }
+  std::string joined;
+  bool in_record = false;
+  while (true) {
+    uint8_t type = 0;
+    std::string_view frag;
+    if (!read_fragment(type, frag)) return;
 
-  // --- читаем трейлер и валидируем ---
-  WalRecordTrailer tr{};
-  if (::read(fd_, &tr, sizeof(tr)) != (ssize_t)sizeof(tr)) {
-    if (open_next_file()) return next();
-    return std::nullopt;
-  }
-  const uint32_t expect_len = static_cast<uint32_t>(sizeof(m) + m.klen + m.vlen);
-  if (tr.magic != WAL_TRAILER_MAGIC || tr.rec_len != expect_len) {
-    // оборванная запись — переходим к следующему сегменту
-    if (open_next_file()) return next();
-    return std::nullopt;
+    if (type == WAL_FRAG_FULL && !in_record) {
+      if (!add_record(frag, seg)) return; // запись целиком в буфере файла
+    } else if (type == WAL_FRAG_FIRST && !in_record) {
+      joined.assign(frag);
+      in_record = true;
+    } else if (type == WAL_FRAG_MIDDLE && in_record) {
+      joined.append(frag);
+    } else if (type == WAL_FRAG_LAST && in_record) {
+      joined.append(frag);
+      in_record = false;
+      seg.joined.push_back(std::move(joined)); // key/value ссылаются сюда
+      joined = std::string{};
+      if (!add_record(seg.joined.back(), seg)) return;
+    } else {
+      return; // нарушена последовательность фрагментов
+    }
   }
+}
+
+bool load_wal_segment(const std::string& path, WalSegment& seg) {
+  seg.records.clear();
+  seg.joined.clear();
+  seg.max_seqno = 0;
+  if (!read_whole_file(path, seg.data)) return false;
+  if (seg.data.size() < WalSegmentConst::HEADER_SIZE) return false;
+
+  WalSegmentHeader hdr{};
+  std::memcpy(&hdr, seg.data.data(), sizeof(hdr));
+  if (std::memcmp(hdr.magic, WalSegmentConst::MAGIC, 7) != 0) return false;
+  if (hdr.version == WalSegmentConst::VERSION) parse_padded(seg);
+  else if (hdr.version == WalSegmentConst::VERSION_PACKED) parse_packed(seg);
+  else return false;
+  return true;
+}
 
-  // пропускаем паддинг до 4К
-  const uint64_t used = expect_len + sizeof(WalRecordTrailer);
-  const uint64_t rem  = used % WalSegmentConst::BLOCK_SIZE;
-  if (rem) ::lseek(fd_, (off_t)(WalSegmentConst::BLOCK_SIZE - rem), SEEK_CUR);
+WalReader::WalReader(const std::string& wal_dir)
+    : wal_dir_(wal_dir), files_(list_wal_segments(wal_dir)) {}
 
-  // checksum
-  if (m.checksum != dummy_checksum(k, v)) {
-    if (open_next_file()) return next();
-    return std::nullopt;
+bool WalReader::load_next() {
+  while (file_pos_ < files_.size()) {
+    if (load_wal_segment(join_path(wal_dir_, files_[file_pos_++]), seg_)) {
+      rec_pos_ = 0;
+      return true;
+    }
   }
+  return false;
+}
 
-  return Item{m.flags, m.seqno, std::move(k), std::move(v)};
+std::optional<WalReader::Item> WalReader::next() {
+  // после битой/оборванной записи — со следующего сегмента
+  while (rec_pos_ >= seg_.records.size()) {
+    if (!load_next()) return std::nullopt;
+  }
+  const auto& r = seg_.records[rec_pos_++];
+  return Item{r.flags, r.seqno, std::string(r.key), std::string(r.value)};
 }
 
 } // namespace uringkv
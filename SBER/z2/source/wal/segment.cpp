@@ -1,6 +1,8 @@
 #include "wal/segment.hpp"
 #include <algorithm>
+#include <cctype>
 #include <cstdio>
+#include <dirent.h>
 
 namespace uringkv {
 
@@ -10,4 +12,21 @@ std::string wal_segment_name(uint64_t index) {
   return std::string(buf);
 }
 
+std::vector<std::string> list_wal_segments(const std::string& dir) {
+  std::vector<std::string> out;
+  DIR* d = ::opendir(dir.c_str());
+  if (!d) return out;
+  while (auto* ent = ::readdir(d)) {
+    std::string n = ent->d_name;
+    if (n.size() == 10 && n.substr(6) == ".wal") {
+      bool digits = std::all_of(n.begin(), n.begin() + 6,
+                                [](unsigned char c) { return std::isdigit(c); });
+      if (digits) out.push_back(n);
+    }
+  }
+  ::closedir(d);
+  std::sort(out.begin(), out.end());
+  return out;
+}
+
 }
@@ -11,6 +11,10 @@
 #endif
 #include <spdlog/spdlog.h>
 #include <cstdlib>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
 
 namespace uringkv {
 
@@ -18,6 +22,7 @@ struct UringBackend::Impl {
 #if URKV_HAVE_URING
   io_uring ring{};
   bool ok = false;
+  bool dead = false; // сбой посреди пакета чтения: кольцо больше не используем
 
   // batching
   unsigned pending = 0;
@@ -32,6 +37,23 @@ struct UringBackend::Impl {
   void* buf_mem = nullptr;
   size_t buf_len = 0;
 
+  // ---- асинхронная запись ----
+  struct AsyncOp {
+    WriteCallback cb;
+    std::string heap;      // копия данных, если они не в кольце
+    size_t ring_off = 0;
+    size_t ring_len = 0;   // 0 — кольцо не занято
+    uint32_t len = 0;
+    int res = 0;
+    int cqes = 0;          // ещё не пришедших CQE: write [+ fsync]
+    bool submitted = false;
+  };
+  // в порядке отправки; место в кольце освобождается только с головы
+  std::deque<std::unique_ptr<AsyncOp>> async_ops;
+  size_t ring_head = 0;    // следующий свободный байт кольца
+  unsigned queued = 0;     // SQE подготовлено, но не отправлено
+  std::size_t unfinished = 0; // операций без вызванного колбэка
+
   explicit Impl(unsigned qd, bool sqpoll, size_t buf_size, unsigned batch) {
     submit_batch = batch ? batch : 16;
     buf_len = buf_size;
@@ -66,6 +88,7 @@ struct UringBackend::Impl {
   }
   ~Impl() {
     if (ok) {
+      if (!dead) poll_async(true);
       if (buffers_registered) {
         (void)io_uring_unregister_buffers(&ring);
         free(buf_mem);
@@ -97,6 +120,121 @@ struct UringBackend::Impl {
     }
     return true;
   }
+
+  // Место под n байт в кольце fixed buffer (или false). Занятое лежит от
+  // головы async_ops до ring_head; строгие неравенства не дают голове догнать хвост.
+  bool ring_alloc(size_t n, size_t& off) {
+    if (!buffers_registered || n == 0 || n > buf_len) return false;
+    const AsyncOp* oldest = nullptr;
+    for (const auto& op : async_ops)
+      if (op->ring_len) { oldest = op.get(); break; }
+    if (!oldest) {
+      off = 0;
+      ring_head = n;
+      return true;
+    }
+    const size_t tail = oldest->ring_off;
+    if (ring_head >= tail) {
+      if (buf_len - ring_head >= n) { off = ring_head; ring_head += n; return true; }
+      if (n < tail) { off = 0; ring_head = n; return true; } // хвост буфера пропускаем
+      return false;
+    }
+    if (tail - ring_head > n) { off = ring_head; ring_head += n; return true; }
+    return false;
+  }
+
+  void release_done() {
+    while (!async_ops.empty() && async_ops.front()->cqes == 0) async_ops.pop_front();
+    if (async_ops.empty()) ring_head = 0;
+  }
+
+  void finish(AsyncOp* op) {
+    --unfinished;
+    auto cb = std::move(op->cb);
+    if (cb) cb(op->res);
+  }
+
+  void complete_async(io_uring_cqe* cqe) {
+    const auto raw = reinterpret_cast<uintptr_t>(io_uring_cqe_get_data(cqe));
+    const bool is_fsync = (raw & 1u) != 0;
+    auto* op = reinterpret_cast<AsyncOp*>(raw & ~uintptr_t(1));
+    const int res = cqe->res;
+    io_uring_cqe_seen(&ring, cqe);
+    if (!op) return; // не наша CQE
+    if (!is_fsync) {
+      if (res < 0) op->res = res;
+      else if (static_cast<uint32_t>(res) != op->len) op->res = -EIO; // короткая запись
+      else op->res = res;
+    } else if (res < 0 && op->res >= 0) {
+      op->res = res; // в т.ч. -ECANCELED после неудачной записи
+    }
+    if (--op->cqes == 0) finish(op);
+  }
+
+  // отправленные и неотправленные SQE, которые уже не завершатся, — ошибкой
+  void fail_async(bool only_unsubmitted) {
+    for (auto& op : async_ops) {
+      if (op->cqes == 0 || (only_unsubmitted && op->submitted)) continue;
+      op->cqes = 0;
+      op->res = -EIO;
+      finish(op.get());
+    }
+    release_done();
+  }
+
+  bool submit_async() {
+    if (queued == 0) return true;
+    int s = io_uring_submit(&ring);
+    if (s < 0) {
+      spdlog::error("io_uring: WAL submit failed: {}", strerror(-s));
+      dead = true;
+      fail_async(/*only_unsubmitted=*/true);
+      queued = 0;
+      return false;
+    }
+    for (auto& op : async_ops) op->submitted = true;
+    queued = 0;
+    return true;
+  }
+
+  std::size_t poll_async(bool wait) {
+    std::size_t n = 0;
+    if (wait && !submit_async()) wait = false;
+    while (unfinished > 0) {
+      io_uring_cqe* cqe = nullptr;
+      int r = wait ? io_uring_wait_cqe(&ring, &cqe) : io_uring_peek_cqe(&ring, &cqe);
+      if (r < 0) {
+        if (!wait) break;
+        // ждать больше нечем: кольцо не используем, операции — с ошибкой
+        spdlog::error("io_uring: wait for WAL completion failed: {}", strerror(-r));
+        dead = true;
+        n += unfinished;
+        fail_async(false);
+        break;
+      }
+      const std::size_t before = unfinished;
+      complete_async(cqe);
+      n += before - unfinished;
+    }
+    release_done();
+    return n;
+  }
+
+  // дождаться CQE уже отправленных writev (кольцо общее с записью)
+  bool drain_pending() {
+    if (pending == 0) return true;
+    int s = io_uring_submit(&ring);
+    if (s < 0) return false;
+    bool ok_all = true;
+    for (int i = 0; i < s; ++i) {
+      io_uring_cqe* cqe = nullptr;
+      if (io_uring_wait_cqe(&ring, &cqe) < 0) return false;
+      if (cqe->res < 0) ok_all = false;
+      io_uring_cqe_seen(&ring, cqe);
+    }
+    pending = 0;
+    return ok_all;
+  }
 #else
   explicit Impl(unsigned, bool, size_t, unsigned) {}
   ~Impl() = default;
@@ -121,7 +259,8 @@ bool UringBackend::initialized() const noexcept { return p_ != nullptr; }
 
 bool UringBackend::writev(int fd, const struct ::iovec* iov, int iovcnt) {
 #if URKV_HAVE_URING
-  if (!p_ || !p_->ok) return false;
+  if (!p_ || !p_->ok || p_->dead) return false;
+  if (!p_->async_ops.empty()) p_->poll_async(true); // CQE асинхронных записей не путаем со своими
 
   if (!p_->ensure_fixed_file(fd)) {
     io_uring_sqe* sqe = io_uring_get_sqe(&p_->ring);
@@ -170,7 +309,9 @@ bool UringBackend::writev(int fd, const struct ::iovec* iov, int iovcnt) {
 
 bool UringBackend::fsync(int fd) {
 #if URKV_HAVE_URING
-  if (!p_ || !p_->ok) return false;
+  if (!p_ || !p_->ok || p_->dead) return false;
+  if (!p_->async_ops.empty()) p_->poll_async(true);
+  if (p_->dead) return false;
 
   if (p_->pending > 0) {
     int s = io_uring_submit(&p_->ring);
@@ -218,4 +359,223 @@ bool UringBackend::fsync(int fd) {
 #endif
 }
 
+bool UringBackend::write_async(int fd, uint64_t off, std::string_view data, bool sync, WriteCallback cb) {
+#if URKV_HAVE_URING
+  if (!p_ || !p_->ok || p_->dead || data.size() > UINT32_MAX) return false;
+  if (!p_->drain_pending()) return false; // CQE синхронных writev не смешиваем с нашими
+
+  auto op = std::make_unique<Impl::AsyncOp>();
+  op->cb = std::move(cb);
+  op->len = static_cast<uint32_t>(data.size());
+
+  // место в кольце; если занято — ждём завершения старых записей
+  size_t roff = 0, head_before = 0;
+  bool in_ring = false;
+  while (p_->buffers_registered && data.size() <= p_->buf_len) {
+    head_before = p_->ring_head;
+    if ((in_ring = p_->ring_alloc(data.size(), roff))) break;
+    if (p_->unfinished == 0 || p_->poll_async(true) == 0 || p_->dead) break;
+  }
+  // op не встал в очередь — занятое им место в кольце возвращается
+  // (если release_done уже сбросил кольцо, откатывать нечего)
+  auto undo = [&] {
+    if (in_ring && p_->ring_head == roff + data.size()) p_->ring_head = head_before;
+    return false;
+  };
+  if (p_->dead) return undo();
+  const char* src = nullptr;
+  if (in_ring) {
+    char* dst = static_cast<char*>(p_->buf_mem) + roff;
+    std::memcpy(dst, data.data(), data.size());
+    op->ring_off = roff;
+    op->ring_len = data.size();
+    src = dst;
+  } else {
+    op->heap.assign(data);
+    src = op->heap.data();
+  }
+
+  // write и связанный fsync должны уйти в одном submit
+  const unsigned need = sync ? 2u : 1u;
+  if (io_uring_sq_space_left(&p_->ring) < need && !p_->submit_async()) return undo();
+  io_uring_sqe* w = io_uring_get_sqe(&p_->ring);
+  if (!w) return undo();
+  if (in_ring)
+    io_uring_prep_write_fixed(w, fd, src, op->len, off, 0);
+  else
+    io_uring_prep_write(w, fd, src, op->len, off);
+  io_uring_sqe_set_data(w, op.get());
+  op->cqes = 1;
+  if (sync) {
+    w->flags |= IOSQE_IO_LINK;
+    io_uring_sqe* f = io_uring_get_sqe(&p_->ring);
+    io_uring_prep_fsync(f, fd, IORING_FSYNC_DATASYNC);
+    io_uring_sqe_set_data(f, reinterpret_cast<void*>(reinterpret_cast<uintptr_t>(op.get()) | 1u));
+    op->cqes = 2;
+  }
+  p_->queued += need;
+  p_->unfinished++;
+  p_->async_ops.push_back(std::move(op));
+  if (p_->queued >= p_->submit_batch) (void)p_->submit_async();
+  return true;
+#else
+  (void)fd; (void)off; (void)data; (void)sync; (void)cb; return false;
+#endif
+}
+
+bool UringBackend::submit() {
+#if URKV_HAVE_URING
+  if (!p_ || !p_->ok) return false;
+  return p_->submit_async();
+#else
+  return false;
+#endif
+}
+
+std::size_t UringBackend::poll(bool wait) {
+#if URKV_HAVE_URING
+  if (!p_ || !p_->ok) return 0;
+  return p_->poll_async(wait);
+#else
+  (void)wait; return 0;
+#endif
+}
+
+std::size_t UringBackend::inflight() const noexcept {
+#if URKV_HAVE_URING
+  return p_ ? p_->unfinished : 0;
+#else
+  return 0;
+#endif
+}
+
+static void posix_read(UringBackend::ReadOp& op) {
+  ssize_t r = ::pread(op.fd, op.dst, op.len, static_cast<off_t>(op.off));
+  op.res = r < 0 ? -errno : static_cast<int>(r);
+}
+
+void UringBackend::read_batch(std::span<ReadOp> ops, const std::function<void(std::size_t)>& on_done) {
+  std::size_t next = 0; // первая ещё не отправленная операция
+#if URKV_HAVE_URING
+  if (p_ && p_->ok && !p_->async_ops.empty()) p_->poll_async(true);
+  if (p_ && p_->ok && !p_->dead && p_->drain_pending()) {
+    constexpr std::size_t kNoFixed = SIZE_MAX;
+    std::vector<std::size_t> fixed_off(ops.size(), kNoFixed);
+    std::vector<char> done(ops.size(), 0);
+    std::size_t fixed_used = 0;
+    std::size_t inflight = 0;
+    bool broken = false;
+
+    // user_data CQE отмены (индексы чтений меньше)
+    void* const kCancelTag = reinterpret_cast<void*>(UINTPTR_MAX);
+
+    auto complete = [&](io_uring_cqe* cqe) {
+      if (io_uring_cqe_get_data(cqe) == kCancelTag) {
+        io_uring_cqe_seen(&p_->ring, cqe);
+        return;
+      }
+      const auto i = static_cast<std::size_t>(reinterpret_cast<uintptr_t>(io_uring_cqe_get_data(cqe)));
+      auto& op = ops[i];
+      op.res = cqe->res;
+      io_uring_cqe_seen(&p_->ring, cqe);
+      --inflight;
+      done[i] = 1;
+      if (op.res > 0 && fixed_off[i] != kNoFixed)
+        std::memcpy(op.dst, static_cast<char*>(p_->buf_mem) + fixed_off[i], static_cast<std::size_t>(op.res));
+      on_done(i);
+    };
+
+    while (!broken && (next < ops.size() || inflight > 0)) {
+      unsigned queued = 0;
+      while (next < ops.size()) {
+        io_uring_sqe* sqe = io_uring_get_sqe(&p_->ring);
+        if (!sqe) break; // SQ заполнена — отправим и дождёмся части CQE
+        auto& op = ops[next];
+        if (p_->buffers_registered && fixed_used + op.len <= p_->buf_len) {
+          char* b = static_cast<char*>(p_->buf_mem) + fixed_used;
+          io_uring_prep_read_fixed(sqe, op.fd, b, op.len, op.off, 0);
+          fixed_off[next] = fixed_used;
+          fixed_used += op.len;
+        } else {
+          io_uring_prep_read(sqe, op.fd, op.dst, op.len, op.off);
+        }
+        io_uring_sqe_set_data(sqe, reinterpret_cast<void*>(static_cast<uintptr_t>(next)));
+        ++next;
+        ++queued;
+      }
+      if (queued) {
+        int s = io_uring_submit(&p_->ring);
+        if (s < static_cast<int>(queued)) {
+          // кольцо в непонятном состоянии: дожидаемся отправленного и больше его не используем
+          spdlog::warn("io_uring: read submit failed ({}), falling back to pread", s);
+          broken = true;
+          p_->dead = true;
+          next -= queued - static_cast<unsigned>(s > 0 ? s : 0);
+          if (s > 0) inflight += static_cast<std::size_t>(s);
+          break;
+        }
+        inflight += queued;
+      }
+
+      io_uring_cqe* cqe = nullptr;
+      const int r = io_uring_wait_cqe(&p_->ring, &cqe);
+      if (r == -EINTR || r == -EAGAIN) continue;
+      if (r < 0) {
+        spdlog::warn("io_uring: read wait failed ({}), falling back to pread", strerror(-r));
+        broken = true;
+        p_->dead = true;
+        break;
+      }
+      // забираем всё, что уже готово, не дожидаясь остального пакета
+      do {
+        complete(cqe);
+      } while (inflight > 0 && io_uring_peek_cqe(&p_->ring, &cqe) == 0);
+    }
+
+    // После сбоя ядро ещё пишет в dst и fixed buffer отправленных чтений:
+    // вернуть управление можно только после их CQE. Ожидание повторяется,
+    // после первой ошибки незавершённые отменяются (если в SQ не осталось
+    // неотправленных SQE — их отправил бы тот же submit). Если CQE не дождаться
+    // и после отмены, продолжать нельзя: память пакета может быть испорчена.
+    bool cancelled = false;
+    int errors = 0;
+    while (broken && inflight > 0) {
+      io_uring_cqe* cqe = nullptr;
+      const int r = io_uring_wait_cqe(&p_->ring, &cqe);
+      if (r == 0) {
+        complete(cqe);
+        continue;
+      }
+      if (r == -EINTR || r == -EAGAIN) continue;
+      if (!cancelled && io_uring_sq_ready(&p_->ring) == 0) {
+        cancelled = true;
+        unsigned n = 0;
+        for (std::size_t i = 0; i < next; ++i) {
+          io_uring_sqe* sqe = done[i] ? nullptr : io_uring_get_sqe(&p_->ring);
+          if (!sqe) continue;
+          io_uring_prep_cancel(sqe, reinterpret_cast<void*>(static_cast<uintptr_t>(i)), 0);
+          io_uring_sqe_set_data(sqe, kCancelTag);
+          ++n;
+        }
+        if (n) (void)io_uring_submit(&p_->ring);
+        continue;
+      }
+      if (++errors >= 1000) {
+        spdlog::critical("io_uring: {} read(s) still in flight, wait failed: {}", inflight, strerror(-r));
+        std::abort();
+      }
+    }
+    for (std::size_t i = 0; i < next; ++i) {
+      if (done[i]) continue;
+      ops[i].res = -EIO;
+      on_done(i);
+    }
+  }
+#endif
+  for (; next < ops.size(); ++next) {
+    posix_read(ops[next]);
+    on_done(next);
+  }
+}
+
 } // namespace uringkv
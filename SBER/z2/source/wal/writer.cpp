@@ -3,12 +3,11 @@
 #include "wal/record.hpp"
 #include "wal/segment.hpp"
 #include <spdlog/spdlog.h>
+#include <xxhash.h>
 
 #include <algorithm>
-#include <cctype>
 #include <cerrno>
 #include <cstring>
-#include <dirent.h>
 #include <fcntl.h>
 #include <sys/stat.h>
 #include <sys/uio.h>
@@ -22,29 +21,12 @@
 
 namespace uringkv {
 
-static std::vector<std::string> list_wal_segments_sorted(const std::string &dir) {
-  std::vector<std::string> out;
-  DIR *d = ::opendir(dir.c_str());
-  if (!d) return out;
-  while (auto *ent = ::readdir(d)) {
-    std::string n = ent->d_name;
-    if (n.size() == 10 && n.substr(6) == ".wal") {
-      bool digits = std::all_of(n.begin(), n.begin()+6,
-                                [](unsigned char c){ return std::isdigit(c); });
-      if (digits) out.push_back(n);
-    }
-  }
-  ::closedir(d);
-  std::sort(out.begin(), out.end());
-  return out;
-}
-
 // NEW: добавлены параметры fixed_buffer_bytes и submit_batch
 WalWriter::WalWriter(const std::string &wal_dir, bool use_uring,
                      unsigned uring_qd, bool uring_sqpoll,
                      std::size_t uring_fixed_buffer_bytes, unsigned uring_submit_batch,
                      uint64_t max_segment_bytes, uint64_t group_commit_bytes,
-                     FlushMode flush_mode)
+                     FlushMode flush_mode, WalFormat format)
     : wal_dir_(wal_dir),
       use_uring_(use_uring),
       uring_(use_uring ? UringBackend(uring_qd, uring_sqpoll,
@@ -52,26 +34,32 @@ WalWriter::WalWriter(const std::string &wal_dir, bool use_uring,
                        : UringBackend()),
       max_segment_bytes_(max_segment_bytes),
       group_commit_bytes_(group_commit_bytes ? group_commit_bytes : (1ull<<20)),
-      flush_mode_(flush_mode) {
+      flush_mode_(flush_mode),
+      format_(format) {
   if (wal_dir_.empty()) return;
 
   if (use_uring_ && !uring_.initialized()) {
     use_uring_ = false;
     spdlog::warn("liburing not available; falling back to POSIX I/O");
   } else if (use_uring_) {
+    async_ = true;
     spdlog::info("io_uring enabled (qd={}, sqpoll={}, fixed_buf={}B, submit_batch={})",
                  uring_qd, (uring_sqpoll ? "on" : "off"),
                  static_cast<unsigned long long>(uring_fixed_buffer_bytes),
                  uring_submit_batch);
   }
 
-  auto files = list_wal_segments_sorted(wal_dir_);
+  auto files = list_wal_segments(wal_dir_);
   seg_index_ = files.empty() ? 0 : std::stoull(files.back().substr(0, 6));
   (void)open_new_segment(seg_index_ + 1, /*start_seqno*/ 1);
 }
 
 WalWriter::~WalWriter() {
-  if (fd_ >= 0) ::close(fd_);
+  if (fd_ >= 0) {
+    (void)write_pending_();
+    if (async_) uring_.poll(true);
+    ::close(fd_);
+  }
 }
 
 WalWriter::WalWriter(WalWriter &&o) noexcept {
@@ -79,8 +67,13 @@ WalWriter::WalWriter(WalWriter &&o) noexcept {
   wal_dir_ = std::move(o.wal_dir_);
   path_ = std::move(o.path_);
   bytes_since_sync_ = o.bytes_since_sync_;
+  appended_bytes_ = o.appended_bytes_;
+  format_ = o.format_;
+  pending_ = std::move(o.pending_);
+  scratch_ = std::move(o.scratch_);
   uring_ = std::move(o.uring_);
   use_uring_ = o.use_uring_;
+  async_ = o.async_;
   seg_index_ = o.seg_index_;
   seg_size_ = o.seg_size_;
   max_segment_bytes_ = o.max_segment_bytes_;
@@ -93,13 +86,22 @@ WalWriter::WalWriter(WalWriter &&o) noexcept {
 
 WalWriter &WalWriter::operator=(WalWriter &&o) noexcept {
   if (this != &o) {
-    if (fd_ >= 0) ::close(fd_);
+    if (fd_ >= 0) {
+      (void)write_pending_();
+      if (async_) uring_.poll(true);
+      ::close(fd_);
+    }
     fd_ = o.fd_; o.fd_ = -1;
     wal_dir_ = std::move(o.wal_dir_);
     path_ = std::move(o.path_);
     bytes_since_sync_ = o.bytes_since_sync_;
+    appended_bytes_ = o.appended_bytes_;
+    format_ = o.format_;
+    pending_ = std::move(o.pending_);
+    scratch_ = std::move(o.scratch_);
     uring_ = std::move(o.uring_);
     use_uring_ = o.use_uring_;
+    async_ = o.async_;
     seg_index_ = o.seg_index_;
     seg_size_ = o.seg_size_;
     max_segment_bytes_ = o.max_segment_bytes_;
@@ -113,19 +115,26 @@ WalWriter &WalWriter::operator=(WalWriter &&o) noexcept {
 }
 
 bool WalWriter::open_new_segment(uint64_t index, uint64_t start_seqno) {
-  if (fd_ >= 0) { ::close(fd_); fd_ = -1; }
+  if (fd_ >= 0) {
+    if (async_) uring_.poll(true); // записи в старый сегмент должны завершиться
+    ::close(fd_);
+    fd_ = -1;
+  }
+  pending_.clear();
 
   seg_index_ = index;
   path_ = join_path(wal_dir_, wal_segment_name(index));
 
-  fd_ = ::open(path_.c_str(), O_CREAT | O_TRUNC | O_WRONLY | O_APPEND, 0600);
+  const int append = async_ ? 0 : O_APPEND;
+  fd_ = ::open(path_.c_str(), O_CREAT | O_TRUNC | O_WRONLY | append, 0600);
   if (fd_ < 0) { spdlog::error("WAL open failed: {}", path_); return false; }
   spdlog::info("WAL open: {}", path_);
 
   WalSegmentHeader hdr{};
   std::memset(&hdr, 0, sizeof(hdr));
   std::memcpy(hdr.magic, WalSegmentConst::MAGIC, 7);
-  hdr.version = WalSegmentConst::VERSION;
+  hdr.version = (format_ == WalFormat::PACKED) ? WalSegmentConst::VERSION_PACKED
+                                               : WalSegmentConst::VERSION;
   hdr.start_seqno = start_seqno;
 
   char pad[WalSegmentConst::HEADER_SIZE];
@@ -140,8 +149,8 @@ bool WalWriter::open_new_segment(uint64_t index, uint64_t start_seqno) {
 }
 
 bool WalWriter::open_or_rotate_if_needed(uint64_t next_bytes, uint64_t next_seqno) {
-  if (seg_size_ + next_bytes + sizeof(WalRecordTrailer) > max_segment_bytes_) {
-    if (!this->fsync_backend()) return false;
+  if (seg_size_ + pending_.size() + next_bytes + sizeof(WalRecordTrailer) > max_segment_bytes_) {
+    if (!write_pending_() || !this->fsync_backend()) return false;
     return open_new_segment(seg_index_ + 1, next_seqno);
   }
   return true;
@@ -151,13 +160,20 @@ bool WalWriter::append_put(uint64_t seqno, std::string_view k, std::string_view
   WalRecordMeta m{static_cast<uint32_t>(k.size()),
                   static_cast<uint32_t>(v.size()),
                   WAL_FLAG_PUT, seqno, dummy_checksum(k, v)};
-  return append_(m, k, v);
+  return (format_ == WalFormat::PACKED) ? append_packed_(m, k, v) : append_(m, k, v);
 }
 
 bool WalWriter::append_del(uint64_t seqno, std::string_view k) {
   std::string_view v{};
   WalRecordMeta m{static_cast<uint32_t>(k.size()), 0u, WAL_FLAG_DEL, seqno, dummy_checksum(k, v)};
-  return append_(m, k, v);
+  return (format_ == WalFormat::PACKED) ? append_packed_(m, k, v) : append_(m, k, v);
+}
+
+bool WalWriter::append_batch(uint64_t first_seqno, std::string_view rep) {
+  std::string_view k{};
+  WalRecordMeta m{0u, static_cast<uint32_t>(rep.size()), WAL_FLAG_BATCH, first_seqno,
+                  dummy_checksum(k, rep)};
+  return (format_ == WalFormat::PACKED) ? append_packed_(m, k, rep) : append_(m, k, rep);
 }
 
 bool WalWriter::write_vectored(const struct ::iovec *iov, int iovcnt) {
@@ -232,6 +248,21 @@ bool WalWriter::append_(const WalRecordMeta &m, std::string_view k, std::string_
   tr.rec_len = static_cast<uint32_t>(body);
   tr.magic   = WAL_TRAILER_MAGIC;
 
+  if (async_) {
+    // запись с паддингом копится в pending_ и уходит одним write в commit()
+    const uint64_t used = body + trailer_sz;
+    const uint64_t rem  = used % WalSegmentConst::BLOCK_SIZE;
+    const uint64_t pad  = rem ? (WalSegmentConst::BLOCK_SIZE - rem) : 0;
+    pending_.append(reinterpret_cast<const char *>(&m), sizeof(m));
+    pending_.append(k.data(), k.size());
+    pending_.append(v.data(), v.size());
+    pending_.append(reinterpret_cast<const char *>(&tr), sizeof(tr));
+    pending_.append(pad, '\0');
+    appended_bytes_ += used + pad;
+    bytes_since_sync_ += used;
+    return true;
+  }
+
   struct ::iovec iov[4];
   iov[0].iov_base = const_cast<void *>(static_cast<const void *>(&m));
   iov[0].iov_len  = sizeof(m);
@@ -258,6 +289,7 @@ bool WalWriter::append_(const WalRecordMeta &m, std::string_view k, std::string_
   }
 
   seg_size_ += used + ((rem) ? (WalSegmentConst::BLOCK_SIZE - rem) : 0);
+  appended_bytes_ += used + ((rem) ? (WalSegmentConst::BLOCK_SIZE - rem) : 0);
   bytes_since_sync_ += used;
 
   if (bytes_since_sync_ >= group_commit_bytes_) {
@@ -267,8 +299,175 @@ bool WalWriter::append_(const WalRecordMeta &m, std::string_view k, std::string_
   return true;
 }
 
+// ---------------- PACKED (v2) ----------------
+
+// Режет запись на фрагменты так, чтобы ни один не пересекал границу блока.
+void WalWriter::emit_fragments_(std::string_view rec) {
+  constexpr size_t H  = sizeof(WalFragmentHeader);
+  constexpr size_t BS = WalSegmentConst::BLOCK_SIZE;
+
+  bool first = true;
+  do {
+    const size_t block_off =
+        static_cast<size_t>((seg_size_ + pending_.size() - WalSegmentConst::HEADER_SIZE) % BS);
+    size_t left = BS - block_off;
+    if (left < H) {
+      // заголовок не влезает — добиваем блок нулями
+      pending_.append(left, '\0');
+      left = BS;
+    }
+
+    const size_t n = std::min(left - H, rec.size());
+    const bool last = (n == rec.size());
+    const uint8_t type = (first && last) ? WAL_FRAG_FULL
+                       : first           ? WAL_FRAG_FIRST
+                       : last            ? WAL_FRAG_LAST
+                                         : WAL_FRAG_MIDDLE;
+
+    WalFragmentHeader h{};
+    h.checksum = static_cast<uint32_t>(XXH32(rec.data(), n, type));
+    h.length   = static_cast<uint16_t>(n);
+    h.type     = type;
+    pending_.append(reinterpret_cast<const char *>(&h), H);
+    pending_.append(rec.data(), n);
+
+    rec.remove_prefix(n);
+    first = false;
+  } while (!rec.empty());
+}
+
+bool WalWriter::append_packed_(const WalRecordMeta &m, std::string_view k, std::string_view v) {
+  if (fd_ < 0) return false;
+
+  constexpr uint64_t H = sizeof(WalFragmentHeader);
+  const uint64_t body = sizeof(m) + k.size() + v.size();
+  // худший случай: заголовок на каждый блок + паддинг хвоста
+  const uint64_t worst = body + (body / (WalSegmentConst::BLOCK_SIZE - H) + 2) * H + H;
+  const uint64_t used  = seg_size_ + pending_.size();
+  if (used > WalSegmentConst::HEADER_SIZE && used + worst > max_segment_bytes_) {
+    if (!write_pending_() || !this->fsync_backend()) return false;
+    if (!open_new_segment(seg_index_ + 1, m.seqno)) return false;
+  }
+
+  scratch_.clear();
+  scratch_.append(reinterpret_cast<const char *>(&m), sizeof(m));
+  scratch_.append(k.data(), k.size());
+  scratch_.append(v.data(), v.size());
+
+  const size_t before = pending_.size();
+  emit_fragments_(scratch_);
+  appended_bytes_ += pending_.size() - before;
+  bytes_since_sync_ += body;
+  return true;
+}
+
+// Один write на весь накопленный батч.
+// (uring-батчинг SQE тут не нужен: батч уже собран в памяти)
+bool WalWriter::write_pending_() {
+  if (pending_.empty()) return true;
+  if (fd_ < 0) return false;
+
+  if (async_) {
+    bool ok = false;
+    const bool queued = submit_async_(pending_, false, [&ok](bool r) { ok = r; });
+    pending_.clear();
+    uring_.poll(true);
+    return queued && ok;
+  }
+
+  size_t off = 0;
+  while (off < pending_.size()) {
+    ssize_t w = ::write(fd_, pending_.data() + off, pending_.size() - off);
+    if (w < 0) {
+      if (errno == EINTR) continue;
+      spdlog::error("WAL write failed: {}", strerror(errno));
+      seg_size_ += off;
+      pending_.clear();
+      return false;
+    }
+    off += static_cast<size_t>(w);
+  }
+  seg_size_ += pending_.size();
+  pending_.clear();
+  return true;
+}
+
+// async: data копируется в кольцо/кучу UringBackend до возврата; смещение —
+// текущий конец сегмента, его сразу сдвигаем под следующие записи
+bool WalWriter::submit_async_(std::string_view data, bool sync, std::function<void(bool)> on_done) {
+  const uint64_t off = seg_size_;
+  seg_size_ += data.size();
+  UringBackend::WriteCallback cb = [this, sync, done = std::move(on_done)](int res) {
+    if (res < 0) spdlog::error("WAL async write failed: {}", strerror(-res));
+    else if (sync) ++sync_fdatasync_;
+    if (done) done(res >= 0);
+  };
+  if (uring_.write_async(fd_, off, data, sync, cb)) return true;
+
+  // кольцо недоступно — тот же буфер синхронно
+  int res = 0;
+  for (size_t done = 0; done < data.size();) {
+    ssize_t w = ::pwrite(fd_, data.data() + done, data.size() - done, static_cast<off_t>(off + done));
+    if (w < 0 && errno == EINTR) continue;
+    if (w <= 0) { res = w < 0 ? -errno : -EIO; break; }
+    done += static_cast<size_t>(w);
+  }
+  if (res == 0 && sync && !posix_fdatasync(fd_)) res = -errno;
+  if (res == 0) res = static_cast<int>(std::min<size_t>(data.size(), INT32_MAX));
+  cb(res);
+  return res >= 0;
+}
+
+bool WalWriter::commit_async(std::function<void(bool)> on_durable) {
+  if (!async_) {
+    const bool ok = commit();
+    if (on_durable) on_durable(ok);
+    return ok;
+  }
+  if (fd_ < 0) return false;
+  const bool sync = bytes_since_sync_ >= group_commit_bytes_;
+  if (sync) bytes_since_sync_ = 0;
+  if (pending_.empty()) {
+    const bool ok = !sync || this->fsync_backend();
+    if (on_durable) on_durable(ok);
+    return ok;
+  }
+  const bool ok = submit_async_(pending_, sync, std::move(on_durable));
+  pending_.clear();
+  return ok;
+}
+
+void WalWriter::poll(bool wait) {
+  if (async_) (void)uring_.poll(wait);
+}
+
+bool WalWriter::commit() {
+  if (async_) {
+    bool ok = false;
+    const bool queued = commit_async([&ok](bool r) { ok = r; });
+    uring_.poll(true);
+    return queued && ok;
+  }
+  if (format_ != WalFormat::PACKED) return fd_ >= 0;
+  if (!write_pending_()) return false;
+  if (bytes_since_sync_ >= group_commit_bytes_) {
+    if (!this->fsync_backend()) return false;
+    bytes_since_sync_ = 0;
+  }
+  return true;
+}
+
+bool WalWriter::rotate(uint64_t next_seqno) {
+  if (fd_ < 0) return false;
+  if (!write_pending_() || !this->fsync_backend()) return false;
+  bytes_since_sync_ = 0;
+  return open_new_segment(seg_index_ + 1, next_seqno);
+}
+
 void WalWriter::fsync_if_needed() {
-  if (fd_ >= 0) (void)this->fsync_backend();
+  if (fd_ < 0) return;
+  if (!write_pending_()) return;
+  (void)this->fsync_backend();
 }
 
 } // namespace uringkv
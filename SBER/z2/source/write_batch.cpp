@@ -0,0 +1,84 @@
+#include "kv.hpp"
+#include "util.hpp"
+#include "wal/record.hpp"
+
+#include <cstring>
+
+namespace uringkv {
+
+static constexpr std::size_t BATCH_HEADER = sizeof(uint32_t); // count
+
+WriteBatch::WriteBatch() { clear(); }
+
+void WriteBatch::clear() {
+  rep_.assign(BATCH_HEADER, '\0');
+  count_ = 0;
+  range_dels_ = 0;
+}
+
+static void set_count(std::string &rep, std::size_t n) {
+  const uint32_t c = static_cast<uint32_t>(n);
+  std::memcpy(rep.data(), &c, sizeof(c));
+}
+
+void WriteBatch::put(std::string_view key, std::string_view value) {
+  rep_.push_back(static_cast<char>(WAL_FLAG_PUT));
+  put_varint32(rep_, static_cast<uint32_t>(key.size()));
+  rep_.append(key);
+  put_varint32(rep_, static_cast<uint32_t>(value.size()));
+  rep_.append(value);
+  set_count(rep_, ++count_);
+}
+
+void WriteBatch::del(std::string_view key) {
+  rep_.push_back(static_cast<char>(WAL_FLAG_DEL));
+  put_varint32(rep_, static_cast<uint32_t>(key.size()));
+  rep_.append(key);
+  set_count(rep_, ++count_);
+}
+
+void WriteBatch::delete_range(std::string_view start, std::string_view end) {
+  rep_.push_back(static_cast<char>(WAL_FLAG_RANGE_DEL));
+  put_varint32(rep_, static_cast<uint32_t>(start.size()));
+  rep_.append(start);
+  put_varint32(rep_, static_cast<uint32_t>(end.size()));
+  rep_.append(end);
+  set_count(rep_, ++count_);
+  ++range_dels_;
+}
+
+bool WriteBatch::for_each(std::string_view rep,
+                          const std::function<void(uint32_t, std::string_view, std::string_view)> &fn) {
+  if (rep.size() < BATCH_HEADER)
+    return false;
+  uint32_t count = 0;
+  std::memcpy(&count, rep.data(), sizeof(count));
+
+  const char *p = rep.data() + BATCH_HEADER;
+  const char *limit = rep.data() + rep.size();
+  uint32_t seen = 0;
+  while (p < limit) {
+    const uint32_t flags = static_cast<uint8_t>(*p++);
+    if (flags != WAL_FLAG_PUT && flags != WAL_FLAG_DEL && flags != WAL_FLAG_RANGE_DEL)
+      return false;
+    uint32_t klen = 0, vlen = 0;
+    p = get_varint32(p, limit, klen);
+    if (!p || uint64_t(limit - p) < klen)
+      return false;
+    const std::string_view key(p, klen);
+    p += klen;
+    std::string_view value;
+    if (flags != WAL_FLAG_DEL) {
+      p = get_varint32(p, limit, vlen);
+      if (!p || uint64_t(limit - p) < vlen)
+        return false;
+      value = std::string_view(p, vlen);
+      p += vlen;
+    }
+    fn(flags, key, value);
+    ++seen;
+  }
+  return seen == count;
+}
+
+} // namespace uringkv
@@ -0,0 +1,99 @@
+#ifdef __has_include
+#  if __has_include(<catch2/catch_all.hpp>)
+#    include <catch2/catch_all.hpp>
+#  else
+#    include <catch2/catch.hpp>
+#  endif
+#endif
+
+#include "kv.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace uringkv;
+namespace fs = std::filesystem;
+
+static std::string bfdir(const char* p){
+  auto b = fs::temp_directory_path();
+  auto d = b / (std::string(p)+std::to_string(::getpid()));
+  fs::remove_all(d);
+  fs::create_directories(d);
+  return d.string();
+}
+
+static std::vector<fs::path> wal_files(const std::string& dir) {
+  std::vector<fs::path> out;
+  for (auto& e : fs::directory_iterator(fs::path(dir) / "wal"))
+    if (e.path().extension() == ".wal") out.push_back(e.path());
+  std::sort(out.begin(), out.end());
+  return out;
+}
+
+static bool wait_flushes(KV& kv, uint64_t n) {
+  for (int i = 0; i < 500; ++i) {
+    if (kv.get_metrics().sst_flushes >= n) return true;
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  return false;
+}
+
+TEST_CASE("Background flush: reads see immutable MemTable, WAL purged by segment range") {
+  auto dir = bfdir("uringkv_bgflush_");
+  {
+    KV kv({.path = dir, .sst_flush_threshold_bytes = 8 * 1024,
+           .background_compaction = false, .final_flush_on_close = false});
+
+    // первая MemTable: ~10 KiB => swap в immutable + фоновый flush
+    for (int i = 0; i < 100; ++i)
+      REQUIRE(kv.put("a" + std::to_string(i), std::string(100, 'a')));
+    // сразу читаем (данные могут быть ещё в imm)
+    for (int i = 0; i < 100; ++i)
+      REQUIRE(kv.get("a" + std::to_string(i)).value() == std::string(100, 'a'));
+
+    REQUIRE(wait_flushes(kv, 1));
+
+    // записи после swap живут в новом сегменте, старые сегменты удалены
+    REQUIRE(kv.put("tail", "t"));
+    REQUIRE(kv.del("a0"));
+    auto wals = wal_files(dir);
+    REQUIRE(wals.size() == 1);
+    REQUIRE(fs::file_size(wals[0]) > 4096);
+    REQUIRE(wals[0].filename() != "000001.wal");
+  }
+
+  // без финального flush: часть данных из SST, хвост — replay WAL
+  KV kv({.path = dir, .background_compaction = false});
+  REQUIRE(kv.get("tail").value() == "t");
+  REQUIRE_FALSE(kv.get("a0").has_value());
+  REQUIRE(kv.get("a99").value() == std::string(100, 'a'));
+  REQUIRE(kv.scan("a", "b").size() == 99);
+}
+
+TEST_CASE("Background flush: concurrent writers across many MemTable swaps") {
+  auto dir = bfdir("uringkv_bgflush_mt_");
+  constexpr int kThreads = 4, kPer = 1000;
+  {
+    KV kv({.path = dir, .sst_flush_threshold_bytes = 16 * 1024,
+           .l0_compact_threshold = 4});
+    std::vector<std::thread> th;
+    std::atomic<int> failed{0};
+    for (int t = 0; t < kThreads; ++t)
+      th.emplace_back([&, t] {
+        for (int i = 0; i < kPer; ++i)
+          if (!kv.put("t" + std::to_string(t) + "_" + std::to_string(i), std::string(64, 'x'))) ++failed;
+      });
+    for (auto& x : th) x.join();
+    REQUIRE(failed.load() == 0);
+    REQUIRE(kv.get_metrics().sst_flushes > 1);
+  }
+
+  KV kv({.path = dir});
+  REQUIRE(kv.scan("", "").size() == size_t(kThreads) * kPer);
+}
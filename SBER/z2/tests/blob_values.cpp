@@ -0,0 +1,221 @@
+#ifdef __has_include
+#  if __has_include(<catch2/catch_all.hpp>)
+#    include <catch2/catch_all.hpp>
+#  else
+#    include <catch2/catch.hpp>
+#  endif
+#endif
+
+#include "kv.hpp"
+#include "blob/blob_file.hpp"
+#include "sst/manifest.hpp"
+#include "sst/reader.hpp"
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace uringkv;
+namespace fs = std::filesystem;
+
+static std::string bldir(const char* p){
+  auto b = fs::temp_directory_path();
+  auto d = b / (std::string(p)+std::to_string(::getpid()));
+  fs::remove_all(d);
+  fs::create_directories(d);
+  return d.string();
+}
+
+// сбой после последней правки: отметка закрытия (последний commit) оборвана,
+// открытие сверяет каталоги с MANIFEST
+static void drop_clean_mark(const std::string& sst_dir) {
+  const auto path = sst_dir + "/MANIFEST";
+  std::string body;
+  {
+    std::ifstream in(path, std::ios::binary);
+    body.assign(std::istreambuf_iterator<char>(in), {});
+  }
+  body.pop_back();
+  body.resize(body.rfind('\n') + 1);
+  std::ofstream(path, std::ios::binary | std::ios::trunc) << body;
+}
+
+static std::string bkey(int i) {
+  char b[32];
+  std::snprintf(b, sizeof(b), "key%05d", i);
+  return b;
+}
+
+// большие значения у чётных ключей
+static std::string bval(int i, int gen) {
+  const std::string tag = std::to_string(gen) + ":" + std::to_string(i) + ":";
+  return tag + std::string(i % 2 == 0 ? 3000 : 20, char('a' + gen % 26));
+}
+
+// записи SST по флагам (из всех таблиц MANIFEST)
+static std::pair<int, int> sst_flag_counts(const std::string& dir) {
+  uint64_t last = 0;
+  SstLevels levels;
+  int blobs = 0, inline_puts = 0;
+  if (!read_manifest(dir + "/sst", last, levels)) return {0, 0};
+  for (const auto& lvl : levels)
+    for (const auto& f : lvl) {
+      SstReader rd(f.path);
+      SstReader::Iterator it(&rd);
+      for (it.seek_to_first(); it.valid(); it.next()) {
+        if (it.flags() == SST_FLAG_BLOB) ++blobs;
+        if (it.flags() == SST_FLAG_PUT) ++inline_puts;
+      }
+    }
+  return {blobs, inline_puts};
+}
+
+static bool wait_metrics(KV& kv, uint64_t gc_runs, uint64_t files_deleted) {
+  for (int i = 0; i < 500; ++i) {
+    const auto m = kv.get_metrics();
+    if (m.blob_gc_runs >= gc_runs && m.blob_files_deleted >= files_deleted) return true;
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  return false;
+}
+
+TEST_CASE("Blob values: large values go to blob files, reads resolve references") {
+  auto dir = bldir("uringkv_blob_basic_");
+  auto opts = KVOptions{.path = dir, .sst_flush_threshold_bytes = 64 * 1024, .background_compaction = false,
+                        .l0_compact_threshold = 100, .blob_value_threshold = 1024};
+  {
+    KV kv(opts);
+    for (int i = 0; i < 200; ++i) REQUIRE(kv.put(bkey(i), bval(i, 1)));
+  } // финальный flush
+
+  const auto [blobs, inline_puts] = sst_flag_counts(dir);
+  REQUIRE(blobs == 100);       // чётные
+  REQUIRE(inline_puts == 100); // короткие остаются в SST
+  REQUIRE_FALSE(list_blob_files(dir + "/blob").empty());
+
+  KV kv(opts);
+  const auto m = kv.get_metrics();
+  REQUIRE(m.blob_files >= 1);
+  REQUIRE(m.blob_bytes >= 99 * 3000);
+  REQUIRE(m.blob_garbage_bytes == 0);
+  REQUIRE(kv.del(bkey(10)));
+
+  for (int i = 0; i < 200; ++i) {
+    auto v = kv.get(bkey(i));
+    if (i == 10) REQUIRE_FALSE(v.has_value());
+    else REQUIRE(v.value() == bval(i, 1));
+  }
+  std::vector<std::string> ks;
+  for (int i = 0; i < 200; i += 3) ks.push_back(bkey(i));
+  std::vector<std::string_view> views(ks.begin(), ks.end());
+  const auto got = kv.multi_get(views);
+  for (std::size_t j = 0; j < ks.size(); ++j) {
+    const int i = int(j) * 3;
+    if (i == 10) REQUIRE_FALSE(got[j].has_value());
+    else REQUIRE(got[j].value() == bval(i, 1));
+  }
+  const auto all = kv.scan("", "");
+  REQUIRE(all.size() == 199);
+  for (const auto& it : all) REQUIRE(it.value == bval(std::stoi(it.key.substr(3)), 1));
+}
+
+TEST_CASE("Blob values: compaction counts garbage, GC relocates live values and frees files") {
+  auto dir = bldir("uringkv_blob_gc_");
+  auto opts = KVOptions{.path = dir, .sst_flush_threshold_bytes = 64 * 1024, .l0_compact_threshold = 2,
+                        .blob_value_threshold = 1024, .blob_gc_garbage_ratio = 0.3,
+                        .final_flush_on_close = true};
+  {
+    KV kv(opts);
+    for (int i = 0; i < 100; ++i) REQUIRE(kv.put(bkey(i), bval(i, 1)));
+    auto snap = kv.snapshot();
+    // перезапись большей части: старые значения становятся мусором после компактации
+    for (int gen = 2; gen <= 4; ++gen)
+      for (int i = 0; i < 80; ++i) REQUIRE(kv.put(bkey(i), bval(i, gen)));
+    for (int i = 0; i < 300; ++i) REQUIRE(kv.put("pad" + std::to_string(i), std::string(400, 'p')));
+    REQUIRE(wait_metrics(kv, 1, 1));
+
+    const auto m = kv.get_metrics();
+    REQUIRE(m.blob_gc_relocated_bytes > 0);
+    REQUIRE(m.blob_bytes_written >= m.blob_bytes);
+    for (int i = 0; i < 100; ++i) {
+      REQUIRE(kv.get(bkey(i)).value() == bval(i, i < 80 ? 4 : 1));
+      // снимок держит первые версии: GC переносит и их
+      REQUIRE(kv.get(bkey(i), {.snapshot = snap.get()}).value() == bval(i, 1));
+    }
+  }
+
+  // после GC и перезапуска ссылки указывают на живые файлы
+  KV kv(opts);
+  for (int i = 0; i < 100; ++i) REQUIRE(kv.get(bkey(i)).value() == bval(i, i < 80 ? 4 : 1));
+  const auto m = kv.get_metrics();
+  REQUIRE(m.blob_files == list_blob_files(dir + "/blob").size());
+}
+
+TEST_CASE("Blob values: gc_blobs on demand, open iterator outlives deleted blob files") {
+  auto dir = bldir("uringkv_blob_manual_gc_");
+  // фоновый GC выключен порогом > 1, мусор копит фоновая компактация
+  KV kv({.path = dir, .sst_flush_threshold_bytes = 32 * 1024, .l0_compact_threshold = 2,
+         .blob_value_threshold = 1024, .blob_gc_garbage_ratio = 2.0});
+
+  for (int i = 0; i < 40; ++i) REQUIRE(kv.put(bkey(i), bval(i * 2, 1)));
+  REQUIRE(kv.put("z", std::string(40 * 1024, 'z'))); // переполнить MemTable
+  for (int i = 0; i < 30; ++i) REQUIRE(kv.put(bkey(i), bval(i * 2, 2)));
+  REQUIRE(kv.put("z", std::string(40 * 1024, 'y')));
+  for (int i = 0; i < 500 && kv.get_metrics().blob_garbage_bytes == 0; ++i)
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  auto m = kv.get_metrics();
+  REQUIRE(m.compactions >= 1);
+  REQUIRE(m.blob_garbage_bytes > 0);
+  REQUIRE(m.blob_gc_runs == 0);
+
+  KV::Iterator it(&kv);
+  REQUIRE(kv.gc_blobs(0.1));
+  m = kv.get_metrics();
+  REQUIRE(m.blob_files_deleted >= 1);
+  REQUIRE(m.blob_gc_relocated_bytes > 0);
+  REQUIRE(m.blob_garbage_bytes < m.blob_bytes / 10);
+
+  std::size_t n = 0;
+  for (it.seek_to_first(); it.valid(); it.next(), ++n) {
+    if (it.key() == "z") continue;
+    const int i = std::stoi(std::string(it.key().substr(3)));
+    REQUIRE(it.value() == bval(i * 2, i < 30 ? 2 : 1));
+  }
+  REQUIRE(n == 41);
+  for (int i = 0; i < 40; ++i) REQUIRE(kv.get(bkey(i)).value() == bval(i * 2, i < 30 ? 2 : 1));
+}
+
+TEST_CASE("Blob values: orphan blob files are removed, corrupt records are not returned") {
+  auto dir = bldir("uringkv_blob_recovery_");
+  auto opts = KVOptions{.path = dir, .background_compaction = false, .blob_value_threshold = 100};
+  {
+    KV kv(opts);
+    REQUIRE(kv.put("big", std::string(5000, 'b')));
+    REQUIRE(kv.put("small", "s"));
+  }
+  const auto files = list_blob_files(dir + "/blob");
+  REQUIRE(files.size() == 1);
+  { std::ofstream(dir + "/blob/" + blob_name(999), std::ios::binary) << "junk"; } // недокоммиченный flush
+  drop_clean_mark(dir + "/sst");
+
+  {
+    KV kv(opts);
+    REQUIRE(kv.get("big").value() == std::string(5000, 'b'));
+    REQUIRE(list_blob_files(dir + "/blob") == files);
+  }
+
+  {
+    std::fstream f(dir + "/blob/" + files[0], std::ios::in | std::ios::out | std::ios::binary);
+    f.seekp(sizeof(BlobFileHeader) + sizeof(BlobRecordHeader) + 3 + 100);
+    f.put('#');
+  }
+  KV kv(opts);
+  REQUIRE_FALSE(kv.get("big").has_value());
+  REQUIRE(kv.get("small").value() == "s");
+  REQUIRE(kv.scan("", "").size() == 1);
+}
@@ -0,0 +1,86 @@
+#ifdef __has_include
+#  if __has_include(<catch2/catch_all.hpp>)
+#    include <catch2/catch_all.hpp>
+#  else
+#    include <catch2/catch.hpp>
+#  endif
+#endif
+
+#include "cache/block_cache.hpp"
+#include "kv.hpp"
+
+#include <filesystem>
+#include <string>
+#include <unistd.h>
+
+using namespace uringkv;
+namespace fs = std::filesystem;
+
+static std::string bcdir(const char* p){
+  auto b = fs::temp_directory_path();
+  auto d = b / (std::string(p)+std::to_string(::getpid()));
+  fs::remove_all(d);
+  fs::create_directories(d);
+  return d.string();
+}
+
+TEST_CASE("BlockCache: byte budget, LRU eviction, erase by file") {
+  BlockCache c(64 * 1024, /*num_shard_bits=*/0); // один шард — порядок вытеснения предсказуем
+  REQUIRE(c.lookup(1, 0) == nullptr);
+  REQUIRE(c.misses() == 1);
+
+  for (uint64_t i = 0; i < 10; ++i) c.insert(1, i * 4096, std::string(4000, char('a' + i)));
+  REQUIRE(c.usage() <= c.capacity());
+  REQUIRE(c.lookup(1, 0)->at(0) == 'a');
+  REQUIRE(c.hits() == 1);
+
+  // ещё 10 блоков: вытесняются самые старые, но не только что прочитанный 0
+  for (uint64_t i = 10; i < 20; ++i) c.insert(1, i * 4096, std::string(4000, 'z'));
+  REQUIRE(c.evictions() > 0);
+  REQUIRE(c.usage() <= c.capacity());
+  REQUIRE(c.lookup(1, 0) != nullptr);
+  REQUIRE(c.lookup(1, 1 * 4096) == nullptr);
+
+  // Handle живёт после вытеснения
+  auto h = c.insert(2, 0, "keep");
+  c.erase_file(2);
+  REQUIRE(c.lookup(2, 0) == nullptr);
+  REQUIRE(*h == "keep");
+
+  // слишком большой блок не кэшируется
+  auto big = c.insert(3, 0, std::string(128 * 1024, 'b'));
+  REQUIRE(big->size() == 128 * 1024);
+  REQUIRE(c.lookup(3, 0) == nullptr);
+}
+
+TEST_CASE("BlockCache: repeated GETs are served from cache (v2 and v3)") {
+  for (uint32_t ver : {2u, 3u}) {
+    auto dir = bcdir(("uringkv_bcache_v" + std::to_string(ver) + "_").c_str());
+    {
+      KV kv({.path = dir, .sst_flush_threshold_bytes = 32 * 1024, .sst_format_version = ver,
+             .background_compaction = false, .l0_compact_threshold = 100});
+      for (int i = 0; i < 500; ++i) REQUIRE(kv.put("k" + std::to_string(i), "v" + std::to_string(i)));
+    }
+
+    KV kv({.path = dir, .sst_format_version = ver, .background_compaction = false,
+           .l0_compact_threshold = 100});
+    for (int i = 0; i < 100; ++i) REQUIRE(kv.get("k" + std::to_string(i)).value() == "v" + std::to_string(i));
+    const auto m1 = kv.get_metrics();
+    REQUIRE(m1.block_cache_misses > 0);
+    REQUIRE(m1.block_cache_usage > 0);
+
+    // второй проход по тем же ключам — только попадания
+    for (int i = 0; i < 100; ++i) REQUIRE(kv.get("k" + std::to_string(i)).value() == "v" + std::to_string(i));
+    const auto m2 = kv.get_metrics();
+    REQUIRE(m2.block_cache_misses == m1.block_cache_misses);
+    REQUIRE(m2.block_cache_hits >= m1.block_cache_hits + 100);
+  }
+
+  // кэш выключен
+  auto dir = bcdir("uringkv_bcache_off_");
+  KV kv({.path = dir, .sst_flush_threshold_bytes = 1024, .background_compaction = false,
+         .block_cache_bytes = 0});
+  for (int i = 0; i < 100; ++i) REQUIRE(kv.put("k" + std::to_string(i), std::string(64, 'x')));
+  REQUIRE(kv.get("k5").has_value());
+  REQUIRE(kv.get_metrics().block_cache_hits + kv.get_metrics().block_cache_misses == 0);
+}
@@ -0,0 +1,94 @@
+#ifdef __has_include
+#  if __has_include(<catch2/catch_all.hpp>)
+#    include <catch2/catch_all.hpp>
+#  else
+#    include <catch2/catch.hpp>
+#  endif
+#endif
+
+#include "kv.hpp"
+#include "sst/filter.hpp"
+#include "sst/index.hpp"
+#include "sst/table.hpp"
+#include "sst/writer.hpp"
+
+#include <filesystem>
+#include <string>
+#include <unistd.h>
+
+using namespace uringkv;
+namespace fs = std::filesystem;
+
+static std::string bldir(const char* p){
+  auto b = fs::temp_directory_path();
+  auto d = b / (std::string(p)+std::to_string(::getpid()));
+  fs::remove_all(d);
+  fs::create_directories(d);
+  return d.string();
+}
+
+static uint64_t khash(const std::string& k) { return sst_key_hash(k.data(), k.size()); }
+
+TEST_CASE("Blocked bloom: no false negatives, bounded false positive rate") {
+  constexpr int N = 20000;
+  BloomFilterBuilder b(10);
+  for (int i = 0; i < N; ++i) b.add_hash(sst_filter_key_hash(khash("in" + std::to_string(i))));
+  const std::string data = b.finish();
+
+  BloomFilter f;
+  REQUIRE(f.init(data));
+  for (int i = 0; i < N; ++i)
+    REQUIRE(f.may_contain(sst_filter_key_hash(khash("in" + std::to_string(i)))));
+
+  int fp = 0;
+  for (int i = 0; i < N; ++i)
+    if (f.may_contain(sst_filter_key_hash(khash("out" + std::to_string(i))))) ++fp;
+  REQUIRE(fp < N * 3 / 100); // ~1% при 10 бит/ключ
+
+  // битые данные не принимаются
+  std::string bad = data;
+  bad[bad.size() / 2] ^= 0x5a;
+  BloomFilter g;
+  REQUIRE_FALSE(g.init(bad));
+  REQUIRE_FALSE(g.init(std::string_view(data).substr(0, data.size() - 4)));
+}
+
+TEST_CASE("Bloom: SST filter block skips tables on GET misses") {
+  auto dir = bldir("uringkv_bloom_");
+  {
+    const auto p = dir + "/f.sst";
+    {
+      SstWriter w(p, SstWriterOptions{.bloom_bits_per_key = 10});
+      for (int i = 0; i < 1000; ++i) REQUIRE(w.add("k" + std::to_string(100000 + i), SST_FLAG_PUT, "v"));
+      REQUIRE(w.finish());
+    }
+    SstTable t(p);
+    REQUIRE(t.has_filter());
+    REQUIRE(t.may_contain(khash("k100500")));
+    REQUIRE(t.get("k100500").has_value());
+  }
+
+  for (uint32_t bits : {10u, 0u}) {
+    const auto db = dir + "/db" + std::to_string(bits);
+    {
+      KV kv({.path = db, .sst_flush_threshold_bytes = 16 * 1024, .bloom_bits_per_key = bits,
+             .background_compaction = false, .l0_compact_threshold = 100});
+      for (int i = 0; i < 2000; ++i) REQUIRE(kv.put("key" + std::to_string(i), std::string(32, 'v')));
+    }
+    KV kv({.path = db, .bloom_bits_per_key = bits, .background_compaction = false,
+           .l0_compact_threshold = 100});
+    REQUIRE(kv.get_metrics().sst_count > 1);
+    for (int i = 0; i < 2000; i += 7) REQUIRE(kv.get("key" + std::to_string(i)).has_value());
+    for (int i = 0; i < 2000; ++i) REQUIRE_FALSE(kv.get("key" + std::to_string(i) + "x").has_value());
+
+    const auto m = kv.get_metrics();
+    if (bits == 0) {
+      REQUIRE(m.bloom_checks == 0);
+      continue;
+    }
+    REQUIRE(m.bloom_checks == m.bloom_useful + m.bloom_hits + m.bloom_false_positives);
+    REQUIRE(m.bloom_hits == (2000 + 6) / 7);
+    REQUIRE(m.bloom_useful > 0);
+    REQUIRE(m.bloom_false_positives * 10 < m.bloom_useful);
+  }
+}
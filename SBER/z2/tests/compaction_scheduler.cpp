@@ -0,0 +1,118 @@
+#ifdef __has_include
+#  if __has_include(<catch2/catch_all.hpp>)
+#    include <catch2/catch_all.hpp>
+#  else
+#    include <catch2/catch.hpp>
+#  endif
+#endif
+
+#include "kv.hpp"
+#include "sst/manifest.hpp"
+
+#include <chrono>
+#include <filesystem>
+#include <map>
+#include <random>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+using namespace uringkv;
+namespace fs = std::filesystem;
+
+static std::string csdir(const char* p){
+  auto b = fs::temp_directory_path();
+  auto d = b / (std::string(p)+std::to_string(::getpid()));
+  fs::remove_all(d);
+  fs::create_directories(d);
+  return d.string();
+}
+
+static std::string ckey(int i) {
+  char b[32];
+  std::snprintf(b, sizeof(b), "key%06d", i);
+  return b;
+}
+
+static void check_model(KV& kv, const std::map<std::string, std::string>& model, int keys) {
+  for (int i = 0; i < keys; ++i) {
+    auto it = model.find(ckey(i));
+    auto v = kv.get(ckey(i));
+    if (it == model.end()) REQUIRE_FALSE(v.has_value());
+    else REQUIRE(v.value() == it->second);
+  }
+  REQUIRE(kv.scan("", "").size() == model.size());
+}
+
+TEST_CASE("Compaction scheduler: parallel leveled jobs keep levels disjoint and data intact") {
+  auto dir = csdir("uringkv_compaction_threads_");
+  auto opts = KVOptions{.path = dir, .sst_flush_threshold_bytes = 8 * 1024,
+                        .sst_target_file_bytes = 8 * 1024,
+                        .l0_compact_threshold = 2,
+                        .compaction_policy = CompactionPolicy::LEVELED,
+                        .level_base_bytes = 32 * 1024, .level_size_multiplier = 4,
+                        .max_levels = 4, .compaction_threads = 4, .max_subcompactions = 2};
+  std::map<std::string, std::string> model;
+  {
+    KV kv(opts);
+    std::mt19937 rng(11);
+    for (int i = 0; i < 8000; ++i) {
+      const std::string k = ckey(static_cast<int>(rng() % 2000));
+      if (rng() % 9 == 0) {
+        REQUIRE(kv.del(k));
+        model.erase(k);
+      } else {
+        const std::string v = "v" + std::to_string(i) + std::string(40, 'x');
+        REQUIRE(kv.put(k, v));
+        model[k] = v;
+      }
+    }
+    const auto m = kv.get_metrics();
+    REQUIRE(m.compactions > 0);
+    REQUIRE(m.compaction_parallel_peak >= 1);
+    REQUIRE(m.compaction_parallel_peak <= 4);
+    check_model(kv, model, 2000);
+  }
+
+  uint64_t last = 0;
+  SstLevels levels;
+  REQUIRE(read_manifest(dir + "/sst", last, levels));
+  for (size_t l = 1; l < levels.size(); ++l)
+    for (size_t i = 0; i < levels[l].size(); ++i) {
+      REQUIRE(fs::exists(levels[l][i].path));
+      if (i) REQUIRE(levels[l][i - 1].largest < levels[l][i].smallest);
+    }
+
+  KV kv(opts);
+  check_model(kv, model, 2000);
+}
+
+TEST_CASE("Compaction scheduler: large job is split into key-range subcompactions") {
+  auto dir = csdir("uringkv_subcompactions_");
+  auto opts = KVOptions{.path = dir, .sst_flush_threshold_bytes = 512 * 1024,
+                        .l0_compact_threshold = 4, .max_subcompactions = 4};
+  std::map<std::string, std::string> model;
+  {
+    KV kv(opts);
+    for (int round = 0; round < 2; ++round)
+      for (int i = 0; i < 2000; ++i) {
+        const std::string v = std::to_string(round) + std::string(1000, char('a' + i % 26));
+        REQUIRE(kv.put(ckey(i), v));
+        model[ckey(i)] = v;
+      }
+    for (int i = 0; i < 500 && kv.get_metrics().compactions == 0; ++i)
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    const auto m = kv.get_metrics();
+    REQUIRE(m.compactions >= 1);
+    REQUIRE(m.subcompactions >= 2);
+    check_model(kv, model, 2000);
+  }
+
+  // выходы частей не пересекаются и переживают переоткрытие
+  uint64_t last = 0;
+  SstLevels levels;
+  REQUIRE(read_manifest(dir + "/sst", last, levels));
+  KV kv(opts);
+  check_model(kv, model, 2000);
+}
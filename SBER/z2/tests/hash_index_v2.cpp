@@ -0,0 +1,114 @@
+#ifdef __has_include
+#  if __has_include(<catch2/catch_all.hpp>)
+#    include <catch2/catch_all.hpp>
+#  else
+#    include <catch2/catch.hpp>
+#  endif
+#endif
+
+#include "sst/index.hpp"
+#include "sst/table.hpp"
+#include "sst/writer.hpp"
+
+#include <cstring>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <unistd.h>
+
+using namespace uringkv;
+namespace fs = std::filesystem;
+
+static std::string hidir(const char* p){
+  auto b = fs::temp_directory_path();
+  auto d = b / (std::string(p)+std::to_string(::getpid()));
+  fs::remove_all(d);
+  fs::create_directories(d);
+  return d.string();
+}
+
+static std::string key_of(int i) {
+  char buf[32];
+  std::snprintf(buf, sizeof(buf), "key%08d", i);
+  return buf;
+}
+
+TEST_CASE("Hash index v2: SIMD tag match equals the scalar one") {
+  std::mt19937_64 rng(42);
+  for (int round = 0; round < 2000; ++round) {
+    HashIndexBucket b;
+    std::memset(&b, 0, sizeof(b));
+    for (uint32_t i = 0; i < kHidxBucketSlots; ++i)
+      b.tag[i] = (rng() % 3 == 0) ? 0 : static_cast<uint16_t>(1 + rng() % 4); // много совпадений
+    const auto tag = static_cast<uint16_t>(1 + rng() % 4);
+    const auto s = hidx_match_scalar(b, tag);
+    const auto v = hidx_match_simd(b, tag);
+    REQUIRE(s.hits == v.hits);
+    REQUIRE(s.empty == v.empty);
+  }
+}
+
+TEST_CASE("Hash index v2: point lookups, misses and ~4x smaller than v1") {
+  auto dir = hidir("uringkv_hidx2_");
+  constexpr int N = 20000;
+  const auto p1 = dir + "/v1.sst", p2 = dir + "/v2.sst";
+  for (uint32_t ver : {kHidxVersionV1, kHidxVersionV2}) {
+    SstWriter w(ver == kHidxVersionV1 ? p1 : p2, SstWriterOptions{.hash_index_version = ver});
+    for (int i = 0; i < N; ++i) {
+      // две версии у каждого десятого ключа
+      if (i % 10 == 0) REQUIRE(w.add(key_of(i), SST_FLAG_PUT, "new" + std::to_string(i), 200 + i));
+      REQUIRE(w.add(key_of(i), SST_FLAG_PUT, "val" + std::to_string(i), 100));
+    }
+    REQUIRE(w.finish());
+    REQUIRE(w.hash_index_version() == ver);
+  }
+
+  SstTable t1(p1), t2(p2);
+  REQUIRE(t1.hash_index_version() == kHidxVersionV1);
+  REQUIRE(t2.hash_index_version() == kHidxVersionV2);
+  REQUIRE(t2.hash_index_bytes() * 4 <= t1.hash_index_bytes());
+
+  for (int i = 0; i < N; ++i) {
+    const auto k = key_of(i);
+    auto r = t2.get(k);
+    REQUIRE(r);
+    REQUIRE(r->second == (i % 10 == 0 ? "new" : "val") + std::to_string(i));
+    if (i % 10 == 0) {
+      auto old = t2.get(k, /*snapshot=*/150);
+      REQUIRE(old);
+      REQUIRE(old->second == "val" + std::to_string(i));
+    }
+    REQUIRE_FALSE(t2.get("miss" + std::to_string(i)));
+  }
+
+  // двухфазный GET (multi_get) идёт через тот же индекс
+  for (int i = 0; i < N; i += 97) {
+    SstTable::PendingRead rd;
+    std::optional<std::pair<uint32_t, std::string>> out;
+    if (!t2.prepare_get(key_of(i), rd, out)) {
+      std::string data(rd.size, '\0');
+      REQUIRE(::pread(t2.fd(), data.data(), data.size(), (off_t)rd.offset) == (ssize_t)data.size());
+      out = t2.finish_get(key_of(i), rd, data);
+    }
+    REQUIRE(out);
+    REQUIRE(out->second == (i % 10 == 0 ? "new" : "val") + std::to_string(i));
+  }
+  fs::remove_all(dir);
+}
+
+TEST_CASE("Hash index v2: more than 65536 blocks falls back to v1") {
+  auto dir = hidir("uringkv_hidx2_big_");
+  const auto p = dir + "/big.sst";
+  constexpr int N = 70000;
+  {
+    SstWriter w(p, SstWriterOptions{.block_size = 16}); // по ключу на блок
+    for (int i = 0; i < N; ++i) REQUIRE(w.add(key_of(i), SST_FLAG_PUT, "v", 1));
+    REQUIRE(w.finish());
+    REQUIRE(w.hash_index_version() == kHidxVersionV1);
+  }
+  SstTable t(p);
+  REQUIRE(t.hash_index_version() == kHidxVersionV1);
+  for (int i = 0; i < N; i += 1013) REQUIRE(t.get(key_of(i)));
+  REQUIRE_FALSE(t.get("nope"));
+  fs::remove_all(dir);
+}
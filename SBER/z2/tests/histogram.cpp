@@ -0,0 +1,70 @@
+#ifdef __has_include
+#  if __has_include(<catch2/catch_all.hpp>)
+#    include <catch2/catch_all.hpp>
+#  else
+#    include <catch2/catch.hpp>
+#  endif
+#endif
+
+#include "histogram.hpp"
+
+#include <algorithm>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace uringkv;
+
+TEST_CASE("LatencyHistogram: percentiles within 1/64 relative error") {
+  LatencyHistogram h;
+  std::mt19937_64 rng(7);
+  std::vector<uint64_t> vals;
+  for (int i = 0; i < 100000; ++i) {
+    const uint64_t v = 100 + rng() % 5'000'000; // 100 нс .. 5 мс
+    vals.push_back(v);
+    h.record(v);
+  }
+  std::sort(vals.begin(), vals.end());
+  REQUIRE(h.count() == vals.size());
+  REQUIRE(h.min() == vals.front());
+  REQUIRE(h.max() == vals.back());
+  for (double p : {1.0, 50.0, 90.0, 99.0, 99.9}) {
+    const uint64_t exact = vals[static_cast<std::size_t>(p / 100.0 * double(vals.size())) - 1];
+    const uint64_t got = h.percentile(p);
+    REQUIRE(got >= exact);
+    REQUIRE(double(got - exact) <= double(exact) / 64.0 + 1);
+  }
+  REQUIRE(h.percentile(100) == vals.back());
+
+  // малые значения — точно; запредельные — в последней корзине
+  LatencyHistogram s;
+  for (uint64_t v = 0; v < 100; ++v) s.record(v);
+  REQUIRE(s.percentile(50) == 49);
+  s.record(UINT64_MAX / 2);
+  REQUIRE(s.max() == UINT64_MAX / 2);
+  REQUIRE(s.percentile(100) >= LatencyHistogram::max_value() / 2);
+}
+
+TEST_CASE("LatencyHistogram: concurrent record, merge and reset") {
+  LatencyHistogram a, b;
+  std::vector<std::thread> th;
+  for (int t = 0; t < 4; ++t)
+    th.emplace_back([&, t] { for (int i = 0; i < 10000; ++i) (t % 2 ? a : b).record(1000 + i); });
+  for (auto& t : th) t.join();
+  REQUIRE(a.count() == 20000);
+  REQUIRE(b.count() == 20000);
+
+  LatencyHistogram m;
+  m.merge(a);
+  m.merge(b);
+  REQUIRE(m.count() == 40000);
+  REQUIRE(m.sum() == a.sum() + b.sum());
+  REQUIRE(m.min() == 1000);
+  REQUIRE(m.max() == 10999);
+  REQUIRE(m.percentile(50) >= 5999);
+
+  m.reset();
+  REQUIRE(m.count() == 0);
+  REQUIRE(m.percentile(99) == 0);
+  REQUIRE(m.min() == 0);
+}
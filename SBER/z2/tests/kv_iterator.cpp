@@ -0,0 +1,167 @@
+#ifdef __has_include
+#  if __has_include(<catch2/catch_all.hpp>)
+#    include <catch2/catch_all.hpp>
+#  else
+#    include <catch2/catch.hpp>
+#  endif
+#endif
+
+#include "kv.hpp"
+
+#include <filesystem>
+#include <map>
+#include <random>
+#include <string>
+#include <unistd.h>
+
+using namespace uringkv;
+namespace fs = std::filesystem;
+
+static std::string itdir(const char* p){
+  auto b = fs::temp_directory_path();
+  auto d = b / (std::string(p)+std::to_string(::getpid()));
+  fs::remove_all(d);
+  fs::create_directories(d);
+  return d.string();
+}
+
+static std::string ikey(int i) {
+  char b[32];
+  std::snprintf(b, sizeof(b), "k%02d/%05d", i % 10, i);
+  return b;
+}
+
+TEST_CASE("KV::Iterator: merge of MemTable and SST levels, seek, prefix, limit") {
+  auto dir = itdir("uringkv_iter_");
+  KV kv({.path = dir, .sst_flush_threshold_bytes = 8 * 1024, .sst_target_file_bytes = 8 * 1024,
+         .l0_compact_threshold = 2, .compaction_policy = CompactionPolicy::LEVELED,
+         .level_base_bytes = 32 * 1024, .level_size_multiplier = 4, .max_levels = 4});
+
+  std::map<std::string, std::string> model;
+  std::mt19937 rng(11);
+  for (int i = 0; i < 5000; ++i) {
+    const auto k = ikey(int(rng() % 2000));
+    if (rng() % 5 == 0) {
+      REQUIRE(kv.del(k));
+      model.erase(k);
+    } else {
+      const auto v = "v" + std::to_string(i);
+      REQUIRE(kv.put(k, v));
+      model[k] = v;
+    }
+  }
+  REQUIRE(kv.get_metrics().sst_count > 1);
+
+  // полный проход
+  {
+    KV::Iterator it(&kv);
+    auto m = model.begin();
+    for (it.seek_to_first(); it.valid(); it.next(), ++m) {
+      REQUIRE(m != model.end());
+      REQUIRE(it.key() == m->first);
+      REQUIRE(it.value() == m->second);
+    }
+    REQUIRE(m == model.end());
+
+    // seek на отсутствующий ключ — следующий существующий
+    it.seek("k03/00500x");
+    REQUIRE(it.valid());
+    REQUIRE(it.key() == model.upper_bound("k03/00500x")->first);
+  }
+
+  // префикс + лимит
+  {
+    KV::Iterator it(&kv, {.prefix = "k07/", .limit = 25});
+    std::size_t n = 0;
+    auto m = model.lower_bound("k07/");
+    for (it.seek_to_first(); it.valid(); it.next(), ++m, ++n) REQUIRE(it.key() == m->first);
+    REQUIRE(n == 25);
+
+    KV::Iterator all(&kv, {.prefix = "k07/"});
+    n = 0;
+    for (all.seek("a"); all.valid(); all.next(), ++n) REQUIRE(all.key().starts_with("k07/"));
+    REQUIRE(n == size_t(std::distance(model.lower_bound("k07/"), model.lower_bound("k08/"))));
+  }
+
+  // верхняя граница включительно — как у scan
+  auto part = kv.scan(ikey(10), ikey(19));
+  REQUIRE(part.size() == size_t(std::distance(model.lower_bound(ikey(10)), model.upper_bound(ikey(19)))));
+}
+
+TEST_CASE("KV::Iterator: sees a consistent snapshot while writes and flushes continue") {
+  auto dir = itdir("uringkv_iter_snap_");
+  KV kv({.path = dir, .sst_flush_threshold_bytes = 4 * 1024, .background_compaction = false,
+         .l0_compact_threshold = 100});
+  for (int i = 0; i < 200; ++i) REQUIRE(kv.put(ikey(i), "old"));
+
+  KV::Iterator it(&kv);
+
+  // после снимка: перезапись, удаление, новые ключи, несколько flush
+  for (int i = 0; i < 200; i += 2) REQUIRE(kv.put(ikey(i), std::string(64, 'n')));
+  for (int i = 1; i < 200; i += 4) REQUIRE(kv.del(ikey(i)));
+  for (int i = 200; i < 400; ++i) REQUIRE(kv.put(ikey(i), std::string(64, 'n')));
+  REQUIRE(kv.get_metrics().sst_flushes > 0);
+
+  std::size_t n = 0;
+  for (it.seek_to_first(); it.valid(); it.next(), ++n) REQUIRE(it.value() == "old");
+  REQUIRE(n == 200);
+
+  // новый итератор видит всё
+  KV::Iterator now(&kv);
+  n = 0;
+  for (now.seek_to_first(); now.valid(); now.next()) ++n;
+  REQUIRE(n == 400 - 50);
+}
+
+TEST_CASE("KV::Iterator: tables from TableCache, blocks through BlockCache, opened lazily") {
+  auto dir = itdir("uringkv_iter_cache_");
+  const uint32_t format = GENERATE(2u, 3u);
+  // LEVELED: таблицы L1+ по 8 KiB не пересекаются
+  KVOptions o{.path = dir, .sst_flush_threshold_bytes = 8 * 1024, .sst_format_version = format,
+              .sst_target_file_bytes = 8 * 1024, .l0_compact_threshold = 2,
+              .compaction_policy = CompactionPolicy::LEVELED, .level_base_bytes = 32 * 1024,
+              .level_size_multiplier = 4, .max_levels = 4};
+  std::map<std::string, std::string> model;
+  {
+    KV kv(o);
+    REQUIRE(kv.init_storage_layout());
+    for (int i = 0; i < 2000; ++i) {
+      model[ikey(i)] = "v" + std::to_string(i) + std::string(100, 'x');
+      REQUIRE(kv.put(ikey(i), model[ikey(i)]));
+    }
+  }
+
+  {
+    KV kv(o);
+    const auto m0 = kv.get_metrics();
+    REQUIRE(m0.sst_count > 4);
+    REQUIRE(m0.table_cache_opens == 0);
+
+    // короткий проход от seek открывает не все таблицы
+    auto read = [&](std::string_view from, int n) {
+      KV::Iterator it(&kv);
+      auto m = model.lower_bound(std::string(from));
+      for (it.seek(from); it.valid() && n > 0; it.next(), ++m, --n) {
+        REQUIRE(it.key() == m->first);
+        REQUIRE(it.value() == m->second);
+      }
+    };
+    read("k05/00995", 3);
+    const auto m1 = kv.get_metrics();
+    REQUIRE(m1.table_cache_opens > 0);
+    REQUIRE(m1.table_cache_opens < m0.sst_count);
+
+    // повтор — таблицы из TableCache, блоки (записи v2) из BlockCache
+    read("k05/00995", 3);
+    const auto m2 = kv.get_metrics();
+    REQUIRE(m2.table_cache_opens == m1.table_cache_opens);
+    REQUIRE(m2.block_cache_hits > m1.block_cache_hits);
+
+    // полный проход по-прежнему видит всё
+    std::size_t n = 0;
+    KV::Iterator it(&kv);
+    for (it.seek_to_first(); it.valid(); it.next()) ++n;
+    REQUIRE(n == model.size());
+  }
+  fs::remove_all(dir);
+}
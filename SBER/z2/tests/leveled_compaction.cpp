@@ -0,0 +1,141 @@
+#ifdef __has_include
+#  if __has_include(<catch2/catch_all.hpp>)
+#    include <catch2/catch_all.hpp>
+#  else
+#    include <catch2/catch.hpp>
+#  endif
+#endif
+
+#include "kv.hpp"
+#include "sst/manifest.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <random>
+#include <string>
+#include <unistd.h>
+
+using namespace uringkv;
+namespace fs = std::filesystem;
+
+static std::string lvdir(const char* p){
+  auto b = fs::temp_directory_path();
+  auto d = b / (std::string(p)+std::to_string(::getpid()));
+  fs::remove_all(d);
+  fs::create_directories(d);
+  return d.string();
+}
+
+// сбой после последней правки: отметка закрытия (последний commit) оборвана,
+// открытие сверяет каталоги с MANIFEST
+static void drop_clean_mark(const std::string& sst_dir) {
+  const auto path = sst_dir + "/MANIFEST";
+  std::string body;
+  {
+    std::ifstream in(path, std::ios::binary);
+    body.assign(std::istreambuf_iterator<char>(in), {});
+  }
+  body.pop_back();
+  body.resize(body.rfind('\n') + 1);
+  std::ofstream(path, std::ios::binary | std::ios::trunc) << body;
+}
+
+static std::string lkey(int i) {
+  char b[32];
+  std::snprintf(b, sizeof(b), "key%06d", i);
+  return b;
+}
+
+static KVOptions leveled_opts(const std::string& dir) {
+  return KVOptions{.path = dir, .sst_flush_threshold_bytes = 8 * 1024,
+                   .sst_target_file_bytes = 8 * 1024,
+                   .l0_compact_threshold = 2,
+                   .compaction_policy = CompactionPolicy::LEVELED,
+                   .level_base_bytes = 32 * 1024, .level_size_multiplier = 4,
+                   .max_levels = 4};
+}
+
+TEST_CASE("Leveled compaction: non-overlapping levels, newest wins, tombstones") {
+  auto dir = lvdir("uringkv_leveled_");
+  std::map<std::string, std::string> model;
+  {
+    KV kv(leveled_opts(dir));
+    std::mt19937 rng(7);
+    for (int i = 0; i < 6000; ++i) {
+      const std::string k = lkey(static_cast<int>(rng() % 1500));
+      if (rng() % 8 == 0) {
+        REQUIRE(kv.del(k));
+        model.erase(k);
+      } else {
+        const std::string v = "v" + std::to_string(i) + std::string(40, 'x');
+        REQUIRE(kv.put(k, v));
+        model[k] = v;
+      }
+    }
+    REQUIRE(kv.get_metrics().compactions > 0);
+  }
+
+  uint64_t last = 0;
+  SstLevels levels;
+  REQUIRE(read_manifest(dir + "/sst", last, levels));
+  size_t deep = 0;
+  for (size_t l = 1; l < levels.size(); ++l) {
+    for (size_t i = 0; i < levels[l].size(); ++i) {
+      const auto& f = levels[l][i];
+      REQUIRE(fs::exists(f.path));
+      REQUIRE(f.smallest <= f.largest);
+      REQUIRE(f.index <= last);
+      if (i) REQUIRE(levels[l][i - 1].largest < f.smallest);
+      if (l >= 2) ++deep;
+    }
+  }
+  REQUIRE(deep > 0);
+
+  KV kv(leveled_opts(dir));
+  for (int i = 0; i < 1500; ++i) {
+    auto it = model.find(lkey(i));
+    auto v = kv.get(lkey(i));
+    if (it == model.end()) REQUIRE_FALSE(v.has_value());
+    else REQUIRE(v.value() == it->second);
+  }
+  auto all = kv.scan("", "");
+  REQUIRE(all.size() == model.size());
+  auto part = kv.scan(lkey(100), lkey(199));
+  REQUIRE(part.size() == size_t(std::distance(model.lower_bound(lkey(100)),
+                                              model.upper_bound(lkey(199)))));
+}
+
+TEST_CASE("MANIFEST: unlisted SSTs removed, legacy directory loaded as L0") {
+  auto dir = lvdir("uringkv_manifest_");
+  {
+    KV kv({.path = dir, .sst_flush_threshold_bytes = 4 * 1024,
+           .background_compaction = false, .l0_compact_threshold = 100});
+    for (int i = 0; i < 300; ++i) REQUIRE(kv.put(lkey(i), std::string(50, 'a')));
+  }
+  const auto sst_dir = fs::path(dir) / "sst";
+  uint64_t last = 0;
+  SstLevels levels;
+  REQUIRE(read_manifest(sst_dir.string(), last, levels));
+  REQUIRE(levels[0].size() > 1);
+  for (size_t i = 1; i < levels[0].size(); ++i)
+    REQUIRE(levels[0][i - 1].index < levels[0][i].index);
+
+  // недокоммиченная компактация оставила файл вне MANIFEST
+  const auto orphan = sst_dir / sst_name(last + 5);
+  fs::copy_file(levels[0][0].path, orphan);
+  drop_clean_mark(sst_dir.string());
+  {
+    KV kv({.path = dir, .background_compaction = false, .l0_compact_threshold = 100});
+    REQUIRE_FALSE(fs::exists(orphan));
+    REQUIRE(kv.scan("", "").size() == 300);
+  }
+
+  // каталог старого формата: без MANIFEST все SST читаются как L0
+  fs::remove(sst_dir / "MANIFEST");
+  KV kv({.path = dir, .background_compaction = false, .l0_compact_threshold = 100});
+  REQUIRE(kv.get(lkey(299)).value() == std::string(50, 'a'));
+  REQUIRE(kv.scan("", "").size() == 300);
+  REQUIRE(fs::exists(sst_dir / "MANIFEST"));
+}
@@ -0,0 +1,140 @@
+#ifdef __has_include
+#  if __has_include(<catch2/catch_all.hpp>)
+#    include <catch2/catch_all.hpp>
+#  else
+#    include <catch2/catch.hpp>
+#  endif
+#endif
+
+#include "kv.hpp"
+#include "sst/manifest.hpp"
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace uringkv;
+namespace fs = std::filesystem;
+
+static std::string mldir(const char* p){
+  auto b = fs::temp_directory_path();
+  auto d = b / (std::string(p)+std::to_string(::getpid()));
+  fs::remove_all(d);
+  fs::create_directories(d);
+  return d.string();
+}
+
+static std::string mkey(int i) {
+  char b[32];
+  std::snprintf(b, sizeof(b), "key%06d", i);
+  return b;
+}
+
+static std::vector<std::string> sst_paths(const std::string& sst_dir) {
+  uint64_t last = 0;
+  SstLevels levels;
+  std::vector<std::string> out;
+  if (!read_manifest(sst_dir, last, levels)) return out;
+  for (const auto& lvl : levels)
+    for (const auto& f : lvl) out.push_back(f.path);
+  return out;
+}
+
+// фон утих: компактаций не идёт, версия одна, и ~200 мс не было ни flush'а,
+// ни новой компактации (до 10 с)
+static void wait_background_idle(KV& kv) {
+  uint64_t done = UINT64_MAX;
+  for (int i = 0, quiet = 0; i < 1000 && quiet < 20; ++i) {
+    const auto m = kv.get_metrics();
+    const uint64_t now = m.sst_flushes + m.compactions;
+    quiet = (m.compactions_running == 0 && m.live_versions == 1 && now == done) ? quiet + 1 : 0;
+    done = now;
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+}
+
+TEST_CASE("MANIFEST log: flushes append edits, clean close is marked, long log is rewritten") {
+  auto dir = mldir("uringkv_manifest_log_");
+  auto opts = KVOptions{.path = dir, .sst_flush_threshold_bytes = 4 * 1024,
+                        .background_compaction = false, .l0_compact_threshold = 100};
+  {
+    KV kv(opts);
+    for (int i = 0; i < 400; ++i) REQUIRE(kv.put(mkey(i), std::string(50, 'a')));
+    const auto m = kv.get_metrics();
+    REQUIRE(m.sst_count > 3);
+    // снимок при создании, пустая правка открытия и по правке на flush
+    REQUIRE(m.manifest_edits >= m.sst_count + 1);
+    REQUIRE(m.manifest_rewrites == 0);
+    REQUIRE(m.live_versions == 1);
+  }
+
+  uint64_t last = 0;
+  SstLevels levels;
+  ManifestStatus st;
+  REQUIRE(read_manifest(dir + "/sst", last, levels, nullptr, &st));
+  REQUIRE(st.clean);
+  REQUIRE_FALSE(st.torn);
+  REQUIRE(levels[0].size() > 3);
+  REQUIRE(last >= levels[0].back().index);
+
+  // оборванная правка в хвосте отбрасывается, журнал переписывается снимком
+  { std::ofstream(dir + "/sst/MANIFEST", std::ios::app) << "file 0 777 10 1 1 x61 x62\nlast 777\n"; }
+  REQUIRE(read_manifest(dir + "/sst", last, levels, nullptr, &st));
+  REQUIRE(st.torn);
+  REQUIRE_FALSE(st.clean);
+  for (const auto& f : levels[0]) REQUIRE(f.index != 777);
+
+  opts.manifest_max_bytes = 1024;
+  {
+    KV kv(opts);
+    REQUIRE(kv.scan("", "").size() == 400);
+    for (int i = 400; i < 1200; ++i) REQUIRE(kv.put(mkey(i), std::string(50, 'b')));
+    REQUIRE(kv.get_metrics().manifest_rewrites > 0);
+  }
+  REQUIRE(read_manifest(dir + "/sst", last, levels, nullptr, &st));
+  REQUIRE(st.clean);
+  REQUIRE_FALSE(st.torn);
+
+  KV kv(opts);
+  REQUIRE(kv.scan("", "").size() == 1200);
+  REQUIRE(kv.get(mkey(1199)).value() == std::string(50, 'b'));
+}
+
+TEST_CASE("Versions: compacted SSTs stay on disk while an iterator holds the old version") {
+  auto dir = mldir("uringkv_versions_");
+  auto opts = KVOptions{.path = dir, .sst_flush_threshold_bytes = 4 * 1024, .l0_compact_threshold = 3};
+  KV kv(opts);
+  for (int i = 0; i < 100; ++i) REQUIRE(kv.put(mkey(i), std::string(60, 'a')));
+  for (int i = 0; i < 500 && kv.get_metrics().sst_count == 0; ++i)
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  const auto before = sst_paths(dir + "/sst");
+  REQUIRE_FALSE(before.empty());
+
+  auto it = std::make_unique<KV::Iterator>(&kv);
+  // новые flush'и запускают компактацию, старые SST выбывают из дерева
+  for (int round = 0; round < 3; ++round)
+    for (int i = 0; i < 100; ++i) REQUIRE(kv.put(mkey(i), std::string(60, char('b' + round))));
+  for (int i = 0; i < 500 && kv.get_metrics().compactions == 0; ++i)
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  REQUIRE(kv.get_metrics().compactions > 0);
+  REQUIRE(kv.get_metrics().live_versions >= 2);
+  for (const auto& p : before) REQUIRE(fs::exists(p));
+
+  // итератор читает свою версию целиком
+  int n = 0;
+  for (it->seek_to_first(); it->valid(); it->next(), ++n) REQUIRE(it->value() == std::string(60, 'a'));
+  REQUIRE(n == 100);
+
+  it.reset();
+  // фоновые flush и компактация ещё могут держать свою версию
+  wait_background_idle(kv);
+  const auto m = kv.get_metrics();
+  REQUIRE(m.live_versions == 1);
+  REQUIRE(m.sst_files_deleted > 0);
+  for (const auto& p : before) REQUIRE_FALSE(fs::exists(p));
+  REQUIRE(kv.get(mkey(5)).value() == std::string(60, 'd'));
+}
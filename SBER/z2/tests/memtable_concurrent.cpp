@@ -0,0 +1,175 @@
+#ifdef __has_include
+#  if __has_include(<catch2/catch_all.hpp>)
+#    include <catch2/catch_all.hpp>
+#  else
+#    include <catch2/catch.hpp>
+#  endif
+#endif
+
+#include "kv.hpp"
+#include "memtable/memtable.hpp"
+#include "wal/record.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace uringkv;
+namespace fs = std::filesystem;
+
+static std::string mdir(const char* p){
+  auto b = fs::temp_directory_path();
+  auto d = b / (std::string(p)+std::to_string(::getpid()));
+  fs::remove_all(d);
+  fs::create_directories(d);
+  return d.string();
+}
+
+static std::string mkey(int i) {
+  char b[32];
+  std::snprintf(b, sizeof(b), "key%08d", i);
+  return b;
+}
+
+TEST_CASE("MemTable: ordered versions, newest wins, tombstones") {
+  MemTable mt;
+  REQUIRE(mt.empty());
+  mt.add(1, WAL_FLAG_PUT, "b", "b1");
+  mt.add(2, WAL_FLAG_PUT, "a", "a1");
+  mt.add(3, WAL_FLAG_PUT, "b", "b2");
+  mt.add(4, WAL_FLAG_DEL, "c", "");
+  mt.add(5, WAL_FLAG_PUT, "", "empty-key");
+
+  std::optional<std::string> v;
+  REQUIRE(mt.get("b", v));
+  REQUIRE(v.value() == "b2");
+  REQUIRE(mt.get("c", v));
+  REQUIRE_FALSE(v.has_value());
+  REQUIRE(mt.get("", v));
+  REQUIRE(v.value() == "empty-key");
+  REQUIRE_FALSE(mt.get("bb", v));
+
+  // все версии: key asc, seqno desc
+  std::vector<std::pair<std::string, uint64_t>> all;
+  MemTable::Iterator it(&mt);
+  for (it.seek_to_first(); it.valid(); it.next()) all.emplace_back(it.key(), it.seqno());
+  REQUIRE(all == std::vector<std::pair<std::string, uint64_t>>{
+                     {"", 5}, {"a", 2}, {"b", 3}, {"b", 1}, {"c", 4}});
+
+  // только последние версии
+  std::vector<std::string> latest;
+  for (it.seek("a"); it.valid(); it.next_key()) latest.emplace_back(it.value());
+  REQUIRE(latest == std::vector<std::string>{"a1", "b2", ""});
+  REQUIRE(mt.entries() == 5);
+}
+
+TEST_CASE("MemTable: lock-free readers while a writer inserts") {
+  MemTable mt;
+  constexpr int N = 20000;
+  std::atomic<int> published{0};
+  std::atomic<bool> stop{false};
+  std::atomic<int> errors{0};
+
+  // писатель вставляет ключи в перемешанном порядке
+  std::vector<int> order(N);
+  for (int i = 0; i < N; ++i) order[i] = i;
+  std::shuffle(order.begin(), order.end(), std::mt19937(42));
+
+  std::vector<std::thread> readers;
+  for (int r = 0; r < 4; ++r) {
+    readers.emplace_back([&, r] {
+      std::mt19937 rng(r);
+      while (!stop.load()) {
+        const int n = published.load(std::memory_order_acquire);
+        if (n > 0) {
+          // всё опубликованное обязано находиться
+          const int i = order[rng() % n];
+          std::optional<std::string> v;
+          if (!mt.get(mkey(i), v) || v != std::to_string(i)) ++errors;
+        }
+        // итерация всегда строго упорядочена
+        MemTable::Iterator it(&mt);
+        std::string prev;
+        int seen = 0;
+        for (it.seek_to_first(); it.valid() && seen < 500; it.next(), ++seen) {
+          if (seen && std::string(it.key()) <= prev) ++errors;
+          prev.assign(it.key());
+        }
+      }
+    });
+  }
+
+  for (int i = 0; i < N; ++i) {
+    mt.add(static_cast<uint64_t>(i + 1), WAL_FLAG_PUT, mkey(order[i]), std::to_string(order[i]));
+    published.store(i + 1, std::memory_order_release);
+  }
+  stop.store(true);
+  for (auto& t : readers) t.join();
+
+  REQUIRE(errors.load() == 0);
+  REQUIRE(mt.entries() == uint64_t(N));
+}
+
+TEST_CASE("KV: multi-reader/multi-writer stress with flushes and compaction") {
+  auto dir = mdir("uringkv_mt_stress_");
+  constexpr int kWriters = 4, kReaders = 4, kPerWriter = 1500;
+
+  std::atomic<int> errors{0};
+  std::atomic<int> done_writers{0};
+  {
+    KV kv({.path = dir, .sst_flush_threshold_bytes = 32 * 1024,
+           .l0_compact_threshold = 3});
+
+    std::vector<std::thread> th;
+    for (int w = 0; w < kWriters; ++w) {
+      th.emplace_back([&, w] {
+        for (int i = 0; i < kPerWriter; ++i) {
+          const int id = w * kPerWriter + i;
+          if (!kv.put(mkey(id), "v" + std::to_string(id))) ++errors;
+          if (i % 10 == 9 && !kv.del(mkey(id - 5))) ++errors; // каждый 10-й удаляет свой ключ
+        }
+        ++done_writers;
+      });
+    }
+    for (int r = 0; r < kReaders; ++r) {
+      th.emplace_back([&, r] {
+        std::mt19937 rng(100 + r);
+        while (done_writers.load() < kWriters) {
+          const int id = static_cast<int>(rng() % (kWriters * kPerWriter));
+          auto v = kv.get(mkey(id));
+          if (v && *v != "v" + std::to_string(id)) ++errors; // чужое значение
+          if (rng() % 64 == 0) {
+            auto items = kv.scan(mkey(id), mkey(id + 200));
+            for (size_t i = 1; i < items.size(); ++i)
+              if (items[i - 1].key >= items[i].key) ++errors;
+          }
+        }
+      });
+    }
+    for (auto& t : th) t.join();
+    REQUIRE(errors.load() == 0);
+
+    auto check = [&](KV& db) {
+      for (int w = 0; w < kWriters; ++w) {
+        for (int i = 0; i < kPerWriter; ++i) {
+          const int id = w * kPerWriter + i;
+          const bool deleted = (i + 5) % 10 == 9 && i + 5 < kPerWriter;
+          auto v = db.get(mkey(id));
+          if (deleted) REQUIRE_FALSE(v.has_value());
+          else REQUIRE(v.value() == "v" + std::to_string(id));
+        }
+      }
+    };
+    check(kv);
+    REQUIRE(kv.get_metrics().sst_flushes > 0);
+  }
+
+  KV kv({.path = dir});
+  auto all = kv.scan("", "");
+  REQUIRE(all.size() == size_t(kWriters) * (kPerWriter - kPerWriter / 10));
+}
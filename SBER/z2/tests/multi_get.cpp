@@ -0,0 +1,157 @@
+#ifdef __has_include
+#  if __has_include(<catch2/catch_all.hpp>)
+#    include <catch2/catch_all.hpp>
+#  else
+#    include <catch2/catch.hpp>
+#  endif
+#endif
+
+#include "kv.hpp"
+#include "wal/uring_backend.hpp"
+
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <random>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using namespace uringkv;
+namespace fs = std::filesystem;
+
+static std::string mgdir(const char* p){
+  auto b = fs::temp_directory_path();
+  auto d = b / (std::string(p)+std::to_string(::getpid()));
+  fs::remove_all(d);
+  fs::create_directories(d);
+  return d.string();
+}
+
+static std::string mkey(int i) {
+  char b[32];
+  std::snprintf(b, sizeof(b), "key%06d", i);
+  return b;
+}
+
+TEST_CASE("UringBackend: read_batch completes every op (uring or pread fallback)") {
+  auto dir = mgdir("uringkv_read_batch_");
+  const auto path = dir + "/f.bin";
+  std::string data;
+  for (int i = 0; i < 64 * 1024; ++i) data.push_back(char('a' + i % 26));
+  std::ofstream(path, std::ios::binary) << data;
+
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  REQUIRE(fd >= 0);
+  UringBackend ring(8, false, /*fixed_buffer_len=*/16 * 1024, 4);
+
+  // операций больше глубины очереди и больше fixed buffer
+  std::vector<std::string> bufs(51, std::string(1000, '\0'));
+  std::vector<UringBackend::ReadOp> ops;
+  for (int i = 0; i < 50; ++i)
+    ops.push_back({fd, uint64_t(i) * 1217, 1000, bufs[i].data(), 0});
+  ops.push_back({fd, data.size() - 10, 100, bufs.back().data(), 0}); // короткое чтение у конца файла
+
+  std::vector<int> seen(ops.size(), 0);
+  ring.read_batch(ops, [&](std::size_t i) { ++seen[i]; });
+  ::close(fd);
+
+  for (std::size_t i = 0; i + 1 < ops.size(); ++i) {
+    REQUIRE(seen[i] == 1);
+    REQUIRE(ops[i].res == 1000);
+    REQUIRE(bufs[i] == data.substr(i * 1217, 1000));
+  }
+  REQUIRE(seen.back() == 1);
+  REQUIRE(ops.back().res == 10);
+}
+
+TEST_CASE("multi_get: matches get over MemTable and SST levels (v2/v3, cache on/off)") {
+  for (uint32_t ver : {2u, 3u}) {
+    for (std::size_t bc : {std::size_t(0), std::size_t(1) << 20}) {
+      auto dir = mgdir("uringkv_multi_get_");
+      auto opts = [&] {
+        return KVOptions{.path = dir, .use_uring = true, .uring_fixed_buffer_bytes = 64 * 1024,
+                         .sst_flush_threshold_bytes = 16 * 1024, .sst_format_version = ver,
+                         .sst_target_file_bytes = 16 * 1024, .l0_compact_threshold = 3,
+                         .block_cache_bytes = bc, .compaction_policy = CompactionPolicy::LEVELED,
+                         .level_base_bytes = 64 * 1024, .level_size_multiplier = 4,
+                         .final_flush_on_close = false};
+      };
+
+      std::map<std::string, std::string> model;
+      std::mt19937 rng(ver * 31 + (bc ? 1 : 0));
+      {
+        KV kv(opts());
+        for (int i = 0; i < 4000; ++i) {
+          const auto k = mkey(int(rng() % 1200));
+          if (rng() % 6 == 0) {
+            REQUIRE(kv.del(k));
+            model.erase(k);
+          } else {
+            const auto v = "v" + std::to_string(i) + std::string(rng() % 60, 'x');
+            REQUIRE(kv.put(k, v));
+            model[k] = v;
+          }
+        }
+      }
+
+      // хвост остаётся в WAL → MemTable; остальное в SST
+      KV kv(opts());
+      for (int i = 0; i < 100; ++i) {
+        REQUIRE(kv.put(mkey(1200 + i), "mem"));
+        model[mkey(1200 + i)] = "mem";
+      }
+      REQUIRE(kv.get_metrics().sst_count > 1);
+
+      std::vector<std::string> owned;
+      for (int i = 0; i < 1400; i += 3) owned.push_back(mkey(i));
+      owned.push_back(mkey(5));
+      owned.push_back(mkey(5)); // повторы допустимы
+      owned.push_back("zzz");
+      std::vector<std::string_view> keys(owned.begin(), owned.end());
+
+      for (int pass = 0; pass < 2; ++pass) { // второй проход — из кэша блоков
+        auto got = kv.multi_get(keys);
+        REQUIRE(got.size() == keys.size());
+        for (std::size_t i = 0; i < keys.size(); ++i) {
+          auto it = model.find(owned[i]);
+          if (it == model.end()) REQUIRE_FALSE(got[i].has_value());
+          else REQUIRE(got[i].value() == it->second);
+          REQUIRE(got[i] == kv.get(keys[i]));
+        }
+      }
+    }
+  }
+}
+
+TEST_CASE("multi_get: ReadOptions snapshot is honoured in MemTable and SST (cache on/off)") {
+  for (std::size_t bc : {std::size_t(0), std::size_t(1) << 20}) {
+    auto dir = mgdir("uringkv_multi_get_snap_");
+    KV kv({.path = dir, .use_uring = true, .uring_fixed_buffer_bytes = 64 * 1024,
+           .sst_flush_threshold_bytes = 16 * 1024, .l0_compact_threshold = 3, .block_cache_bytes = bc});
+    for (int i = 0; i < 600; ++i) REQUIRE(kv.put(mkey(i), "old" + std::to_string(i)));
+    auto snap = kv.snapshot();
+
+    // после снимка: перезапись, удаление, range tombstone; затем flush'и
+    for (int i = 0; i < 600; i += 2) REQUIRE(kv.put(mkey(i), "new"));
+    for (int i = 0; i < 600; i += 5) REQUIRE(kv.del(mkey(i)));
+    REQUIRE(kv.delete_range(mkey(300), mkey(350)));
+    for (int i = 0; i < 2000; ++i) REQUIRE(kv.put(mkey(1000 + i), std::string(60, 'f')));
+    REQUIRE(kv.get_metrics().sst_count > 0);
+
+    std::vector<std::string> owned;
+    for (int i = 0; i < 600; ++i) owned.push_back(mkey(i));
+    std::vector<std::string_view> keys(owned.begin(), owned.end());
+    const ReadOptions ro{.snapshot = snap.get()};
+    for (int pass = 0; pass < 2; ++pass) {
+      const auto then = kv.multi_get(keys, ro);
+      const auto now = kv.multi_get(keys);
+      for (int i = 0; i < 600; ++i) {
+        REQUIRE(then[i] == std::optional<std::string>("old" + std::to_string(i)));
+        REQUIRE(then[i] == kv.get(keys[i], ro));
+        REQUIRE(now[i] == kv.get(keys[i]));
+      }
+    }
+  }
+}
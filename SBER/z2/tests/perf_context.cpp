@@ -0,0 +1,151 @@
+#ifdef __has_include
+#  if __has_include(<catch2/catch_all.hpp>)
+#    include <catch2/catch_all.hpp>
+#  else
+#    include <catch2/catch.hpp>
+#  endif
+#endif
+
+#include "kv.hpp"
+#include "perf_context.hpp"
+
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+using namespace uringkv;
+
+static std::string tmpdir(const char* prefix) {
+  auto d = std::filesystem::temp_directory_path() / (std::string(prefix) + std::to_string(::getpid()));
+  std::filesystem::remove_all(d);
+  std::filesystem::create_directories(d);
+  return d.string();
+}
+
+// 200 ключей в SST (финальный flush при закрытии) и один в MemTable
+static KVOptions fill(const std::string& dir, bool hist) {
+  KVOptions o{.path = dir, .block_cache_bytes = 0, .latency_histograms = hist};
+  {
+    KV kv(o);
+    REQUIRE(kv.init_storage_layout());
+    for (int i = 0; i < 200; ++i) REQUIRE(kv.put("key" + std::to_string(1000 + i), std::string(100, 'v')));
+  }
+  return o;
+}
+
+TEST_CASE("PerfContext: GET stages by level, disabled by default") {
+  auto dir = tmpdir("uringkv_perf_");
+  const auto o = fill(dir, false);
+  KV kv(o);
+  REQUIRE(kv.put("mem", "x"));
+  auto& pc = get_perf_context();
+
+  REQUIRE(get_perf_level() == PerfLevel::DISABLE);
+  pc.reset();
+  REQUIRE(kv.get("mem"));
+  REQUIRE(kv.put("w", "0"));
+  REQUIRE(pc.to_string().empty());
+
+  // счётчики без времени
+  set_perf_level(PerfLevel::ENABLE_COUNT);
+  pc.reset();
+  REQUIRE(kv.get("key1101"));
+  REQUIRE(pc.table_open_count == 1);
+  REQUIRE(pc.get_tables_probed == 1);
+  REQUIRE(pc.block_read_count == 1);
+  REQUIRE(pc.block_read_bytes > 0);
+  REQUIRE(pc.get_memtable_ns == 0);
+  REQUIRE(pc.block_read_ns == 0);
+
+  // время стадий: SST-путь проходит все стадии, кроме blob
+  set_perf_level(PerfLevel::ENABLE_TIME);
+  pc.reset();
+  REQUIRE(kv.get("key1102"));
+  CAPTURE(pc.to_string());
+  REQUIRE(pc.get_memtable_ns > 0);
+  REQUIRE(pc.get_table_cache_ns > 0);
+  REQUIRE(pc.index_probe_ns > 0);
+  REQUIRE(pc.block_read_ns >= pc.block_checksum_ns);
+  REQUIRE(pc.block_checksum_ns > 0);
+  REQUIRE(pc.record_read_ns > 0);
+  REQUIRE(pc.blob_read_ns == 0);
+  REQUIRE(pc.table_open_count == 0); // таблица уже в кэше
+  REQUIRE(pc.to_string().find("index_probe_ns=") != std::string::npos);
+
+  // ключ из MemTable дальше не идёт
+  pc.reset();
+  REQUIRE(kv.get("mem") == std::optional<std::string>("x"));
+  REQUIRE(pc.get_memtable_hits == 1);
+  REQUIRE(pc.get_table_cache_ns == 0);
+  REQUIRE(pc.block_read_count == 0);
+
+  // запись: WAL и MemTable у лидера
+  pc.reset();
+  REQUIRE(kv.put("w", "1"));
+  REQUIRE(pc.write_wal_ns > 0);
+  REQUIRE(pc.write_memtable_ns > 0);
+
+  PerfContext sum;
+  sum += pc;
+  sum += pc;
+  REQUIRE(sum.write_wal_ns == 2 * pc.write_wal_ns);
+
+  set_perf_level(PerfLevel::DISABLE);
+  std::filesystem::remove_all(dir);
+}
+
+TEST_CASE("KVMetrics: per-operation latency histograms") {
+  auto dir = tmpdir("uringkv_lat_");
+
+  SECTION("off by default") {
+    KV kv(fill(dir, false));
+    REQUIRE(kv.get("key1000"));
+    const auto m = kv.get_metrics();
+    REQUIRE(m.get_latency.count == 0);
+    REQUIRE(m.put_latency.count == 0);
+  }
+
+  SECTION("on") {
+    KV kv(fill(dir, true));
+    for (int i = 0; i < 50; ++i) REQUIRE(kv.get("key" + std::to_string(1000 + i)));
+    REQUIRE_FALSE(kv.get("nope"));
+    REQUIRE(kv.put("a", "1"));
+    REQUIRE(kv.del("a"));
+    REQUIRE(kv.scan("key1000", "key1010").size() == 11);
+
+    const auto m = kv.get_metrics();
+    REQUIRE(m.get_latency.count == 51);
+    REQUIRE(m.put_latency.count == 1);
+    REQUIRE(m.del_latency.count == 1);
+    REQUIRE(m.scan_latency.count == 1);
+    REQUIRE(m.get_latency.p50_ns > 0);
+    REQUIRE(m.get_latency.p50_ns <= m.get_latency.p99_ns);
+    REQUIRE(m.get_latency.p99_ns <= m.get_latency.max_ns);
+    REQUIRE(m.get_latency.sum_ns >= m.get_latency.max_ns);
+    REQUIRE(m.flush_latency.count == 0);
+
+    kv.reset_metrics(false);
+    REQUIRE(kv.get_metrics().get_latency.count == 0);
+  }
+
+  SECTION("flush and compaction") {
+    // fsync на каждый commit, flush каждые 4 KiB
+    KVOptions o{.path = dir, .wal_group_commit_bytes = 1, .sst_flush_threshold_bytes = 4096,
+                .l0_compact_threshold = 2, .latency_histograms = true};
+    KV kv(o);
+    REQUIRE(kv.init_storage_layout());
+    for (int i = 0; i < 400; ++i) REQUIRE(kv.put("k" + std::to_string(i), std::string(64, 'x')));
+    // фоновые flush и компактация
+    for (int t = 0; t < 200 && kv.get_metrics().compactions == 0; ++t)
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    const auto m = kv.get_metrics();
+    REQUIRE(m.flush_latency.count == m.sst_flushes);
+    REQUIRE(m.flush_latency.count > 0);
+    REQUIRE(m.compaction_latency.count == m.compactions);
+    REQUIRE(m.wal_sync_latency.count > 0);
+    REQUIRE(m.wal_sync_latency.count <= m.wal_syncs);
+  }
+  std::filesystem::remove_all(dir);
+}
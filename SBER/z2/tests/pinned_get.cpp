@@ -0,0 +1,147 @@
+#ifdef __has_include
+#  if __has_include(<catch2/catch_all.hpp>)
+#    include <catch2/catch_all.hpp>
+#  else
+#    include <catch2/catch.hpp>
+#  endif
+#endif
+
+#include "kv.hpp"
+
+#include <filesystem>
+#include <string>
+#include <unistd.h>
+
+using namespace uringkv;
+
+static std::string tmpdir(const char* prefix) {
+  auto d = std::filesystem::temp_directory_path() / (std::string(prefix) + std::to_string(::getpid()));
+  std::filesystem::remove_all(d);
+  std::filesystem::create_directories(d);
+  return d.string();
+}
+
+static std::string pkey(int i) { return "key" + std::to_string(1000 + i); }
+static std::string pval(int i, std::size_t len) { return std::to_string(i) + ":" + std::string(len, char('a' + i % 26)); }
+
+// 64 ключа в SST (финальный flush при закрытии)
+static void fill(const KVOptions& o, std::size_t len) {
+  KV kv(o);
+  REQUIRE(kv.init_storage_layout());
+  for (int i = 0; i < 64; ++i) REQUIRE(kv.put(pkey(i), pval(i, len)));
+}
+
+TEST_CASE("PinnableSlice: GET from MemTable pins the arena") {
+  auto dir = tmpdir("uringkv_pin_mem_");
+  KVOptions o{.path = dir, .sst_flush_threshold_bytes = 64 * 1024};
+  PinnableSlice v;
+  {
+    KV kv(o);
+    REQUIRE(kv.init_storage_layout());
+    const std::string big(64 * 1024 - 1, 'm');
+    REQUIRE(kv.put("big", big));
+    REQUIRE(kv.get("big", v));
+    REQUIRE(v.pinned());
+    REQUIRE(v.view() == big);
+
+    // перезапись и смена MemTable (flush) вид не трогают
+    REQUIRE(kv.put("big", "new"));
+    for (int i = 0; i < 64; ++i) REQUIRE(kv.put(pkey(i), pval(i, 4096)));
+    REQUIRE(v.view() == big);
+    REQUIRE(kv.get("big") == std::optional<std::string>("new"));
+
+    REQUIRE(kv.del("big"));
+    PinnableSlice gone;
+    REQUIRE_FALSE(kv.get("big", gone));
+    REQUIRE(gone.empty());
+    REQUIRE_FALSE(gone.pinned());
+  }
+  // и переживает KV
+  REQUIRE(v.size() == 64 * 1024 - 1);
+  REQUIRE(v.view().back() == 'm');
+  std::filesystem::remove_all(dir);
+}
+
+TEST_CASE("PinnableSlice: GET from SST pins the cached block") {
+  auto dir = tmpdir("uringkv_pin_sst_");
+
+  SECTION("v3 block survives eviction") {
+    // кэш на пару блоков: чтения остальных ключей вытесняют первый
+    KVOptions o{.path = dir, .block_cache_bytes = 16 * 1024};
+    fill(o, 3000);
+    KV kv(o);
+    PinnableSlice v;
+    REQUIRE(kv.get(pkey(7), v));
+    REQUIRE(v.pinned());
+    REQUIRE(v.view() == pval(7, 3000));
+    for (int i = 0; i < 64; ++i) REQUIRE(kv.get(pkey(i)) == std::optional<std::string>(pval(i, 3000)));
+    REQUIRE(v.view() == pval(7, 3000));
+
+    // повторное чтение в тот же слайс отпускает прежний блок
+    REQUIRE(kv.get(pkey(8), v));
+    REQUIRE(v.view() == pval(8, 3000));
+    REQUIRE_FALSE(kv.get("nope", v));
+    REQUIRE(v.empty());
+  }
+
+  SECTION("v2 record") {
+    KVOptions o{.path = dir, .sst_format_version = 2};
+    fill(o, 100);
+    KV kv(o);
+    PinnableSlice v;
+    REQUIRE(kv.get(pkey(3), v));
+    REQUIRE(v.pinned());
+    REQUIRE(v.view() == pval(3, 100));
+  }
+  std::filesystem::remove_all(dir);
+}
+
+TEST_CASE("PinnableSlice: own buffer without block cache and for blobs") {
+  auto dir = tmpdir("uringkv_pin_own_");
+
+  SECTION("no block cache") {
+    KVOptions o{.path = dir, .block_cache_bytes = 0};
+    fill(o, 100);
+    KV kv(o);
+    PinnableSlice v;
+    REQUIRE(kv.get(pkey(5), v));
+    REQUIRE_FALSE(v.pinned());
+    REQUIRE(v.view() == pval(5, 100));
+    PinnableSlice w(std::move(v));
+    REQUIRE(v.empty());
+    REQUIRE(w.view() == pval(5, 100));
+  }
+
+  SECTION("blob value") {
+    KVOptions o{.path = dir, .blob_value_threshold = 1024};
+    fill(o, 4096);
+    KV kv(o);
+    PinnableSlice v;
+    REQUIRE(kv.get(pkey(9), v));
+    REQUIRE_FALSE(v.pinned());
+    REQUIRE(v.view() == pval(9, 4096));
+    REQUIRE(v.to_string() == pval(9, 4096));
+  }
+  std::filesystem::remove_all(dir);
+}
+
+TEST_CASE("PinnableSlice: move rebuilds the view into its own buffer") {
+  PinnableSlice a;
+  a.own(std::string("xyzabc"), 3, 3); // короткая строка — в SSO, адрес меняется при перемещении
+  PinnableSlice b(std::move(a));
+  REQUIRE(a.empty());
+  REQUIRE(b.view() == "abc");
+  a = std::move(b);
+  REQUIRE(a.view() == "abc");
+  REQUIRE(a.release() == "abc");
+  REQUIRE(a.empty());
+
+  const auto hold = std::make_shared<const std::string>("pinned");
+  a.pin(std::string_view(*hold).substr(0, 3), hold);
+  REQUIRE(hold.use_count() == 2);
+  b = std::move(a);
+  REQUIRE(b.view() == "pin");
+  REQUIRE(b.pinned());
+  b.reset();
+  REQUIRE(hold.use_count() == 1);
+}
@@ -0,0 +1,246 @@
+#ifdef __has_include
+#  if __has_include(<catch2/catch_all.hpp>)
+#    include <catch2/catch_all.hpp>
+#  else
+#    include <catch2/catch.hpp>
+#  endif
+#endif
+
+#include "kv.hpp"
+#include "sst/footer.hpp"
+#include "sst/range_del.hpp"
+#include "sst/reader.hpp"
+#include "sst/table.hpp"
+#include "sst/writer.hpp"
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace uringkv;
+namespace fs = std::filesystem;
+
+static std::string rddir(const char* p){
+  auto b = fs::temp_directory_path();
+  auto d = b / (std::string(p)+std::to_string(::getpid()));
+  fs::remove_all(d);
+  fs::create_directories(d);
+  return d.string();
+}
+
+static std::string rkey(const char* prefix, int i) {
+  char b[32];
+  std::snprintf(b, sizeof(b), "%s%05d", prefix, i);
+  return b;
+}
+
+// get, multi_get и scan должны сходиться: ключи [lo, hi) удалены, остальные на месте
+static void check_deleted(KV& kv, int n, int lo, int hi) {
+  std::vector<std::string> ks;
+  for (int i = 0; i < n; ++i) ks.push_back(rkey("k", i));
+  std::vector<std::string_view> views(ks.begin(), ks.end());
+  const auto got = kv.multi_get(views);
+  for (int i = 0; i < n; ++i) {
+    const bool gone = i >= lo && i < hi;
+    REQUIRE(kv.get(ks[i]).has_value() == !gone);
+    REQUIRE(got[i].has_value() == !gone);
+  }
+  REQUIRE(kv.scan("k", "l").size() == static_cast<size_t>(n - (hi - lo)));
+}
+
+TEST_CASE("SST: range tombstone block round-trips, a corrupted one makes the table unusable") {
+  auto dir = rddir("uringkv_rdel_sst_");
+  const auto path = dir + "/t.sst";
+  {
+    SstWriter w(path, {});
+    for (int i = 0; i < 100; ++i) REQUIRE(w.add(rkey("k", i), SST_FLAG_PUT, "v", 10 + i));
+    REQUIRE(w.add_range_tombstone(rkey("k", 50), rkey("k", 60), 200));
+    REQUIRE(w.add_range_tombstone(rkey("k", 20), rkey("k", 30), 5));
+    REQUIRE(w.finish());
+  }
+  SstTable t(path);
+  REQUIRE(t.good());
+  REQUIRE(t.range_tombstones().size() == 2);
+  REQUIRE(t.range_tombstones()[0].start == rkey("k", 20)); // по возрастанию start
+  REQUIRE(t.range_del_seq(rkey("k", 55)) == 200);
+  REQUIRE(t.range_del_seq(rkey("k", 55), 100) == 0); // снимку не виден
+  REQUIRE(t.range_del_seq(rkey("k", 60)) == 0);        // end исключителен
+  uint64_t seq = 0;
+  REQUIRE(t.get(rkey("k", 55), UINT64_MAX, &seq).has_value());
+  REQUIRE(seq == 65);
+  SstReader rd(path);
+  REQUIRE(rd.range_tombstones().size() == 2);
+
+  // v2 tombstone'ы не хранит
+  SstWriter v2(dir + "/v2.sst", {.format_version = kSstVersionV2});
+  REQUIRE_FALSE(v2.add_range_tombstone("a", "b", 1));
+
+  {
+    std::fstream f(path, std::ios::in | std::ios::out | std::ios::binary);
+    f.seekg(-static_cast<std::streamoff>(sizeof(SstFooter) + sizeof(SstFooterExt)), std::ios::end);
+    SstFooterExt ext{};
+    f.read(reinterpret_cast<char*>(&ext), sizeof(ext));
+    REQUIRE(ext.reserved[5] > 0);
+    f.seekp(static_cast<std::streamoff>(ext.reserved[4] + 6));
+    f.put('#');
+  }
+  SstTable bad(path);
+  REQUIRE_FALSE(bad.good());
+}
+
+TEST_CASE("KV: delete_range hides keys in MemTable and SST, survives reopen, respects snapshots") {
+  auto dir = rddir("uringkv_rdel_kv_");
+  auto opts = KVOptions{.path = dir, .sst_flush_threshold_bytes = 16 * 1024,
+                        .background_compaction = false, .l0_compact_threshold = 100};
+  const int n = 1000;
+  {
+    KV kv(opts);
+    for (int i = 0; i < n; ++i) REQUIRE(kv.put(rkey("k", i), std::string(40, 'a')));
+    REQUIRE(kv.get_metrics().sst_count > 0);
+
+    REQUIRE_FALSE(kv.delete_range(rkey("k", 5), rkey("k", 5))); // пустой диапазон
+    auto snap = kv.snapshot();
+    REQUIRE(kv.delete_range(rkey("k", 100), rkey("k", 300)));
+    check_deleted(kv, n, 100, 300);
+    // снимок до удаления видит старые значения
+    REQUIRE(kv.get(rkey("k", 150), ReadOptions{.snapshot = snap.get()}).has_value());
+    REQUIRE(kv.scan("", "", ReadOptions{.snapshot = snap.get()}).size() == static_cast<size_t>(n));
+
+    // запись после tombstone'а снова видна
+    REQUIRE(kv.put(rkey("k", 150), "new"));
+    REQUIRE(kv.get(rkey("k", 150)).value() == "new");
+    REQUIRE(kv.del(rkey("k", 150)));
+
+    // пакет: tombstone и put в одном WAL-записи, put новее
+    WriteBatch b;
+    b.delete_range(rkey("k", 400), rkey("k", 410));
+    b.put(rkey("k", 405), "batch");
+    REQUIRE(kv.write(b));
+    REQUIRE(kv.get(rkey("k", 404)) == std::nullopt);
+    REQUIRE(kv.get(rkey("k", 405)).value() == "batch");
+    REQUIRE(kv.put(rkey("k", 404), std::string(40, 'a')));
+    REQUIRE(kv.del(rkey("k", 405)));
+    REQUIRE(kv.put(rkey("k", 405), std::string(40, 'a')));
+    for (int i = 400; i < 410; ++i) REQUIRE(kv.put(rkey("k", i), std::string(40, 'a')));
+    check_deleted(kv, n, 100, 300);
+
+    // tombstone уходит в SST вместе с MemTable
+    for (int i = 0; i < 400; ++i) REQUIRE(kv.put(rkey("z", i), std::string(40, 'z')));
+    check_deleted(kv, n, 100, 300);
+    REQUIRE(kv.get_metrics().range_deletes == 2);
+  }
+
+  // воспроизведение WAL и SST с блоком tombstone'ов
+  KV kv(opts);
+  check_deleted(kv, n, 100, 300);
+  KV::Iterator it(&kv, IteratorOptions{.prefix = "k"});
+  it.seek(rkey("k", 99));
+  REQUIRE(it.valid());
+  it.next();
+  REQUIRE(it.key() == rkey("k", 300));
+
+  // prefix: все z*, k* остаются
+  REQUIRE(kv.delete_prefix("z"));
+  REQUIRE(kv.scan("z", "").empty());
+  REQUIRE(kv.get(rkey("k", 0)).has_value());
+  REQUIRE_FALSE(kv.delete_prefix("\xff\xff"));
+}
+
+TEST_CASE("KV: compaction drops covered versions and whole SSTs under a range tombstone") {
+  auto dir = rddir("uringkv_rdel_compact_");
+  auto opts = KVOptions{.path = dir, .sst_flush_threshold_bytes = 16 * 1024, .l0_compact_threshold = 100};
+  const int n = 1000;
+  {
+    KV kv(opts);
+    for (int i = 0; i < n; ++i) REQUIRE(kv.put(rkey("k", i), std::string(40, 'a')));
+    for (int i = 0; i < 500 && kv.get_metrics().sst_count < 2; ++i)
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    REQUIRE(kv.get_metrics().sst_count >= 2);
+
+    // все SST с k* целиком под tombstone'ом: после его flush'а они выбывают без слияния
+    REQUIRE(kv.delete_range("k", "l"));
+    for (int i = 0; i < 400; ++i) REQUIRE(kv.put(rkey("m", i), std::string(40, 'm')));
+    for (int i = 0; i < 500 && kv.get_metrics().range_del_dropped_files == 0; ++i)
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    const auto m = kv.get_metrics();
+    REQUIRE(m.range_del_dropped_files > 0);
+    REQUIRE(m.compactions == 0);
+    REQUIRE(kv.get(rkey("k", 10)) == std::nullopt);
+    REQUIRE(kv.scan("k", "l").empty());
+    REQUIRE(kv.scan("m", "n").size() == 400);
+  }
+
+  // слияние: накрытые версии выбрасываются, частично накрытые файлы переписываются
+  opts.path = rddir("uringkv_rdel_compact_merge_");
+  opts.l0_compact_threshold = 3;
+  opts.background_compaction = false;
+  {
+    KV kv(opts);
+    for (int i = 0; i < n; ++i) REQUIRE(kv.put(rkey("k", i), std::string(40, 'a')));
+    REQUIRE(kv.delete_range(rkey("k", 250), rkey("k", 750)));
+    for (int i = 0; i < 300; ++i) REQUIRE(kv.put(rkey("m", i), std::string(40, 'm')));
+    REQUIRE(kv.put(rkey("k", 500), "back"));
+  } // компактация в деструкторе
+
+  // одна SST: tombstone выброшен (ниже ничего нет), накрытые версии тоже
+  std::vector<std::string> ssts;
+  for (const auto& e : fs::directory_iterator(opts.path + "/sst"))
+    if (e.path().extension() == ".sst") ssts.push_back(e.path().string());
+  REQUIRE(ssts.size() == 1);
+  {
+    SstReader rd(ssts[0]);
+    REQUIRE(rd.range_tombstones().empty());
+    SstReader::Iterator it(&rd);
+    size_t records = 0;
+    for (it.seek_to_first(); it.valid(); it.next()) ++records;
+    REQUIRE(records == static_cast<size_t>(n - 500 + 1 + 300));
+  }
+
+  KV kv(opts);
+  REQUIRE(kv.get(rkey("k", 500)).value() == "back");
+  REQUIRE(kv.get(rkey("k", 499)) == std::nullopt);
+  REQUIRE(kv.get(rkey("k", 249)).has_value());
+  REQUIRE(kv.get(rkey("k", 750)).has_value());
+  REQUIRE(kv.scan("k", "l").size() == static_cast<size_t>(n - 500 + 1));
+}
+
+TEST_CASE("KV: write rejects a batch whose range tombstone delete_range would refuse") {
+  auto dir = rddir("uringkv_rdel_batch_");
+
+  SECTION("empty or reversed range") {
+    KV kv({.path = dir, .sst_flush_threshold_bytes = 16 * 1024});
+    WriteBatch b;
+    b.put("a", "1");
+    b.delete_range("k5", "k5");
+    REQUIRE_FALSE(kv.write(b));
+    b.clear();
+    b.put("a", "1");
+    b.delete_range("k9", "k1");
+    REQUIRE_FALSE(kv.write(b));
+    // пакет отклонён целиком: put не применён, seqno не потрачены
+    REQUIRE_FALSE(kv.get("a").has_value());
+    REQUIRE(kv.get_metrics().range_deletes == 0);
+  }
+
+  SECTION("SST v2") {
+    auto opts = KVOptions{.path = dir, .sst_flush_threshold_bytes = 16 * 1024, .sst_format_version = 2};
+    {
+      KV kv(opts);
+      WriteBatch b;
+      b.put("a", "1");
+      b.delete_range("k1", "k9");
+      REQUIRE_FALSE(kv.write(b));
+      REQUIRE_FALSE(kv.delete_range("k1", "k9"));
+      REQUIRE_FALSE(kv.get("a").has_value());
+      // flush'и v2 идут дальше как обычно
+      for (int i = 0; i < 1000; ++i) REQUIRE(kv.put(rkey("k", i), std::string(40, 'a')));
+    }
+    KV kv(opts);
+    REQUIRE(kv.scan("", "").size() == 1000);
+  }
+  fs::remove_all(dir);
+}
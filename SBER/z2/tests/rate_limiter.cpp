@@ -0,0 +1,115 @@
+#ifdef __has_include
+#  if __has_include(<catch2/catch_all.hpp>)
+#    include <catch2/catch_all.hpp>
+#  else
+#    include <catch2/catch.hpp>
+#  endif
+#endif
+
+#include "kv.hpp"
+#include "rate_limiter.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+using namespace uringkv;
+namespace fs = std::filesystem;
+using Clock = std::chrono::steady_clock;
+
+static std::string rldir(const char* p){
+  auto b = fs::temp_directory_path();
+  auto d = b / (std::string(p)+std::to_string(::getpid()));
+  fs::remove_all(d);
+  fs::create_directories(d);
+  return d.string();
+}
+
+static double ms_since(Clock::time_point t0) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+}
+
+TEST_CASE("RateLimiter: token bucket throttles to the configured rate") {
+  RateLimiter unlimited(0);
+  auto t0 = Clock::now();
+  unlimited.request(64ull << 20, RateLimiter::Priority::LOW);
+  REQUIRE(ms_since(t0) < 50);
+  REQUIRE(unlimited.bytes_through(RateLimiter::Priority::LOW) == (64ull << 20));
+  REQUIRE(unlimited.wait_us(RateLimiter::Priority::LOW) == 0);
+
+  // запас — 100 мс (100 KiB), остальные 300 KiB набираются ~300 мс
+  RateLimiter rl(1 << 20);
+  t0 = Clock::now();
+  rl.request(400 * 1024, RateLimiter::Priority::LOW);
+  const double ms = ms_since(t0);
+  REQUIRE(ms >= 250);
+  REQUIRE(ms < 2000);
+  REQUIRE(rl.wait_us(RateLimiter::Priority::LOW) > 0);
+
+  // снятие лимита отпускает ждущих
+  rl.set_rate(1024);
+  std::thread th([&] { rl.request(1 << 20, RateLimiter::Priority::LOW); });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  t0 = Clock::now();
+  rl.set_rate(0);
+  th.join();
+  REQUIRE(ms_since(t0) < 500);
+}
+
+TEST_CASE("RateLimiter: flush (HIGH) gets tokens before compaction (LOW)") {
+  RateLimiter rl(1 << 20);
+  rl.request(100 * 1024, RateLimiter::Priority::LOW); // выбрать запас
+
+  std::atomic<bool> low_done{false};
+  Clock::time_point low_end, high_end;
+  std::thread low([&] {
+    rl.request(600 * 1024, RateLimiter::Priority::LOW);
+    low_end = Clock::now();
+    low_done = true;
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(30));
+  rl.request(100 * 1024, RateLimiter::Priority::HIGH);
+  high_end = Clock::now();
+  REQUIRE_FALSE(low_done.load());
+  low.join();
+  // HIGH обслужен за ~100 мс, LOW ждал его и закончил заметно позже
+  REQUIRE(high_end < low_end);
+  REQUIRE(rl.bytes_through(RateLimiter::Priority::HIGH) == 100 * 1024);
+}
+
+TEST_CASE("KV: background writes are rate limited, L0 triggers slow down writes") {
+  auto dir = rldir("uringkv_rate_limit_");
+  auto opts = KVOptions{.path = dir, .sst_flush_threshold_bytes = 64 * 1024, .l0_compact_threshold = 2,
+                        .bg_rate_bytes_per_sec = 16 << 20, .bg_rate_auto_tune = true,
+                        .l0_slowdown_trigger = 2, .l0_stop_trigger = 4};
+  const std::string val(2500, 'v');
+  {
+    KV kv(opts);
+    for (int i = 0; i < 400; ++i) REQUIRE(kv.put("key" + std::to_string(10000 + i), val));
+    for (int i = 0; i < 500 && kv.get_metrics().compactions == 0; ++i)
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    const auto m = kv.get_metrics();
+    REQUIRE(m.compactions >= 1);
+    REQUIRE(m.bg_flush_bytes > 0);
+    REQUIRE(m.bg_compaction_bytes > 0);
+    // автоподстройка держит лимит в [1/8, 1] от заданного
+    REQUIRE(m.bg_rate_limit >= (16u << 20) / 8);
+    REQUIRE(m.bg_rate_limit <= (16u << 20));
+    REQUIRE(m.write_slowdowns + m.write_stalls > 0);
+    REQUIRE(m.write_stall_us > 0);
+    for (int i = 0; i < 400; i += 37) REQUIRE(kv.get("key" + std::to_string(10000 + i)).value() == val);
+  }
+
+  // без фоновой компактации записи не тормозятся: разгружать L0 некому
+  opts.path = rldir("uringkv_rate_limit_nobg_");
+  opts.background_compaction = false;
+  KV kv(opts);
+  for (int i = 0; i < 400; ++i) REQUIRE(kv.put("key" + std::to_string(10000 + i), val));
+  const auto m = kv.get_metrics();
+  REQUIRE(m.write_slowdowns == 0);
+  REQUIRE(m.pending_compaction_bytes > 0);
+}
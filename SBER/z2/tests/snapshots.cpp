@@ -0,0 +1,139 @@
+#ifdef __has_include
+#  if __has_include(<catch2/catch_all.hpp>)
+#    include <catch2/catch_all.hpp>
+#  else
+#    include <catch2/catch.hpp>
+#  endif
+#endif
+
+#include "kv.hpp"
+#include "sst/manifest.hpp"
+#include "sst/reader.hpp"
+
+#include <chrono>
+#include <filesystem>
+#include <map>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+using namespace uringkv;
+namespace fs = std::filesystem;
+
+static std::string spdir(const char* p){
+  auto b = fs::temp_directory_path();
+  auto d = b / (std::string(p)+std::to_string(::getpid()));
+  fs::remove_all(d);
+  fs::create_directories(d);
+  return d.string();
+}
+
+static std::string skey(int i) {
+  char b[32];
+  std::snprintf(b, sizeof(b), "key%05d", i);
+  return b;
+}
+
+static bool wait_for(KV& kv, uint64_t flushes, uint64_t compactions) {
+  for (int i = 0; i < 500; ++i) {
+    const auto m = kv.get_metrics();
+    if (m.sst_flushes >= flushes && m.compactions >= compactions) return true;
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  return false;
+}
+
+// сколько версий ключа лежит во всех SST из MANIFEST
+static std::map<std::string, int> sst_versions(const std::string& dir) {
+  uint64_t last = 0;
+  SstLevels levels;
+  std::map<std::string, int> out;
+  if (!read_manifest(dir + "/sst", last, levels)) return out;
+  for (const auto& lvl : levels)
+    for (const auto& f : lvl) {
+      SstReader rd(f.path);
+      SstReader::Iterator it(&rd);
+      for (it.seek_to_first(); it.valid(); it.next()) ++out[std::string(it.key())];
+    }
+  return out;
+}
+
+TEST_CASE("Snapshot: get/scan/iterator see a point-in-time view across flush and compaction") {
+  auto dir = spdir("uringkv_snapshot_");
+  KV kv({.path = dir, .sst_flush_threshold_bytes = 8 * 1024, .sst_target_file_bytes = 8 * 1024,
+         .l0_compact_threshold = 2, .compaction_policy = CompactionPolicy::LEVELED,
+         .level_base_bytes = 32 * 1024, .level_size_multiplier = 4, .max_levels = 4});
+
+  for (int i = 0; i < 500; ++i) REQUIRE(kv.put(skey(i), "v1-" + std::to_string(i)));
+  auto snap = kv.snapshot();
+  const ReadOptions at{.snapshot = snap.get()};
+
+  for (int r = 0; r < 3; ++r)
+    for (int i = 0; i < 500; ++i) REQUIRE(kv.put(skey(i), "v2-" + std::to_string(r) + std::string(40, 'x')));
+  for (int i = 0; i < 500; i += 5) REQUIRE(kv.del(skey(i)));
+  for (int i = 500; i < 600; ++i) REQUIRE(kv.put(skey(i), "new"));
+  REQUIRE(wait_for(kv, 3, 1));
+
+  for (int i = 0; i < 600; ++i) {
+    auto old = kv.get(skey(i), at);
+    if (i < 500) REQUIRE(old.value() == "v1-" + std::to_string(i));
+    else REQUIRE_FALSE(old.has_value());
+
+    auto now = kv.get(skey(i));
+    if (i < 500 && i % 5 == 0) REQUIRE_FALSE(now.has_value());
+    else if (i < 500) REQUIRE(now.value() == "v2-2" + std::string(40, 'x'));
+    else REQUIRE(now.value() == "new");
+  }
+
+  auto old_all = kv.scan("", "", at);
+  REQUIRE(old_all.size() == 500);
+  for (const auto& it : old_all) REQUIRE(it.value.starts_with("v1-"));
+  REQUIRE(kv.scan("", "").size() == 600 - 100);
+
+  KV::Iterator it(&kv, {.prefix = "key001", .snapshot = snap.get()});
+  std::size_t n = 0;
+  for (it.seek_to_first(); it.valid(); it.next(), ++n) REQUIRE(it.value().starts_with("v1-"));
+  REQUIRE(n == 100);
+}
+
+TEST_CASE("Snapshot: flush keeps old versions only while a snapshot needs them") {
+  auto dir = spdir("uringkv_snapshot_gc_");
+  KV kv({.path = dir, .sst_flush_threshold_bytes = 4 * 1024, .background_compaction = false,
+         .l0_compact_threshold = 100});
+
+  REQUIRE(kv.put("a", "1"));
+  {
+    auto snap = kv.snapshot();
+    REQUIRE(kv.put("a", "2"));
+    REQUIRE(kv.put("a", "3")); // "2" не нужна ни снимку, ни последнему чтению
+    for (int i = 0; i < 100; ++i) REQUIRE(kv.put(skey(i), std::string(64, 'f')));
+    REQUIRE(wait_for(kv, 1, 0));
+    REQUIRE(kv.get("a", {.snapshot = snap.get()}).value() == "1");
+    REQUIRE(kv.get("a").value() == "3");
+  }
+  REQUIRE(sst_versions(dir)["a"] == 2); // "3" для всех и "1" для снимка
+
+  // без снимков следующий flush пишет одну версию
+  REQUIRE(kv.put("b", "1"));
+  REQUIRE(kv.put("b", "2"));
+  for (int i = 100; i < 200; ++i) REQUIRE(kv.put(skey(i), std::string(64, 'f')));
+  REQUIRE(wait_for(kv, 2, 0));
+  REQUIRE(sst_versions(dir)["b"] == 1);
+  REQUIRE(kv.get("b").value() == "2");
+}
+
+TEST_CASE("Snapshot: seqno continues after SSTs on reopen") {
+  auto dir = spdir("uringkv_snapshot_reopen_");
+  {
+    KV kv({.path = dir, .background_compaction = false});
+    REQUIRE(kv.put("k", "a"));
+  } // финальный flush: WAL пуст, seqno только в SST
+
+  KV kv({.path = dir, .background_compaction = false});
+  REQUIRE(kv.get("k").value() == "a");
+  REQUIRE(kv.put("k", "b"));
+  auto snap = kv.snapshot();
+  REQUIRE(kv.put("k", "c"));
+  REQUIRE(kv.get("k", {.snapshot = snap.get()}).value() == "b");
+  REQUIRE(kv.get("k").value() == "c");
+}
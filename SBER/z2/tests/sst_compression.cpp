@@ -0,0 +1,207 @@
+#ifdef __has_include
+#  if __has_include(<catch2/catch_all.hpp>)
+#    include <catch2/catch_all.hpp>
+#  else
+#    include <catch2/catch.hpp>
+#  endif
+#endif
+
+#include "kv.hpp"
+#include "cache/block_cache.hpp"
+#include "sst/compression.hpp"
+#include "sst/reader.hpp"
+#include "sst/table.hpp"
+#include "sst/writer.hpp"
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <random>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace uringkv;
+namespace fs = std::filesystem;
+
+static std::string cdir(const char* p){
+  auto b = fs::temp_directory_path();
+  auto d = b / (std::string(p)+std::to_string(::getpid()));
+  fs::remove_all(d);
+  fs::create_directories(d);
+  return d.string();
+}
+
+// JSON-подобные значения: хорошо сжимаются, особенно со словарём
+static std::string json_val(int i) {
+  return "{\"id\":" + std::to_string(i) + ",\"name\":\"user_" + std::to_string(i * 7 % 1000) +
+         "\",\"active\":" + (i % 3 ? "true" : "false") + ",\"tags\":[\"alpha\",\"beta\"],\"score\":" +
+         std::to_string(i % 97) + "}";
+}
+
+static std::vector<std::pair<std::string, std::optional<std::string>>> json_entries(int n) {
+  std::vector<std::pair<std::string, std::optional<std::string>>> e;
+  char kb[32];
+  for (int i = 0; i < n; ++i) {
+    std::snprintf(kb, sizeof(kb), "user%08d", i);
+    if (i % 10 == 7) e.emplace_back(kb, std::nullopt);
+    else e.emplace_back(kb, json_val(i));
+  }
+  return e;
+}
+
+static void check_table(const std::string& path,
+                        const std::vector<std::pair<std::string, std::optional<std::string>>>& entries,
+                        BlockCache* cache) {
+  SstTable t(path, cache, cache ? 1 : 0);
+  REQUIRE(t.good());
+  for (size_t i = 0; i < entries.size(); i += 7) {
+    auto r = t.get(entries[i].first);
+    REQUIRE(r.has_value());
+    if (entries[i].second) REQUIRE(r->second == *entries[i].second);
+    else REQUIRE(r->first == SST_FLAG_DEL);
+  }
+  REQUIRE_FALSE(t.get("user99999999").has_value());
+
+  SstReader rd(path);
+  SstReader::Iterator it(&rd);
+  size_t n = 0;
+  for (it.seek_to_first(); it.valid(); it.next(), ++n) REQUIRE(it.key() == entries[n].first);
+  REQUIRE(n == entries.size());
+}
+
+TEST_CASE("SST compression: LZ4/Zstd blocks read back through table, iterator and block cache") {
+  auto dir = cdir("uringkv_sst_codec_");
+  const auto entries = json_entries(3000);
+  const auto plain = dir + "/plain.sst";
+  { SstWriter w(plain, {}); REQUIRE(w.write_sorted(entries)); }
+
+  for (auto codec : {SstCompression::LZ4, SstCompression::ZSTD}) {
+    const auto path = dir + "/" + sst_compression_name(codec) + ".sst";
+    uint64_t raw = 0, stored = 0;
+    {
+      SstWriter w(path, {.compression = codec});
+      REQUIRE(w.write_sorted(entries));
+      raw = w.raw_block_bytes();
+      stored = w.stored_block_bytes();
+    }
+    if (!sst_compression_supported(codec)) {
+      // кодек не собран — блоки пишутся как есть
+      REQUIRE(stored == raw);
+      REQUIRE(fs::file_size(path) == fs::file_size(plain));
+      check_table(path, entries, nullptr);
+      continue;
+    }
+    REQUIRE(stored * 2 < raw);
+    REQUIRE(fs::file_size(path) * 3 / 2 < fs::file_size(plain));
+
+    check_table(path, entries, nullptr);
+
+    // в кэше лежат распакованные блоки: повторное чтение не распаковывает
+    BlockCache cache(8 << 20);
+    check_table(path, entries, &cache);
+    SstTable t(path, &cache, 1);
+    const uint64_t before = sst_codec_stats().blocks_decompressed.load();
+    for (size_t i = 0; i < entries.size(); i += 7) REQUIRE(t.get(entries[i].first).has_value());
+    REQUIRE(sst_codec_stats().blocks_decompressed.load() == before);
+  }
+
+  // несжимаемые блоки остаются несжатыми
+  std::vector<std::pair<std::string, std::optional<std::string>>> rnd;
+  std::mt19937_64 rng(7);
+  for (int i = 0; i < 200; ++i) {
+    std::string v(200, '\0');
+    for (auto& c : v) c = static_cast<char>(rng());
+    rnd.emplace_back("k" + std::to_string(1000 + i), v);
+  }
+  SstWriter w(dir + "/random.sst", {.compression = SstCompression::ZSTD});
+  REQUIRE(w.write_sorted(rnd));
+  REQUIRE(w.stored_block_bytes() == w.raw_block_bytes());
+  check_table(dir + "/random.sst", rnd, nullptr);
+}
+
+TEST_CASE("SST compression: zstd dictionary is trained, stored in the table and required to read") {
+  auto dir = cdir("uringkv_sst_dict_");
+  const auto entries = json_entries(6000);
+  const auto nodict = dir + "/nodict.sst";
+  const auto path = dir + "/dict.sst";
+  { SstWriter w(nodict, {.block_size = 1024, .compression = SstCompression::ZSTD}); REQUIRE(w.write_sorted(entries)); }
+
+  SstWriter w(path, {.block_size = 1024, .compression = SstCompression::ZSTD, .zstd_dict_bytes = 4096});
+  REQUIRE(w.write_sorted(entries));
+  if (!sst_compression_supported(SstCompression::ZSTD)) {
+    REQUIRE_FALSE(w.has_dict());
+    check_table(path, entries, nullptr);
+    return;
+  }
+  REQUIRE(w.has_dict());
+  // маленькие блоки сжимаются заметно лучше с общим словарём
+  REQUIRE(w.stored_block_bytes() < fs::file_size(nodict));
+  check_table(path, entries, nullptr);
+
+  // словарь битый — таблица не открывается (её блоки без него не распаковать)
+  {
+    std::fstream f(path, std::ios::in | std::ios::out | std::ios::binary);
+    f.seekg(-static_cast<std::streamoff>(sizeof(SstFooter) + sizeof(SstFooterExt)), std::ios::end);
+    SstFooterExt ext{};
+    f.read(reinterpret_cast<char*>(&ext), sizeof(ext));
+    REQUIRE(ext.reserved[3] > 0);
+    f.seekp(static_cast<std::streamoff>(ext.reserved[2] + 10));
+    f.put('#');
+  }
+  SstTable t(path);
+  REQUIRE_FALSE(t.good());
+}
+
+TEST_CASE("SST compression: corrupted compressed block is not returned") {
+  auto dir = cdir("uringkv_sst_codec_corrupt_");
+  const auto entries = json_entries(500);
+  const auto path = dir + "/t.sst";
+  { SstWriter w(path, {.compression = SstCompression::LZ4}); REQUIRE(w.write_sorted(entries)); }
+  {
+    std::fstream f(path, std::ios::in | std::ios::out | std::ios::binary);
+    f.seekp(20);
+    f.put('#');
+  }
+  SstTable t(path);
+  REQUIRE(t.good());
+  REQUIRE_FALSE(t.get(entries[0].first).has_value());
+  SstReader rd(path);
+  SstReader::Iterator it(&rd);
+  it.seek_to_first();
+  REQUIRE_FALSE(it.valid()); // первый блок битый — дальше не читаем
+}
+
+TEST_CASE("KV: compressed SSTs through flush, compaction with dictionary, multi_get and reopen") {
+  auto dir = cdir("uringkv_kv_codec_");
+  const auto codec = sst_compression_supported(SstCompression::ZSTD) ? SstCompression::ZSTD : SstCompression::LZ4;
+  auto opts = KVOptions{.path = dir, .sst_flush_threshold_bytes = 64 * 1024, .sst_block_size = 1024,
+                        .sst_compression = codec, .sst_zstd_dict_bytes = 2048,
+                        .l0_compact_threshold = 3};
+  {
+    KV kv(opts);
+    for (int round = 0; round < 3; ++round)
+      for (int i = 0; i < 1500; ++i) REQUIRE(kv.put("user" + std::to_string(10000 + i), json_val(i + round)));
+    for (int i = 0; i < 500 && kv.get_metrics().compactions == 0; ++i)
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    const auto m = kv.get_metrics();
+    REQUIRE(m.compactions >= 1);
+    REQUIRE(m.sst_block_raw_bytes > 0);
+    if (sst_compression_supported(codec)) REQUIRE(m.sst_block_stored_bytes * 2 < m.sst_block_raw_bytes);
+    else REQUIRE(m.sst_block_stored_bytes == m.sst_block_raw_bytes);
+  }
+
+  KV kv(opts);
+  std::vector<std::string> ks;
+  for (int i = 0; i < 1500; i += 11) ks.push_back("user" + std::to_string(10000 + i));
+  std::vector<std::string_view> views(ks.begin(), ks.end());
+  const auto got = kv.multi_get(views);
+  for (size_t j = 0; j < ks.size(); ++j) {
+    REQUIRE(got[j].value() == json_val(int(j) * 11 + 2));
+    REQUIRE(kv.get(ks[j]).value() == json_val(int(j) * 11 + 2));
+  }
+  REQUIRE(kv.scan("", "").size() == 1500);
+  if (sst_compression_supported(codec)) REQUIRE(kv.get_metrics().sst_blocks_decompressed > 0);
+}
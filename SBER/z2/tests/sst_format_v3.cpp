@@ -0,0 +1,143 @@
+#ifdef __has_include
+#  if __has_include(<catch2/catch_all.hpp>)
+#    include <catch2/catch_all.hpp>
+#  else
+#    include <catch2/catch.hpp>
+#  endif
+#endif
+
+#include "kv.hpp"
+#include "sst/manifest.hpp"
+#include "sst/reader.hpp"
+#include "sst/table.hpp"
+#include "sst/writer.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using namespace uringkv;
+namespace fs = std::filesystem;
+
+static std::string v3dir(const char* p){
+  auto b = fs::temp_directory_path();
+  auto d = b / (std::string(p)+std::to_string(::getpid()));
+  fs::remove_all(d);
+  fs::create_directories(d);
+  return d.string();
+}
+
+static std::vector<std::pair<std::string, std::optional<std::string>>> make_entries(int n) {
+  std::vector<std::pair<std::string, std::optional<std::string>>> e;
+  char kb[32];
+  for (int i = 0; i < n; ++i) {
+    std::snprintf(kb, sizeof(kb), "user%012d", i);
+    if (i % 10 == 7) e.emplace_back(kb, std::nullopt);
+    else e.emplace_back(kb, std::string(100, char('a' + i % 26)));
+  }
+  return e;
+}
+
+TEST_CASE("SST v3: packed blocks are much smaller than v2 and read back identically") {
+  auto dir = v3dir("uringkv_sstv3_");
+  const auto entries = make_entries(2000);
+  const auto p2 = dir + "/v2.sst";
+  const auto p3 = dir + "/v3.sst";
+
+  { SstWriter w(p2, {.format_version = 2}); REQUIRE(w.write_sorted(entries)); }
+  { SstWriter w(p3, {.format_version = 3}); REQUIRE(w.write_sorted(entries)); }
+
+  // 2000 записей по ~120 байт: v2 тратит 4 KiB на запись
+  REQUIRE(fs::file_size(p3) * 10 < fs::file_size(p2));
+
+  SstTable t2(p2), t3(p3);
+  REQUIRE(t2.good());
+  REQUIRE(t3.good());
+  REQUIRE(t2.version() == 2);
+  REQUIRE(t3.version() == 3);
+
+  for (size_t i = 0; i < entries.size(); i += 37) {
+    auto a = t2.get(entries[i].first);
+    auto b = t3.get(entries[i].first);
+    REQUIRE(a.has_value());
+    REQUIRE(b.has_value());
+    REQUIRE(a->first == b->first);
+    if (entries[i].second) {
+      REQUIRE(b->first == SST_FLAG_PUT);
+      REQUIRE(b->second == *entries[i].second);
+    } else {
+      REQUIRE(b->first == SST_FLAG_DEL);
+    }
+  }
+  REQUIRE_FALSE(t3.get("user999999999999").has_value());
+  REQUIRE_FALSE(t3.get("a").has_value());
+
+  SstReader r2(p2), r3(p3);
+  auto s2 = r2.scan("user000000000100", "user000000000900");
+  auto s3 = r3.scan("user000000000100", "user000000000900");
+  REQUIRE(s3.size() == 801);
+  REQUIRE(s2 == s3);
+  REQUIRE(r3.scan("", "") == entries);
+}
+
+TEST_CASE("SST v3: block checksum catches corruption") {
+  auto dir = v3dir("uringkv_sstv3_crc_");
+  const auto entries = make_entries(500);
+  const auto p3 = dir + "/v3.sst";
+  { SstWriter w(p3); REQUIRE(w.write_sorted(entries)); }
+
+  {
+    // портим байт в первом блоке данных
+    std::fstream f(p3, std::ios::in | std::ios::out | std::ios::binary);
+    REQUIRE(f.good());
+    f.seekp(100, std::ios::beg);
+    const char bad = static_cast<char>(0xEE);
+    f.write(&bad, 1);
+  }
+
+  SstTable t(p3);
+  REQUIRE(t.good());
+  REQUIRE_FALSE(t.get(entries[0].first).has_value());      // битый блок не отдаёт данных
+  REQUIRE(t.get(entries.back().first).has_value());         // остальные блоки целы
+
+  SstReader r(p3);
+  REQUIRE(r.scan("", "").empty());                          // скан останавливается на битом блоке
+}
+
+TEST_CASE("SST v3: KV reads legacy v2 tables and compacts them into v3") {
+  auto dir = v3dir("uringkv_sstv3_compat_");
+  const auto sst_dir = fs::path(dir) / "sst";
+  fs::create_directories(sst_dir);
+
+  // таблица, записанная старым форматом
+  {
+    std::vector<std::pair<std::string, std::optional<std::string>>> old{
+        {"a", "old"}, {"b", "old"}, {"c", std::nullopt}};
+    SstWriter w((sst_dir / sst_name(1)).string(), {.format_version = 2});
+    REQUIRE(w.write_sorted(old));
+  }
+
+  {
+    KV kv({.path = dir, .sst_flush_threshold_bytes = 1024,
+           .background_compaction = false, .l0_compact_threshold = 3});
+    REQUIRE(kv.get("a").value() == "old");
+    REQUIRE_FALSE(kv.get("c").has_value());
+    REQUIRE(kv.put("b", "new"));
+    for (int i = 0; i < 60; ++i) REQUIRE(kv.put("k" + std::to_string(i), std::string(64, 'x')));
+  } // закрытие: финальный flush + компактация
+
+  for (auto& name : list_sst_sorted(sst_dir.string())) {
+    SstTable t((sst_dir / name).string());
+    REQUIRE(t.good());
+    REQUIRE(t.version() == 3);
+  }
+
+  KV kv({.path = dir});
+  REQUIRE(kv.get("a").value() == "old");
+  REQUIRE(kv.get("b").value() == "new");
+  REQUIRE_FALSE(kv.get("c").has_value());
+  REQUIRE(kv.get("k59").value() == std::string(64, 'x'));
+}
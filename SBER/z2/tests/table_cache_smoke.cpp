@@ -9,9 +9,14 @@
 #include "kv.hpp"
 #include "cache/table_cache.hpp"
 #include "sst/table.hpp"
+#include "sst/writer.hpp"
 
+#include <atomic>
+#include <chrono>
 #include <filesystem>
+#include <thread>
 #include <unistd.h>
+#include <vector>
 
 using namespace uringkv;
 
@@ -22,6 +27,19 @@ static std::string tmpdir(const char* prefix){
   return d.string();
 }
 
+// фон утих: компактаций не идёт, версия одна, и ~200 мс не было ни flush'а,
+// ни новой компактации (до 10 с)
+static void wait_background_idle(KV& kv) {
+  uint64_t done = UINT64_MAX;
+  for (int i = 0, quiet = 0; i < 1000 && quiet < 20; ++i) {
+    const auto m = kv.get_metrics();
+    const uint64_t now = m.sst_flushes + m.compactions;
+    quiet = (m.compactions_running == 0 && m.live_versions == 1 && now == done) ? quiet + 1 : 0;
+    done = now;
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+}
+
 TEST_CASE("TableCache: hits grow on repeated access") {
   auto dir = tmpdir("uringkv_cache_");
 
@@ -46,7 +64,7 @@ TEST_CASE("TableCache: hits grow on repeated access") {
 
   TableCache cache(2);
 
-  auto t1 = cache.get_table(sst_path);
+  auto t1 = cache.get_table(1, sst_path);
   REQUIRE(t1 != nullptr);
   REQUIRE(t1->good());
 
@@ -54,7 +72,7 @@ TEST_CASE("TableCache: hits grow on repeated access") {
   auto before_miss  = cache.misses();
   auto before_open  = cache.opens();
 
-  auto t2 = cache.get_table(sst_path);
+  auto t2 = cache.get_table(1, sst_path);
   REQUIRE(t2 != nullptr);
   REQUIRE(t2->good());
 
@@ -63,3 +81,88 @@ TEST_CASE("TableCache: hits grow on repeated access") {
   REQUIRE(cache.opens() == before_open);     // не должно расти
   REQUIRE(cache.misses() == before_miss);    // и промахов не добавилось
 }
+
+TEST_CASE("TableCache: concurrent readers, LRU eviction per shard, erase_file closes one table") {
+  auto dir = tmpdir("uringkv_cache_mt_");
+  const int files = 32;
+  std::vector<std::string> paths;
+  for (int f = 0; f < files; ++f) {
+    paths.push_back(dir + "/" + std::to_string(f + 1) + ".sst");
+    SstWriter w(paths.back(), {});
+    for (int i = 0; i < 200; ++i)
+      REQUIRE(w.add("f" + std::to_string(f) + "_" + std::to_string(1000 + i), SST_FLAG_PUT, "v", i + 1));
+    REQUIRE(w.finish());
+  }
+
+  TableCache cache(16);
+  std::atomic<int> bad{0};
+  std::vector<std::thread> th;
+  for (int t = 0; t < 8; ++t)
+    th.emplace_back([&, t] {
+      for (int i = 0; i < 500; ++i) {
+        const int f = (i * 7 + t) % files;
+        auto tbl = cache.get_table(f + 1, paths[f]);
+        if (!tbl || !tbl->get("f" + std::to_string(f) + "_1100"))
+          bad.fetch_add(1);
+      }
+    });
+  for (auto& x : th) x.join();
+
+  REQUIRE(bad.load() == 0);
+  REQUIRE(cache.hits() + cache.misses() == 8 * 500);
+  REQUIRE(cache.opens() >= static_cast<uint64_t>(files));
+  REQUIRE(cache.evictions() > 0);
+  REQUIRE(cache.size() <= cache.capacity());
+  REQUIRE(cache.pinned_bytes() > 0);
+  REQUIRE(cache.open_max_us() <= cache.open_us());
+
+  // выдача после вытеснения/закрытия: копия у читателя остаётся рабочей
+  auto held = cache.get_table(1, paths[0]);
+  const auto n = cache.size();
+  cache.erase_file(1);
+  REQUIRE(cache.size() == n - 1);
+  REQUIRE(held->get("f0_1100").has_value());
+  const auto opens = cache.opens();
+  REQUIRE(cache.get_table(1, paths[0]) != nullptr);
+  REQUIRE(cache.opens() == opens + 1);
+
+  REQUIRE(cache.get_table(999, dir + "/missing.sst") == nullptr);
+  cache.reset_stats();
+  REQUIRE(cache.hits() + cache.misses() + cache.opens() + cache.open_us() == 0);
+}
+
+TEST_CASE("KV: compaction closes only removed tables, readers need no global lock") {
+  auto dir = tmpdir("uringkv_cache_kv_");
+  std::filesystem::remove_all(dir);
+  KV kv({.path = dir, .sst_flush_threshold_bytes = 16 * 1024, .l0_compact_threshold = 3});
+  const std::string val(100, 'v');
+  for (int i = 0; i < 300; ++i) REQUIRE(kv.put("key" + std::to_string(10000 + i), val));
+
+  std::atomic<bool> stop{false};
+  std::atomic<int> bad{0};
+  std::vector<std::thread> readers;
+  for (int t = 0; t < 4; ++t)
+    readers.emplace_back([&, t] {
+      for (int i = 0; !stop.load(); i = (i + 13) % 300)
+        if (kv.get("key" + std::to_string(10000 + (i + t) % 300)) != val)
+          bad.fetch_add(1);
+    });
+  for (int i = 300; i < 1500; ++i) REQUIRE(kv.put("key" + std::to_string(10000 + i), val));
+  for (int i = 0; i < 500 && kv.get_metrics().compactions == 0; ++i)
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  stop = true;
+  for (auto& x : readers) x.join();
+
+  REQUIRE(bad.load() == 0);
+  // версию с выбывшими таблицами может ещё держать идущая компактация
+  wait_background_idle(kv);
+  for (int i = 0; i < 1500; i += 50) REQUIRE(kv.get("key" + std::to_string(10000 + i)) == val);
+  const auto m = kv.get_metrics();
+  REQUIRE(m.compactions >= 1);
+  REQUIRE(m.table_cache_opens > 0);
+  // таблицы выбывших файлов закрыты вместе с последней версией, где они были
+  REQUIRE(m.sst_files_deleted > 0);
+  REQUIRE(m.table_cache_files <= m.sst_count);
+  REQUIRE(m.table_cache_files > 0);
+  REQUIRE(m.table_cache_pinned_bytes > 0);
+}
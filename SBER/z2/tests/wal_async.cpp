@@ -0,0 +1,127 @@
+#ifdef __has_include
+#  if __has_include(<catch2/catch_all.hpp>)
+#    include <catch2/catch_all.hpp>
+#  else
+#    include <catch2/catch.hpp>
+#  endif
+#endif
+
+#include "kv.hpp"
+#include "wal/reader.hpp"
+#include "wal/uring_backend.hpp"
+#include "wal/writer.hpp"
+
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using namespace uringkv;
+namespace fs = std::filesystem;
+
+static std::string wadir(const char* p){
+  auto b = fs::temp_directory_path();
+  auto d = b / (std::string(p)+std::to_string(::getpid()));
+  fs::remove_all(d);
+  fs::create_directories(d);
+  return d.string();
+}
+
+TEST_CASE("UringBackend: async writes through the fixed-buffer ring with linked fsync") {
+  auto dir = wadir("uringkv_uring_async_");
+  const auto path = dir + "/f.bin";
+  const int fd = ::open(path.c_str(), O_CREAT | O_TRUNC | O_WRONLY, 0600);
+  REQUIRE(fd >= 0);
+
+  UringBackend ring(8, false, /*fixed_buffer_len=*/8 * 1024, /*submit_batch=*/4);
+  if (!ring.initialized()) {
+    // без liburing асинхронного пути нет — WalWriter пишет синхронно
+    REQUIRE_FALSE(ring.write_async(fd, 0, "x", true, [](int) {}));
+    REQUIRE(ring.inflight() == 0);
+    ::close(fd);
+    return;
+  }
+
+  // записей больше кольца (переход через 0) и одна больше всего буфера (куча)
+  std::string expect;
+  std::vector<int> res;
+  for (int i = 0; i < 40; ++i) {
+    const std::string chunk(i == 17 ? 20000 : 1500, char('a' + i % 26));
+    const auto off = expect.size();
+    expect += chunk;
+    const std::size_t slot = res.size();
+    res.push_back(0);
+    REQUIRE(ring.write_async(fd, off, chunk, /*sync=*/i % 8 == 7, [&res, slot](int r) { res[slot] = r; }));
+    if (i % 5 == 0) ring.poll(false);
+  }
+  ring.poll(true);
+  REQUIRE(ring.inflight() == 0);
+  ::close(fd);
+
+  for (int i = 0; i < 40; ++i) REQUIRE(res[i] == (i == 17 ? 20000 : 1500));
+  std::ifstream in(path, std::ios::binary);
+  std::stringstream ss;
+  ss << in.rdbuf();
+  REQUIRE(ss.str() == expect);
+}
+
+TEST_CASE("WalWriter: commit_async reports durability and records replay (uring or sync)") {
+  for (bool uring : {false, true}) {
+    for (auto fmt : {WalFormat::PADDED, WalFormat::PACKED}) {
+      auto dir = wadir("uringkv_wal_async_");
+      int durable = 0, failed = 0;
+      uint64_t syncs = 0;
+      {
+        WalWriter w(dir, uring, 16, false, /*fixed_buffer=*/16 * 1024, /*submit_batch=*/4,
+                    64ull << 20, /*group_commit_bytes=*/1, FlushMode::FDATASYNC, fmt);
+        REQUIRE(w.good());
+        uint64_t seq = 1;
+        for (int c = 0; c < 50; ++c) {
+          for (int i = 0; i < 5; ++i, ++seq) {
+            if (i == 4) REQUIRE(w.append_del(seq, "k" + std::to_string(c)));
+            else REQUIRE(w.append_put(seq, "k" + std::to_string(c) + "/" + std::to_string(i), std::string(100, 'v')));
+          }
+          REQUIRE(w.commit_async([&](bool ok) { ++(ok ? durable : failed); }));
+          if (c % 10 == 9) w.poll(true);
+        }
+        w.poll(true);
+        syncs = w.syncs();
+      }
+      REQUIRE(durable == 50);
+      REQUIRE(failed == 0);
+      REQUIRE(syncs >= 50); // group_commit_bytes = 1: fsync на каждый commit
+
+      WalReader rd(dir);
+      uint64_t n = 0, last = 0;
+      while (auto it = rd.next()) {
+        REQUIRE(it->seqno == last + 1);
+        last = it->seqno;
+        ++n;
+      }
+      REQUIRE(n == 250);
+    }
+  }
+}
+
+TEST_CASE("KV: use_uring with fixed buffer and submit batch keeps data durable") {
+  auto dir = wadir("uringkv_kv_async_wal_");
+  auto opts = KVOptions{.path = dir, .use_uring = true, .uring_fixed_buffer_bytes = 64 * 1024,
+                        .uring_submit_batch = 4, .wal_group_commit_bytes = 4096,
+                        .final_flush_on_close = false};
+  {
+    KV kv(opts);
+    for (int i = 0; i < 300; ++i) REQUIRE(kv.put("k" + std::to_string(i), std::string(i % 300, 'x')));
+    WriteBatch b;
+    for (int i = 0; i < 100; ++i) b.del("k" + std::to_string(i));
+    REQUIRE(kv.write(b));
+  }
+  KV kv(opts);
+  for (int i = 0; i < 300; ++i) {
+    auto v = kv.get("k" + std::to_string(i));
+    if (i < 100) REQUIRE_FALSE(v.has_value());
+    else REQUIRE(v.value() == std::string(i % 300, 'x'));
+  }
+}